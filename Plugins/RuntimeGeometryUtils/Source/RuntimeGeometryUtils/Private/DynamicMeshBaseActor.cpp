@@ -7,10 +7,33 @@
 #include "MeshNormals.h"
 #include "MeshTransforms.h"
 #include "MeshSimplification.h"
+#include "MeshPartitionedSimplify.h"
 #include "Operations/MeshBoolean.h"
-#include "Implicit/Solidify.h"
+#include "SparseSolidify.h"
+#include "Async/Async.h"
+#include "MeshBooleanBroadPhase.h"
+#include "MeshBooleanOps.h"
+#include "MeshBooleanCache.h"
+#include "MeshSignedDistanceGrid.h"
+
+namespace DynamicMeshBaseActorLocals
+{
+	static FMeshBoolean::EBooleanOp GetBooleanOp(EDynamicMeshActorBooleanOperation Operation)
+	{
+		switch (Operation)
+		{
+			default:
+				return FMeshBoolean::EBooleanOp::Union;
+			case EDynamicMeshActorBooleanOperation::Subtraction:
+				return FMeshBoolean::EBooleanOp::Difference;
+			case EDynamicMeshActorBooleanOperation::Intersection:
+				return FMeshBoolean::EBooleanOp::Intersect;
+		}
+	}
+}
 
 #include "DynamicMeshOBJReader.h"
+#include "DynamicMeshCache.h"
 
 // Sets default values
 ADynamicMeshBaseActor::ADynamicMeshBaseActor()
@@ -19,9 +42,9 @@ ADynamicMeshBaseActor::ADynamicMeshBaseActor()
 	PrimaryActorTick.bCanEverTick = true;
 
 	AccumulatedTime = 0;
-	MeshAABBTree.SetMesh(&SourceMesh);
+	MeshAABBTree = MakeUnique<FUpdatableMeshAABBTree3>(&SourceMesh, false);
 
-	FastWinding = MakeUnique<TFastWindingTree<FDynamicMesh3>>(&MeshAABBTree, false);
+	FastWinding = MakeUnique<TFastWindingTree<FDynamicMesh3>>(MeshAABBTree.Get(), false);
 
 	MeshPool = CreateDefaultSubobject<UGeneratedMeshPool>(TEXT("MeshPool"));
 }
@@ -55,6 +78,10 @@ void ADynamicMeshBaseActor::Tick(float DeltaTime)
 	Super::Tick(DeltaTime);
 
 	AccumulatedTime += DeltaTime;
+	if (SpatialUpdateMode == EDynamicMeshActorSpatialUpdateMode::Background)
+	{
+		UpdateBackgroundSpatialRebuild();
+	}
 	if (bRegenerateOnTick && SourceType == EDynamicMeshActorSourceType::Primitive)
 	{
 		OnMeshGenerationSettingsModified();
@@ -74,18 +101,157 @@ void ADynamicMeshBaseActor::PostEditChangeProperty(FPropertyChangedEvent& Proper
 void ADynamicMeshBaseActor::EditMesh(TFunctionRef<void(FDynamicMesh3&)> EditFunc)
 {
 	EditFunc(SourceMesh);
+	bHaveMeshContentHash = false;
+
+	UpdateSpatialDataAfterEdit();
+
+	OnMeshEditedInternal();
+}
+
 
-	// update spatial data structures
+bool ADynamicMeshBaseActor::EditMeshRegion(TFunctionRef<bool(FDynamicMesh3&, TArray<int32>&, TArray<int32>&)> EditFunc)
+{
+	// the AABBTree can only be patched for the region if it was up to date for SourceMesh before the edit
+	bool bUpdateTreeRegion = SpatialMeshCopy.IsValid() == false
+		&& SpatialUpdateMode != EDynamicMeshActorSpatialUpdateMode::Background
+		&& MeshAABBTree->IsUpToDate();
+
+	TArray<int32> RemovedTriangles, AddedTriangles;
+	if (EditFunc(SourceMesh, RemovedTriangles, AddedTriangles) == false)
+	{
+		return false;
+	}
+	bHaveMeshContentHash = false;
+	RecomputeRegionNormals(SourceMesh, AddedTriangles);
+
+	if (bUpdateTreeRegion)
+	{
+		MeshAABBTree->UpdateRegion(RemovedTriangles, AddedTriangles);
+	}
+	// the FastWindingTree, flat BVH and inside query grid cannot be patched, so they are rebuilt for the whole mesh as after EditMesh()
+	UpdateSpatialDataAfterEdit();
+
+	OnMeshRegionEditedInternal(RemovedTriangles, AddedTriangles);
+	OnMeshRegionModified.Broadcast(this, RemovedTriangles, AddedTriangles);
+	return true;
+}
+
+
+void ADynamicMeshBaseActor::UpdateSpatialDataAfterEdit()
+{
+	bSpatialDataDirty = true;
+	if (SpatialMeshCopy.IsValid() == false)
+	{
+		// structures reference SourceMesh, so they are no longer valid
+		FlatBVH.Reset();
+		InsideQueryGrid.Reset();
+		bHasSpatialData = false;
+	}
 	if (bEnableSpatialQueries || bEnableInsideQueries)
 	{
-		MeshAABBTree.Build();
+		if (SpatialUpdateMode == EDynamicMeshActorSpatialUpdateMode::Immediate)
+		{
+			RebuildSpatialData();
+		}
+		else if (SpatialUpdateMode == EDynamicMeshActorSpatialUpdateMode::Background)
+		{
+			UpdateBackgroundSpatialRebuild();
+		}
+	}
+}
+
+
+const FDynamicMesh3& ADynamicMeshBaseActor::GetSpatialMesh() const
+{
+	return (SpatialMeshCopy.IsValid()) ? *SpatialMeshCopy : SourceMesh;
+}
+
+
+void ADynamicMeshBaseActor::RebuildSpatialData()
+{
+	PendingSpatialRebuild = TFuture<void>();
+	PendingSpatialData.Reset();
+	if (SpatialMeshCopy.IsValid())
+	{
+		// switch back from a Background mode copy to SourceMesh
+		MeshAABBTree->SetMesh(&SourceMesh, false);
+		FastWinding = MakeUnique<TFastWindingTree<FDynamicMesh3>>(MeshAABBTree.Get(), false);
+		SpatialMeshCopy.Reset();
+	}
+
+	FlatBVH.Reset();
+	InsideQueryGrid.Reset();
+	if (bEnableSpatialQueries || bEnableInsideQueries)
+	{
+		// refits the existing tree if only vertex positions changed since it was built
+		MeshAABBTree->Update();
 		if (bEnableInsideQueries)
 		{
 			FastWinding->Build();
 		}
+		bHasSpatialData = true;
 	}
+	bSpatialDataDirty = false;
+}
 
-	OnMeshEditedInternal();
+
+void ADynamicMeshBaseActor::UpdateBackgroundSpatialRebuild()
+{
+	if (PendingSpatialRebuild.IsValid() && PendingSpatialRebuild.IsReady())
+	{
+		FDynamicMeshActorSpatialData& Rebuilt = *PendingSpatialData;
+		MeshAABBTree = MoveTemp(Rebuilt.AABBTree);
+		FastWinding = (Rebuilt.FastWinding.IsValid()) ? MoveTemp(Rebuilt.FastWinding) : MakeUnique<TFastWindingTree<FDynamicMesh3>>(MeshAABBTree.Get(), false);
+		FlatBVH = MoveTemp(Rebuilt.FlatBVH);
+		InsideQueryGrid.Reset();
+		SpatialMeshCopy = MoveTemp(Rebuilt.Mesh);
+		bHasSpatialData = true;
+		PendingSpatialRebuild = TFuture<void>();
+		PendingSpatialData.Reset();
+	}
+
+	// only one rebuild runs at a time, further edits are picked up when it completes
+	if (bSpatialDataDirty && PendingSpatialRebuild.IsValid() == false && (bEnableSpatialQueries || bEnableInsideQueries))
+	{
+		TSharedPtr<FDynamicMeshActorSpatialData, ESPMode::ThreadSafe> SpatialData = MakeShared<FDynamicMeshActorSpatialData, ESPMode::ThreadSafe>();
+		SpatialData->Mesh = MakeUnique<FDynamicMesh3>(SourceMesh);
+		bool bBuildFastWinding = bEnableInsideQueries;
+		bool bBuildFlatBVH = bEnableSpatialQueries && bUseFlatQueryBVH;
+		PendingSpatialData = SpatialData;
+		PendingSpatialRebuild = Async(EAsyncExecution::ThreadPool, [SpatialData, bBuildFastWinding, bBuildFlatBVH]()
+		{
+			SpatialData->AABBTree = MakeUnique<FUpdatableMeshAABBTree3>(SpatialData->Mesh.Get(), true);
+			if (bBuildFastWinding)
+			{
+				SpatialData->FastWinding = MakeUnique<TFastWindingTree<FDynamicMesh3>>(SpatialData->AABBTree.Get(), true);
+			}
+			if (bBuildFlatBVH)
+			{
+				SpatialData->FlatBVH.Build(*SpatialData->Mesh);
+			}
+		});
+		bSpatialDataDirty = false;
+	}
+}
+
+
+void ADynamicMeshBaseActor::UpdateSpatialDataForQuery()
+{
+	if (SpatialUpdateMode != EDynamicMeshActorSpatialUpdateMode::Background)
+	{
+		if (bSpatialDataDirty || bHasSpatialData == false)
+		{
+			RebuildSpatialData();
+		}
+		return;
+	}
+
+	UpdateBackgroundSpatialRebuild();
+	while ((bWaitForSpatialRebuild || bHasSpatialData == false) && PendingSpatialRebuild.IsValid())
+	{
+		PendingSpatialRebuild.Wait();
+		UpdateBackgroundSpatialRebuild();
+	}
 }
 
 
@@ -104,6 +270,11 @@ void ADynamicMeshBaseActor::OnMeshEditedInternal()
 	OnMeshModified.Broadcast(this);
 }
 
+void ADynamicMeshBaseActor::OnMeshRegionEditedInternal(const TArray<int32>& RemovedTriangles, const TArray<int32>& AddedTriangles)
+{
+	OnMeshEditedInternal();
+}
+
 
 void ADynamicMeshBaseActor::OnMeshGenerationSettingsModified()
 {
@@ -152,7 +323,10 @@ void ADynamicMeshBaseActor::RegenerateSourceMesh(FDynamicMesh3& MeshOut)
 		}
 
 		MeshOut = FDynamicMesh3();
-		if ( ! RTGUtils::ReadOBJMesh(UsePath, MeshOut, true, true, true, bReverseOrientation))
+		bool bRead = (bCacheImportedMesh) ?
+			RTGUtils::ReadOBJMeshCached(UsePath, MeshOut, true, true, true, bReverseOrientation)
+			: RTGUtils::ReadOBJMesh(UsePath, MeshOut, true, true, true, bReverseOrientation);
+		if ( ! bRead )
 		{
 			UE_LOG(LogTemp, Warning, TEXT("Error reading mesh file %s"), *UsePath);
 			FSphereGenerator SphereGen;
@@ -196,6 +370,87 @@ void ADynamicMeshBaseActor::RecomputeNormals(FDynamicMesh3& MeshOut)
 }
 
 
+void ADynamicMeshBaseActor::RecomputeRegionNormals(FDynamicMesh3& MeshOut, const TArray<int32>& Triangles)
+{
+	if (this->NormalsMode == EDynamicMeshActorNormalsMode::SplitNormals)
+	{
+		return;
+	}
+	if (MeshOut.HasAttributes() == false)
+	{
+		RecomputeNormals(MeshOut);
+		return;
+	}
+
+	FDynamicMeshNormalOverlay* Normals = MeshOut.Attributes()->PrimaryNormals();
+	if (this->NormalsMode == EDynamicMeshActorNormalsMode::FaceNormals)
+	{
+		for (int32 tid : Triangles)
+		{
+			if (MeshOut.IsTriangle(tid))
+			{
+				FVector3f TriNormal = (FVector3f)MeshOut.GetTriNormal(tid);
+				Normals->SetTriangle(tid, FIndex3i(Normals->AppendElement(TriNormal), Normals->AppendElement(TriNormal), Normals->AppendElement(TriNormal)));
+			}
+		}
+		return;
+	}
+
+	// Per-vertex normals have one element per vertex. The vertices of Triangles reuse one of their existing elements,
+	// which is then set in all of their triangles, as the region and the rest of the mesh may have had different elements.
+	TMap<int32, int32> VertexElements;
+	for (int32 tid : Triangles)
+	{
+		if (MeshOut.IsTriangle(tid))
+		{
+			FIndex3i TriV = MeshOut.GetTriangle(tid);
+			for (int32 j = 0; j < 3; ++j)
+			{
+				VertexElements.Add(TriV[j], -1);
+			}
+		}
+	}
+	TSet<int32> RegionTriangles;
+	for (TPair<int32, int32>& VertexElement : VertexElements)
+	{
+		int32 vid = VertexElement.Key;
+		for (int32 tid : MeshOut.VtxTrianglesItr(vid))
+		{
+			RegionTriangles.Add(tid);
+			if (VertexElement.Value < 0 && Normals->IsSetTriangle(tid))
+			{
+				VertexElement.Value = Normals->GetTriangle(tid)[MeshOut.GetTriangle(tid).IndexOf(vid)];
+			}
+		}
+		FVector3f VertexNormal = (FVector3f)FMeshNormals::ComputeVertexNormal(MeshOut, vid);
+		if (VertexElement.Value < 0)
+		{
+			VertexElement.Value = Normals->AppendElement(VertexNormal);
+		}
+		else
+		{
+			Normals->SetElement(VertexElement.Value, VertexNormal);
+		}
+	}
+	for (int32 tid : RegionTriangles)
+	{
+		FIndex3i TriV = MeshOut.GetTriangle(tid);
+		FIndex3i TriElements = (Normals->IsSetTriangle(tid)) ? Normals->GetTriangle(tid) : FIndex3i::Invalid();
+		for (int32 j = 0; j < 3; ++j)
+		{
+			if (const int32* Element = VertexElements.Find(TriV[j]))
+			{
+				TriElements[j] = *Element;
+			}
+		}
+		if (TriElements.A >= 0 && TriElements.B >= 0 && TriElements.C >= 0)
+		{
+			Normals->SetTriangle(tid, TriElements);
+		}
+	}
+}
+
+
 
 int ADynamicMeshBaseActor::GetTriangleCount() const
 {
@@ -225,18 +480,32 @@ float ADynamicMeshBaseActor::DistanceToPoint(FVector WorldPoint, FVector& Neares
 	{
 		return TNumericLimits<float>::Max();
 	}
+	UpdateSpatialDataForQuery();
 
 	FTransform3d ActorToWorld(GetActorTransform());
 	FVector3d LocalPoint = ActorToWorld.InverseTransformPosition((FVector3d)WorldPoint);
 
 	double NearDistSqr;
-	NearestTriangle = MeshAABBTree.FindNearestTriangle(LocalPoint, NearDistSqr);
+	if (const FFlatMeshBVH* BVH = GetFlatQueryBVH())
+	{
+		FVector3d NearestPoint, BaryCoords;
+		NearestTriangle = BVH->FindNearestTriangle(LocalPoint, NearDistSqr, NearestPoint, BaryCoords);
+		if (NearestTriangle < 0)
+		{
+			return TNumericLimits<float>::Max();
+		}
+		NearestWorldPoint = (FVector)ActorToWorld.TransformPosition(NearestPoint);
+		TriBaryCoords = (FVector)BaryCoords;
+		return (float)FMathd::Sqrt(NearDistSqr);
+	}
+
+	NearestTriangle = MeshAABBTree->FindNearestTriangle(LocalPoint, NearDistSqr);
 	if (NearestTriangle < 0)
 	{
 		return TNumericLimits<float>::Max();
 	}
 
-	FDistPoint3Triangle3d DistQuery = TMeshQueries<FDynamicMesh3>::TriangleDistance(SourceMesh, NearestTriangle, LocalPoint);
+	FDistPoint3Triangle3d DistQuery = TMeshQueries<FDynamicMesh3>::TriangleDistance(GetSpatialMesh(), NearestTriangle, LocalPoint);
 	NearestWorldPoint = (FVector)ActorToWorld.TransformPosition(DistQuery.ClosestTrianglePoint);
 	TriBaryCoords = (FVector)DistQuery.TriangleBaryCoords;
 	return (float)FMathd::Sqrt(NearDistSqr);
@@ -247,9 +516,17 @@ FVector ADynamicMeshBaseActor::NearestPoint(FVector WorldPoint)
 {
 	if (bEnableSpatialQueries)
 	{
+		UpdateSpatialDataForQuery();
 		FTransform3d ActorToWorld(GetActorTransform());
 		FVector3d LocalPoint = ActorToWorld.InverseTransformPosition((FVector3d)WorldPoint);
-		return (FVector)ActorToWorld.TransformPosition(MeshAABBTree.FindNearestPoint(LocalPoint));
+		if (const FFlatMeshBVH* BVH = GetFlatQueryBVH())
+		{
+			double NearDistSqr;
+			FVector3d NearestPoint, BaryCoords;
+			return (BVH->FindNearestTriangle(LocalPoint, NearDistSqr, NearestPoint, BaryCoords) >= 0) ?
+				(FVector)ActorToWorld.TransformPosition(NearestPoint) : WorldPoint;
+		}
+		return (FVector)ActorToWorld.TransformPosition(MeshAABBTree->FindNearestPoint(LocalPoint));
 	}
 	return WorldPoint;
 }
@@ -258,8 +535,13 @@ bool ADynamicMeshBaseActor::ContainsPoint(FVector WorldPoint, float WindingThres
 {
 	if (bEnableInsideQueries)
 	{
+		UpdateSpatialDataForQuery();
 		FTransform3d ActorToWorld(GetActorTransform());
 		FVector3d LocalPoint = ActorToWorld.InverseTransformPosition((FVector3d)WorldPoint);
+		if (const FWindingOccupancyGrid* Grid = GetInsideQueryGrid(WindingThreshold))
+		{
+			return Grid->IsInside(*FastWinding, LocalPoint);
+		}
 		return FastWinding->IsInside(LocalPoint, WindingThreshold);
 	}
 	return false;
@@ -272,19 +554,36 @@ bool ADynamicMeshBaseActor::IntersectRay(FVector RayOrigin, FVector RayDirection
 {
 	if (bEnableSpatialQueries)
 	{
+		UpdateSpatialDataForQuery();
 		FTransform3d ActorToWorld(GetActorTransform());
 		FVector3d WorldDirection(RayDirection); WorldDirection.Normalize();
 		FRay3d LocalRay(ActorToWorld.InverseTransformPosition((FVector3d)RayOrigin),
 			ActorToWorld.InverseTransformNormal(WorldDirection));
+		if (const FFlatMeshBVH* BVH = GetFlatQueryBVH())
+		{
+			double RayParameter;
+			FVector3d BaryCoords;
+			NearestTriangle = BVH->FindNearestHitTriangle(LocalRay, MaxDistance, RayParameter, BaryCoords);
+			if (NearestTriangle >= 0)
+			{
+				HitDistance = (float)RayParameter;
+				WorldHitPoint = (FVector)ActorToWorld.TransformPosition(LocalRay.PointAt(RayParameter));
+				TriBaryCoords = (FVector)BaryCoords;
+				return true;
+			}
+			return false;
+		}
+
 		IMeshSpatial::FQueryOptions QueryOptions;
 		if (MaxDistance > 0)
 		{
 			QueryOptions.MaxDistance = MaxDistance;
 		}
-		NearestTriangle = MeshAABBTree.FindNearestHitTriangle(LocalRay, QueryOptions);
-		if (SourceMesh.IsTriangle(NearestTriangle))
+		NearestTriangle = MeshAABBTree->FindNearestHitTriangle(LocalRay, QueryOptions);
+		const FDynamicMesh3& SpatialMesh = GetSpatialMesh();
+		if (SpatialMesh.IsTriangle(NearestTriangle))
 		{
-			FIntrRay3Triangle3d IntrQuery = TMeshQueries<FDynamicMesh3>::TriangleIntersection(SourceMesh, NearestTriangle, LocalRay);
+			FIntrRay3Triangle3d IntrQuery = TMeshQueries<FDynamicMesh3>::TriangleIntersection(SpatialMesh, NearestTriangle, LocalRay);
 			if (IntrQuery.IntersectionType == EIntersectionType::Point)
 			{
 				HitDistance = IntrQuery.RayParameter;
@@ -298,6 +597,147 @@ bool ADynamicMeshBaseActor::IntersectRay(FVector RayOrigin, FVector RayDirection
 }
 
 
+const FFlatMeshBVH* ADynamicMeshBaseActor::GetFlatQueryBVH()
+{
+	if (!bEnableSpatialQueries || !bUseFlatQueryBVH)
+	{
+		return nullptr;
+	}
+	if (FlatBVH.IsValidFor(GetSpatialMesh()) == false)
+	{
+		FlatBVH.Build(GetSpatialMesh());
+	}
+	return &FlatBVH;
+}
+
+
+const FWindingOccupancyGrid* ADynamicMeshBaseActor::GetInsideQueryGrid(float WindingThreshold)
+{
+	if (!bEnableInsideQueries || !bUseInsideQueryGrid)
+	{
+		return nullptr;
+	}
+	if (InsideQueryGrid.IsValidFor(GetSpatialMesh(), WindingThreshold) == false)
+	{
+		InsideQueryGrid.Build(GetSpatialMesh(), *MeshAABBTree, *FastWinding, WindingThreshold, InsideQueryGridResolution);
+	}
+	return &InsideQueryGrid;
+}
+
+
+FMeshDistanceQueryResults ADynamicMeshBaseActor::DistanceToPoints(const TArray<FVector>& WorldPoints)
+{
+	FMeshDistanceQueryResults Results;
+	if (bEnableSpatialQueries)
+	{
+		UpdateSpatialDataForQuery();
+	}
+	if (const FFlatMeshBVH* BVH = GetFlatQueryBVH())
+	{
+		RTGUtils::FindDistancesToPoints(*BVH, FTransform3d(GetActorTransform()), WorldPoints, Results);
+	}
+	else if (bEnableSpatialQueries)
+	{
+		RTGUtils::FindDistancesToPoints(GetSpatialMesh(), *MeshAABBTree, FTransform3d(GetActorTransform()), WorldPoints, Results);
+	}
+	else
+	{
+		Results.Distances.Init(TNumericLimits<float>::Max(), WorldPoints.Num());
+		Results.NearestPoints = WorldPoints;
+		Results.NearestTriangles.Init(-1, WorldPoints.Num());
+		Results.TriBaryCoords.Init(FVector::ZeroVector, WorldPoints.Num());
+	}
+	return Results;
+}
+
+
+TArray<FVector> ADynamicMeshBaseActor::NearestPoints(const TArray<FVector>& WorldPoints)
+{
+	if (bEnableSpatialQueries)
+	{
+		UpdateSpatialDataForQuery();
+		TArray<FVector> Results;
+		if (const FFlatMeshBVH* BVH = GetFlatQueryBVH())
+		{
+			RTGUtils::FindNearestPoints(*BVH, FTransform3d(GetActorTransform()), WorldPoints, Results);
+		}
+		else
+		{
+			RTGUtils::FindNearestPoints(*MeshAABBTree, FTransform3d(GetActorTransform()), WorldPoints, Results);
+		}
+		return Results;
+	}
+	return WorldPoints;
+}
+
+
+TArray<bool> ADynamicMeshBaseActor::ContainsPoints(const TArray<FVector>& WorldPoints, float WindingThreshold)
+{
+	TArray<bool> Results;
+	if (bEnableInsideQueries)
+	{
+		UpdateSpatialDataForQuery();
+		if (const FWindingOccupancyGrid* Grid = GetInsideQueryGrid(WindingThreshold))
+		{
+			RTGUtils::FindContainedPoints(*Grid, *FastWinding, FTransform3d(GetActorTransform()), WorldPoints, Results);
+		}
+		else
+		{
+			RTGUtils::FindContainedPoints(*FastWinding, FTransform3d(GetActorTransform()), WorldPoints, WindingThreshold, Results);
+		}
+	}
+	else
+	{
+		Results.Init(false, WorldPoints.Num());
+	}
+	return Results;
+}
+
+
+FMeshRayQueryResults ADynamicMeshBaseActor::IntersectRays(const TArray<FVector>& RayOrigins, const TArray<FVector>& RayDirections, float MaxDistance)
+{
+	FMeshRayQueryResults Results;
+	if (bEnableSpatialQueries)
+	{
+		UpdateSpatialDataForQuery();
+	}
+	if (const FFlatMeshBVH* BVH = GetFlatQueryBVH())
+	{
+		RTGUtils::FindRayIntersections(*BVH, FTransform3d(GetActorTransform()), RayOrigins, RayDirections, MaxDistance, Results);
+	}
+	else if (bEnableSpatialQueries)
+	{
+		RTGUtils::FindRayIntersections(*MeshAABBTree, FTransform3d(GetActorTransform()), RayOrigins, RayDirections, MaxDistance, Results);
+	}
+	else
+	{
+		Results.bHit.Init(false, RayOrigins.Num());
+		Results.HitDistances.Init(0, RayOrigins.Num());
+		Results.HitPoints.Init(FVector::ZeroVector, RayOrigins.Num());
+		Results.HitTriangles.Init(-1, RayOrigins.Num());
+		Results.TriBaryCoords.Init(FVector::ZeroVector, RayOrigins.Num());
+	}
+	return Results;
+}
+
+
+FMeshRayMultiHitResults ADynamicMeshBaseActor::IntersectRaysAllHits(const TArray<FVector>& RayOrigins, const TArray<FVector>& RayDirections, float MaxDistance)
+{
+	FMeshRayMultiHitResults Results;
+	if (bEnableSpatialQueries)
+	{
+		UpdateSpatialDataForQuery();
+		RTGUtils::FindAllRayIntersections(*MeshAABBTree, FTransform3d(GetActorTransform()), RayOrigins, RayDirections, MaxDistance, Results);
+	}
+	else
+	{
+		Results.FirstHits.Init(0, RayOrigins.Num());
+		Results.HitCounts.Init(0, RayOrigins.Num());
+	}
+	return Results;
+}
+
+
 
 
 void ADynamicMeshBaseActor::SubtractMesh(ADynamicMeshBaseActor* OtherMeshActor)
@@ -314,38 +754,113 @@ void ADynamicMeshBaseActor::IntersectWithMesh(ADynamicMeshBaseActor* OtherMeshAc
 }
 
 
+uint64 ADynamicMeshBaseActor::GetMeshContentHash()
+{
+	if (!bHaveMeshContentHash)
+	{
+		MeshContentHash = RTGUtils::ComputeMeshContentHash(SourceMesh);
+		bHaveMeshContentHash = true;
+	}
+	return MeshContentHash;
+}
+
+
 void ADynamicMeshBaseActor::BooleanWithMesh(ADynamicMeshBaseActor* OtherMeshActor, EDynamicMeshActorBooleanOperation Operation)
 {
 	if (ensure(OtherMeshActor) == false) return;
 
+	// local booleans only modify a region of SourceMesh, which a cached result would replace
+	FMeshBoolean::EBooleanOp ApplyOp = DynamicMeshBaseActorLocals::GetBooleanOp(Operation);
+	bool bLocalBoolean = bLocalBooleans && ApplyOp != FMeshBoolean::EBooleanOp::Intersect;
+	if (bCacheBooleanResults == false || bLocalBoolean || RTGUtils::IsMeshBooleanCacheEnabled() == false)
+	{
+		ApplyBooleanWithMesh(OtherMeshActor, Operation);
+		return;
+	}
+
+	// the result is in our local space, so it is keyed by the transform of OtherMesh relative to this actor
+	FTransform3d OtherToActor(OtherMeshActor->GetActorTransform().GetRelativeTransform(GetActorTransform()));
+	uint64 MeshHash = GetMeshContentHash();
+	uint64 OtherMeshHash = OtherMeshActor->GetMeshContentHash();
+
+	FDynamicMesh3 CachedResult;
+	uint64 CachedResultHash = 0;
+	if (RTGUtils::FindCachedMeshBoolean(MeshHash, OtherMeshHash, OtherToActor, ApplyOp, CachedResult, CachedResultHash))
+	{
+		// cached results already have their normals computed
+		EditMesh([&](FDynamicMesh3& MeshToUpdate)
+		{
+			MeshToUpdate = MoveTemp(CachedResult);
+		});
+		MeshContentHash = CachedResultHash;
+		bHaveMeshContentHash = true;
+		return;
+	}
+
+	ApplyBooleanWithMesh(OtherMeshActor, Operation);
+	RTGUtils::AddCachedMeshBoolean(MeshHash, OtherMeshHash, OtherToActor, ApplyOp, SourceMesh, GetMeshContentHash());
+}
+
+
+void ADynamicMeshBaseActor::ApplyBooleanWithMesh(ADynamicMeshBaseActor* OtherMeshActor, EDynamicMeshActorBooleanOperation Operation)
+{
+	FMeshBoolean::EBooleanOp ApplyOp = DynamicMeshBaseActorLocals::GetBooleanOp(Operation);
+
 	FTransform3d ActorToWorld(GetActorTransform());
 	FTransform3d OtherToWorld(OtherMeshActor->GetActorTransform());
+	const FDynamicMesh3& OtherMesh = OtherMeshActor->GetMeshRef();
 
-	FDynamicMesh3 OtherMesh;
-	OtherMeshActor->GetMeshCopy(OtherMesh);
-	MeshTransforms::ApplyTransform(OtherMesh, OtherToWorld);
-	MeshTransforms::ApplyTransformInverse(OtherMesh, ActorToWorld);
+	// broad phase: if the bounds or the surfaces do not intersect, the result can be found without the boolean kernel
+	EMeshBooleanBroadPhaseResult Relationship = EMeshBooleanBroadPhaseResult::Disjoint;
+	if (RTGUtils::TestBooleanBoundsOverlap(SourceMesh, ActorToWorld, OtherMesh, OtherToWorld))
+	{
+		TUniquePtr<FUpdatableMeshAABBTree3> TempTree, OtherTempTree;
+		Relationship = RTGUtils::ClassifyBooleanOperands(
+			GetSourceMeshAABBTree(TempTree), ActorToWorld,
+			OtherMeshActor->GetSourceMeshAABBTree(OtherTempTree), OtherToWorld);
+	}
+	if (Relationship != EMeshBooleanBroadPhaseResult::Intersecting)
+	{
+		if (RTGUtils::IsBooleanNoOp(ApplyOp, Relationship) == false)
+		{
+			EditMesh([&](FDynamicMesh3& MeshToUpdate)
+			{
+				RTGUtils::ApplyTrivialBoolean(MeshToUpdate, ActorToWorld, OtherMesh, OtherToWorld, ApplyOp, Relationship);
+				RecomputeNormals(MeshToUpdate);
+			});
+		}
+		return;
+	}
 
-	EditMesh([&](FDynamicMesh3& MeshToUpdate) {
+	// the boolean applies the relative transform to (an internal copy of) OtherMesh
+	FTransform3d OtherToActor(OtherMeshActor->GetActorTransform().GetRelativeTransform(GetActorTransform()));
 
-		FDynamicMesh3 ResultMesh;
+	if (bLocalBooleans && ApplyOp != FMeshBoolean::EBooleanOp::Intersect)
+	{
+		FDynamicMesh3 LocalOtherMesh(OtherMesh);
+		MeshTransforms::ApplyTransform(LocalOtherMesh, OtherToWorld);
+		MeshTransforms::ApplyTransformInverse(LocalOtherMesh, ActorToWorld);
+		TUniquePtr<FUpdatableMeshAABBTree3> TempTree;
+		FUpdatableMeshAABBTree3& Tree = GetSourceMeshAABBTree(TempTree);
 
-		FMeshBoolean::EBooleanOp ApplyOp = FMeshBoolean::EBooleanOp::Union;
-		switch (Operation)
+		bool bComputedLocal = EditMeshRegion([&](FDynamicMesh3& MeshToUpdate, TArray<int32>& RemovedTriangles, TArray<int32>& AddedTriangles)
 		{
-			default:
-				break;
-			case EDynamicMeshActorBooleanOperation::Subtraction:
-				ApplyOp = FMeshBoolean::EBooleanOp::Difference;
-				break;
-			case EDynamicMeshActorBooleanOperation::Intersection:
-				ApplyOp = FMeshBoolean::EBooleanOp::Intersect;
-				break;
+			return RTGUtils::ComputeLocalMeshBoolean(MeshToUpdate, Tree, LocalOtherMesh, ApplyOp, RemovedTriangles, AddedTriangles);
+		});
+		if (bComputedLocal)
+		{
+			return;
 		}
+		// otherwise SourceMesh is unmodified, and the full boolean is computed below
+	}
+
+	EditMesh([&](FDynamicMesh3& MeshToUpdate) {
+
+		FDynamicMesh3 ResultMesh;
 
 		FMeshBoolean Boolean(
 			&MeshToUpdate, FTransform3d::Identity(),
-			&OtherMesh, FTransform3d::Identity(),
+			&OtherMesh, OtherToActor,
 			&ResultMesh,
 			ApplyOp);
 		Boolean.bPutResultInInputSpace = true;
@@ -363,11 +878,50 @@ void ADynamicMeshBaseActor::BooleanWithMesh(ADynamicMeshBaseActor* OtherMeshActo
 }
 
 
+void ADynamicMeshBaseActor::BooleanWithMany(TArray<ADynamicMeshBaseActor*> OtherMeshes, EDynamicMeshActorBooleanOperation Operation)
+{
+	TArray<const FDynamicMesh3*> Operands;
+	TArray<FTransform3d> OperandTransforms;
+	for (ADynamicMeshBaseActor* OtherMeshActor : OtherMeshes)
+	{
+		if (OtherMeshActor)
+		{
+			Operands.Add(&OtherMeshActor->GetMeshRef());
+			OperandTransforms.Add(FTransform3d(OtherMeshActor->GetActorTransform()));
+		}
+	}
+
+	FTransform3d ActorToWorld(GetActorTransform());
+	EditMesh([&](FDynamicMesh3& MeshToUpdate)
+	{
+		RTGUtils::ComputeMeshBooleanWithMany(MeshToUpdate, ActorToWorld, Operands, OperandTransforms, DynamicMeshBaseActorLocals::GetBooleanOp(Operation));
+		RecomputeNormals(MeshToUpdate);
+	});
+}
+
+
+FUpdatableMeshAABBTree3& ADynamicMeshBaseActor::GetSourceMeshAABBTree(TUniquePtr<FUpdatableMeshAABBTree3>& TempTree)
+{
+	if (SpatialMeshCopy.IsValid() == false)
+	{
+		// MeshAABBTree is for SourceMesh, so update it (refitting it if only positions changed) and keep it for later queries
+		MeshAABBTree->Update();
+		return *MeshAABBTree;
+	}
+	// in Background mode MeshAABBTree is for a copy of SourceMesh, which may be out of date
+	TempTree = MakeUnique<FUpdatableMeshAABBTree3>(&SourceMesh, true);
+	return *TempTree;
+}
+
+
 
 bool ADynamicMeshBaseActor::ImportMesh(FString Path, bool bFlipOrientation, bool bRecomputeNormals)
 {
 	FDynamicMesh3 ImportedMesh;
-	if (!RTGUtils::ReadOBJMesh(Path, ImportedMesh, true, true, true, bFlipOrientation))
+	bool bRead = (bCacheImportedMesh) ?
+		RTGUtils::ReadOBJMeshCached(Path, ImportedMesh, true, true, true, bFlipOrientation)
+		: RTGUtils::ReadOBJMesh(Path, ImportedMesh, true, true, true, bFlipOrientation);
+	if (!bRead)
 	{
 		UE_LOG(LogTemp, Warning, TEXT("Error reading mesh file %s"), *Path);
 		return false;
@@ -440,31 +994,39 @@ void ADynamicMeshBaseActor::CopyFromMesh(UGeneratedMesh* GeneratedMesh, bool bRe
 
 void ADynamicMeshBaseActor::SolidifyMesh(int VoxelResolution, float WindingThreshold)
 {
-	if (MeshAABBTree.IsValid() == false)
+	// reuse the spatial data if it is up to date, otherwise build a temporary FastWinding for SourceMesh
+	TUniquePtr<FUpdatableMeshAABBTree3> TempTree;
+	TUniquePtr<TFastWindingTree<FDynamicMesh3>> TempWinding;
+	FUpdatableMeshAABBTree3& Tree = GetSourceMeshAABBTree(TempTree);
+	TFastWindingTree<FDynamicMesh3>* Winding = FastWinding.Get();
+	bool bFastWindingValid = bHasSpatialData && bEnableInsideQueries;
+	if (&Tree != MeshAABBTree.Get() || bFastWindingValid == false)
 	{
-		MeshAABBTree.Build();
+		TempWinding = MakeUnique<TFastWindingTree<FDynamicMesh3>>(&Tree, false);
+		Winding = TempWinding.Get();
 	}
-	if (FastWinding->IsBuilt() == false)
+
+	double ExtendBounds = 2.0;
+	FDynamicMesh3 SolidMesh;
+	RTGUtils::ComputeSparseSolidify(SourceMesh, *Winding, VoxelResolution, WindingThreshold, ExtendBounds, 5, SolidMesh);
+
+	SolidMesh.EnableAttributes();
+	RecomputeNormals(SolidMesh);
+
+	EditMesh([&](FDynamicMesh3& MeshToUpdate)
 	{
-		FastWinding->Build();
-	}
+		MeshToUpdate = MoveTemp(SolidMesh);
+	});
+}
 
-	// ugh workaround for bug
-	FDynamicMesh3 CompactMesh;
-	CompactMesh.CompactCopy(SourceMesh, false, false, false, false);
-	FDynamicMeshAABBTree3 AABBTree(&CompactMesh, true);
-	TFastWindingTree<FDynamicMesh3> Winding(&AABBTree, true);
+void ADynamicMeshBaseActor::SolidifyMeshSDF(int VoxelResolution, float Offset)
+{
+	TUniquePtr<FUpdatableMeshAABBTree3> TempTree;
+	FUpdatableMeshAABBTree3& Tree = GetSourceMeshAABBTree(TempTree);
+	TFastWindingTree<FDynamicMesh3> Winding(&Tree, true);
 
-	double ExtendBounds = 2.0;
-	//TImplicitSolidify<FDynamicMesh3> SolidifyCalc(&SourceMesh, &MeshAABBTree, FastWinding.Get());
-	//SolidifyCalc.SetCellSizeAndExtendBounds(MeshAABBTree.GetBoundingBox(), ExtendBounds, VoxelResolution);
-	TImplicitSolidify<FDynamicMesh3> SolidifyCalc(&CompactMesh, &AABBTree, &Winding);
-	SolidifyCalc.SetCellSizeAndExtendBounds(AABBTree.GetBoundingBox(), ExtendBounds, VoxelResolution);
-	SolidifyCalc.WindingThreshold = WindingThreshold;
-	SolidifyCalc.SurfaceSearchSteps = 5;
-	SolidifyCalc.bSolidAtBoundaries = true;
-	SolidifyCalc.ExtendBounds = ExtendBounds;
-	FDynamicMesh3 SolidMesh(&SolidifyCalc.Generate());
+	FDynamicMesh3 SolidMesh;
+	RTGUtils::ComputeOffsetSurface(SourceMesh, Tree, Winding, VoxelResolution, Offset, SolidMesh);
 
 	SolidMesh.EnableAttributes();
 	RecomputeNormals(SolidMesh);
@@ -496,6 +1058,24 @@ void ADynamicMeshBaseActor::SimplifyMeshToTriCount(int32 TargetTriangleCount)
 }
 
 
+void ADynamicMeshBaseActor::SimplifyMeshToTriCountParallel(int32 TargetTriangleCount, int NumPartitions)
+{
+	TargetTriangleCount = FMath::Max(1, TargetTriangleCount);
+	if (TargetTriangleCount >= SourceMesh.TriangleCount()) return;
+
+	FDynamicMesh3 SimplifyMesh;
+	SimplifyMesh.CompactCopy(SourceMesh, false, false, false, false);
+	RTGUtils::SimplifyMeshPartitioned(SimplifyMesh, TargetTriangleCount, false, NumPartitions);
+	SimplifyMesh.EnableAttributes();
+	RecomputeNormals(SimplifyMesh);
+
+	EditMesh([&](FDynamicMesh3& MeshToUpdate)
+	{
+		MeshToUpdate = MoveTemp(SimplifyMesh);
+	});
+}
+
+
 
 
 UGeneratedMesh* ADynamicMeshBaseActor::AllocateComputeMesh()
@@ -0,0 +1,504 @@
+#include "DynamicMeshCache.h"
+#include "DynamicMeshOBJReader.h"
+#include "DynamicMeshAttributeSet.h"
+
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Async/ParallelFor.h"
+#include "Hash/CityHash.h"
+#include "Misc/Paths.h"
+
+
+namespace MeshCacheLocals
+{
+	static const uint32 MeshCacheMagic = 0x48534D52;		// "RMSH"
+	static const uint32 MeshCacheVersion = 1;
+	static const int64 HashBlockSize = 4 * 1024 * 1024;
+
+	/** Optional sections present in a cache file */
+	enum class EMeshCacheSections : uint32
+	{
+		None = 0,
+		VertexColors = 1,
+		TriangleGroups = 2,
+		Attributes = 4
+	};
+	ENUM_CLASS_FLAGS(EMeshCacheSections);
+
+	/** Identifies the source file (and import options) a cache was generated from */
+	struct FMeshCacheKey
+	{
+		FString SourcePath;
+		int64 SourceSize = 0;
+		int64 SourceTimestamp = 0;
+		uint64 SourceHash = 0;
+		uint32 ImportFlags = 0;
+
+		void Serialize(FArchive& Ar)
+		{
+			Ar << SourcePath;
+			Ar << SourceSize;
+			Ar << SourceTimestamp;
+			Ar << SourceHash;
+			Ar << ImportFlags;
+		}
+	};
+
+
+	/**
+	 * Hash fixed-size blocks of the file independently (in parallel if the file can be mapped) and then hash the block hashes.
+	 */
+	static bool ComputeContentHash(const FString& Path, int64 FileSize, uint64& HashOut)
+	{
+		int32 NumBlocks = (int32)((FileSize + HashBlockSize - 1) / HashBlockSize);
+		TArray<uint64> BlockHashes;
+		BlockHashes.SetNum(NumBlocks);
+
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		TUniquePtr<IMappedFileHandle> MappedFile((FileSize > 0) ? PlatformFile.OpenMapped(*Path) : nullptr);
+		TUniquePtr<IMappedFileRegion> MappedRegion((MappedFile) ? MappedFile->MapRegion(0, FileSize) : nullptr);
+		if (MappedRegion && MappedRegion->GetMappedSize() == FileSize)
+		{
+			const char* Data = (const char*)MappedRegion->GetMappedPtr();
+			ParallelFor(NumBlocks, [&](int32 bi)
+			{
+				int64 Offset = bi * HashBlockSize;
+				BlockHashes[bi] = CityHash64(Data + Offset, (uint32)FMath::Min(HashBlockSize, FileSize - Offset));
+			});
+		}
+		else if (NumBlocks > 0)
+		{
+			TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Path));
+			if (!Reader)
+			{
+				return false;
+			}
+			TArray<uint8> Block;
+			Block.SetNumUninitialized((int32)FMath::Min(HashBlockSize, FileSize));
+			for (int32 bi = 0; bi < NumBlocks; ++bi)
+			{
+				int64 Size = FMath::Min(HashBlockSize, FileSize - bi * HashBlockSize);
+				Reader->Serialize(Block.GetData(), Size);
+				if (Reader->IsError())
+				{
+					return false;
+				}
+				BlockHashes[bi] = CityHash64((const char*)Block.GetData(), (uint32)Size);
+			}
+		}
+
+		HashOut = CityHash64WithSeed((const char*)BlockHashes.GetData(), (uint32)(BlockHashes.Num() * sizeof(uint64)), (uint64)FileSize);
+		return true;
+	}
+
+
+	static bool GetSourceKey(const FString& SourcePath, RTGUtils::EMeshCacheImportFlags ImportFlags, bool bComputeHash, FMeshCacheKey& KeyOut)
+	{
+		IFileManager& FileManager = IFileManager::Get();
+		int64 Size = FileManager.FileSize(*SourcePath);
+		if (Size < 0)
+		{
+			return false;
+		}
+		KeyOut.SourcePath = FPaths::ConvertRelativePathToFull(SourcePath);
+		KeyOut.SourceSize = Size;
+		KeyOut.SourceTimestamp = FileManager.GetTimeStamp(*SourcePath).GetTicks();
+		KeyOut.ImportFlags = (uint32)ImportFlags;
+		return (bComputeHash == false) || ComputeContentHash(SourcePath, Size, KeyOut.SourceHash);
+	}
+
+
+	template<typename ElementType>
+	static void SerializeArray(FArchive& Ar, TArray<ElementType>& Array, int32 Num)
+	{
+		if (Ar.IsLoading())
+		{
+			Array.SetNumUninitialized(Num);
+		}
+		if (Num > 0)
+		{
+			Ar.Serialize(Array.GetData(), (int64)Num * sizeof(ElementType));
+		}
+	}
+
+
+	/** Contiguous mesh arrays, in the order they are stored in the cache file */
+	struct FMeshCacheData
+	{
+		EMeshCacheSections Sections = EMeshCacheSections::None;
+		int32 NumVertices = 0;
+		int32 NumTriangles = 0;
+		int32 NumNormals = 0;
+		int32 NumUVs = 0;
+
+		TArray<FVector3d> Positions;
+		TArray<FIndex3i> Triangles;
+		TArray<FVector3f> Colors;
+		TArray<int32> Groups;
+		TArray<FVector3f> NormalElements;
+		TArray<FIndex3i> NormalTriangles;
+		TArray<FVector2f> UVElements;
+		TArray<FIndex3i> UVTriangles;
+
+		void Serialize(FArchive& Ar)
+		{
+			uint32 SectionBits = (uint32)Sections;
+			Ar << SectionBits;
+			Sections = (EMeshCacheSections)SectionBits;
+			Ar << NumVertices;
+			Ar << NumTriangles;
+			Ar << NumNormals;
+			Ar << NumUVs;
+			if (Ar.IsLoading())
+			{
+				// sanity-check the counts against the remaining file size before allocating anything
+				int64 MinBytes = (int64)NumVertices * sizeof(FVector3d) + (int64)NumTriangles * sizeof(FIndex3i);
+				if (EnumHasAnyFlags(Sections, EMeshCacheSections::VertexColors))
+				{
+					MinBytes += (int64)NumVertices * sizeof(FVector3f);
+				}
+				if (EnumHasAnyFlags(Sections, EMeshCacheSections::TriangleGroups))
+				{
+					MinBytes += (int64)NumTriangles * sizeof(int32);
+				}
+				if (EnumHasAnyFlags(Sections, EMeshCacheSections::Attributes))
+				{
+					MinBytes += (int64)NumNormals * sizeof(FVector3f) + (int64)NumUVs * sizeof(FVector2f) + 2 * (int64)NumTriangles * sizeof(FIndex3i);
+				}
+				if (NumVertices < 0 || NumTriangles < 0 || NumNormals < 0 || NumUVs < 0 || MinBytes > Ar.TotalSize() - Ar.Tell())
+				{
+					Ar.SetError();
+					return;
+				}
+			}
+
+			SerializeArray(Ar, Positions, NumVertices);
+			SerializeArray(Ar, Triangles, NumTriangles);
+			if (EnumHasAnyFlags(Sections, EMeshCacheSections::VertexColors))
+			{
+				SerializeArray(Ar, Colors, NumVertices);
+			}
+			if (EnumHasAnyFlags(Sections, EMeshCacheSections::TriangleGroups))
+			{
+				SerializeArray(Ar, Groups, NumTriangles);
+			}
+			if (EnumHasAnyFlags(Sections, EMeshCacheSections::Attributes))
+			{
+				SerializeArray(Ar, NormalElements, NumNormals);
+				SerializeArray(Ar, NormalTriangles, NumTriangles);
+				SerializeArray(Ar, UVElements, NumUVs);
+				SerializeArray(Ar, UVTriangles, NumTriangles);
+			}
+		}
+
+		/** Gather the arrays from a compact mesh */
+		void InitializeFromMesh(const FDynamicMesh3& Mesh)
+		{
+			NumVertices = Mesh.MaxVertexID();
+			NumTriangles = Mesh.MaxTriangleID();
+			Sections = EMeshCacheSections::None;
+
+			Positions.SetNumUninitialized(NumVertices);
+			ParallelFor(NumVertices, [&](int32 vid)
+			{
+				Positions[vid] = Mesh.GetVertex(vid);
+			});
+			Triangles.SetNumUninitialized(NumTriangles);
+			ParallelFor(NumTriangles, [&](int32 tid)
+			{
+				Triangles[tid] = Mesh.GetTriangle(tid);
+			});
+
+			if (Mesh.HasVertexColors())
+			{
+				Sections |= EMeshCacheSections::VertexColors;
+				Colors.SetNumUninitialized(NumVertices);
+				ParallelFor(NumVertices, [&](int32 vid)
+				{
+					Colors[vid] = Mesh.GetVertexColor(vid);
+				});
+			}
+			if (Mesh.HasTriangleGroups())
+			{
+				Sections |= EMeshCacheSections::TriangleGroups;
+				Groups.SetNumUninitialized(NumTriangles);
+				ParallelFor(NumTriangles, [&](int32 tid)
+				{
+					Groups[tid] = Mesh.GetTriangleGroup(tid);
+				});
+			}
+			if (Mesh.HasAttributes())
+			{
+				Sections |= EMeshCacheSections::Attributes;
+				const FDynamicMeshNormalOverlay* Normals = Mesh.Attributes()->PrimaryNormals();
+				const FDynamicMeshUVOverlay* UVs = Mesh.Attributes()->PrimaryUV();
+				NumNormals = Normals->MaxElementID();
+				NumUVs = UVs->MaxElementID();
+				NormalElements.SetNumUninitialized(NumNormals);
+				UVElements.SetNumUninitialized(NumUVs);
+				NormalTriangles.SetNumUninitialized(NumTriangles);
+				UVTriangles.SetNumUninitialized(NumTriangles);
+				ParallelFor(NumNormals, [&](int32 eid)
+				{
+					NormalElements[eid] = Normals->GetElement(eid);
+				});
+				ParallelFor(NumUVs, [&](int32 eid)
+				{
+					UVElements[eid] = UVs->GetElement(eid);
+				});
+				ParallelFor(NumTriangles, [&](int32 tid)
+				{
+					NormalTriangles[tid] = Normals->IsSetTriangle(tid) ? Normals->GetTriangle(tid) : FIndex3i::Invalid();
+					UVTriangles[tid] = UVs->IsSetTriangle(tid) ? UVs->GetTriangle(tid) : FIndex3i::Invalid();
+				});
+			}
+		}
+
+		/** Build a mesh from the arrays. @return false if the data is inconsistent */
+		bool BuildMesh(FDynamicMesh3& Mesh) const
+		{
+			for (int32 vid = 0; vid < NumVertices; ++vid)
+			{
+				Mesh.AppendVertex(Positions[vid]);
+			}
+			if (EnumHasAnyFlags(Sections, EMeshCacheSections::VertexColors))
+			{
+				Mesh.EnableVertexColors(FVector3f::Zero());
+				for (int32 vid = 0; vid < NumVertices; ++vid)
+				{
+					Mesh.SetVertexColor(vid, Colors[vid]);
+				}
+			}
+
+			bool bHaveGroups = EnumHasAnyFlags(Sections, EMeshCacheSections::TriangleGroups);
+			if (bHaveGroups)
+			{
+				Mesh.EnableTriangleGroups();
+			}
+			for (int32 tid = 0; tid < NumTriangles; ++tid)
+			{
+				if (Mesh.AppendTriangle(Triangles[tid], (bHaveGroups) ? Groups[tid] : 0) != tid)
+				{
+					return false;
+				}
+			}
+
+			if (EnumHasAnyFlags(Sections, EMeshCacheSections::Attributes))
+			{
+				Mesh.EnableAttributes();
+				FDynamicMeshNormalOverlay* Normals = Mesh.Attributes()->PrimaryNormals();
+				FDynamicMeshUVOverlay* UVs = Mesh.Attributes()->PrimaryUV();
+				for (const FVector3f& Normal : NormalElements)
+				{
+					Normals->AppendElement(Normal);
+				}
+				for (const FVector2f& UV : UVElements)
+				{
+					UVs->AppendElement(UV);
+				}
+				for (int32 tid = 0; tid < NumTriangles; ++tid)
+				{
+					const FIndex3i& NormalTri = NormalTriangles[tid];
+					if (Normals->IsElement(NormalTri.A) && Normals->IsElement(NormalTri.B) && Normals->IsElement(NormalTri.C))
+					{
+						Normals->SetTriangle(tid, NormalTri);
+					}
+					const FIndex3i& UVTri = UVTriangles[tid];
+					if (UVs->IsElement(UVTri.A) && UVs->IsElement(UVTri.B) && UVs->IsElement(UVTri.C))
+					{
+						UVs->SetTriangle(tid, UVTri);
+					}
+				}
+			}
+			return true;
+		}
+	};
+
+
+	static bool IsCompactMesh(const FDynamicMesh3& Mesh)
+	{
+		if (Mesh.IsCompact() == false)
+		{
+			return false;
+		}
+		if (Mesh.HasAttributes())
+		{
+			const FDynamicMeshNormalOverlay* Normals = Mesh.Attributes()->PrimaryNormals();
+			const FDynamicMeshUVOverlay* UVs = Mesh.Attributes()->PrimaryUV();
+			return Normals->ElementCount() == Normals->MaxElementID() && UVs->ElementCount() == UVs->MaxElementID();
+		}
+		return true;
+	}
+
+
+	static bool WriteMeshCacheWithKey(const FString& SourcePath, FMeshCacheKey& Key, const FDynamicMesh3& MeshIn)
+	{
+		// the cache layout uses dense IDs
+		const FDynamicMesh3* Mesh = &MeshIn;
+		FDynamicMesh3 CompactMesh;
+		if (IsCompactMesh(MeshIn) == false)
+		{
+			CompactMesh.CompactCopy(MeshIn);
+			Mesh = &CompactMesh;
+		}
+
+		FMeshCacheData Data;
+		Data.InitializeFromMesh(*Mesh);
+
+		// write to a temporary file and then move it into place, so a partially-written cache is never read. The temporary
+		// file is unique (in the same directory, so the move is a rename), as several imports may write the same cache at once.
+		FString CachePath = RTGUtils::GetMeshCachePath(SourcePath);
+		FString TempPath = FPaths::CreateTempFilename(*FPaths::GetPath(CachePath), *(FPaths::GetCleanFilename(CachePath) + TEXT("-")), TEXT(".tmp"));
+		{
+			TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*TempPath));
+			if (!Writer)
+			{
+				return false;
+			}
+			uint32 Magic = MeshCacheMagic;
+			uint32 Version = MeshCacheVersion;
+			*Writer << Magic;
+			*Writer << Version;
+			Key.Serialize(*Writer);
+			Data.Serialize(*Writer);
+			if (Writer->Close() == false)
+			{
+				IFileManager::Get().Delete(*TempPath);
+				return false;
+			}
+		}
+		return IFileManager::Get().Move(*CachePath, *TempPath, true, true);
+	}
+}
+
+
+
+FString RTGUtils::GetMeshCachePath(const FString& SourcePath)
+{
+	return SourcePath + TEXT(".rtgmesh");
+}
+
+
+
+bool RTGUtils::WriteMeshCache(
+	const FString& SourcePath,
+	const FDynamicMesh3& Mesh,
+	EMeshCacheImportFlags ImportFlags)
+{
+	using namespace MeshCacheLocals;
+
+	FMeshCacheKey Key;
+	if (GetSourceKey(SourcePath, ImportFlags, true, Key) == false)
+	{
+		return false;
+	}
+	return WriteMeshCacheWithKey(SourcePath, Key, Mesh);
+}
+
+
+
+bool RTGUtils::ReadMeshCache(
+	const FString& SourcePath,
+	FDynamicMesh3& MeshOut,
+	EMeshCacheImportFlags ImportFlags)
+{
+	using namespace MeshCacheLocals;
+
+	FString CachePath = GetMeshCachePath(SourcePath);
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*CachePath));
+	if (!Reader)
+	{
+		return false;
+	}
+
+	uint32 Magic = 0, Version = 0;
+	*Reader << Magic;
+	*Reader << Version;
+	if (Reader->IsError() || Magic != MeshCacheMagic || Version != MeshCacheVersion)
+	{
+		return false;
+	}
+
+	FMeshCacheKey CachedKey, CurrentKey;
+	CachedKey.Serialize(*Reader);
+	if (Reader->IsError() || GetSourceKey(SourcePath, ImportFlags, false, CurrentKey) == false)
+	{
+		return false;
+	}
+	if (CachedKey.SourcePath != CurrentKey.SourcePath
+		|| CachedKey.SourceSize != CurrentKey.SourceSize
+		|| CachedKey.ImportFlags != CurrentKey.ImportFlags)
+	{
+		return false;
+	}
+
+	// if the file was touched but not modified, the content hash still matches and the cache can be used
+	bool bRewriteKey = false;
+	if (CachedKey.SourceTimestamp != CurrentKey.SourceTimestamp)
+	{
+		if (ComputeContentHash(SourcePath, CurrentKey.SourceSize, CurrentKey.SourceHash) == false
+			|| CurrentKey.SourceHash != CachedKey.SourceHash)
+		{
+			return false;
+		}
+		bRewriteKey = true;
+	}
+
+	FMeshCacheData Data;
+	Data.Serialize(*Reader);
+	if (Reader->IsError())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Mesh cache %s is corrupt, ignoring it"), *CachePath);
+		return false;
+	}
+	Reader.Reset();
+
+	FDynamicMesh3 CachedMesh;
+	if (Data.BuildMesh(CachedMesh) == false)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Mesh cache %s is corrupt, ignoring it"), *CachePath);
+		return false;
+	}
+	MeshOut = MoveTemp(CachedMesh);
+
+	if (bRewriteKey)
+	{
+		WriteMeshCacheWithKey(SourcePath, CurrentKey, MeshOut);
+	}
+	return true;
+}
+
+
+
+bool RTGUtils::ReadOBJMeshCached(
+	const FString& Path,
+	FDynamicMesh3& MeshOut,
+	bool bNormals,
+	bool bTexCoords,
+	bool bVertexColors,
+	bool bReverseOrientation,
+	const FOBJReadProgressFunc& ProgressFunc)
+{
+	EMeshCacheImportFlags ImportFlags = EMeshCacheImportFlags::None;
+	ImportFlags |= (bNormals) ? EMeshCacheImportFlags::Normals : EMeshCacheImportFlags::None;
+	ImportFlags |= (bTexCoords) ? EMeshCacheImportFlags::TexCoords : EMeshCacheImportFlags::None;
+	ImportFlags |= (bVertexColors) ? EMeshCacheImportFlags::VertexColors : EMeshCacheImportFlags::None;
+	ImportFlags |= (bReverseOrientation) ? EMeshCacheImportFlags::ReverseOrientation : EMeshCacheImportFlags::None;
+
+	if (ReadMeshCache(Path, MeshOut, ImportFlags))
+	{
+		return true;
+	}
+
+	if (ReadOBJMesh(Path, MeshOut, bNormals, bTexCoords, bVertexColors, bReverseOrientation, ProgressFunc) == false)
+	{
+		return false;
+	}
+
+	if (WriteMeshCache(Path, MeshOut, ImportFlags) == false)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Could not write mesh cache %s"), *GetMeshCachePath(Path));
+	}
+	return true;
+}
@@ -1,9 +1,16 @@
 #include "DynamicMeshOBJReader.h"
 #include "DynamicMeshAttributeSet.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
 #include "tinyobj/tiny_obj_loader.h"
 
+#include <cmath>
 
-bool RTGUtils::ReadOBJMesh(
+
+bool RTGUtils::ReadOBJMesh_TinyOBJ(
 	const FString& Path,
 	FDynamicMesh3& MeshOut,
 	bool bNormals,
@@ -33,6 +40,9 @@ bool RTGUtils::ReadOBJMesh(
 		return false;
 	}
 
+	// face indices are relative to the file, so replace any existing mesh
+	MeshOut.Clear();
+
 	// append vertices
 	for (size_t vi = 0; vi < attrib.vertices.size() / 3; ++vi)
 	{
@@ -131,4 +141,1227 @@ bool RTGUtils::ReadOBJMesh(
 	}
 
 	return true;
-}
\ No newline at end of file
+}
+
+
+
+/*
+ * Multithreaded chunked OBJ parser.
+ *
+ * The parsing rules below intentionally mirror tinyobj (number parsing, index fixup, polygon
+ * triangulation, default vertex colors) so that ReadOBJMesh_Parallel() and ReadOBJMesh_TinyOBJ()
+ * produce identical meshes. Only the records that contribute to the FDynamicMesh3 (v/vn/vt/f) are parsed.
+ */
+namespace OBJReaderLocals
+{
+	static FORCEINLINE bool IsSpace(char C) { return C == ' ' || C == '\t'; }
+	static FORCEINLINE bool IsDigit(char C) { return C >= '0' && C <= '9'; }
+	static FORCEINLINE bool IsLineBreak(char C) { return C == '\n' || C == '\r'; }
+
+	/** Skip spaces and tabs (strspn(" \t")) */
+	static FORCEINLINE const char* SkipSpaces(const char* Cur, const char* End)
+	{
+		while (Cur < End && IsSpace(*Cur))
+		{
+			Cur++;
+		}
+		return Cur;
+	}
+
+	/** Skip spaces, tabs and carriage returns (strspn(" \t\r")) */
+	static FORCEINLINE const char* SkipSeparators(const char* Cur, const char* End)
+	{
+		while (Cur < End && (IsSpace(*Cur) || *Cur == '\r'))
+		{
+			Cur++;
+		}
+		return Cur;
+	}
+
+	/** Find end of a numeric token (strcspn(" \t\r")) */
+	static FORCEINLINE const char* FindTokenEnd(const char* Cur, const char* End)
+	{
+		while (Cur < End && !IsSpace(*Cur) && *Cur != '\r')
+		{
+			Cur++;
+		}
+		return Cur;
+	}
+
+	/** Find end of a face-index token (strcspn("/ \t\r")) */
+	static FORCEINLINE const char* FindIndexEnd(const char* Cur, const char* End)
+	{
+		while (Cur < End && *Cur != '/' && !IsSpace(*Cur) && *Cur != '\r')
+		{
+			Cur++;
+		}
+		return Cur;
+	}
+
+
+	/**
+	 * Port of tinyobj::tryParseDouble(). This is deliberately not strtod(), the result must
+	 * round exactly the way tinyobj does so that both readers produce bit-identical positions.
+	 */
+	static bool TryParseDouble(const char* S, const char* SEnd, double& ResultOut)
+	{
+		if (S >= SEnd)
+		{
+			return false;
+		}
+
+		double Mantissa = 0.0;
+		int Exponent = 0;
+		char Sign = '+';
+		char ExpSign = '+';
+		const char* Cur = S;
+		int Read = 0;
+		bool bEndNotReached = false;
+		bool bLeadingDecimalDots = false;
+
+		if (*Cur == '+' || *Cur == '-')
+		{
+			Sign = *Cur;
+			Cur++;
+			if (Cur != SEnd && *Cur == '.')
+			{
+				bLeadingDecimalDots = true;
+			}
+		}
+		else if (IsDigit(*Cur))
+		{
+		}
+		else if (*Cur == '.')
+		{
+			bLeadingDecimalDots = true;
+		}
+		else
+		{
+			return false;
+		}
+
+		// integer part
+		bEndNotReached = (Cur != SEnd);
+		if (!bLeadingDecimalDots)
+		{
+			while (bEndNotReached && IsDigit(*Cur))
+			{
+				Mantissa *= 10;
+				Mantissa += static_cast<int>(*Cur - 0x30);
+				Cur++;
+				Read++;
+				bEndNotReached = (Cur != SEnd);
+			}
+			if (Read == 0)
+			{
+				return false;
+			}
+		}
+
+		if (bEndNotReached)
+		{
+			bool bParseExponent = true;
+
+			// decimal part
+			if (*Cur == '.')
+			{
+				static const double PowLUT[] = { 1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001 };
+				const int LUTEntries = sizeof(PowLUT) / sizeof(PowLUT[0]);
+
+				Cur++;
+				Read = 1;
+				bEndNotReached = (Cur != SEnd);
+				while (bEndNotReached && IsDigit(*Cur))
+				{
+					Mantissa += static_cast<int>(*Cur - 0x30) * (Read < LUTEntries ? PowLUT[Read] : std::pow(10.0, -Read));
+					Read++;
+					Cur++;
+					bEndNotReached = (Cur != SEnd);
+				}
+			}
+			else if (*Cur != 'e' && *Cur != 'E')
+			{
+				bParseExponent = false;
+			}
+
+			// exponent part
+			if (bParseExponent && bEndNotReached && (*Cur == 'e' || *Cur == 'E'))
+			{
+				Cur++;
+				bEndNotReached = (Cur != SEnd);
+				if (bEndNotReached && (*Cur == '+' || *Cur == '-'))
+				{
+					ExpSign = *Cur;
+					Cur++;
+				}
+				else if (!bEndNotReached || !IsDigit(*Cur))
+				{
+					return false;
+				}
+
+				Read = 0;
+				bEndNotReached = (Cur != SEnd);
+				while (bEndNotReached && IsDigit(*Cur))
+				{
+					Exponent *= 10;
+					Exponent += static_cast<int>(*Cur - 0x30);
+					Cur++;
+					Read++;
+					bEndNotReached = (Cur != SEnd);
+				}
+				Exponent *= (ExpSign == '+' ? 1 : -1);
+				if (Read == 0)
+				{
+					return false;
+				}
+			}
+		}
+
+		ResultOut = (Sign == '+' ? 1 : -1) *
+			(Exponent ? std::ldexp(Mantissa * std::pow(5.0, Exponent), Exponent) : Mantissa);
+		return true;
+	}
+
+	/** tinyobj::parseReal() with a default value */
+	static FORCEINLINE float ParseReal(const char*& Token, const char* LineEnd, double DefaultValue = 0.0)
+	{
+		Token = SkipSpaces(Token, LineEnd);
+		const char* TokenEnd = FindTokenEnd(Token, LineEnd);
+		double Value = DefaultValue;
+		TryParseDouble(Token, TokenEnd, Value);
+		Token = TokenEnd;
+		return static_cast<float>(Value);
+	}
+
+	/** tinyobj::parseReal() that reports failure */
+	static FORCEINLINE bool ParseReal(const char*& Token, const char* LineEnd, float& ValueOut)
+	{
+		Token = SkipSpaces(Token, LineEnd);
+		const char* TokenEnd = FindTokenEnd(Token, LineEnd);
+		double Value;
+		bool bOK = TryParseDouble(Token, TokenEnd, Value);
+		if (bOK)
+		{
+			ValueOut = static_cast<float>(Value);
+		}
+		Token = TokenEnd;
+		return bOK;
+	}
+
+	/** Equivalent of atoi() on a line that is not null-terminated */
+	static FORCEINLINE int32 ParseInt(const char* Token, const char* LineEnd)
+	{
+		while (Token < LineEnd && (IsSpace(*Token) || *Token == '\v' || *Token == '\f'))
+		{
+			Token++;
+		}
+		bool bNegative = false;
+		if (Token < LineEnd && (*Token == '+' || *Token == '-'))
+		{
+			bNegative = (*Token == '-');
+			Token++;
+		}
+		int64 Value = 0;
+		while (Token < LineEnd && IsDigit(*Token))
+		{
+			Value = Value * 10 + (*Token - '0');
+			Token++;
+		}
+		return (int32)(bNegative ? -Value : Value);
+	}
+
+
+	/** One corner of an OBJ face. Indices are 0-based, or -1 if not specified. */
+	struct FOBJCorner
+	{
+		int32 V = -1;
+		int32 VT = -1;
+		int32 VN = -1;
+	};
+
+	enum EOBJRelativeIndex : uint8
+	{
+		RelativeV = 1,
+		RelativeVT = 2,
+		RelativeVN = 4
+	};
+
+	/** Parse output for one line-aligned chunk of the file */
+	struct FOBJChunk
+	{
+		const char* Begin = nullptr;
+		const char* End = nullptr;
+
+		TArray<float> Positions;		// xyz
+		TArray<float> Colors;			// rgb, always one per position (white if not specified, as in tinyobj)
+		TArray<float> Normals;			// xyz
+		TArray<float> TexCoords;		// uv
+
+		TArray<FOBJCorner> Corners;
+		TArray<int32> FaceSizes;
+
+		/** Negative OBJ indices are relative to the number of elements seen so far. Here they are first
+		 * resolved against the chunk-local counts, these are (CornerIndex, EOBJRelativeIndex flags) pairs
+		 * that must be offset by the global counts of the preceding chunks. */
+		TArray<TPair<int32, uint8>> RelativeCorners;
+
+		/** Triangulated faces, 3 corners per triangle, filled in after all chunks have been parsed */
+		TArray<FOBJCorner> Triangles;
+
+		bool bFailed = false;
+
+		int32 NumPositions() const { return Positions.Num() / 3; }
+		int32 NumNormals() const { return Normals.Num() / 3; }
+		int32 NumTexCoords() const { return TexCoords.Num() / 2; }
+	};
+
+
+	/** tinyobj::fixIndex(), except that negative indices are resolved against chunk-local counts and flagged */
+	static FORCEINLINE bool FixIndex(int32 Index, int32 LocalCount, int32& IndexOut, uint8& RelativeFlags, uint8 RelativeFlag)
+	{
+		if (Index > 0)
+		{
+			IndexOut = Index - 1;
+			return true;
+		}
+		if (Index == 0)
+		{
+			return false;	// zero is not allowed by the spec
+		}
+		IndexOut = LocalCount + Index;
+		RelativeFlags |= RelativeFlag;
+		return true;
+	}
+
+	/**
+	 * tinyobj::parseTriple(), parses i, i/j, i//k or i/j/k.
+	 * Negative indices are resolved against the given element counts (NumV,NumVT,NumVN) and flagged in RelativeFlags.
+	 */
+	static bool ParseTriple(const char*& Token, const char* LineEnd, int32 NumV, int32 NumVT, int32 NumVN, FOBJCorner& CornerOut, uint8& RelativeFlags)
+	{
+		if (!FixIndex(ParseInt(Token, LineEnd), NumV, CornerOut.V, RelativeFlags, RelativeV))
+		{
+			return false;
+		}
+		Token = FindIndexEnd(Token, LineEnd);
+		if (Token >= LineEnd || *Token != '/')
+		{
+			return true;
+		}
+		Token++;
+
+		// i//k
+		if (Token < LineEnd && *Token == '/')
+		{
+			Token++;
+			if (!FixIndex(ParseInt(Token, LineEnd), NumVN, CornerOut.VN, RelativeFlags, RelativeVN))
+			{
+				return false;
+			}
+			Token = FindIndexEnd(Token, LineEnd);
+			return true;
+		}
+
+		// i/j/k or i/j
+		if (!FixIndex(ParseInt(Token, LineEnd), NumVT, CornerOut.VT, RelativeFlags, RelativeVT))
+		{
+			return false;
+		}
+		Token = FindIndexEnd(Token, LineEnd);
+		if (Token >= LineEnd || *Token != '/')
+		{
+			return true;
+		}
+		Token++;
+		if (!FixIndex(ParseInt(Token, LineEnd), NumVN, CornerOut.VN, RelativeFlags, RelativeVN))
+		{
+			return false;
+		}
+		Token = FindIndexEnd(Token, LineEnd);
+		return true;
+	}
+
+
+	/** OBJ record types that contribute to the FDynamicMesh3 */
+	enum class EOBJRecord : uint8
+	{
+		Ignored,
+		Vertex,
+		Normal,
+		TexCoord,
+		Face
+	};
+
+	/**
+	 * Determine the record type of the line [LineStart,LineEnd).
+	 * TokenOut is set to the first character after the record keyword.
+	 */
+	static FORCEINLINE EOBJRecord ClassifyLine(const char* LineStart, const char* LineEnd, const char*& TokenOut)
+	{
+		const char* Token = SkipSpaces(LineStart, LineEnd);
+		int64 Length = LineEnd - Token;
+		if (Length < 2)
+		{
+			return EOBJRecord::Ignored;
+		}
+		if (Token[0] == 'v')
+		{
+			if (IsSpace(Token[1]))
+			{
+				TokenOut = Token + 2;
+				return EOBJRecord::Vertex;
+			}
+			if (Length > 2 && IsSpace(Token[2]))
+			{
+				TokenOut = Token + 3;
+				return (Token[1] == 'n') ? EOBJRecord::Normal : (Token[1] == 't') ? EOBJRecord::TexCoord : EOBJRecord::Ignored;
+			}
+		}
+		else if (Token[0] == 'f' && IsSpace(Token[1]))
+		{
+			TokenOut = SkipSpaces(Token + 2, LineEnd);
+			return EOBJRecord::Face;
+		}
+		// everything else (comments, groups, materials, smoothing groups, lines, points, ...) does not affect the FDynamicMesh3
+		return EOBJRecord::Ignored;
+	}
+
+	/** tinyobj::parseVertexWithColor(), colors default to white if not all three are present */
+	static FORCEINLINE void ParseVertex(const char* Token, const char* LineEnd, float* PositionOut, float* ColorOut)
+	{
+		PositionOut[0] = ParseReal(Token, LineEnd);
+		PositionOut[1] = ParseReal(Token, LineEnd);
+		PositionOut[2] = ParseReal(Token, LineEnd);
+		bool bFoundColor = ParseReal(Token, LineEnd, ColorOut[0]) && ParseReal(Token, LineEnd, ColorOut[1]) && ParseReal(Token, LineEnd, ColorOut[2]);
+		if (!bFoundColor)
+		{
+			ColorOut[0] = ColorOut[1] = ColorOut[2] = 1.0f;
+		}
+	}
+
+	/** Parse all corners of a face line, calling CornerFunc(Corner, RelativeFlags) for each. @return false on a parse error */
+	template<typename CornerFuncType>
+	static FORCEINLINE bool ParseFace(const char* Token, const char* LineEnd, int32 NumV, int32 NumVT, int32 NumVN, CornerFuncType CornerFunc)
+	{
+		while (Token < LineEnd)
+		{
+			FOBJCorner Corner;
+			uint8 RelativeFlags = 0;
+			if (!ParseTriple(Token, LineEnd, NumV, NumVT, NumVN, Corner, RelativeFlags))
+			{
+				return false;
+			}
+			CornerFunc(Corner, RelativeFlags);
+			Token = SkipSeparators(Token, LineEnd);
+		}
+		return true;
+	}
+
+	/** Call LineFunc(LineStart, LineEnd) for each line in [Begin,End). Stops and returns false if LineFunc returns false. */
+	template<typename LineFuncType>
+	static FORCEINLINE bool ForEachLine(const char* Begin, const char* End, LineFuncType LineFunc)
+	{
+		const char* Cur = Begin;
+		while (Cur < End)
+		{
+			const char* LineEnd = Cur;
+			while (LineEnd < End && !IsLineBreak(*LineEnd))
+			{
+				LineEnd++;
+			}
+			if (!LineFunc(Cur, LineEnd))
+			{
+				return false;
+			}
+			Cur = LineEnd + 1;		// "\r\n" produces an empty line, which is skipped
+		}
+		return true;
+	}
+
+
+	/** Parse one line [LineStart,LineEnd) into Chunk. @return false on a parse error */
+	static bool ParseLine(FOBJChunk& Chunk, const char* LineStart, const char* LineEnd)
+	{
+		const char* Token = nullptr;
+		switch (ClassifyLine(LineStart, LineEnd, Token))
+		{
+		case EOBJRecord::Vertex:
+		{
+			float Position[3], Color[3];
+			ParseVertex(Token, LineEnd, Position, Color);
+			Chunk.Positions.Append(Position, 3);
+			Chunk.Colors.Append(Color, 3);
+			return true;
+		}
+		case EOBJRecord::Normal:
+			Chunk.Normals.Add(ParseReal(Token, LineEnd));
+			Chunk.Normals.Add(ParseReal(Token, LineEnd));
+			Chunk.Normals.Add(ParseReal(Token, LineEnd));
+			return true;
+		case EOBJRecord::TexCoord:
+			Chunk.TexCoords.Add(ParseReal(Token, LineEnd));
+			Chunk.TexCoords.Add(ParseReal(Token, LineEnd));
+			return true;
+		case EOBJRecord::Face:
+		{
+			int32 NumCorners = 0;
+			bool bOK = ParseFace(Token, LineEnd, Chunk.NumPositions(), Chunk.NumTexCoords(), Chunk.NumNormals(),
+				[&Chunk, &NumCorners](const FOBJCorner& Corner, uint8 RelativeFlags)
+			{
+				if (RelativeFlags != 0)
+				{
+					Chunk.RelativeCorners.Add(TPair<int32, uint8>(Chunk.Corners.Num(), RelativeFlags));
+				}
+				Chunk.Corners.Add(Corner);
+				NumCorners++;
+			});
+			Chunk.FaceSizes.Add(NumCorners);
+			return bOK;
+		}
+		default:
+			return true;
+		}
+	}
+
+
+	static void ParseChunk(FOBJChunk& Chunk)
+	{
+		Chunk.bFailed = !ForEachLine(Chunk.Begin, Chunk.End, [&Chunk](const char* LineStart, const char* LineEnd)
+		{
+			return ParseLine(Chunk, LineStart, LineEnd);
+		});
+	}
+
+
+	/** Split [Begin,End) into NumChunks ranges that each end just after a line break */
+	static void SplitIntoChunks(const char* Begin, const char* End, int32 NumChunks, TArray<FOBJChunk>& ChunksOut)
+	{
+		int64 TargetSize = FMath::Max<int64>(1, (End - Begin) / NumChunks);
+		const char* Cur = Begin;
+		while (Cur < End)
+		{
+			const char* ChunkEnd = (End - Cur > TargetSize) ? (Cur + TargetSize) : End;
+			while (ChunkEnd < End && !IsLineBreak(*(ChunkEnd - 1)))
+			{
+				ChunkEnd++;
+			}
+			FOBJChunk& Chunk = ChunksOut.AddDefaulted_GetRef();
+			Chunk.Begin = Cur;
+			Chunk.End = ChunkEnd;
+			Cur = ChunkEnd;
+		}
+	}
+
+
+	/** Counts the chunk steps completed by a chunked read, and reports them to the progress callback */
+	struct FOBJReadProgress
+	{
+		const RTGUtils::FOBJReadProgressFunc& ProgressFunc;
+		int32 TotalSteps;
+		TAtomic<int32> CompletedSteps { 0 };
+		TAtomic<bool> bCancelled { false };
+
+		FOBJReadProgress(const RTGUtils::FOBJReadProgressFunc& ProgressFuncIn, int32 TotalStepsIn)
+			: ProgressFunc(ProgressFuncIn), TotalSteps(FMath::Max(TotalStepsIn, 1))
+		{
+		}
+
+		bool IsCancelled() const { return bCancelled; }
+
+		/** Called from the worker threads after each chunk step */
+		void CompleteStep()
+		{
+			int32 Completed = ++CompletedSteps;
+			if (ProgressFunc && ProgressFunc((float)Completed / (float)TotalSteps) == false)
+			{
+				bCancelled = true;
+			}
+		}
+	};
+
+
+	/** pnpoly point-in-polygon test, as used by tinyobj triangulation */
+	static bool PointInTriangle2(const float* VertX, const float* VertY, float TestX, float TestY)
+	{
+		bool bInside = false;
+		for (int32 i = 0, j = 2; i < 3; j = i++)
+		{
+			if (((VertY[i] > TestY) != (VertY[j] > TestY)) &&
+				(TestX < (VertX[j] - VertX[i]) * (TestY - VertY[i]) / (VertY[j] - VertY[i]) + VertX[i]))
+			{
+				bInside = !bInside;
+			}
+		}
+		return bInside;
+	}
+
+	/**
+	 * Triangulate an OBJ face into TrianglesOut. This is a port of the ear-clipping in
+	 * tinyobj's exportGroupsToShape() (triangulate=true), so polygons are split identically.
+	 * Positions are read back from Mesh, where they were stored as exactly-converted floats.
+	 */
+	static void TriangulateFace(const FOBJCorner* Face, int32 NumCorners, const FDynamicMesh3& Mesh, TArray<FOBJCorner>& TrianglesOut)
+	{
+		if (NumCorners < 3)
+		{
+			return;
+		}
+		if (NumCorners == 3)
+		{
+			TrianglesOut.Add(Face[0]);
+			TrianglesOut.Add(Face[1]);
+			TrianglesOut.Add(Face[2]);
+			return;
+		}
+
+		const int32 NumV = Mesh.MaxVertexID();
+		auto IsValidV = [NumV](int32 vi) { return vi >= 0 && vi < NumV; };
+		auto GetCoord = [&Mesh](int32 vi, int32 Axis) { return (float)Mesh.GetVertex(vi)[Axis]; };
+
+		// find the two axes to work in
+		int32 Axes[2] = { 1, 2 };
+		for (int32 k = 0; k < NumCorners; ++k)
+		{
+			int32 vi0 = Face[(k + 0) % NumCorners].V;
+			int32 vi1 = Face[(k + 1) % NumCorners].V;
+			int32 vi2 = Face[(k + 2) % NumCorners].V;
+			if (!IsValidV(vi0) || !IsValidV(vi1) || !IsValidV(vi2))
+			{
+				continue;
+			}
+			float e0x = GetCoord(vi1, 0) - GetCoord(vi0, 0);
+			float e0y = GetCoord(vi1, 1) - GetCoord(vi0, 1);
+			float e0z = GetCoord(vi1, 2) - GetCoord(vi0, 2);
+			float e1x = GetCoord(vi2, 0) - GetCoord(vi1, 0);
+			float e1y = GetCoord(vi2, 1) - GetCoord(vi1, 1);
+			float e1z = GetCoord(vi2, 2) - GetCoord(vi1, 2);
+			float cx = std::fabs(e0y * e1z - e0z * e1y);
+			float cy = std::fabs(e0z * e1x - e0x * e1z);
+			float cz = std::fabs(e0x * e1y - e0y * e1x);
+			if (cx > FLT_EPSILON || cy > FLT_EPSILON || cz > FLT_EPSILON)
+			{
+				if (!(cx > cy && cx > cz))
+				{
+					Axes[0] = 0;
+					if (cz > cx && cz > cy)
+					{
+						Axes[1] = 1;
+					}
+				}
+				break;
+			}
+		}
+
+		float Area = 0;
+		for (int32 k = 0; k < NumCorners; ++k)
+		{
+			int32 vi0 = Face[(k + 0) % NumCorners].V;
+			int32 vi1 = Face[(k + 1) % NumCorners].V;
+			if (!IsValidV(vi0) || !IsValidV(vi1))
+			{
+				continue;
+			}
+			Area += (GetCoord(vi0, Axes[0]) * GetCoord(vi1, Axes[1]) - GetCoord(vi0, Axes[1]) * GetCoord(vi1, Axes[0])) * 0.5f;
+		}
+
+		TArray<FOBJCorner, TInlineAllocator<16>> Remaining;
+		Remaining.Append(Face, NumCorners);
+		int32 GuessVert = 0;
+		FOBJCorner Ind[3];
+		float VX[3], VY[3];
+
+		int32 RemainingIterations = NumCorners;
+		int32 PreviousRemainingVertices = NumCorners;
+		while (Remaining.Num() > 3 && RemainingIterations > 0)
+		{
+			int32 NumPoly = Remaining.Num();
+			if (GuessVert >= NumPoly)
+			{
+				GuessVert -= NumPoly;
+			}
+
+			if (PreviousRemainingVertices != NumPoly)
+			{
+				PreviousRemainingVertices = NumPoly;
+				RemainingIterations = NumPoly;
+			}
+			else
+			{
+				RemainingIterations--;
+			}
+
+			for (int32 k = 0; k < 3; k++)
+			{
+				Ind[k] = Remaining[(GuessVert + k) % NumPoly];
+				bool bValid = IsValidV(Ind[k].V);
+				VX[k] = bValid ? GetCoord(Ind[k].V, Axes[0]) : 0.0f;
+				VY[k] = bValid ? GetCoord(Ind[k].V, Axes[1]) : 0.0f;
+			}
+			float e0x = VX[1] - VX[0];
+			float e0y = VY[1] - VY[0];
+			float e1x = VX[2] - VX[1];
+			float e1y = VY[2] - VY[1];
+			float Cross = e0x * e1y - e0y * e1x;
+			// if an internal angle
+			if (Cross * Area < 0.0f)
+			{
+				GuessVert += 1;
+				continue;
+			}
+
+			// check all other verts in case they are inside this triangle
+			bool bOverlap = false;
+			for (int32 OtherVert = 3; OtherVert < NumPoly; ++OtherVert)
+			{
+				int32 OtherV = Remaining[(GuessVert + OtherVert) % NumPoly].V;
+				if (!IsValidV(OtherV))
+				{
+					continue;
+				}
+				if (PointInTriangle2(VX, VY, GetCoord(OtherV, Axes[0]), GetCoord(OtherV, Axes[1])))
+				{
+					bOverlap = true;
+					break;
+				}
+			}
+			if (bOverlap)
+			{
+				GuessVert += 1;
+				continue;
+			}
+
+			// this triangle is an ear
+			TrianglesOut.Add(Ind[0]);
+			TrianglesOut.Add(Ind[1]);
+			TrianglesOut.Add(Ind[2]);
+
+			// remove the middle vertex from the list
+			Remaining.RemoveAt((GuessVert + 1) % NumPoly, 1, false);
+		}
+
+		if (Remaining.Num() == 3)
+		{
+			TrianglesOut.Add(Remaining[0]);
+			TrianglesOut.Add(Remaining[1]);
+			TrianglesOut.Add(Remaining[2]);
+		}
+	}
+
+
+	/** Append one OBJ triangle to the mesh, setting overlay triangles the same way as ReadOBJMesh_TinyOBJ() */
+	static FORCEINLINE void AppendOBJTriangle(FDynamicMesh3& MeshOut, FDynamicMeshNormalOverlay* Normals, FDynamicMeshUVOverlay* UVs,
+		const FOBJCorner& C0, const FOBJCorner& C1, const FOBJCorner& C2)
+	{
+		int32 tid = MeshOut.AppendTriangle(C0.V, C1.V, C2.V);
+		if (tid < 0)
+		{
+			return;
+		}
+		if (Normals && Normals->IsElement(C0.VN) && Normals->IsElement(C1.VN) && Normals->IsElement(C2.VN))
+		{
+			Normals->SetTriangle(tid, FIndex3i(C0.VN, C1.VN, C2.VN));
+		}
+		if (UVs && UVs->IsElement(C0.VT) && UVs->IsElement(C1.VT) && UVs->IsElement(C2.VT))
+		{
+			UVs->SetTriangle(tid, FIndex3i(C0.VT, C1.VT, C2.VT));
+		}
+	}
+}
+
+
+
+bool RTGUtils::ReadOBJMesh_Parallel(
+	const FString& Path,
+	FDynamicMesh3& MeshOut,
+	bool bNormals,
+	bool bTexCoords,
+	bool bVertexColors,
+	bool bReverseOrientation,
+	const FOBJReadProgressFunc& ProgressFunc)
+{
+	using namespace OBJReaderLocals;
+
+	TArray<uint8> FileBuffer;
+	if (FFileHelper::LoadFileToArray(FileBuffer, *Path) == false)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Cannot open file [%s]"), *Path);
+		return false;
+	}
+
+	const char* FileBegin = (const char*)FileBuffer.GetData();
+	const char* FileEnd = FileBegin + FileBuffer.Num();
+
+	// split into line-aligned chunks and parse them on worker threads
+	const int64 MinChunkBytes = 256 * 1024;
+	int32 MaxChunks = 4 * FMath::Max(1, FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+	int32 NumChunks = (int32)FMath::Clamp<int64>(FileBuffer.Num() / MinChunkBytes, 1, MaxChunks);
+	TArray<FOBJChunk> Chunks;
+	SplitIntoChunks(FileBegin, FileEnd, NumChunks, Chunks);
+	NumChunks = Chunks.Num();
+
+	// each chunk is parsed and then triangulated
+	FOBJReadProgress Progress(ProgressFunc, 2 * NumChunks);
+	ParallelFor(NumChunks, [&](int32 ci)
+	{
+		if (Progress.IsCancelled() == false)
+		{
+			ParseChunk(Chunks[ci]);
+			Progress.CompleteStep();
+		}
+	});
+	if (Progress.IsCancelled())
+	{
+		return false;
+	}
+
+	for (const FOBJChunk& Chunk : Chunks)
+	{
+		if (Chunk.bFailed)
+		{
+			UE_LOG(LogTemp, Display, TEXT("Failed to parse `f' line in [%s] (e.g. zero value for face index)"), *Path);
+			return false;
+		}
+	}
+
+	// resolve relative indices now that the global element counts preceding each chunk are known
+	TArray<FIndex3i> ChunkBaseCounts;		// (positions, texcoords, normals)
+	ChunkBaseCounts.SetNum(NumChunks);
+	FIndex3i TotalCounts(0, 0, 0);
+	for (int32 ci = 0; ci < NumChunks; ++ci)
+	{
+		ChunkBaseCounts[ci] = TotalCounts;
+		TotalCounts.A += Chunks[ci].NumPositions();
+		TotalCounts.B += Chunks[ci].NumTexCoords();
+		TotalCounts.C += Chunks[ci].NumNormals();
+	}
+	ParallelFor(NumChunks, [&](int32 ci)
+	{
+		FOBJChunk& Chunk = Chunks[ci];
+		const FIndex3i& Base = ChunkBaseCounts[ci];
+		for (const TPair<int32, uint8>& Relative : Chunk.RelativeCorners)
+		{
+			FOBJCorner& Corner = Chunk.Corners[Relative.Key];
+			Corner.V += (Relative.Value & RelativeV) ? Base.A : 0;
+			Corner.VT += (Relative.Value & RelativeVT) ? Base.B : 0;
+			Corner.VN += (Relative.Value & RelativeVN) ? Base.C : 0;
+		}
+	});
+
+	// append vertices and attribute elements in file order. Face indices are relative to the file, so replace any existing mesh.
+	MeshOut.Clear();
+	for (const FOBJChunk& Chunk : Chunks)
+	{
+		const float* P = Chunk.Positions.GetData();
+		int32 Num = Chunk.NumPositions();
+		for (int32 k = 0; k < Num; ++k)
+		{
+			MeshOut.AppendVertex(FVector3d(P[3*k], P[3*k+1], P[3*k+2]));
+		}
+	}
+
+	if (bVertexColors)
+	{
+		MeshOut.EnableVertexColors(FVector3f::Zero());
+		int32 vi = 0;
+		for (const FOBJChunk& Chunk : Chunks)
+		{
+			const float* C = Chunk.Colors.GetData();
+			int32 Num = Chunk.NumPositions();
+			for (int32 k = 0; k < Num; ++k)
+			{
+				MeshOut.SetVertexColor(vi++, FVector3f(C[3*k], C[3*k+1], C[3*k+2]));
+			}
+		}
+	}
+
+	if (bNormals || bTexCoords)
+	{
+		MeshOut.EnableAttributes();
+	}
+	FDynamicMeshNormalOverlay* Normals = (bNormals) ? MeshOut.Attributes()->PrimaryNormals() : nullptr;
+	FDynamicMeshUVOverlay* UVs = (bTexCoords) ? MeshOut.Attributes()->PrimaryUV() : nullptr;
+	for (const FOBJChunk& Chunk : Chunks)
+	{
+		if (Normals)
+		{
+			const float* N = Chunk.Normals.GetData();
+			int32 Num = Chunk.NumNormals();
+			for (int32 k = 0; k < Num; ++k)
+			{
+				Normals->AppendElement(FVector3f(N[3*k], N[3*k+1], N[3*k+2]));
+			}
+		}
+		if (UVs)
+		{
+			const float* T = Chunk.TexCoords.GetData();
+			int32 Num = Chunk.NumTexCoords();
+			for (int32 k = 0; k < Num; ++k)
+			{
+				UVs->AppendElement(FVector2f(T[2*k], T[2*k+1]));
+			}
+		}
+	}
+
+	// triangulate faces in parallel (needs all positions), then append the triangles in order
+	ParallelFor(NumChunks, [&](int32 ci)
+	{
+		if (Progress.IsCancelled())
+		{
+			return;
+		}
+		FOBJChunk& Chunk = Chunks[ci];
+		Chunk.Triangles.Reserve(Chunk.Corners.Num());
+		int32 CornerIndex = 0;
+		for (int32 FaceSize : Chunk.FaceSizes)
+		{
+			TriangulateFace(&Chunk.Corners[CornerIndex], FaceSize, MeshOut, Chunk.Triangles);
+			CornerIndex += FaceSize;
+		}
+		Chunk.Corners.Empty();
+		Chunk.FaceSizes.Empty();
+		Progress.CompleteStep();
+	});
+	if (Progress.IsCancelled())
+	{
+		return false;
+	}
+
+	for (FOBJChunk& Chunk : Chunks)
+	{
+		int32 NumTriangles = Chunk.Triangles.Num() / 3;
+		for (int32 k = 0; k < NumTriangles; ++k)
+		{
+			AppendOBJTriangle(MeshOut, Normals, UVs, Chunk.Triangles[3*k], Chunk.Triangles[3*k+1], Chunk.Triangles[3*k+2]);
+		}
+		Chunk.Triangles.Empty();
+	}
+
+	if (bReverseOrientation)
+	{
+		MeshOut.ReverseOrientation();
+	}
+
+	return true;
+}
+
+
+
+namespace OBJReaderLocals
+{
+	enum class EMappedReadResult
+	{
+		/** The file could not be opened or mapped */
+		Unavailable,
+		/** The file was mapped but could not be parsed, or the read was cancelled */
+		Failed,
+		Succeeded
+	};
+
+	/** Implementation of ReadOBJMesh_MemoryMapped(), which distinguishes a file that cannot be mapped from one that cannot be parsed */
+	static EMappedReadResult ReadOBJMeshMapped(
+		const FString& Path,
+		FDynamicMesh3& MeshOut,
+		bool bNormals,
+		bool bTexCoords,
+		bool bVertexColors,
+		bool bReverseOrientation,
+		const RTGUtils::FOBJReadProgressFunc& ProgressFunc)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*Path));
+		if (!MappedFile)
+		{
+			return EMappedReadResult::Unavailable;		// file is missing or platform does not support mapping
+		}
+		TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+		if (!MappedRegion)
+		{
+			return EMappedReadResult::Unavailable;
+		}
+
+		const char* FileBegin = (const char*)MappedRegion->GetMappedPtr();
+		const char* FileEnd = FileBegin + MappedRegion->GetMappedSize();
+
+		const int64 MinChunkBytes = 1024 * 1024;
+		int32 NumWorkers = FMath::Max(1, FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+		int32 NumChunks = (int32)FMath::Clamp<int64>((FileEnd - FileBegin) / MinChunkBytes, 1, 64 * NumWorkers);
+		TArray<FOBJChunk> Chunks;
+		SplitIntoChunks(FileBegin, FileEnd, NumChunks, Chunks);
+		NumChunks = Chunks.Num();
+
+		// each chunk is visited by the three passes
+		FOBJReadProgress Progress(ProgressFunc, 3 * NumChunks);
+
+		// Pass 1: count v/vn/vt records per chunk and validate face records, without storing anything.
+		// Faces are validated here so that MeshOut is never modified if the file is rejected.
+		TArray<FIndex3i> ChunkCounts;		// (positions, texcoords, normals)
+		ChunkCounts.Init(FIndex3i(0, 0, 0), NumChunks);
+		ParallelFor(NumChunks, [&](int32 ci)
+		{
+			if (Progress.IsCancelled())
+			{
+				return;
+			}
+			FIndex3i& Counts = ChunkCounts[ci];
+			Chunks[ci].bFailed = !ForEachLine(Chunks[ci].Begin, Chunks[ci].End, [&Counts](const char* LineStart, const char* LineEnd)
+			{
+				const char* Token = nullptr;
+				switch (ClassifyLine(LineStart, LineEnd, Token))
+				{
+				case EOBJRecord::Vertex:	Counts.A++; return true;
+				case EOBJRecord::TexCoord:	Counts.B++; return true;
+				case EOBJRecord::Normal:	Counts.C++; return true;
+				case EOBJRecord::Face:		return ParseFace(Token, LineEnd, 0, 0, 0, [](const FOBJCorner&, uint8) {});
+				default:					return true;
+				}
+			});
+			Progress.CompleteStep();
+		});
+		if (Progress.IsCancelled())
+		{
+			return EMappedReadResult::Failed;
+		}
+
+		for (const FOBJChunk& Chunk : Chunks)
+		{
+			if (Chunk.bFailed)
+			{
+				UE_LOG(LogTemp, Display, TEXT("Failed to parse `f' line in [%s] (e.g. zero value for face index)"), *Path);
+				return EMappedReadResult::Failed;
+			}
+		}
+
+		TArray<FIndex3i> ChunkBaseCounts;
+		ChunkBaseCounts.SetNum(NumChunks);
+		FIndex3i TotalCounts(0, 0, 0);
+		for (int32 ci = 0; ci < NumChunks; ++ci)
+		{
+			ChunkBaseCounts[ci] = TotalCounts;
+			TotalCounts.A += ChunkCounts[ci].A;
+			TotalCounts.B += ChunkCounts[ci].B;
+			TotalCounts.C += ChunkCounts[ci].C;
+		}
+
+		// Allocate the attribute elements, so that Pass 2 can write them in place. Vertices are parsed into flat arrays
+		// and appended afterwards, because setting mesh vertices updates the shared mesh timestamps, which is not thread-safe.
+		// Face indices are relative to the file, so replace any existing mesh.
+		MeshOut.Clear();
+		TArray<FVector3d> Positions;
+		Positions.SetNumUninitialized(TotalCounts.A);
+		TArray<FVector3f> Colors;
+		if (bVertexColors)
+		{
+			Colors.SetNumUninitialized(TotalCounts.A);
+		}
+		if (bNormals || bTexCoords)
+		{
+			MeshOut.EnableAttributes();
+		}
+		FDynamicMeshNormalOverlay* Normals = (bNormals) ? MeshOut.Attributes()->PrimaryNormals() : nullptr;
+		FDynamicMeshUVOverlay* UVs = (bTexCoords) ? MeshOut.Attributes()->PrimaryUV() : nullptr;
+		for (int32 k = 0; Normals && k < TotalCounts.C; ++k)
+		{
+			Normals->AppendElement(FVector3f::Zero());
+		}
+		for (int32 k = 0; UVs && k < TotalCounts.B; ++k)
+		{
+			UVs->AppendElement(FVector2f::Zero());
+		}
+
+		// Pass 2: parse v/vn/vt records straight from the mapped pages into the vertex arrays and attribute overlays
+		ParallelFor(NumChunks, [&](int32 ci)
+		{
+			if (Progress.IsCancelled())
+			{
+				return;
+			}
+			FIndex3i Next = ChunkBaseCounts[ci];
+			ForEachLine(Chunks[ci].Begin, Chunks[ci].End, [&](const char* LineStart, const char* LineEnd)
+			{
+				const char* Token = nullptr;
+				switch (ClassifyLine(LineStart, LineEnd, Token))
+				{
+				case EOBJRecord::Vertex:
+				{
+					float Position[3], Color[3];
+					ParseVertex(Token, LineEnd, Position, Color);
+					int32 vid = Next.A++;
+					Positions[vid] = FVector3d(Position[0], Position[1], Position[2]);
+					if (bVertexColors)
+					{
+						Colors[vid] = FVector3f(Color[0], Color[1], Color[2]);
+					}
+					break;
+				}
+				case EOBJRecord::TexCoord:
+				{
+					int32 eid = Next.B++;
+					if (UVs)
+					{
+						float U = ParseReal(Token, LineEnd);
+						float V = ParseReal(Token, LineEnd);
+						UVs->SetElement(eid, FVector2f(U, V));
+					}
+					break;
+				}
+				case EOBJRecord::Normal:
+				{
+					int32 eid = Next.C++;
+					if (Normals)
+					{
+						float X = ParseReal(Token, LineEnd);
+						float Y = ParseReal(Token, LineEnd);
+						float Z = ParseReal(Token, LineEnd);
+						Normals->SetElement(eid, FVector3f(X, Y, Z));
+					}
+					break;
+				}
+				default:
+					break;
+				}
+				return true;
+			});
+			Progress.CompleteStep();
+		});
+		if (Progress.IsCancelled())
+		{
+			return EMappedReadResult::Failed;
+		}
+
+		for (const FVector3d& Position : Positions)
+		{
+			MeshOut.AppendVertex(Position);
+		}
+		Positions.Empty();
+		if (bVertexColors)
+		{
+			MeshOut.EnableVertexColors(FVector3f::Zero());
+			for (int32 vid = 0; vid < TotalCounts.A; ++vid)
+			{
+				MeshOut.SetVertexColor(vid, Colors[vid]);
+			}
+			Colors.Empty();
+		}
+
+		// Pass 3: parse and triangulate faces in windows of chunks on worker threads, appending each window
+		// in file order before parsing the next one. This bounds the face staging memory to one window.
+		int32 WindowSize = FMath::Min(NumWorkers, NumChunks);
+		for (int32 WindowStart = 0; WindowStart < NumChunks; WindowStart += WindowSize)
+		{
+			int32 WindowCount = FMath::Min(WindowSize, NumChunks - WindowStart);
+			ParallelFor(WindowCount, [&](int32 wi)
+			{
+				if (Progress.IsCancelled())
+				{
+					return;
+				}
+				int32 ci = WindowStart + wi;
+				FOBJChunk& Chunk = Chunks[ci];
+				FIndex3i Seen = ChunkBaseCounts[ci];
+				TArray<FOBJCorner, TInlineAllocator<16>> FaceCorners;
+				ForEachLine(Chunk.Begin, Chunk.End, [&](const char* LineStart, const char* LineEnd)
+				{
+					const char* Token = nullptr;
+					switch (ClassifyLine(LineStart, LineEnd, Token))
+					{
+					case EOBJRecord::Vertex:	Seen.A++; break;
+					case EOBJRecord::TexCoord:	Seen.B++; break;
+					case EOBJRecord::Normal:	Seen.C++; break;
+					case EOBJRecord::Face:
+						FaceCorners.Reset();
+						ParseFace(Token, LineEnd, Seen.A, Seen.B, Seen.C, [&FaceCorners](const FOBJCorner& Corner, uint8) { FaceCorners.Add(Corner); });
+						TriangulateFace(FaceCorners.GetData(), FaceCorners.Num(), MeshOut, Chunk.Triangles);
+						break;
+					default:
+						break;
+					}
+					return true;
+				});
+				Progress.CompleteStep();
+			});
+			if (Progress.IsCancelled())
+			{
+				return EMappedReadResult::Failed;
+			}
+
+			for (int32 wi = 0; wi < WindowCount; ++wi)
+			{
+				FOBJChunk& Chunk = Chunks[WindowStart + wi];
+				int32 NumTriangles = Chunk.Triangles.Num() / 3;
+				for (int32 k = 0; k < NumTriangles; ++k)
+				{
+					AppendOBJTriangle(MeshOut, Normals, UVs, Chunk.Triangles[3*k], Chunk.Triangles[3*k+1], Chunk.Triangles[3*k+2]);
+				}
+				Chunk.Triangles.Empty();
+			}
+		}
+
+		if (bReverseOrientation)
+		{
+			MeshOut.ReverseOrientation();
+		}
+
+		return EMappedReadResult::Succeeded;
+	}
+}
+
+
+bool RTGUtils::ReadOBJMesh_MemoryMapped(
+	const FString& Path,
+	FDynamicMesh3& MeshOut,
+	bool bNormals,
+	bool bTexCoords,
+	bool bVertexColors,
+	bool bReverseOrientation,
+	const FOBJReadProgressFunc& ProgressFunc)
+{
+	return OBJReaderLocals::ReadOBJMeshMapped(Path, MeshOut, bNormals, bTexCoords, bVertexColors, bReverseOrientation, ProgressFunc) == OBJReaderLocals::EMappedReadResult::Succeeded;
+}
+
+
+bool RTGUtils::ReadOBJMesh(
+	const FString& Path,
+	FDynamicMesh3& MeshOut,
+	bool bNormals,
+	bool bTexCoords,
+	bool bVertexColors,
+	bool bReverseOrientation,
+	const FOBJReadProgressFunc& ProgressFunc)
+{
+	using namespace OBJReaderLocals;
+
+	// track cancellation, so that a cancelled read is not retried with tinyobj
+	TAtomic<bool> bCancelled(false);
+	FOBJReadProgressFunc TrackedProgressFunc;
+	if (ProgressFunc)
+	{
+		TrackedProgressFunc = [&ProgressFunc, &bCancelled](float Fraction)
+		{
+			bool bContinue = ProgressFunc(Fraction);
+			if (bContinue == false)
+			{
+				bCancelled = true;
+			}
+			return bContinue;
+		};
+	}
+
+	// the file is only loaded into memory by the parallel parser if it cannot be mapped
+	EMappedReadResult MappedResult = ReadOBJMeshMapped(Path, MeshOut, bNormals, bTexCoords, bVertexColors, bReverseOrientation, TrackedProgressFunc);
+	if (MappedResult == EMappedReadResult::Succeeded)
+	{
+		return true;
+	}
+	if (MappedResult == EMappedReadResult::Unavailable
+		&& ReadOBJMesh_Parallel(Path, MeshOut, bNormals, bTexCoords, bVertexColors, bReverseOrientation, TrackedProgressFunc))
+	{
+		return true;
+	}
+	if (bCancelled)
+	{
+		return false;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Chunked OBJ parsers failed for [%s], retrying with tinyobj"), *Path);
+	return ReadOBJMesh_TinyOBJ(Path, MeshOut, bNormals, bTexCoords, bVertexColors, bReverseOrientation);
+}
@@ -1,132 +1,492 @@
 #include "DynamicMeshOBJWriter.h"
 #include "DynamicMeshAttributeSet.h"
-#include "DynamicMeshEditor.h"
 
-#include <fstream>
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMisc.h"
 
+#include <cmath>
 
 
-class FDynamicMeshOBJWriter
+namespace OBJWriterLocals
 {
-public:
-
-	std::ofstream FileOut;
+	/**
+	 * Growable ANSI text buffer with locale-independent number formatting
+	 */
+	struct FOBJTextBuffer
+	{
+		TArray<ANSICHAR> Data;
 
-	TFunction<bool(const FString&)> OpenFile = [this](const FString& Path) { FileOut.open(*Path, std::ofstream::out | std::ofstream::trunc); return !!FileOut; };
-	TFunction<void()> CloseFile = [this]() { FileOut.close(); };
-	TFunction<void(const TCHAR*)> WriteLine = [this](const TCHAR* Line) { FileOut << TCHAR_TO_ANSI(Line) << std::endl; };
+		void Reset()
+		{
+			Data.Reset();
+		}
 
-	bool Write(const char* OutputPath, const FDynamicMesh3& Mesh)
-	{
-		if (!OpenFile(OutputPath))
+		void Append(ANSICHAR Char)
 		{
-			return false;
+			Data.Add(Char);
 		}
 
-		int32 NumVertices = Mesh.VertexCount();
-		for (int32 vi = 0; vi < NumVertices; ++vi)
+		void Append(const ANSICHAR* String, int32 Length)
 		{
-			FVector3d Pos = Mesh.GetVertex(vi);
-			WriteLine(*FString::Printf(TEXT("v %f %f %f"), Pos.X, Pos.Y, Pos.Z));
+			Data.Append(String, Length);
 		}
 
-		int32 NumUVs = 0;
-		const FDynamicMeshUVOverlay* UVs = nullptr;
-		if (Mesh.Attributes() && Mesh.Attributes()->PrimaryUV())
+		void AppendInt(int64 Value)
 		{
-			UVs = Mesh.Attributes()->PrimaryUV();
-			NumUVs = UVs->ElementCount();
-			for (int32 ui = 0; ui < NumUVs; ++ui)
+			if (Value < 0)
 			{
-				FVector2f UV = UVs->GetElement(ui);
-				WriteLine(*FString::Printf(TEXT("vt %f %f"), UV.X, UV.Y));
+				Append('-');
+				AppendUInt((uint64)(-Value));
+			}
+			else
+			{
+				AppendUInt((uint64)Value);
 			}
 		}
 
-		int32 NumNormals = 0;
-		const FDynamicMeshNormalOverlay* Normals = nullptr;
-		if (Mesh.Attributes() && Mesh.Attributes()->PrimaryNormals())
+		void AppendUInt(uint64 Value)
 		{
-			Normals = Mesh.Attributes()->PrimaryNormals();
-			NumNormals = Normals->ElementCount();
-			for (int32 ni = 0; ni < NumNormals; ++ni)
+			ANSICHAR Digits[24];
+			int32 NumDigits = 0;
+			do
 			{
-				FVector3f Normal = Normals->GetElement(ni);
-				WriteLine(*FString::Printf(TEXT("vn %f %f %f"), Normal.X, Normal.Y, Normal.Z));
+				Digits[NumDigits++] = (ANSICHAR)('0' + (Value % 10));
+				Value /= 10;
+			} while (Value != 0);
+			while (NumDigits > 0)
+			{
+				Append(Digits[--NumDigits]);
 			}
 		}
 
-		struct FMeshTri
+		/** Append Value with six fractional digits, ie same output as printf("%f") */
+		void AppendFloat(double Value)
 		{
-			int32 Index;
-			int32 Group;
-		};
-		TSet<int32> AllGroupIDs;
+			if (!FMath::IsFinite(Value) || FMath::Abs(Value) >= 1.0e12)
+			{
+				// out of range for the fixed-point path below, this is rare enough to go through the CRT
+				ANSICHAR Temp[512];
+				int32 Length = FCStringAnsi::Snprintf(Temp, UE_ARRAY_COUNT(Temp), "%f", Value);
+				Append(Temp, FMath::Clamp(Length, 0, (int32)UE_ARRAY_COUNT(Temp) - 1));
+				return;
+			}
 
-		TArray<FMeshTri> Triangles;
+			if (std::signbit(Value))
+			{
+				Append('-');
+			}
+			uint64 Scaled = (uint64)(FMath::Abs(Value) * 1.0e6 + 0.5);
+			AppendUInt(Scaled / 1000000);
+			Append('.');
+			uint64 Fraction = Scaled % 1000000;
+			for (uint64 Divisor = 100000; Divisor > 0; Divisor /= 10)
+			{
+				Append((ANSICHAR)('0' + (Fraction / Divisor) % 10));
+			}
+		}
 
-		int32 NumTriangles = Mesh.TriangleCount();
-		for (int32 ti = 0; ti < NumTriangles; ++ti)
+		/** Append a face corner in v, v/vt, v//vn or v/vt/vn form (indices are 0-based and written 1-based, negative UV/Normal indices are omitted) */
+		void AppendCorner(int64 Vertex, int64 UV, int64 Normal)
 		{
-			if (Mesh.IsTriangle(ti))
+			AppendInt(Vertex + 1);
+			if (UV >= 0 || Normal >= 0)
 			{
-				int32 GroupID = Mesh.GetTriangleGroup(ti);
-				AllGroupIDs.Add(GroupID);
-				Triangles.Add({ ti, GroupID });
+				Append('/');
+				if (UV >= 0)
+				{
+					AppendInt(UV + 1);
+				}
+				if (Normal >= 0)
+				{
+					Append('/');
+					AppendInt(Normal + 1);
+				}
 			}
 		}
-		bool bHaveGroups = AllGroupIDs.Num() > 1;
+	};
 
-		Triangles.StableSort([](const FMeshTri& Tri0, const FMeshTri& Tri1)
+
+	/**
+	 * Order triangles by group ID (stable, ie triangles within a group stay in index order) in linear time.
+	 * @return number of distinct groups
+	 */
+	static int32 SortTrianglesByGroup(const FDynamicMesh3& Mesh, TArray<int32>& TrianglesOut)
+	{
+		int32 NumTriangles = Mesh.MaxTriangleID();
+		TrianglesOut.SetNumUninitialized(NumTriangles);
+		if (Mesh.HasTriangleGroups() == false || NumTriangles == 0)
 		{
-			return Tri0.Group < Tri1.Group;
-		});
+			for (int32 tid = 0; tid < NumTriangles; ++tid)
+			{
+				TrianglesOut[tid] = tid;
+			}
+			return (NumTriangles > 0) ? 1 : 0;
+		}
 
+		int32 MinGroup = TNumericLimits<int32>::Max(), MaxGroup = TNumericLimits<int32>::Lowest();
+		for (int32 tid = 0; tid < NumTriangles; ++tid)
+		{
+			int32 GroupID = Mesh.GetTriangleGroup(tid);
+			MinGroup = FMath::Min(MinGroup, GroupID);
+			MaxGroup = FMath::Max(MaxGroup, GroupID);
+		}
 
-		int32 CurGroupID = -99999;
-		for (FMeshTri MeshTri : Triangles)
+		// map group IDs to dense bins. Usually the ID range is small and a direct lookup table is used,
+		// otherwise only the distinct IDs are sorted
+		TArray<int32> GroupBins;
+		TMap<int32, int32> SparseGroupBins;
+		int32 NumBins = 0;
+		int64 GroupRange = (int64)MaxGroup - (int64)MinGroup + 1;
+		bool bDenseGroups = GroupRange <= (int64)NumTriangles + 1024;
+		if (bDenseGroups)
+		{
+			GroupBins.Init(-1, (int32)GroupRange);
+			for (int32 tid = 0; tid < NumTriangles; ++tid)
+			{
+				GroupBins[Mesh.GetTriangleGroup(tid) - MinGroup] = 0;
+			}
+			for (int32& Bin : GroupBins)
+			{
+				Bin = (Bin >= 0) ? NumBins++ : -1;
+			}
+		}
+		else
 		{
-			if (bHaveGroups && MeshTri.Group != CurGroupID)
+			TArray<int32> GroupIDs;
+			for (int32 tid = 0; tid < NumTriangles; ++tid)
 			{
-				WriteLine(*FString::Printf(TEXT("g %d"), MeshTri.Group));
-				CurGroupID = MeshTri.Group;
+				int32 GroupID = Mesh.GetTriangleGroup(tid);
+				if (SparseGroupBins.Contains(GroupID) == false)
+				{
+					SparseGroupBins.Add(GroupID, 0);
+					GroupIDs.Add(GroupID);
+				}
 			}
+			GroupIDs.Sort();
+			for (int32 GroupID : GroupIDs)
+			{
+				SparseGroupBins[GroupID] = NumBins++;
+			}
+		}
+
+		auto GetBin = [&](int32 tid)
+		{
+			int32 GroupID = Mesh.GetTriangleGroup(tid);
+			return (bDenseGroups) ? GroupBins[GroupID - MinGroup] : SparseGroupBins[GroupID];
+		};
+
+		// counting sort
+		TArray<int32> BinOffsets;
+		BinOffsets.Init(0, NumBins + 1);
+		for (int32 tid = 0; tid < NumTriangles; ++tid)
+		{
+			BinOffsets[GetBin(tid) + 1]++;
+		}
+		for (int32 k = 1; k <= NumBins; ++k)
+		{
+			BinOffsets[k] += BinOffsets[k - 1];
+		}
+		for (int32 tid = 0; tid < NumTriangles; ++tid)
+		{
+			TrianglesOut[BinOffsets[GetBin(tid)]++] = tid;
+		}
+		return NumBins;
+	}
+
+
+	static bool IsCompactForWriting(const FDynamicMesh3& Mesh)
+	{
+		if (Mesh.IsCompact() == false)
+		{
+			return false;
+		}
+		if (Mesh.HasAttributes())
+		{
+			const FDynamicMeshUVOverlay* UVs = Mesh.Attributes()->PrimaryUV();
+			const FDynamicMeshNormalOverlay* Normals = Mesh.Attributes()->PrimaryNormals();
+			return (UVs == nullptr || UVs->ElementCount() == UVs->MaxElementID())
+				&& (Normals == nullptr || Normals->ElementCount() == Normals->MaxElementID());
+		}
+		return true;
+	}
+}
+
 
-			int32 ti = MeshTri.Index;
 
-			FIndex3i TriVertices = Mesh.GetTriangle(ti);
-			FIndex3i TriUVs = (NumUVs > 0) ? UVs->GetTriangle(ti) : FIndex3i::Invalid();
-			FIndex3i TriNormals = (NumNormals > 0) ? Normals->GetTriangle(ti) : FIndex3i::Invalid();
+/**
+ * Streaming OBJ writer. Meshes are written one after the other as v/vt/vn/f blocks with running vertex/UV/normal
+ * index offsets, so no combined mesh is built. Each block is split into chunks that are formatted on worker threads
+ * (chunks of small meshes are formatted concurrently) and written to the file in order.
+ */
+class FDynamicMeshOBJWriter
+{
+public:
+
+	/** If true, triangles are written with reversed orientation and normals are negated, ie same as FDynamicMesh3::ReverseOrientation() */
+	bool bReverseOrientation = false;
+
+	bool Write(const FString& OutputPath, const TArray<const FDynamicMesh3*>& Meshes)
+	{
+		using namespace OBJWriterLocals;
+
+		// counts and index offsets are known up front, so chunks of any mesh can be formatted independently
+		MeshInfos.SetNum(Meshes.Num());
+		Chunks.Reset();
+		int64 VertexOffset = 0, UVOffset = 0, NormalOffset = 0, GroupOffset = 0;
+		int32 NumMeshesWithTriangles = 0;
+		for (int32 mi = 0; mi < Meshes.Num(); ++mi)
+		{
+			const FDynamicMesh3& Mesh = *Meshes[mi];
+			FMeshInfo& Info = MeshInfos[mi];
+			Info.NumVertices = Mesh.VertexCount();
+			Info.NumUVs = (Mesh.HasAttributes() && Mesh.Attributes()->PrimaryUV()) ? Mesh.Attributes()->PrimaryUV()->ElementCount() : 0;
+			Info.NumNormals = (Mesh.HasAttributes() && Mesh.Attributes()->PrimaryNormals()) ? Mesh.Attributes()->PrimaryNormals()->ElementCount() : 0;
+			Info.NumTriangles = Mesh.TriangleCount();
+			Info.VertexOffset = VertexOffset;
+			Info.UVOffset = UVOffset;
+			Info.NormalOffset = NormalOffset;
+			Info.GroupOffset = GroupOffset;
+			VertexOffset += Info.NumVertices;
+			UVOffset += Info.NumUVs;
+			NormalOffset += Info.NumNormals;
+			GroupOffset += (Mesh.HasTriangleGroups()) ? FMath::Max(Mesh.MaxGroupID(), 1) : 1;
+			NumMeshesWithTriangles += (Info.NumTriangles > 0) ? 1 : 0;
+
+			AddChunks(mi, EBlock::Vertices, Info.NumVertices);
+			AddChunks(mi, EBlock::UVs, Info.NumUVs);
+			AddChunks(mi, EBlock::Normals, Info.NumNormals);
+			AddChunks(mi, EBlock::Faces, Info.NumTriangles);
+			Info.LastChunk = Chunks.Num() - 1;
+		}
+		// triangle groups of different meshes are offset to stay distinct, so each mesh becomes at least one OBJ group
+		bool bMultipleMeshes = NumMeshesWithTriangles > 1;
+
+		TUniquePtr<FArchive> FileOut(IFileManager::Get().CreateFileWriter(*OutputPath));
+		if (!FileOut)
+		{
+			return false;
+		}
 
-			bool bHaveUV = (NumUVs != 0) && UVs->IsSetTriangle(ti);
-			bool bHaveNormal = (NumNormals != 0) && Normals->IsSetTriangle(ti);
+		// mesh states are created when a mesh's first chunk enters the window and released after its last chunk is written
+		MeshStates.Reset();
+		MeshStates.SetNum(Meshes.Num());
+		int32 WindowSize = FMath::Max(1, FPlatformMisc::NumberOfCoresIncludingHyperthreads()) * 2;
+		TArray<FOBJTextBuffer> Buffers;
+		Buffers.SetNum(FMath::Min(WindowSize, Chunks.Num()));
+		TArray<int32> NewMeshes;
+		bool bOK = true;
+		for (int32 FirstChunk = 0; FirstChunk < Chunks.Num() && bOK; FirstChunk += WindowSize)
+		{
+			int32 NumInWindow = FMath::Min(WindowSize, Chunks.Num() - FirstChunk);
 
-			if (bHaveUV && bHaveNormal)
+			NewMeshes.Reset();
+			for (int32 ci = FirstChunk; ci < FirstChunk + NumInWindow; ++ci)
 			{
-				WriteLine(*FString::Printf(TEXT("f %d/%d/%d %d/%d/%d %d/%d/%d"),
-					TriVertices.A + 1, TriUVs.A + 1, TriNormals.A + 1,
-					TriVertices.B + 1, TriUVs.B + 1, TriNormals.B + 1,
-					TriVertices.C + 1, TriUVs.C + 1, TriNormals.C + 1));
+				int32 MeshIndex = Chunks[ci].MeshIndex;
+				if (MeshStates[MeshIndex].Mesh == nullptr && (NewMeshes.Num() == 0 || NewMeshes.Last() != MeshIndex))
+				{
+					NewMeshes.Add(MeshIndex);
+				}
 			}
-			else if (bHaveUV)
+			ParallelFor(NewMeshes.Num(), [&](int32 k)
+			{
+				PrepareMesh(NewMeshes[k], *Meshes[NewMeshes[k]], bMultipleMeshes);
+			});
+
+			ParallelFor(NumInWindow, [&](int32 wi)
+			{
+				Buffers[wi].Reset();
+				FormatChunk(Buffers[wi], Chunks[FirstChunk + wi]);
+			});
+
+			for (int32 wi = 0; wi < NumInWindow; ++wi)
 			{
-				WriteLine(*FString::Printf(TEXT("f %d/%d %d/%d %d/%d"),
-					TriVertices.A + 1, TriUVs.A + 1, TriVertices.B + 1, TriUVs.B + 1, TriVertices.C + 1, TriUVs.C + 1));
+				FileOut->Serialize(Buffers[wi].Data.GetData(), Buffers[wi].Data.Num());
+				int32 MeshIndex = Chunks[FirstChunk + wi].MeshIndex;
+				if (MeshInfos[MeshIndex].LastChunk == FirstChunk + wi)
+				{
+					MeshStates[MeshIndex] = FMeshState();
+				}
 			}
-			else if (bHaveNormal)
+			bOK = !FileOut->IsError();
+		}
+
+		MeshStates.Reset();
+		return FileOut->Close() && bOK;
+	}
+
+
+protected:
+
+	enum class EBlock : uint8
+	{
+		Vertices,
+		UVs,
+		Normals,
+		Faces
+	};
+
+	/** range of records in one block of one mesh */
+	struct FChunk
+	{
+		int32 MeshIndex;
+		EBlock Block;
+		int32 Start;
+		int32 End;
+	};
+
+	/** counts and output index offsets for one mesh */
+	struct FMeshInfo
+	{
+		int32 NumVertices = 0;
+		int32 NumUVs = 0;
+		int32 NumNormals = 0;
+		int32 NumTriangles = 0;
+		int64 VertexOffset = 0;
+		int64 UVOffset = 0;
+		int64 NormalOffset = 0;
+		int64 GroupOffset = 0;
+		int32 LastChunk = -1;
+	};
+
+	/** data needed to format the chunks of a mesh, only exists while the mesh is being written */
+	struct FMeshState
+	{
+		const FDynamicMesh3* Mesh = nullptr;
+		TUniquePtr<FDynamicMesh3> CompactMesh;
+		const FDynamicMeshUVOverlay* UVs = nullptr;
+		const FDynamicMeshNormalOverlay* Normals = nullptr;
+		TArray<int32> Triangles;
+		bool bWriteGroups = false;
+	};
+
+	TArray<FMeshInfo> MeshInfos;
+	TArray<FMeshState> MeshStates;
+	TArray<FChunk> Chunks;
+
+	void AddChunks(int32 MeshIndex, EBlock Block, int32 NumRecords)
+	{
+		const int32 ChunkSize = 32768;
+		for (int32 Start = 0; Start < NumRecords; Start += ChunkSize)
+		{
+			Chunks.Add({ MeshIndex, Block, Start, FMath::Min(Start + ChunkSize, NumRecords) });
+		}
+	}
+
+	void PrepareMesh(int32 MeshIndex, const FDynamicMesh3& SourceMesh, bool bMultipleMeshes)
+	{
+		using namespace OBJWriterLocals;
+
+		// OBJ indices are dense, so compact the mesh if it has any gaps
+		FMeshState& State = MeshStates[MeshIndex];
+		State.Mesh = &SourceMesh;
+		if (IsCompactForWriting(SourceMesh) == false)
+		{
+			State.CompactMesh = MakeUnique<FDynamicMesh3>();
+			State.CompactMesh->CompactCopy(SourceMesh);
+			State.Mesh = State.CompactMesh.Get();
+		}
+		if (State.Mesh->HasAttributes())
+		{
+			State.UVs = State.Mesh->Attributes()->PrimaryUV();
+			State.Normals = State.Mesh->Attributes()->PrimaryNormals();
+		}
+		int32 NumGroups = SortTrianglesByGroup(*State.Mesh, State.Triangles);
+		State.bWriteGroups = bMultipleMeshes || NumGroups > 1;
+	}
+
+	void FormatChunk(OBJWriterLocals::FOBJTextBuffer& Out, const FChunk& Chunk) const
+	{
+		const FMeshInfo& Info = MeshInfos[Chunk.MeshIndex];
+		const FMeshState& State = MeshStates[Chunk.MeshIndex];
+		const FDynamicMesh3& Mesh = *State.Mesh;
+
+		switch (Chunk.Block)
+		{
+		case EBlock::Vertices:
+			for (int32 vi = Chunk.Start; vi < Chunk.End; ++vi)
 			{
-				WriteLine(*FString::Printf(TEXT("f %d//%d %d//%d %d//%d"),
-					TriVertices.A + 1, TriNormals.A + 1, TriVertices.B + 1, TriNormals.B + 1, TriVertices.C + 1, TriNormals.C + 1));
+				FVector3d Pos = Mesh.GetVertex(vi);
+				Out.Append("v ", 2);
+				Out.AppendFloat(Pos.X);
+				Out.Append(' ');
+				Out.AppendFloat(Pos.Y);
+				Out.Append(' ');
+				Out.AppendFloat(Pos.Z);
+				Out.Append('\n');
 			}
-			else
+			break;
+
+		case EBlock::UVs:
+			for (int32 ui = Chunk.Start; ui < Chunk.End; ++ui)
 			{
-				WriteLine(*FString::Printf(TEXT("f %d %d %d"), TriVertices.A + 1, TriVertices.B + 1, TriVertices.C + 1));
+				FVector2f UV = State.UVs->GetElement(ui);
+				Out.Append("vt ", 3);
+				Out.AppendFloat(UV.X);
+				Out.Append(' ');
+				Out.AppendFloat(UV.Y);
+				Out.Append('\n');
 			}
-		}
+			break;
 
-		CloseFile();
+		case EBlock::Normals:
+			for (int32 ni = Chunk.Start; ni < Chunk.End; ++ni)
+			{
+				FVector3f Normal = State.Normals->GetElement(ni);
+				if (bReverseOrientation)
+				{
+					Normal = -Normal;
+				}
+				Out.Append("vn ", 3);
+				Out.AppendFloat(Normal.X);
+				Out.Append(' ');
+				Out.AppendFloat(Normal.Y);
+				Out.Append(' ');
+				Out.AppendFloat(Normal.Z);
+				Out.Append('\n');
+			}
+			break;
 
-		return true;
+		case EBlock::Faces:
+		{
+			// reversed orientation swaps the first two corners, same as FDynamicMesh3::ReverseOrientation()
+			const FIndex3i CornerOrder = (bReverseOrientation) ? FIndex3i(1, 0, 2) : FIndex3i(0, 1, 2);
+			for (int32 k = Chunk.Start; k < Chunk.End; ++k)
+			{
+				int32 ti = State.Triangles[k];
+				if (State.bWriteGroups)
+				{
+					int32 GroupID = Mesh.GetTriangleGroup(ti);
+					if (k == 0 || Mesh.GetTriangleGroup(State.Triangles[k - 1]) != GroupID)
+					{
+						Out.Append("g ", 2);
+						Out.AppendInt(Info.GroupOffset + GroupID);
+						Out.Append('\n');
+					}
+				}
+
+				FIndex3i TriVertices = Mesh.GetTriangle(ti);
+				bool bHaveUV = (Info.NumUVs != 0) && State.UVs->IsSetTriangle(ti);
+				bool bHaveNormal = (Info.NumNormals != 0) && State.Normals->IsSetTriangle(ti);
+				FIndex3i TriUVs = (bHaveUV) ? State.UVs->GetTriangle(ti) : FIndex3i::Invalid();
+				FIndex3i TriNormals = (bHaveNormal) ? State.Normals->GetTriangle(ti) : FIndex3i::Invalid();
+
+				Out.Append('f');
+				for (int32 j = 0; j < 3; ++j)
+				{
+					int32 c = CornerOrder[j];
+					Out.Append(' ');
+					Out.AppendCorner(
+						Info.VertexOffset + TriVertices[c],
+						(bHaveUV) ? Info.UVOffset + TriUVs[c] : -1,
+						(bHaveNormal) ? Info.NormalOffset + TriNormals[c] : -1);
+				}
+				Out.Append('\n');
+			}
+			break;
+		}
+		}
 	}
 };
 
@@ -137,19 +497,9 @@ bool RTGUtils::WriteOBJMesh(
 	const FDynamicMesh3& Mesh,
 	bool bReverseOrientation)
 {
-	const FDynamicMesh3* WriteMesh = &Mesh;
-
-	FDynamicMesh3 CopyMesh;
-	if (bReverseOrientation)
-	{
-		CopyMesh = Mesh;
-		CopyMesh.ReverseOrientation();
-		WriteMesh = &CopyMesh;
-	}
-
 	FDynamicMeshOBJWriter Writer;
-	std::string OutputFilePath(TCHAR_TO_UTF8(*OutputPath));
-	return Writer.Write(OutputFilePath.c_str(), *WriteMesh);
+	Writer.bReverseOrientation = bReverseOrientation;
+	return Writer.Write(OutputPath, { &Mesh });
 }
 
 
@@ -159,33 +509,22 @@ bool RTGUtils::WriteOBJMeshes(
 	const TArray<FDynamicMesh3>& Meshes,
 	bool bReverseOrientation)
 {
-	FDynamicMesh3 CombinedMesh;
-	FDynamicMeshEditor Editor(&CombinedMesh);
-
+	TArray<const FDynamicMesh3*> MeshPointers;
 	for (const FDynamicMesh3& Mesh : Meshes)
 	{
-		if (Mesh.HasTriangleGroups())
-		{
-			CombinedMesh.EnableTriangleGroups();
-		}
-		if (Mesh.HasAttributes())
-		{
-			CombinedMesh.EnableAttributes();
-		}
-
-		FMeshIndexMappings Mappings;
-		Editor.AppendMesh(&Mesh, Mappings);
+		MeshPointers.Add(&Mesh);
 	}
+	return WriteOBJMeshes(OutputPath, MeshPointers, bReverseOrientation);
+}
 
-	if (bReverseOrientation)
-	{
-		CombinedMesh.ReverseOrientation();
-	}
 
-	FDynamicMeshOBJWriter Writer;
 
-	std::string OutputFilePath(TCHAR_TO_UTF8(*OutputPath));
-	return Writer.Write(OutputFilePath.c_str(), CombinedMesh);
+bool RTGUtils::WriteOBJMeshes(
+	const FString& OutputPath,
+	const TArray<const FDynamicMesh3*>& Meshes,
+	bool bReverseOrientation)
+{
+	FDynamicMeshOBJWriter Writer;
+	Writer.bReverseOrientation = bReverseOrientation;
+	return Writer.Write(OutputPath, Meshes);
 }
-
-
@@ -30,50 +30,202 @@ void ADynamicPMCActor::OnMeshEditedInternal()
 	Super::OnMeshEditedInternal();
 }
 
+void ADynamicPMCActor::OnMeshRegionEditedInternal(const TArray<int32>& RemovedTriangles, const TArray<int32>& AddedTriangles)
+{
+	if (UpdatePMCMeshRegion(RemovedTriangles, AddedTriangles) == false)
+	{
+		OnMeshEditedInternal();
+		return;
+	}
+	Super::OnMeshEditedInternal();
+}
+
 void ADynamicPMCActor::UpdatePMCMesh()
 {
 	if (MeshComponent)
 	{
-		bool bUseFaceNormals = (this->NormalsMode == EDynamicMeshActorNormalsMode::FaceNormals);
-		bool bUseUV0 = true;
-		bool bUseVertexColors = false;
+		bool bGenerateSectionCollision = UpdatePMCCollisionSettings();
+
+		TriangleSections.Reset();
+		SectionTriangles.Reset();
+		if (SectionGridResolution <= 1)
+		{
+			bool bUseFaceNormals = (this->NormalsMode == EDynamicMeshActorNormalsMode::FaceNormals);
+			bool bUseUV0 = true;
+			bool bUseVertexColors = false;
+			RTGUtils::UpdatePMCFromDynamicMesh_SplitTriangles(MeshComponent, &SourceMesh, bUseFaceNormals, bUseUV0, bUseVertexColors, bGenerateSectionCollision);
 
-		bool bGenerateSectionCollision = false;
-		if (this->CollisionMode == EDynamicMeshActorCollisionMode::ComplexAsSimple
-			|| this->CollisionMode == EDynamicMeshActorCollisionMode::ComplexAsSimpleAsync)
+			// update material on new section
+			UMaterialInterface* UseMaterial = (this->Material != nullptr) ? this->Material : UMaterial::GetDefaultMaterial(MD_Surface);
+			MeshComponent->SetMaterial(0, UseMaterial);
+		}
+		else
 		{
-			bGenerateSectionCollision = true;
-			MeshComponent->bUseAsyncCooking = (this->CollisionMode == EDynamicMeshActorCollisionMode::ComplexAsSimpleAsync);
-			MeshComponent->bUseComplexAsSimpleCollision = true;
+			MeshComponent->ClearAllMeshSections();
+			SectionGridBounds = SourceMesh.GetBounds();
+			TriangleSections.Init(-1, SourceMesh.MaxTriangleID());
+			SectionTriangles.SetNum(SectionGridResolution * SectionGridResolution * SectionGridResolution);
+			for (int32 tid : SourceMesh.TriangleIndicesItr())
+			{
+				int32 SectionIndex = GetTriangleSection(tid);
+				TriangleSections[tid] = SectionIndex;
+				SectionTriangles[SectionIndex].Add(tid);
+			}
+			for (int32 SectionIndex = 0; SectionIndex < SectionTriangles.Num(); ++SectionIndex)
+			{
+				if (SectionTriangles[SectionIndex].Num() > 0)
+				{
+					UpdatePMCSection(SectionIndex, bGenerateSectionCollision);
+				}
+			}
 		}
 
-		RTGUtils::UpdatePMCFromDynamicMesh_SplitTriangles(MeshComponent, &SourceMesh, bUseFaceNormals, bUseUV0, bUseVertexColors, bGenerateSectionCollision);
+		UpdatePMCConvexHullCollision();
+	}
+}
 
-		// update material on new section
-		UMaterialInterface* UseMaterial = (this->Material != nullptr) ? this->Material : UMaterial::GetDefaultMaterial(MD_Surface);
-		MeshComponent->SetMaterial(0, UseMaterial);
+bool ADynamicPMCActor::UpdatePMCMeshRegion(const TArray<int32>& RemovedTriangles, const TArray<int32>& AddedTriangles)
+{
+	if (MeshComponent == nullptr || SectionGridResolution <= 1
+		|| SectionTriangles.Num() != SectionGridResolution * SectionGridResolution * SectionGridResolution)
+	{
+		return false;
+	}
 
-		// generate convex collision
-		if (this->CollisionMode == EDynamicMeshActorCollisionMode::SimpleConvexHull)
+	// The section lists are only filtered for the changed sections, below. A removed triangle ID may have been
+	// reused for an added triangle, in which case it is still listed in its previous section.
+	TSet<int32> ChangedSections;
+	TMap<int32, int32> RemovedTriangleSections;
+	for (int32 tid : RemovedTriangles)
+	{
+		if (TriangleSections.IsValidIndex(tid) && TriangleSections[tid] >= 0)
 		{
-			FMeshConvexHull HullCompute(&SourceMesh);
-			int32 NumTris = FMath::Clamp(this->MaxHullTriangles, 0, 1000);
-			if (NumTris != 0)
-			{
-				HullCompute.bPostSimplify = true;
-				HullCompute.MaxTargetFaceCount = NumTris;
-			}
-			if (HullCompute.Compute())
+			ChangedSections.Add(TriangleSections[tid]);
+			RemovedTriangleSections.Add(tid, TriangleSections[tid]);
+			TriangleSections[tid] = -1;
+		}
+	}
+	int32 OldMaxTriangleID = TriangleSections.Num();
+	if (SourceMesh.MaxTriangleID() > OldMaxTriangleID)
+	{
+		TriangleSections.SetNumUninitialized(SourceMesh.MaxTriangleID());
+		for (int32 tid = OldMaxTriangleID; tid < TriangleSections.Num(); ++tid)
+		{
+			TriangleSections[tid] = -1;
+		}
+	}
+	for (int32 tid : AddedTriangles)
+	{
+		if (SourceMesh.IsTriangle(tid) == false)
+		{
+			continue;
+		}
+		int32 SectionIndex = GetTriangleSection(tid);
+		TriangleSections[tid] = SectionIndex;
+		ChangedSections.Add(SectionIndex);
+		const int32* PreviousSection = RemovedTriangleSections.Find(tid);
+		if (PreviousSection == nullptr || *PreviousSection != SectionIndex)
+		{
+			SectionTriangles[SectionIndex].Add(tid);
+		}
+	}
+
+	// the shared vertices, and with per-vertex normals their normals, may have changed in the neighbouring triangles
+	for (int32 tid : AddedTriangles)
+	{
+		if (SourceMesh.IsTriangle(tid))
+		{
+			FIndex3i TriV = SourceMesh.GetTriangle(tid);
+			for (int32 j = 0; j < 3; ++j)
 			{
-				TArray<FVector> Points;
-				for (FVector3d Pos : HullCompute.ConvexHull.VerticesItr())
+				for (int32 NbrTID : SourceMesh.VtxTrianglesItr(TriV[j]))
 				{
-					Points.Add((FVector)Pos);
+					if (TriangleSections[NbrTID] >= 0)
+					{
+						ChangedSections.Add(TriangleSections[NbrTID]);
+					}
 				}
-				MeshComponent->bUseComplexAsSimpleCollision = false;
-				MeshComponent->ClearCollisionConvexMeshes();
-				MeshComponent->AddCollisionConvexMesh(Points);
 			}
 		}
 	}
+
+	bool bGenerateSectionCollision = UpdatePMCCollisionSettings();
+	for (int32 SectionIndex : ChangedSections)
+	{
+		SectionTriangles[SectionIndex].RemoveAllSwap([&](int32 tid) { return TriangleSections[tid] != SectionIndex; });
+		UpdatePMCSection(SectionIndex, bGenerateSectionCollision);
+	}
+
+	UpdatePMCConvexHullCollision();
+	return true;
+}
+
+int32 ADynamicPMCActor::GetTriangleSection(int32 TriangleID) const
+{
+	// triangles outside the bounds of the last full update are assigned to the boundary sections
+	FVector3d Centroid = SourceMesh.GetTriCentroid(TriangleID);
+	FVector3d GridSize = SectionGridBounds.Max - SectionGridBounds.Min;
+	int32 Cell[3];
+	for (int32 j = 0; j < 3; ++j)
+	{
+		Cell[j] = (GridSize[j] > FMathd::ZeroTolerance) ?
+			FMath::Clamp((int32)((Centroid[j] - SectionGridBounds.Min[j]) / GridSize[j] * (double)SectionGridResolution), 0, SectionGridResolution - 1) : 0;
+	}
+	return Cell[0] + SectionGridResolution * (Cell[1] + SectionGridResolution * Cell[2]);
+}
+
+void ADynamicPMCActor::UpdatePMCSection(int32 SectionIndex, bool bGenerateSectionCollision)
+{
+	if (SectionTriangles[SectionIndex].Num() == 0)
+	{
+		MeshComponent->ClearMeshSection(SectionIndex);
+		return;
+	}
+
+	bool bUseFaceNormals = (this->NormalsMode == EDynamicMeshActorNormalsMode::FaceNormals);
+	bool bUseUV0 = true;
+	bool bUseVertexColors = false;
+	RTGUtils::UpdatePMCSectionFromDynamicMesh_SplitTriangles(MeshComponent, SectionIndex, &SourceMesh, SectionTriangles[SectionIndex],
+		bUseFaceNormals, bUseUV0, bUseVertexColors, bGenerateSectionCollision);
+
+	UMaterialInterface* UseMaterial = (this->Material != nullptr) ? this->Material : UMaterial::GetDefaultMaterial(MD_Surface);
+	MeshComponent->SetMaterial(SectionIndex, UseMaterial);
+}
+
+bool ADynamicPMCActor::UpdatePMCCollisionSettings()
+{
+	if (this->CollisionMode == EDynamicMeshActorCollisionMode::ComplexAsSimple
+		|| this->CollisionMode == EDynamicMeshActorCollisionMode::ComplexAsSimpleAsync)
+	{
+		MeshComponent->bUseAsyncCooking = (this->CollisionMode == EDynamicMeshActorCollisionMode::ComplexAsSimpleAsync);
+		MeshComponent->bUseComplexAsSimpleCollision = true;
+		return true;
+	}
+	return false;
+}
+
+void ADynamicPMCActor::UpdatePMCConvexHullCollision()
+{
+	// generate convex collision
+	if (this->CollisionMode == EDynamicMeshActorCollisionMode::SimpleConvexHull)
+	{
+		FMeshConvexHull HullCompute(&SourceMesh);
+		int32 NumTris = FMath::Clamp(this->MaxHullTriangles, 0, 1000);
+		if (NumTris != 0)
+		{
+			HullCompute.bPostSimplify = true;
+			HullCompute.MaxTargetFaceCount = NumTris;
+		}
+		if (HullCompute.Compute())
+		{
+			TArray<FVector> Points;
+			for (FVector3d Pos : HullCompute.ConvexHull.VerticesItr())
+			{
+				Points.Add((FVector)Pos);
+			}
+			MeshComponent->bUseComplexAsSimpleCollision = false;
+			MeshComponent->ClearCollisionConvexMeshes();
+			MeshComponent->AddCollisionConvexMesh(Points);
+		}
+	}
 }
\ No newline at end of file
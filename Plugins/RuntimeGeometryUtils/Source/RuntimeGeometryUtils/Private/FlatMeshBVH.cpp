@@ -0,0 +1,368 @@
+#include "FlatMeshBVH.h"
+#include "Distance/DistPoint3Triangle3.h"
+
+
+namespace FlatMeshBVHLocals
+{
+	struct FBuildTriangle
+	{
+		FAxisAlignedBox3d Bounds;
+		FVector3d Centroid;
+		int32 TriangleID;
+	};
+
+	struct FBuildTask
+	{
+		int32 NodeIndex;
+		int32 Begin;
+		int32 End;
+	};
+
+	/** Split the triangles [Begin,End) at the midpoint of the longest axis of their centroid bounds. @return start of the second half */
+	static int32 PartitionTriangles(TArray<FBuildTriangle>& Triangles, int32 Begin, int32 End)
+	{
+		FAxisAlignedBox3d CentroidBounds = FAxisAlignedBox3d::Empty();
+		for (int32 k = Begin; k < End; ++k)
+		{
+			CentroidBounds.Contain(Triangles[k].Centroid);
+		}
+		FVector3d Extents = CentroidBounds.Max - CentroidBounds.Min;
+		int32 Axis = (Extents.X >= Extents.Y && Extents.X >= Extents.Z) ? 0 : ((Extents.Y >= Extents.Z) ? 1 : 2);
+
+		int32 Mid = Begin;
+		if (Extents[Axis] > FMathd::ZeroTolerance)
+		{
+			double SplitValue = CentroidBounds.Center()[Axis];
+			for (int32 k = Begin; k < End; ++k)
+			{
+				if (Triangles[k].Centroid[Axis] < SplitValue)
+				{
+					Swap(Triangles[k], Triangles[Mid]);
+					Mid++;
+				}
+			}
+		}
+		// coincident centroids or a one-sided split, in which case any split is as good as another
+		if (Mid == Begin || Mid == End)
+		{
+			Mid = (Begin + End) / 2;
+		}
+		return Mid;
+	}
+
+	/** @return true if the ray hits the box within [0,TMax], in which case TNearOut is the entry distance */
+	static FORCEINLINE bool IntersectBox(const FVector3f& Origin, const FVector3f& InvDirection, const float BoxMin[3], const float BoxMax[3], float TMax, float& TNearOut)
+	{
+		float TNear = 0, TFar = TMax;
+		for (int32 j = 0; j < 3; ++j)
+		{
+			float T1 = (BoxMin[j] - Origin[j]) * InvDirection[j];
+			float T2 = (BoxMax[j] - Origin[j]) * InvDirection[j];
+			TNear = FMath::Max(TNear, FMath::Min(T1, T2));
+			TFar = FMath::Min(TFar, FMath::Max(T1, T2));
+		}
+		TNearOut = TNear;
+		return TNear <= TFar;
+	}
+
+	/** @return squared distance from Point to the box */
+	static FORCEINLINE float BoxDistanceSqr(const FVector3f& Point, const float BoxMin[3], const float BoxMax[3])
+	{
+		float DistSqr = 0;
+		for (int32 j = 0; j < 3; ++j)
+		{
+			float Delta = FMath::Max3(BoxMin[j] - Point[j], 0.0f, Point[j] - BoxMax[j]);
+			DistSqr += Delta * Delta;
+		}
+		return DistSqr;
+	}
+
+	/** Moller-Trumbore ray-triangle intersection, both sides of the triangle are hit. U and V are the barycentric coordinates of V1 and V2. */
+	static FORCEINLINE bool IntersectTriangle(const FVector3f& Origin, const FVector3f& Direction,
+		const FVector3f& V0, const FVector3f& V1, const FVector3f& V2, float TMax, float& T, float& U, float& V)
+	{
+		FVector3f Edge1 = V1 - V0, Edge2 = V2 - V0;
+		FVector3f P = Direction.Cross(Edge2);
+		float Det = Edge1.Dot(P);
+		if (FMathf::Abs(Det) <= FMathf::ZeroTolerance * Edge1.Length() * Edge2.Length())
+		{
+			return false;
+		}
+		float InvDet = 1.0f / Det;
+		FVector3f S = Origin - V0;
+		U = S.Dot(P) * InvDet;
+		if (U < -FMathf::ZeroTolerance || U > 1.0f + FMathf::ZeroTolerance)
+		{
+			return false;
+		}
+		FVector3f Q = S.Cross(Edge1);
+		V = Direction.Dot(Q) * InvDet;
+		if (V < -FMathf::ZeroTolerance || U + V > 1.0f + FMathf::ZeroTolerance)
+		{
+			return false;
+		}
+		T = Edge2.Dot(Q) * InvDet;
+		return T >= 0 && T <= TMax;
+	}
+}
+
+
+void FFlatMeshBVH::Reset()
+{
+	Nodes.Empty();
+	Triangles.Empty();
+	SourceMesh = nullptr;
+	SourceTimestamp = 0;
+}
+
+
+bool FFlatMeshBVH::IsValidFor(const FDynamicMesh3& Mesh) const
+{
+	return SourceMesh == &Mesh && SourceTimestamp == Mesh.GetTimestamp();
+}
+
+
+void FFlatMeshBVH::Build(const FDynamicMesh3& Mesh)
+{
+	using namespace FlatMeshBVHLocals;
+	Reset();
+	SourceMesh = &Mesh;
+	SourceTimestamp = Mesh.GetTimestamp();
+
+	TArray<FBuildTriangle> BuildTriangles;
+	BuildTriangles.Reserve(Mesh.TriangleCount());
+	for (int32 tid : Mesh.TriangleIndicesItr())
+	{
+		FBuildTriangle& Triangle = BuildTriangles.AddDefaulted_GetRef();
+		Triangle.Bounds = Mesh.GetTriBounds(tid);
+		Triangle.Centroid = Mesh.GetTriCentroid(tid);
+		Triangle.TriangleID = tid;
+	}
+	int32 NumTriangles = BuildTriangles.Num();
+	if (NumTriangles == 0)
+	{
+		return;
+	}
+
+	// boxes are padded slightly when converted to single precision, so that they still contain their triangles
+	auto SetChildBox = [this](int32 NodeIndex, int32 k, const FAxisAlignedBox3d& Box)
+	{
+		FNode& Node = Nodes[NodeIndex];
+		double MaxCoord = FMathd::Max3(FMathd::Abs(Box.Min.X), FMathd::Abs(Box.Min.Y), FMathd::Abs(Box.Min.Z));
+		MaxCoord = FMathd::Max(MaxCoord, FMathd::Max3(FMathd::Abs(Box.Max.X), FMathd::Abs(Box.Max.Y), FMathd::Abs(Box.Max.Z)));
+		double Padding = FMathf::ZeroTolerance * (MaxCoord + 1.0);
+		for (int32 j = 0; j < 3; ++j)
+		{
+			Node.ChildMin[k][j] = (float)(Box.Min[j] - Padding);
+			Node.ChildMax[k][j] = (float)(Box.Max[j] + Padding);
+		}
+	};
+
+	Nodes.Reserve(FMath::Max(1, 2 * NumTriangles / MaxLeafTriangles));
+	Nodes.AddDefaulted();
+	TArray<FBuildTask> Tasks;
+	Tasks.Add({ 0, 0, NumTriangles });
+	while (Tasks.Num() > 0)
+	{
+		FBuildTask Task = Tasks.Pop(false);
+		int32 Mid = PartitionTriangles(BuildTriangles, Task.Begin, Task.End);
+		int32 ChildRanges[2][2] = { { Task.Begin, Mid }, { Mid, Task.End } };
+		for (int32 k = 0; k < 2; ++k)
+		{
+			int32 Begin = ChildRanges[k][0], End = ChildRanges[k][1];
+			if (Begin == End)
+			{
+				// only possible for a root with a single triangle. The inverted box is never hit.
+				FNode& Node = Nodes[Task.NodeIndex];
+				Node.ChildIndex[k] = -1;
+				Node.ChildTriCount[k] = 0;
+				for (int32 j = 0; j < 3; ++j)
+				{
+					Node.ChildMin[k][j] = TNumericLimits<float>::Max();
+					Node.ChildMax[k][j] = -TNumericLimits<float>::Max();
+				}
+				continue;
+			}
+
+			FAxisAlignedBox3d Box = FAxisAlignedBox3d::Empty();
+			for (int32 j = Begin; j < End; ++j)
+			{
+				Box.Contain(BuildTriangles[j].Bounds);
+			}
+			SetChildBox(Task.NodeIndex, k, Box);
+
+			if (End - Begin <= MaxLeafTriangles)
+			{
+				Nodes[Task.NodeIndex].ChildIndex[k] = Begin;
+				Nodes[Task.NodeIndex].ChildTriCount[k] = End - Begin;
+			}
+			else
+			{
+				int32 ChildNodeIndex = Nodes.AddDefaulted();
+				Nodes[Task.NodeIndex].ChildIndex[k] = ChildNodeIndex;
+				Nodes[Task.NodeIndex].ChildTriCount[k] = 0;
+				Tasks.Add({ ChildNodeIndex, Begin, End });
+			}
+		}
+	}
+
+	Triangles.SetNumUninitialized(NumTriangles);
+	for (int32 k = 0; k < NumTriangles; ++k)
+	{
+		FVector3d A, B, C;
+		Mesh.GetTriVertices(BuildTriangles[k].TriangleID, A, B, C);
+		Triangles[k].V0 = FVector3f(A);
+		Triangles[k].V1 = FVector3f(B);
+		Triangles[k].V2 = FVector3f(C);
+		Triangles[k].TriangleID = BuildTriangles[k].TriangleID;
+	}
+}
+
+
+int32 FFlatMeshBVH::FindNearestTriangle(const FVector3d& Point, double& NearestDistSqrOut, FVector3d& NearestPointOut, FVector3d& BaryCoordsOut) const
+{
+	using namespace FlatMeshBVHLocals;
+	int32 NearestTriangle = -1;
+	NearestDistSqrOut = TNumericLimits<double>::Max();
+	if (Nodes.Num() == 0)
+	{
+		return NearestTriangle;
+	}
+
+	struct FStackEntry
+	{
+		int32 NodeIndex;
+		float DistSqr;
+	};
+	TArray<FStackEntry, TInlineAllocator<64>> Stack;
+	Stack.Add({ 0, 0.0f });
+	FVector3f QueryPoint(Point);
+	while (Stack.Num() > 0)
+	{
+		FStackEntry Entry = Stack.Pop(false);
+		if (Entry.DistSqr > NearestDistSqrOut)
+		{
+			continue;
+		}
+
+		const FNode& Node = Nodes[Entry.NodeIndex];
+		float ChildDistSqr[2];
+		for (int32 k = 0; k < 2; ++k)
+		{
+			ChildDistSqr[k] = (Node.ChildIndex[k] >= 0) ? BoxDistanceSqr(QueryPoint, Node.ChildMin[k], Node.ChildMax[k]) : TNumericLimits<float>::Max();
+		}
+		int32 Nearer = (ChildDistSqr[1] < ChildDistSqr[0]) ? 1 : 0;
+		int32 Order[2] = { Nearer, 1 - Nearer };
+
+		// test leaf triangles nearest-first, then push inner nodes so that the nearer one is popped first
+		for (int32 k : Order)
+		{
+			if (Node.ChildTriCount[k] > 0 && ChildDistSqr[k] <= NearestDistSqrOut)
+			{
+				for (int32 j = 0; j < Node.ChildTriCount[k]; ++j)
+				{
+					const FTriangle& Triangle = Triangles[Node.ChildIndex[k] + j];
+					FDistPoint3Triangle3d DistQuery(Point, FTriangle3d((FVector3d)Triangle.V0, (FVector3d)Triangle.V1, (FVector3d)Triangle.V2));
+					double DistSqr = DistQuery.GetSquared();
+					if (DistSqr < NearestDistSqrOut)
+					{
+						NearestDistSqrOut = DistSqr;
+						NearestTriangle = Triangle.TriangleID;
+						NearestPointOut = DistQuery.ClosestTrianglePoint;
+						BaryCoordsOut = DistQuery.TriangleBaryCoords;
+					}
+				}
+			}
+		}
+		for (int32 j = 1; j >= 0; --j)
+		{
+			int32 k = Order[j];
+			if (Node.ChildIndex[k] >= 0 && Node.ChildTriCount[k] == 0 && ChildDistSqr[k] <= NearestDistSqrOut)
+			{
+				Stack.Add({ Node.ChildIndex[k], ChildDistSqr[k] });
+			}
+		}
+	}
+	return NearestTriangle;
+}
+
+
+int32 FFlatMeshBVH::FindNearestHitTriangle(const FRay3d& Ray, double MaxDistance, double& RayParameterOut, FVector3d& BaryCoordsOut) const
+{
+	using namespace FlatMeshBVHLocals;
+	int32 HitTriangle = -1;
+	if (Nodes.Num() == 0)
+	{
+		return HitTriangle;
+	}
+
+	FVector3f Origin(Ray.Origin), Direction(Ray.Direction), InvDirection;
+	for (int32 j = 0; j < 3; ++j)
+	{
+		// avoid infinities, which would produce NaNs in the slab test for rays lying in a box plane
+		InvDirection[j] = (FMathf::Abs(Direction[j]) > FMathf::ZeroTolerance) ? (1.0f / Direction[j]) : FMathf::SignNonZero(Direction[j]) * 1e30f;
+	}
+	float TMax = (MaxDistance > 0) ? (float)MaxDistance : TNumericLimits<float>::Max();
+	float HitU = 0, HitV = 0;
+
+	struct FStackEntry
+	{
+		int32 NodeIndex;
+		float TNear;
+	};
+	TArray<FStackEntry, TInlineAllocator<64>> Stack;
+	Stack.Add({ 0, 0.0f });
+	while (Stack.Num() > 0)
+	{
+		FStackEntry Entry = Stack.Pop(false);
+		if (Entry.TNear > TMax)
+		{
+			continue;
+		}
+
+		const FNode& Node = Nodes[Entry.NodeIndex];
+		float ChildTNear[2];
+		bool bChildHit[2];
+		for (int32 k = 0; k < 2; ++k)
+		{
+			bChildHit[k] = Node.ChildIndex[k] >= 0 && IntersectBox(Origin, InvDirection, Node.ChildMin[k], Node.ChildMax[k], TMax, ChildTNear[k]);
+		}
+		int32 Nearer = (bChildHit[1] && (!bChildHit[0] || ChildTNear[1] < ChildTNear[0])) ? 1 : 0;
+		int32 Order[2] = { Nearer, 1 - Nearer };
+
+		// test leaf triangles nearest-first, then push inner nodes so that the nearer one is popped first
+		for (int32 k : Order)
+		{
+			if (bChildHit[k] && Node.ChildTriCount[k] > 0 && ChildTNear[k] <= TMax)
+			{
+				for (int32 j = 0; j < Node.ChildTriCount[k]; ++j)
+				{
+					const FTriangle& Triangle = Triangles[Node.ChildIndex[k] + j];
+					float T, U, V;
+					if (IntersectTriangle(Origin, Direction, Triangle.V0, Triangle.V1, Triangle.V2, TMax, T, U, V))
+					{
+						TMax = T;
+						HitU = U;
+						HitV = V;
+						HitTriangle = Triangle.TriangleID;
+					}
+				}
+			}
+		}
+		for (int32 j = 1; j >= 0; --j)
+		{
+			int32 k = Order[j];
+			if (bChildHit[k] && Node.ChildTriCount[k] == 0 && ChildTNear[k] <= TMax)
+			{
+				Stack.Add({ Node.ChildIndex[k], ChildTNear[k] });
+			}
+		}
+	}
+
+	if (HitTriangle >= 0)
+	{
+		RayParameterOut = TMax;
+		BaryCoordsOut = FVector3d(1.0 - HitU - HitV, HitU, HitV);
+	}
+	return HitTriangle;
+}
@@ -9,22 +9,159 @@
 #include "Generators/GridBoxMeshGenerator.h"
 #include "Generators/BoxSphereGenerator.h"
 #include "Generators/SweepGenerator.h"
+#include "Generators/MeshShapeGenerator.h"
 
 #include "DynamicMeshEditor.h"
 #include "MeshSimplification.h"
 #include "MeshConstraintsUtil.h"
+#include "MeshPartitionedSimplify.h"
 #include "Operations/MeshBoolean.h"
-#include "Implicit/Solidify.h"
+#include "SparseSolidify.h"
 #include "Operations/MeshPlaneCut.h"
 #include "Operations/MeshMirror.h"
 #include "ConstrainedDelaunay2.h"
 
 #include "MeshComponentRuntimeUtils.h"
 #include "DynamicMeshOBJReader.h"
-
+#include "DynamicMeshCache.h"
+#include "UpdatableMeshAABBTree3.h"
+#include "MeshBooleanBroadPhase.h"
+#include "MeshBooleanOps.h"
+#include "MeshBooleanCache.h"
+
+#include "Async/ParallelFor.h"
+#include "Misc/ScopeLock.h"
 #include "Engine/Engine.h"		// so that we can call GEngine->ForceGarbageCollection
 
 
+namespace GeneratedMeshLocals
+{
+	enum class EPrimitiveTemplateType : int32
+	{
+		AxisBox,
+		Sphere,
+		SphereBox,
+		Cylinder,
+		Revolve,
+		Extrusion
+	};
+
+	/** Identifies a primitive template by generator type and all generator parameters */
+	struct FPrimitiveTemplateKey
+	{
+		EPrimitiveTemplateType Type;
+		TArray<double> Params;
+
+		bool operator==(const FPrimitiveTemplateKey& Other) const
+		{
+			return Type == Other.Type && Params == Other.Params;
+		}
+
+		friend uint32 GetTypeHash(const FPrimitiveTemplateKey& Key)
+		{
+			return FCrc::MemCrc32(Key.Params.GetData(), Key.Params.Num() * sizeof(double), (uint32)Key.Type);
+		}
+	};
+
+	/** Stored output of a shape generator. Generate() does nothing, the arrays are copied from the generator that created the template. */
+	class FPrimitiveTemplate : public FMeshShapeGenerator
+	{
+	public:
+		explicit FPrimitiveTemplate(const FMeshShapeGenerator& Generated)
+		{
+			static_cast<FMeshShapeGenerator&>(*this) = Generated;
+		}
+
+		virtual FMeshShapeGenerator& Generate() override
+		{
+			return *this;
+		}
+	};
+
+	/**
+	 * Templates shared by all UGeneratedMesh instances. The number of templates is bounded because
+	 * polygon-based primitives (revolve, extrude) can create an unbounded number of distinct keys.
+	 */
+	static const int32 MaxPrimitiveTemplates = 512;
+	static TMap<FPrimitiveTemplateKey, TSharedPtr<const FPrimitiveTemplate, ESPMode::ThreadSafe>> PrimitiveTemplates;
+	static FCriticalSection PrimitiveTemplatesLock;
+
+	/**
+	 * @return cached template for Key, created by calling GenerateFunc if it does not exist yet
+	 */
+	static TSharedPtr<const FPrimitiveTemplate, ESPMode::ThreadSafe> FindOrCreateTemplate(
+		const FPrimitiveTemplateKey& Key, 
+		TFunctionRef<FMeshShapeGenerator&()> GenerateFunc)
+	{
+		{
+			FScopeLock Lock(&PrimitiveTemplatesLock);
+			if (const TSharedPtr<const FPrimitiveTemplate, ESPMode::ThreadSafe>* Found = PrimitiveTemplates.Find(Key))
+			{
+				return *Found;
+			}
+		}
+
+		TSharedPtr<const FPrimitiveTemplate, ESPMode::ThreadSafe> NewTemplate = MakeShared<FPrimitiveTemplate, ESPMode::ThreadSafe>(GenerateFunc());
+
+		FScopeLock Lock(&PrimitiveTemplatesLock);
+		if (PrimitiveTemplates.Num() >= MaxPrimitiveTemplates)
+		{
+			PrimitiveTemplates.Reset();
+		}
+		PrimitiveTemplates.Add(Key, NewTemplate);
+		return NewTemplate;
+	}
+
+
+	/** @return linear part of Transform as a matrix, ie the columns are the transformed axes */
+	static FMatrix3d GetLinearPart(const FTransform3d& Transform)
+	{
+		return FMatrix3d(
+			Transform.TransformVector(FVector3d::UnitX()),
+			Transform.TransformVector(FVector3d::UnitY()),
+			Transform.TransformVector(FVector3d::UnitZ()), false);
+	}
+
+	/** @return matrix that transforms normals for the given linear transform, ie the inverse-transpose if it is not degenerate */
+	static FMatrix3d GetNormalMatrix(const FMatrix3d& Linear)
+	{
+		return (FMathd::Abs(Linear.Determinant()) > FMathd::ZeroTolerance) ? Linear.Inverse().Transpose() : Linear;
+	}
+
+	/** Apply Position' = Linear * Position + Translation to Mesh, and transform the vertex normals and primary normal overlay with the normal matrix */
+	static void ApplyLinearTransform(FDynamicMesh3& Mesh, const FMatrix3d& Linear, const FVector3d& Translation)
+	{
+		const FMatrix3d NormalMatrix = GetNormalMatrix(Linear);
+		bool bVertexNormals = Mesh.HasVertexNormals();
+		ParallelFor(Mesh.MaxVertexID(), [&](int32 vid)
+		{
+			if (Mesh.IsVertex(vid))
+			{
+				Mesh.SetVertex(vid, Linear * Mesh.GetVertex(vid) + Translation);
+				if (bVertexNormals)
+				{
+					FVector3d Normal = NormalMatrix * (FVector3d)Mesh.GetVertexNormal(vid);
+					Mesh.SetVertexNormal(vid, (FVector3f)Normal.Normalized());
+				}
+			}
+		});
+
+		if (Mesh.HasAttributes())
+		{
+			FDynamicMeshNormalOverlay* Normals = Mesh.Attributes()->PrimaryNormals();
+			ParallelFor(Normals->MaxElementID(), [&](int32 eid)
+			{
+				if (Normals->IsElement(eid))
+				{
+					FVector3d Normal = NormalMatrix * (FVector3d)Normals->GetElement(eid);
+					Normals->SetElement(eid, (FVector3f)Normal.Normalized());
+				}
+			});
+		}
+	}
+}
+
+
 UGeneratedMesh::UGeneratedMesh()
 {
 	Mesh = MakeUnique<FDynamicMesh3>();
@@ -36,6 +173,7 @@ UGeneratedMesh::UGeneratedMesh()
 
 UGeneratedMesh* UGeneratedMesh::ResetMesh()
 {
+	ClearPendingTransform();
 	Mesh->Clear();
 	Mesh->EnableTriangleGroups();
 	Mesh->EnableAttributes();
@@ -44,28 +182,67 @@ UGeneratedMesh* UGeneratedMesh::ResetMesh()
 	return this;
 }
 
-void UGeneratedMesh::OnMeshUpdated()
+void UGeneratedMesh::OnMeshUpdated(bool bPositionsOnly)
+{
+	// after position-only edits the existing trees are refit in GetAABBTree()
+	if (!bPositionsOnly)
+	{
+		MeshAABBTree = nullptr;
+		FastWinding = nullptr;
+	}
+	bHaveContentHash = false;
+	InsideQueryGrid.Reset();
+	DistanceGrid.Reset();
+	ProgressiveLODTriangleCount = -1;
+}
+
+
+uint64 UGeneratedMesh::GetContentHash()
 {
-	MeshAABBTree = nullptr;
-	FastWinding = nullptr;
+	ApplyPendingTransform();
+	if (!bHaveContentHash || ContentHashTimestamp != Mesh->GetTimestamp())
+	{
+		ContentHash = RTGUtils::ComputeMeshContentHash(*Mesh);
+		ContentHashTimestamp = Mesh->GetTimestamp();
+		bHaveContentHash = true;
+	}
+	return ContentHash;
 }
 
 
-TUniquePtr<FDynamicMeshAABBTree3>& UGeneratedMesh::GetAABBTree()
+TUniquePtr<FUpdatableMeshAABBTree3>& UGeneratedMesh::GetAABBTree()
 {
+	ApplyPendingTransform();
 	if (!MeshAABBTree)
 	{
-		MeshAABBTree = MakeUnique<FDynamicMeshAABBTree3>(Mesh.Get(), true);
+		MeshAABBTree = MakeUnique<FUpdatableMeshAABBTree3>(Mesh.Get(), true);
+	}
+	else
+	{
+		// If the mesh was modified but the topology is unchanged, Update() refits the existing tree 
+		// and the FastWinding expansion coefficients are recomputed on it, instead of rebuilding both
+		bool bWasRefit = MeshAABBTree->CanRefit();
+		if (MeshAABBTree->Update())
+		{
+			if (FastWinding && bWasRefit)
+			{
+				FastWinding->Build();
+			}
+			else
+			{
+				FastWinding = nullptr;
+			}
+		}
 	}
 	return MeshAABBTree;
 }
 
 const TUniquePtr<TFastWindingTree<FDynamicMesh3>>& UGeneratedMesh::GetFastWindingTree()
 {
+	// always update the AABBTree first, this also updates or discards an existing FastWinding
+	const TUniquePtr<FUpdatableMeshAABBTree3>& AABBTree = GetAABBTree();
 	if (!FastWinding)
 	{
-		const TUniquePtr<FDynamicMeshAABBTree3>& AABBTree = GetAABBTree();
-
 		FastWinding = MakeUnique<TFastWindingTree<FDynamicMesh3>>(AABBTree.Get(), true);
 	}
 	return FastWinding;
@@ -74,16 +251,20 @@ const TUniquePtr<TFastWindingTree<FDynamicMesh3>>& UGeneratedMesh::GetFastWindin
 
 UGeneratedMesh* UGeneratedMesh::InitializeFrom(ADynamicMeshBaseActor* MeshActor)
 {
+	ClearPendingTransform();
 	*Mesh = MeshActor->GetMeshRef();
 	ClearAppendTransform();
 	OnMeshUpdated();
 	return this;
 }
 
-bool UGeneratedMesh::ReadMeshFromFile(FString Path, bool bFlipOrientation)
+bool UGeneratedMesh::ReadMeshFromFile(FString Path, bool bFlipOrientation, bool bUseMeshCache)
 {
 	FDynamicMesh3 ImportedMesh;
-	if (!RTGUtils::ReadOBJMesh(Path, ImportedMesh, true, true, true, bFlipOrientation))
+	bool bRead = (bUseMeshCache) ?
+		RTGUtils::ReadOBJMeshCached(Path, ImportedMesh, true, true, true, bFlipOrientation)
+		: RTGUtils::ReadOBJMesh(Path, ImportedMesh, true, true, true, bFlipOrientation);
+	if (!bRead)
 	{
 		UE_LOG(LogTemp, Warning, TEXT("Error reading mesh file %s"), *Path);
 		return false;
@@ -91,6 +272,7 @@ bool UGeneratedMesh::ReadMeshFromFile(FString Path, bool bFlipOrientation)
 
 	ImportedMesh.EnableAttributes();
 
+	ClearPendingTransform();
 	*Mesh = MoveTemp(ImportedMesh);
 	ClearAppendTransform();
 	OnMeshUpdated();
@@ -100,7 +282,9 @@ bool UGeneratedMesh::ReadMeshFromFile(FString Path, bool bFlipOrientation)
 
 UGeneratedMesh* UGeneratedMesh::MakeDuplicate(UGeneratedMesh* MeshObj)
 {
-	*Mesh = *(MeshObj->Mesh);
+	const FDynamicMesh3& SourceMesh = *MeshObj->GetMesh();
+	ClearPendingTransform();
+	*Mesh = SourceMesh;
 	OnMeshUpdated();
 	return this;
 }
@@ -124,6 +308,7 @@ void UGeneratedMesh::AppendMeshWithAppendTransform(FDynamicMesh3&& ToAppend, boo
 {
 	MeshTransforms::ApplyTransform(ToAppend, AppendTransform);
 
+	ApplyPendingTransform();
 	FMeshIndexMappings Mappings;
 	FDynamicMeshEditor Editor(Mesh.Get());
 	Editor.AppendMesh(&ToAppend, Mappings);
@@ -136,13 +321,99 @@ void UGeneratedMesh::AppendMeshWithAppendTransform(FDynamicMesh3&& ToAppend, boo
 
 
 
+void UGeneratedMesh::AppendGeneratorWithAppendTransform(const FMeshShapeGenerator& Generator, bool bPostMeshUpdate)
+{
+	ApplyPendingTransform();
+	FDynamicMesh3& TargetMesh = *Mesh;
+
+	// IDs are mapped because the target mesh may re-use free vertex/element slots
+	TArray<int32> VertexMap;
+	VertexMap.SetNumUninitialized(Generator.Vertices.Num());
+	for (int32 k = 0; k < Generator.Vertices.Num(); ++k)
+	{
+		VertexMap[k] = TargetMesh.AppendVertex(AppendTransform.TransformPosition(Generator.Vertices[k]));
+	}
+
+	// generator polygon IDs are dense, so they are offset into a new range of groups
+	int32 GroupOffset = (TargetMesh.HasTriangleGroups()) ? TargetMesh.MaxGroupID() : 0;
+
+	FDynamicMeshNormalOverlay* Normals = nullptr;
+	FDynamicMeshUVOverlay* UVs = nullptr;
+	TArray<int32> NormalMap, UVMap;
+	if (TargetMesh.HasAttributes())
+	{
+		Normals = TargetMesh.Attributes()->PrimaryNormals();
+		NormalMap.SetNumUninitialized(Generator.Normals.Num());
+		for (int32 k = 0; k < Generator.Normals.Num(); ++k)
+		{
+			FVector3d Normal = AppendTransform.TransformNormal((FVector3d)Generator.Normals[k]);
+			NormalMap[k] = Normals->AppendElement((FVector3f)Normal);
+		}
+
+		UVs = TargetMesh.Attributes()->PrimaryUV();
+		UVMap.SetNumUninitialized(Generator.UVs.Num());
+		for (int32 k = 0; k < Generator.UVs.Num(); ++k)
+		{
+			UVMap[k] = UVs->AppendElement(Generator.UVs[k]);
+		}
+	}
+
+	bool bHaveNormalTris = Normals && Generator.TriangleNormals.Num() == Generator.Triangles.Num();
+	bool bHaveUVTris = UVs && Generator.TriangleUVs.Num() == Generator.Triangles.Num();
+	bool bHaveGroups = Generator.TrianglePolygonIDs.Num() == Generator.Triangles.Num();
+	for (int32 k = 0; k < Generator.Triangles.Num(); ++k)
+	{
+		const FIndex3i& Tri = Generator.Triangles[k];
+		int32 GroupID = (bHaveGroups) ? (GroupOffset + Generator.TrianglePolygonIDs[k]) : GroupOffset;
+		int32 tid = TargetMesh.AppendTriangle(VertexMap[Tri.A], VertexMap[Tri.B], VertexMap[Tri.C], GroupID);
+		if (tid < 0)
+		{
+			continue;
+		}
+		if (bHaveNormalTris)
+		{
+			const FIndex3i& NormalTri = Generator.TriangleNormals[k];
+			Normals->SetTriangle(tid, FIndex3i(NormalMap[NormalTri.A], NormalMap[NormalTri.B], NormalMap[NormalTri.C]));
+		}
+		if (bHaveUVTris)
+		{
+			const FIndex3i& UVTri = Generator.TriangleUVs[k];
+			UVs->SetTriangle(tid, FIndex3i(UVMap[UVTri.A], UVMap[UVTri.B], UVMap[UVTri.C]));
+		}
+	}
+
+	if (bPostMeshUpdate)
+	{
+		OnMeshUpdated();
+	}
+}
+
+
+
+void UGeneratedMesh::ClearPrimitiveTemplateCache()
+{
+	using namespace GeneratedMeshLocals;
+	FScopeLock Lock(&PrimitiveTemplatesLock);
+	PrimitiveTemplates.Reset();
+}
+
+
+
 UGeneratedMesh* UGeneratedMesh::AppendAxisBox(FVector Min, FVector Max, int32 StepsX, int32 StepsY, int32 StepsZ)
 {
-	FAxisAlignedBox3d AxisBox((FVector3d)Min, (FVector3d)Max);
+	using namespace GeneratedMeshLocals;
+	StepsX = FMath::Max(0, StepsX);
+	StepsY = FMath::Max(0, StepsY);
+	StepsZ = FMath::Max(0, StepsZ);
+	FPrimitiveTemplateKey Key{ EPrimitiveTemplateType::AxisBox, { Min.X, Min.Y, Min.Z, Max.X, Max.Y, Max.Z, (double)StepsX, (double)StepsY, (double)StepsZ } };
 	FGridBoxMeshGenerator BoxGen;
-	BoxGen.Box = FOrientedBox3d(AxisBox);
-	BoxGen.EdgeVertices = { FMath::Max(0,StepsX), FMath::Max(0,StepsY), FMath::Max(0,StepsZ) };
-	AppendMeshWithAppendTransform(FDynamicMesh3(&BoxGen.Generate()), true);
+	AppendGeneratorWithAppendTransform(*FindOrCreateTemplate(Key, [&]() -> FMeshShapeGenerator&
+	{
+		FAxisAlignedBox3d AxisBox((FVector3d)Min, (FVector3d)Max);
+		BoxGen.Box = FOrientedBox3d(AxisBox);
+		BoxGen.EdgeVertices = { StepsX, StepsY, StepsZ };
+		return BoxGen.Generate();
+	}), true);
 	return this;
 }
 
@@ -155,50 +426,58 @@ UGeneratedMesh* UGeneratedMesh::AppendBox(FBox Box, int32 StepsX, int32 StepsY,
 
 UGeneratedMesh* UGeneratedMesh::AppendSphere(float Radius, int32 Slices, int32 Stacks)
 {
+	using namespace GeneratedMeshLocals;
+	FPrimitiveTemplateKey Key{ EPrimitiveTemplateType::Sphere, { Radius, (double)Slices, (double)Stacks } };
 	FSphereGenerator SphereGen;
-	SphereGen.NumPhi = Stacks;
-	SphereGen.NumTheta = Slices;
-	SphereGen.Radius = Radius;
-	AppendMeshWithAppendTransform( FDynamicMesh3(&SphereGen.Generate()), true);
+	AppendGeneratorWithAppendTransform(*FindOrCreateTemplate(Key, [&]() -> FMeshShapeGenerator&
+	{
+		SphereGen.NumPhi = Stacks;
+		SphereGen.NumTheta = Slices;
+		SphereGen.Radius = Radius;
+		return SphereGen.Generate();
+	}), true);
 	return this;
 }
 
 
 UGeneratedMesh* UGeneratedMesh::AppendSphereBox(float Radius, int32 Steps)
 {
+	using namespace GeneratedMeshLocals;
+	Steps = FMath::Max(0, Steps);
+	FPrimitiveTemplateKey Key{ EPrimitiveTemplateType::SphereBox, { Radius, (double)Steps } };
 	FBoxSphereGenerator SphereGen;
-	SphereGen.Box = FOrientedBox3d();
-	SphereGen.Radius = Radius;
-	SphereGen.EdgeVertices = { FMath::Max(0,Steps), FMath::Max(0,Steps), FMath::Max(0,Steps) };
-	AppendMeshWithAppendTransform(FDynamicMesh3(&SphereGen.Generate()), true);
+	AppendGeneratorWithAppendTransform(*FindOrCreateTemplate(Key, [&]() -> FMeshShapeGenerator&
+	{
+		SphereGen.Box = FOrientedBox3d();
+		SphereGen.Radius = Radius;
+		SphereGen.EdgeVertices = { Steps, Steps, Steps };
+		return SphereGen.Generate();
+	}), true);
 	return this;
 }
 
 
 UGeneratedMesh* UGeneratedMesh::AppendCylinder(float Radius, float Height, int32 Slices, int32 Stacks, bool bCapped)
 {
-	FCylinderGenerator CylGen;
-	CylGen.Radius[0] = Radius;
-	CylGen.Radius[1] = Radius;
-	CylGen.Height = Height;
-	CylGen.LengthSamples = Stacks;
-	CylGen.AngleSamples = Slices;
-	CylGen.bCapped = bCapped;
-	AppendMeshWithAppendTransform(FDynamicMesh3(&CylGen.Generate()), true);
-	return this;
+	return AppendCone(Radius, Radius, Height, Slices, Stacks, bCapped);
 }
 
 
 UGeneratedMesh* UGeneratedMesh::AppendCone(float BaseRadius, float TopRadius, float Height, int32 Slices, int32 Stacks, bool bCapped)
 {
+	using namespace GeneratedMeshLocals;
+	FPrimitiveTemplateKey Key{ EPrimitiveTemplateType::Cylinder, { BaseRadius, TopRadius, Height, (double)Slices, (double)Stacks, (bCapped) ? 1.0 : 0.0 } };
 	FCylinderGenerator CylGen;
-	CylGen.Radius[0] = BaseRadius;
-	CylGen.Radius[1] = TopRadius;
-	CylGen.Height = Height;
-	CylGen.LengthSamples = Stacks;
-	CylGen.AngleSamples = Slices;
-	CylGen.bCapped = bCapped;
-	AppendMeshWithAppendTransform(FDynamicMesh3(&CylGen.Generate()), true);
+	AppendGeneratorWithAppendTransform(*FindOrCreateTemplate(Key, [&]() -> FMeshShapeGenerator&
+	{
+		CylGen.Radius[0] = BaseRadius;
+		CylGen.Radius[1] = TopRadius;
+		CylGen.Height = Height;
+		CylGen.LengthSamples = Stacks;
+		CylGen.AngleSamples = Slices;
+		CylGen.bCapped = bCapped;
+		return CylGen.Generate();
+	}), true);
 	return this;
 }
 
@@ -218,66 +497,195 @@ UGeneratedMesh* UGeneratedMesh::AppendTorus(float Radius, float SectionRadius, i
 
 UGeneratedMesh* UGeneratedMesh::AppendRevolvePolygon(TArray<FVector2D> Polygon, float Radius, int RevolveSteps)
 {
+	using namespace GeneratedMeshLocals;
 	if (Polygon.Num() < 3) return this;
-	FGeneralizedCylinderGenerator RevolveGen;
-	for (FVector2D v : Polygon)
+	FPrimitiveTemplateKey Key{ EPrimitiveTemplateType::Revolve, { Radius, (double)RevolveSteps } };
+	for (const FVector2D& v : Polygon)
 	{
-		RevolveGen.CrossSection.AppendVertex(FVector2d(v));
+		Key.Params.Add(v.X);
+		Key.Params.Add(v.Y);
 	}
-	FPolygon2d PathPoly = FPolygon2d::MakeCircle(Radius, RevolveSteps);
-	for (FVector2d v : PathPoly.GetVertices())
+	FGeneralizedCylinderGenerator RevolveGen;
+	AppendGeneratorWithAppendTransform(*FindOrCreateTemplate(Key, [&]() -> FMeshShapeGenerator&
 	{
-		RevolveGen.Path.Add(v);
-	}
-	RevolveGen.bLoop = true;
-	RevolveGen.bCapped = false;
-	RevolveGen.bPolygroupPerQuad = true;
-	RevolveGen.InitialFrame = FFrame3d(RevolveGen.Path[0]);
-	AppendMeshWithAppendTransform(FDynamicMesh3(&RevolveGen.Generate()), true);
+		for (FVector2D v : Polygon)
+		{
+			RevolveGen.CrossSection.AppendVertex(FVector2d(v));
+		}
+		FPolygon2d PathPoly = FPolygon2d::MakeCircle(Radius, RevolveSteps);
+		for (FVector2d v : PathPoly.GetVertices())
+		{
+			RevolveGen.Path.Add(v);
+		}
+		RevolveGen.bLoop = true;
+		RevolveGen.bCapped = false;
+		RevolveGen.bPolygroupPerQuad = true;
+		RevolveGen.InitialFrame = FFrame3d(RevolveGen.Path[0]);
+		return RevolveGen.Generate();
+	}), true);
 	return this;
 }
 
 
 UGeneratedMesh* UGeneratedMesh::AppendExtrusion(TArray<FVector2D> Polygon, float Height, bool bCapped)
 {
+	using namespace GeneratedMeshLocals;
 	if (Polygon.Num() < 3) return this;
-	FGeneralizedCylinderGenerator ExtrudeGen;
+	FPrimitiveTemplateKey Key{ EPrimitiveTemplateType::Extrusion, { Height, (bCapped) ? 1.0 : 0.0 } };
 	for (const FVector2D& V : Polygon)
 	{
-		ExtrudeGen.CrossSection.AppendVertex((FVector2d)V);
+		Key.Params.Add(V.X);
+		Key.Params.Add(V.Y);
 	}
-	ExtrudeGen.Path.Add(FVector3d::Zero());
-	ExtrudeGen.Path.Add(FVector3d(0, 0, Height));
-	ExtrudeGen.InitialFrame = FFrame3d();
-	ExtrudeGen.bCapped = bCapped;
-	ExtrudeGen.bPolygroupPerQuad = true;
-	AppendMeshWithAppendTransform(FDynamicMesh3(&ExtrudeGen.Generate()), true);
+	FGeneralizedCylinderGenerator ExtrudeGen;
+	AppendGeneratorWithAppendTransform(*FindOrCreateTemplate(Key, [&]() -> FMeshShapeGenerator&
+	{
+		for (const FVector2D& V : Polygon)
+		{
+			ExtrudeGen.CrossSection.AppendVertex((FVector2d)V);
+		}
+		ExtrudeGen.Path.Add(FVector3d::Zero());
+		ExtrudeGen.Path.Add(FVector3d(0, 0, Height));
+		ExtrudeGen.InitialFrame = FFrame3d();
+		ExtrudeGen.bCapped = bCapped;
+		ExtrudeGen.bPolygroupPerQuad = true;
+		return ExtrudeGen.Generate();
+	}), true);
 	return this;
 }
 
 
 UGeneratedMesh* UGeneratedMesh::AppendTiled(UGeneratedMesh* OtherMeshObj, FTransform TransformIn, int RepeatCount, bool bApplyBefore)
 {
-	if (!OtherMeshObj) return this;
-	// make a copy of other mesh so we can apply repeat transforms. This is necessary only for nonuniform scaling.
-	FDynamicMesh3 AppendMesh = *OtherMeshObj->GetMesh();
-	FTransform3d Transformd(TransformIn);
+	using namespace GeneratedMeshLocals;
+	if (!OtherMeshObj || RepeatCount <= 0) return this;
 
-	FMeshIndexMappings Mappings;
+	// compact copy of the other mesh, so tile element ranges are dense (and so that OtherMeshObj may be this)
+	FDynamicMesh3 SourceMesh;
+	SourceMesh.CompactCopy(*OtherMeshObj->GetMesh());
+	ApplyPendingTransform();
+	FDynamicMesh3& TargetMesh = *Mesh;
+
+	// Tile k is transformed by Transform^k, or Transform^(k+1) if bApplyBefore. The powers are accumulated as
+	// affine matrices, because repeated rotation and non-uniform scaling is not representable as a FTransform.
+	FTransform3d Transformd(TransformIn);
+	FMatrix3d BaseLinear = GetLinearPart(Transformd);
+	FVector3d BaseTranslation = Transformd.GetTranslation();
+	TArray<FMatrix3d> TileLinear, TileNormal;
+	TArray<FVector3d> TileTranslation;
+	FMatrix3d Linear = (bApplyBefore) ? BaseLinear : FMatrix3d::Identity();
+	FVector3d Translation = (bApplyBefore) ? BaseTranslation : FVector3d::Zero();
 	for (int32 k = 0; k < RepeatCount; ++k)
 	{
-		if (bApplyBefore)
+		TileLinear.Add(Linear);
+		TileNormal.Add(GetNormalMatrix(Linear));
+		TileTranslation.Add(Translation);
+		Translation = BaseLinear * Translation + BaseTranslation;
+		Linear = BaseLinear * Linear;
+	}
+
+	int32 NumVertices = SourceMesh.MaxVertexID();
+	int32 NumTriangles = SourceMesh.MaxTriangleID();
+	bool bVertexNormals = SourceMesh.HasVertexNormals() && TargetMesh.HasVertexNormals();
+	bool bVertexColors = SourceMesh.HasVertexColors() && TargetMesh.HasVertexColors();
+
+	// allocate all tile vertices and overlay elements up front (IDs are recorded because the target mesh may
+	// re-use free slots), then fill them in parallel over all tiles
+	TArray<int32> VertexIDs;
+	VertexIDs.SetNumUninitialized(NumVertices * RepeatCount);
+	for (int32 k = 0; k < VertexIDs.Num(); ++k)
+	{
+		VertexIDs[k] = TargetMesh.AppendVertex(FVector3d::Zero());
+	}
+	ParallelFor(VertexIDs.Num(), [&](int32 k)
+	{
+		int32 Tile = k / NumVertices, vid = k % NumVertices;
+		TargetMesh.SetVertex(VertexIDs[k], TileLinear[Tile] * SourceMesh.GetVertex(vid) + TileTranslation[Tile]);
+		if (bVertexNormals)
 		{
-			MeshTransforms::ApplyTransform(AppendMesh, Transformd);
+			FVector3d Normal = TileNormal[Tile] * (FVector3d)SourceMesh.GetVertexNormal(vid);
+			TargetMesh.SetVertexNormal(VertexIDs[k], (FVector3f)Normal.Normalized());
 		}
+		if (bVertexColors)
+		{
+			TargetMesh.SetVertexColor(VertexIDs[k], SourceMesh.GetVertexColor(vid));
+		}
+	});
+
+	const FDynamicMeshNormalOverlay* SourceNormals = nullptr;
+	FDynamicMeshNormalOverlay* TargetNormals = nullptr;
+	TArray<int32> NormalIDs;
+	TArray<const FDynamicMeshUVOverlay*> SourceUVs;
+	TArray<FDynamicMeshUVOverlay*> TargetUVs;
+	TArray<TArray<int32>> UVIDs;
+	if (SourceMesh.HasAttributes() && TargetMesh.HasAttributes())
+	{
+		SourceNormals = SourceMesh.Attributes()->PrimaryNormals();
+		TargetNormals = TargetMesh.Attributes()->PrimaryNormals();
+		int32 NumNormals = SourceNormals->MaxElementID();
+		NormalIDs.SetNumUninitialized(NumNormals * RepeatCount);
+		for (int32 k = 0; k < NormalIDs.Num(); ++k)
+		{
+			NormalIDs[k] = TargetNormals->AppendElement(FVector3f::Zero());
+		}
+		ParallelFor(NormalIDs.Num(), [&](int32 k)
+		{
+			int32 Tile = k / NumNormals, eid = k % NumNormals;
+			FVector3d Normal = TileNormal[Tile] * (FVector3d)SourceNormals->GetElement(eid);
+			TargetNormals->SetElement(NormalIDs[k], (FVector3f)Normal.Normalized());
+		});
+
+		int32 NumUVLayers = FMath::Min(SourceMesh.Attributes()->NumUVLayers(), TargetMesh.Attributes()->NumUVLayers());
+		UVIDs.SetNum(NumUVLayers);
+		for (int32 Layer = 0; Layer < NumUVLayers; ++Layer)
+		{
+			const FDynamicMeshUVOverlay* SourceUV = SourceMesh.Attributes()->GetUVLayer(Layer);
+			FDynamicMeshUVOverlay* TargetUV = TargetMesh.Attributes()->GetUVLayer(Layer);
+			SourceUVs.Add(SourceUV);
+			TargetUVs.Add(TargetUV);
+			TArray<int32>& LayerIDs = UVIDs[Layer];
+			int32 NumUVs = SourceUV->MaxElementID();
+			LayerIDs.SetNumUninitialized(NumUVs * RepeatCount);
+			for (int32 k = 0; k < LayerIDs.Num(); ++k)
+			{
+				LayerIDs[k] = TargetUV->AppendElement(SourceUV->GetElement(k % NumUVs));
+			}
+		}
+	}
 
-		Mappings.Reset();
-		FDynamicMeshEditor Editor(Mesh.Get());
-		Editor.AppendMesh(&AppendMesh, Mappings);
-
-		if (!bApplyBefore)
+	// triangles have to be appended serially because they update the mesh topology
+	int32 GroupOffset = (TargetMesh.HasTriangleGroups()) ? TargetMesh.MaxGroupID() : 0;
+	int32 GroupsPerTile = (SourceMesh.HasTriangleGroups()) ? FMath::Max(1, SourceMesh.MaxGroupID()) : 1;
+	for (int32 Tile = 0; Tile < RepeatCount; ++Tile)
+	{
+		const int32* TileVertexIDs = VertexIDs.GetData() + Tile * NumVertices;
+		int32 TileGroupOffset = GroupOffset + Tile * GroupsPerTile;
+		for (int32 tid = 0; tid < NumTriangles; ++tid)
 		{
-			MeshTransforms::ApplyTransform(AppendMesh, Transformd);
+			FIndex3i Tri = SourceMesh.GetTriangle(tid);
+			int32 NewTriID = TargetMesh.AppendTriangle(TileVertexIDs[Tri.A], TileVertexIDs[Tri.B], TileVertexIDs[Tri.C],
+				TileGroupOffset + SourceMesh.GetTriangleGroup(tid));
+			if (NewTriID < 0)
+			{
+				continue;
+			}
+
+			if (SourceNormals && SourceNormals->IsSetTriangle(tid))
+			{
+				FIndex3i ElemTri = SourceNormals->GetTriangle(tid);
+				int32 Offset = Tile * SourceNormals->MaxElementID();
+				TargetNormals->SetTriangle(NewTriID, FIndex3i(NormalIDs[Offset + ElemTri.A], NormalIDs[Offset + ElemTri.B], NormalIDs[Offset + ElemTri.C]));
+			}
+			for (int32 Layer = 0; Layer < SourceUVs.Num(); ++Layer)
+			{
+				if (SourceUVs[Layer]->IsSetTriangle(tid))
+				{
+					FIndex3i ElemTri = SourceUVs[Layer]->GetTriangle(tid);
+					int32 Offset = Tile * SourceUVs[Layer]->MaxElementID();
+					const TArray<int32>& LayerIDs = UVIDs[Layer];
+					TargetUVs[Layer]->SetTriangle(NewTriID, FIndex3i(LayerIDs[Offset + ElemTri.A], LayerIDs[Offset + ElemTri.B], LayerIDs[Offset + ElemTri.C]));
+				}
+			}
 		}
 	}
 
@@ -291,21 +699,8 @@ UGeneratedMesh* UGeneratedMesh::AppendTiled(UGeneratedMesh* OtherMeshObj, FTrans
 UGeneratedMesh* UGeneratedMesh::BooleanWith(UGeneratedMesh* OtherMesh, EGeneratedMeshBooleanOperation Operation)
 {
 	if (!OtherMesh) return this;
-
-	FDynamicMesh3 ResultMesh;
-	FMeshBoolean::EBooleanOp ApplyOp = (FMeshBoolean::EBooleanOp)(int)Operation;
-	FMeshBoolean Boolean( Mesh.Get(), FTransform3d::Identity(),
-						  OtherMesh->Mesh.Get(), FTransform3d::Identity(),
-						  &ResultMesh, ApplyOp);
-	Boolean.bPutResultInInputSpace = true;
-	bool bOK = Boolean.Compute();
-	if (!bOK)
-	{
-		// fill holes
-	}
-	*Mesh = MoveTemp(ResultMesh);
-
-	OnMeshUpdated();
+	ApplyPendingTransform();
+	ApplyBoolean(OtherMesh, FTransform3d::Identity(), Operation);
 	return this;
 }
 
@@ -315,28 +710,114 @@ UGeneratedMesh* UGeneratedMesh::BooleanWith(UGeneratedMesh* OtherMesh, EGenerate
 UGeneratedMesh* UGeneratedMesh::BooleanWithTransformed(UGeneratedMesh* OtherMesh, FTransform TransformIn, EGeneratedMeshBooleanOperation Operation)
 {
 	if (!OtherMesh) return this;
+	ApplyPendingTransform();
+	ApplyBoolean(OtherMesh, FTransform3d(TransformIn), Operation);
+	return this;
+}
+
 
-	FDynamicMesh3 ResultMesh;
 
+void UGeneratedMesh::ApplyBoolean(UGeneratedMesh* OtherMesh, const FTransform3d& OtherTransform, EGeneratedMeshBooleanOperation Operation)
+{
 	FMeshBoolean::EBooleanOp ApplyOp = (FMeshBoolean::EBooleanOp)(int)Operation;
-	FMeshBoolean Boolean(Mesh.Get(), FTransform3d::Identity(),
-		OtherMesh->Mesh.Get(), FTransform3d(TransformIn),
-		&ResultMesh, ApplyOp);
-	Boolean.bPutResultInInputSpace = true;
-	bool bOK = Boolean.Compute();
-	if (!bOK)
+
+	bool bUseCache = bCacheBooleanResults && RTGUtils::IsMeshBooleanCacheEnabled();
+	uint64 MeshHash = 0, OtherMeshHash = 0;
+	if (bUseCache)
+	{
+		MeshHash = GetContentHash();
+		OtherMeshHash = OtherMesh->GetContentHash();
+		uint64 ResultHash = 0;
+		if (RTGUtils::FindCachedMeshBoolean(MeshHash, OtherMeshHash, OtherTransform, ApplyOp, *Mesh, ResultHash))
+		{
+			OnMeshUpdated();
+			ContentHash = ResultHash;
+			ContentHashTimestamp = Mesh->GetTimestamp();
+			bHaveContentHash = true;
+			return;
+		}
+	}
+
+	if (ApplyTrivialBoolean(OtherMesh, OtherTransform, Operation) == false)
+	{
+		FDynamicMesh3 ResultMesh;
+		FMeshBoolean Boolean(Mesh.Get(), FTransform3d::Identity(),
+			OtherMesh->GetMesh().Get(), OtherTransform,
+			&ResultMesh, ApplyOp);
+		Boolean.bPutResultInInputSpace = true;
+		bool bOK = Boolean.Compute();
+		if (!bOK)
+		{
+			// fill holes
+		}
+		*Mesh = MoveTemp(ResultMesh);
+		OnMeshUpdated();
+	}
+
+	if (bUseCache)
+	{
+		RTGUtils::AddCachedMeshBoolean(MeshHash, OtherMeshHash, OtherTransform, ApplyOp, *Mesh, GetContentHash());
+	}
+}
+
+
+
+UGeneratedMesh* UGeneratedMesh::BooleanWithMany(TArray<UGeneratedMesh*> OtherMeshes, EGeneratedMeshBooleanOperation Operation)
+{
+	ApplyPendingTransform();
+
+	TArray<const FDynamicMesh3*> Operands;
+	TArray<FTransform3d> OperandTransforms;
+	for (UGeneratedMesh* OtherMesh : OtherMeshes)
 	{
-		// fill holes
+		if (OtherMesh)
+		{
+			Operands.Add(OtherMesh->GetMesh().Get());
+			OperandTransforms.Add(FTransform3d::Identity());
+		}
 	}
-	*Mesh = MoveTemp(ResultMesh);
+
+	RTGUtils::ComputeMeshBooleanWithMany(*Mesh, FTransform3d::Identity(), Operands, OperandTransforms, (FMeshBoolean::EBooleanOp)(int)Operation);
+
 	OnMeshUpdated();
 	return this;
 }
 
 
 
+bool UGeneratedMesh::ApplyTrivialBoolean(UGeneratedMesh* OtherMesh, const FTransform3d& OtherTransform, EGeneratedMeshBooleanOperation Operation)
+{
+	const FDynamicMesh3& OtherDynamicMesh = *OtherMesh->GetMesh();
+	EMeshBooleanBroadPhaseResult Relationship = EMeshBooleanBroadPhaseResult::Disjoint;
+	if (RTGUtils::TestBooleanBoundsOverlap(*Mesh, FTransform3d::Identity(), OtherDynamicMesh, OtherTransform))
+	{
+		Relationship = RTGUtils::ClassifyBooleanOperands(*GetAABBTree(), FTransform3d::Identity(), *OtherMesh->GetAABBTree(), OtherTransform);
+		if (Relationship == EMeshBooleanBroadPhaseResult::Intersecting)
+		{
+			return false;
+		}
+	}
+
+	if (RTGUtils::ApplyTrivialBoolean(*Mesh, FTransform3d::Identity(), OtherDynamicMesh, OtherTransform, (FMeshBoolean::EBooleanOp)(int)Operation, Relationship))
+	{
+		OnMeshUpdated();
+	}
+	return true;
+}
+
+
+
+UGeneratedMesh* UGeneratedMesh::SetCacheBooleanResults(bool bEnable)
+{
+	bCacheBooleanResults = bEnable;
+	return this;
+}
+
+
+
 UGeneratedMesh* UGeneratedMesh::CutWithPlane(FVector Origin, FVector Normal, bool bFillHole, bool bFlipSide)
 {
+	ApplyPendingTransform();
 	if (bFlipSide)
 	{
 		Normal = -Normal;
@@ -360,6 +841,7 @@ UGeneratedMesh* UGeneratedMesh::CutWithPlane(FVector Origin, FVector Normal, boo
 
 UGeneratedMesh* UGeneratedMesh::Mirror(FVector Origin, FVector Normal, bool bApplyPlaneCut)
 {
+	ApplyPendingTransform();
 	FVector3d PlaneOrigin(Origin), PlaneNormal(Normal);
 	PlaneNormal.Normalize();
 
@@ -387,18 +869,36 @@ UGeneratedMesh* UGeneratedMesh::Mirror(FVector Origin, FVector Normal, bool bApp
 
 UGeneratedMesh* UGeneratedMesh::SolidifyMesh(int VoxelResolution, float WindingThreshold)
 {
-	FDynamicMesh3& SolidifyMesh = *Mesh;
-	FDynamicMeshAABBTree3& SolidifyAABBTree = *GetAABBTree();
+	ApplyPendingTransform();
 	TFastWindingTree<FDynamicMesh3>& SolidifyFastWinding = *GetFastWindingTree();
 
 	double ExtendBounds = 2.0;
-	TImplicitSolidify<FDynamicMesh3> SolidifyCalc(&SolidifyMesh, &SolidifyAABBTree, &SolidifyFastWinding);
-	SolidifyCalc.SetCellSizeAndExtendBounds(SolidifyAABBTree.GetBoundingBox(), ExtendBounds, VoxelResolution);
-	SolidifyCalc.WindingThreshold = WindingThreshold;
-	SolidifyCalc.SurfaceSearchSteps = 5;
-	SolidifyCalc.bSolidAtBoundaries = true;
-	SolidifyCalc.ExtendBounds = ExtendBounds;
-	FDynamicMesh3 SolidMesh(&SolidifyCalc.Generate());
+	FDynamicMesh3 SolidMesh;
+	RTGUtils::ComputeSparseSolidify(*Mesh, SolidifyFastWinding, VoxelResolution, WindingThreshold, ExtendBounds, 5, SolidMesh);
+
+	SolidMesh.EnableAttributes();
+	FMeshNormals::InitializeOverlayToPerVertexNormals(SolidMesh.Attributes()->PrimaryNormals(), false);
+
+	*Mesh = MoveTemp(SolidMesh);
+	OnMeshUpdated();
+	return this;
+}
+
+
+
+UGeneratedMesh* UGeneratedMesh::SolidifyMeshSDF(int VoxelResolution, float Offset)
+{
+	ApplyPendingTransform();
+	TFastWindingTree<FDynamicMesh3>& Winding = *GetFastWindingTree();
+
+	// reuse the distance query grid if it has the same resolution and a wide enough band
+	FDynamicMesh3 SolidMesh;
+	bool bUsedCachedGrid = DistanceGrid.IsValidFor(*Mesh) && DistanceGridResolution == VoxelResolution
+		&& RTGUtils::GenerateOffsetSurface(DistanceGrid, Offset, SolidMesh);
+	if (!bUsedCachedGrid)
+	{
+		RTGUtils::ComputeOffsetSurface(*Mesh, *GetAABBTree(), Winding, VoxelResolution, Offset, SolidMesh);
+	}
 
 	SolidMesh.EnableAttributes();
 	FMeshNormals::InitializeOverlayToPerVertexNormals(SolidMesh.Attributes()->PrimaryNormals(), false);
@@ -412,6 +912,7 @@ UGeneratedMesh* UGeneratedMesh::SolidifyMesh(int VoxelResolution, float WindingT
 UGeneratedMesh* UGeneratedMesh::SimplifyMeshToTriCount(int32 TargetTriangleCount, bool bDiscardAttributes)
 {
 	TargetTriangleCount = FMath::Max(1, TargetTriangleCount);
+	ApplyPendingTransform();
 
 	if (bDiscardAttributes)
 	{
@@ -461,6 +962,81 @@ UGeneratedMesh* UGeneratedMesh::SimplifyMeshToTriCount(int32 TargetTriangleCount
 
 
 
+UGeneratedMesh* UGeneratedMesh::SimplifyMeshToTriCountParallel(int32 TargetTriangleCount, bool bDiscardAttributes, int NumPartitions)
+{
+	ApplyPendingTransform();
+
+	if (bDiscardAttributes)
+	{
+		Mesh->DiscardAttributes();
+	}
+
+	RTGUtils::SimplifyMeshPartitioned(*Mesh, TargetTriangleCount, !bDiscardAttributes, NumPartitions);
+
+	if (bDiscardAttributes)
+	{
+		Mesh->EnableAttributes();
+		FMeshNormals::InitializeOverlayToPerVertexNormals(Mesh->Attributes()->PrimaryNormals(), false);
+	}
+
+	OnMeshUpdated();
+	return this;
+}
+
+
+
+UGeneratedMesh* UGeneratedMesh::BuildProgressiveMesh()
+{
+	ApplyPendingTransform();
+	ProgressiveMesh.Build(*Mesh);
+	ProgressiveLODTriangleCount = -1;
+	return this;
+}
+
+
+bool UGeneratedMesh::SetToProgressiveLOD(int32 TargetTriangleCount)
+{
+	if (ProgressiveMesh.IsBuilt() == false)
+	{
+		return false;
+	}
+
+	// skip the update if Mesh is still the requested level
+	ApplyPendingTransform();
+	int32 LODTriangleCount = ProgressiveMesh.GetLODTriangleCount(TargetTriangleCount);
+	if (LODTriangleCount == ProgressiveLODTriangleCount && Mesh->GetTimestamp() == ProgressiveLODTimestamp)
+	{
+		return true;
+	}
+
+	ProgressiveMesh.ExtractLOD(TargetTriangleCount, *Mesh);
+	Mesh->EnableAttributes();
+	FMeshNormals::InitializeOverlayToPerVertexNormals(Mesh->Attributes()->PrimaryNormals(), false);
+	OnMeshUpdated();
+
+	ProgressiveLODTriangleCount = LODTriangleCount;
+	ProgressiveLODTimestamp = Mesh->GetTimestamp();
+	return true;
+}
+
+
+bool UGeneratedMesh::GetProgressiveMeshTriangleCounts(int& MinTriangleCount, int& MaxTriangleCount)
+{
+	MinTriangleCount = ProgressiveMesh.GetMinTriangleCount();
+	MaxTriangleCount = ProgressiveMesh.GetMaxTriangleCount();
+	return ProgressiveMesh.IsBuilt();
+}
+
+
+UGeneratedMesh* UGeneratedMesh::ClearProgressiveMesh()
+{
+	ProgressiveMesh.Reset();
+	ProgressiveLODTriangleCount = -1;
+	return this;
+}
+
+
+
 
 
 float UGeneratedMesh::DistanceToPoint(FVector Point, FVector& NearestPoint, int& NearestTriangle, FVector& TriBaryCoords)
@@ -469,6 +1045,18 @@ float UGeneratedMesh::DistanceToPoint(FVector Point, FVector& NearestPoint, int&
 	NearestTriangle = -1;
 
 	double NearDistSqr;
+	if (bUseDistanceQueryGrid)
+	{
+		FVector3d GridNearestPoint, BaryCoords;
+		NearestTriangle = GetDistanceGrid().FindNearestTriangle(Point, NearDistSqr, GridNearestPoint, BaryCoords);
+		if (NearestTriangle >= 0)
+		{
+			NearestPoint = (FVector)GridNearestPoint;
+			TriBaryCoords = (FVector)BaryCoords;
+			return (float)FMathd::Sqrt(NearDistSqr);
+		}
+	}
+
 	NearestTriangle = GetAABBTree()->FindNearestTriangle(Point, NearDistSqr);
 	if (NearestTriangle < 0)
 	{
@@ -484,11 +1072,44 @@ float UGeneratedMesh::DistanceToPoint(FVector Point, FVector& NearestPoint, int&
 
 FVector UGeneratedMesh::NearestPoint(FVector Point)
 {
+	if (bUseDistanceQueryGrid)
+	{
+		double NearDistSqr;
+		FVector3d NearestPoint, BaryCoords;
+		if (GetDistanceGrid().FindNearestTriangle(Point, NearDistSqr, NearestPoint, BaryCoords) >= 0)
+		{
+			return (FVector)NearestPoint;
+		}
+	}
 	return (FVector)GetAABBTree()->FindNearestPoint(Point);
 }
 
+
+float UGeneratedMesh::SignedDistanceToPoint(FVector Point, FVector& Gradient)
+{
+	double Distance;
+	FVector3d DistanceGradient;
+	if (GetDistanceGrid().GetDistanceAndGradient(Point, Distance, DistanceGradient))
+	{
+		Gradient = (FVector)DistanceGradient;
+		return (float)Distance;
+	}
+
+	// outside the narrow band
+	FVector3d NearestPoint = GetAABBTree()->FindNearestPoint(Point);
+	double Sign = (GetFastWindingTree()->IsInside(Point, 0.5)) ? -1.0 : 1.0;
+	FVector3d Direction = (FVector3d)Point - NearestPoint;
+	Distance = Direction.Length();
+	Gradient = (Distance > FMathd::ZeroTolerance) ? (FVector)(Direction * (Sign / Distance)) : FVector::ZeroVector;
+	return (float)(Sign * Distance);
+}
+
 bool UGeneratedMesh::ContainsPoint(FVector Point, float WindingThreshold)
 {
+	if (const FWindingOccupancyGrid* Grid = GetInsideQueryGrid(WindingThreshold))
+	{
+		return Grid->IsInside(*GetFastWindingTree(), Point);
+	}
 	return GetFastWindingTree()->IsInside(Point, WindingThreshold);
 }
 
@@ -519,10 +1140,115 @@ bool UGeneratedMesh::IntersectRay(FVector RayOrigin, FVector RayDirection,
 }
 
 
+FMeshDistanceQueryResults UGeneratedMesh::DistanceToPoints(const TArray<FVector>& Points)
+{
+	FMeshDistanceQueryResults Results;
+	FUpdatableMeshAABBTree3* AABBTree = GetAABBTree().Get();
+	if (bUseDistanceQueryGrid)
+	{
+		RTGUtils::FindDistancesToPoints(GetDistanceGrid(), *Mesh, *AABBTree, FTransform3d::Identity(), Points, Results);
+	}
+	else
+	{
+		RTGUtils::FindDistancesToPoints(*Mesh, *AABBTree, FTransform3d::Identity(), Points, Results);
+	}
+	return Results;
+}
+
+TArray<FVector> UGeneratedMesh::NearestPoints(const TArray<FVector>& Points)
+{
+	TArray<FVector> Results;
+	RTGUtils::FindNearestPoints(*GetAABBTree(), FTransform3d::Identity(), Points, Results);
+	return Results;
+}
+
+TArray<bool> UGeneratedMesh::ContainsPoints(const TArray<FVector>& Points, float WindingThreshold)
+{
+	TArray<bool> Results;
+	if (const FWindingOccupancyGrid* Grid = GetInsideQueryGrid(WindingThreshold))
+	{
+		RTGUtils::FindContainedPoints(*Grid, *GetFastWindingTree(), FTransform3d::Identity(), Points, Results);
+	}
+	else
+	{
+		RTGUtils::FindContainedPoints(*GetFastWindingTree(), FTransform3d::Identity(), Points, WindingThreshold, Results);
+	}
+	return Results;
+}
+
+
+UGeneratedMesh* UGeneratedMesh::SetUseInsideQueryGrid(bool bEnable, int GridResolution)
+{
+	bUseInsideQueryGrid = bEnable;
+	if (GridResolution != InsideQueryGridResolution || !bEnable)
+	{
+		InsideQueryGrid.Reset();
+	}
+	InsideQueryGridResolution = GridResolution;
+	return this;
+}
+
+
+UGeneratedMesh* UGeneratedMesh::SetUseDistanceQueryGrid(bool bEnable, int GridResolution, int NarrowBandCells)
+{
+	bUseDistanceQueryGrid = bEnable;
+	if (GridResolution != DistanceGridResolution || NarrowBandCells != DistanceGridBandCells || !bEnable)
+	{
+		DistanceGrid.Reset();
+	}
+	DistanceGridResolution = GridResolution;
+	DistanceGridBandCells = NarrowBandCells;
+	return this;
+}
+
+
+const FMeshSignedDistanceGrid& UGeneratedMesh::GetDistanceGrid()
+{
+	// GetFastWindingTree() also updates the AABBTree, and applies any pending transform
+	TFastWindingTree<FDynamicMesh3>& Winding = *GetFastWindingTree();
+	if (DistanceGrid.IsValidFor(*Mesh) == false)
+	{
+		DistanceGrid.Build(*Mesh, *GetAABBTree(), Winding, DistanceGridResolution, DistanceGridBandCells);
+	}
+	return DistanceGrid;
+}
+
+
+const FWindingOccupancyGrid* UGeneratedMesh::GetInsideQueryGrid(float WindingThreshold)
+{
+	if (!bUseInsideQueryGrid)
+	{
+		return nullptr;
+	}
+	// GetFastWindingTree() also updates the AABBTree, and applies any pending transform
+	TFastWindingTree<FDynamicMesh3>& Winding = *GetFastWindingTree();
+	if (InsideQueryGrid.IsValidFor(*Mesh, WindingThreshold) == false)
+	{
+		InsideQueryGrid.Build(*Mesh, *GetAABBTree(), Winding, WindingThreshold, InsideQueryGridResolution);
+	}
+	return &InsideQueryGrid;
+}
+
+FMeshRayQueryResults UGeneratedMesh::IntersectRays(const TArray<FVector>& RayOrigins, const TArray<FVector>& RayDirections, float MaxDistance)
+{
+	FMeshRayQueryResults Results;
+	RTGUtils::FindRayIntersections(*GetAABBTree(), FTransform3d::Identity(), RayOrigins, RayDirections, MaxDistance, Results);
+	return Results;
+}
+
+FMeshRayMultiHitResults UGeneratedMesh::IntersectRaysAllHits(const TArray<FVector>& RayOrigins, const TArray<FVector>& RayDirections, float MaxDistance)
+{
+	FMeshRayMultiHitResults Results;
+	RTGUtils::FindAllRayIntersections(*GetAABBTree(), FTransform3d::Identity(), RayOrigins, RayDirections, MaxDistance, Results);
+	return Results;
+}
+
+
 
 
 UGeneratedMesh* UGeneratedMesh::SetToFaceNormals()
 {
+	ApplyPendingTransform();
 	FMeshNormals::InitializeMeshToPerTriangleNormals(Mesh.Get());
 	// OnMeshUpdated();		// skip for now as we're just doing normals
 	return this;
@@ -530,6 +1256,7 @@ UGeneratedMesh* UGeneratedMesh::SetToFaceNormals()
 
 UGeneratedMesh* UGeneratedMesh::SetToVertexNormals()
 {
+	ApplyPendingTransform();
 	Mesh->EnableAttributes();
 	FMeshNormals::InitializeOverlayToPerVertexNormals(Mesh->Attributes()->PrimaryNormals(), false);
 	// OnMeshUpdated();		// skip for now as we're just doing normals
@@ -539,6 +1266,7 @@ UGeneratedMesh* UGeneratedMesh::SetToVertexNormals()
 
 UGeneratedMesh* UGeneratedMesh::SetToAngleThresholdNormals(float AngleThresholdDeg)
 {
+	ApplyPendingTransform();
 	Mesh->EnableAttributes();
 
 	float NormalDotProdThreshold = FMathf::Cos(AngleThresholdDeg * FMathf::DegToRad);
@@ -558,6 +1286,7 @@ UGeneratedMesh* UGeneratedMesh::SetToAngleThresholdNormals(float AngleThresholdD
 
 UGeneratedMesh* UGeneratedMesh::RecomputeNormals()
 {
+	ApplyPendingTransform();
 	FMeshNormals::QuickRecomputeOverlayNormals(*Mesh);
 	// OnMeshUpdated();		// skip for now as we're just doing normals
 	return this;
@@ -568,8 +1297,15 @@ UGeneratedMesh* UGeneratedMesh::RecomputeNormals()
 
 UGeneratedMesh* UGeneratedMesh::Translate(FVector Translation)
 {
-	MeshTransforms::Translate(*Mesh, FVector3d(Translation));
-	OnMeshUpdated();
+	if (bDeferTransforms)
+	{
+		AccumulateTransform(FMatrix3d::Identity(), FVector3d(Translation));
+	}
+	else
+	{
+		MeshTransforms::Translate(*Mesh, FVector3d(Translation));
+	}
+	OnMeshUpdated(true);
 	return this;
 }
 
@@ -577,22 +1313,39 @@ UGeneratedMesh* UGeneratedMesh::RotateQuat(FQuat Rotation, FVector OriginIn)
 {
 	FMatrix3d RotMatrix = FQuaterniond(Rotation).ToRotationMatrix();
 	FVector3d Origin(OriginIn);
-	MeshTransforms::ApplyTransform(*Mesh,
-		[&RotMatrix, &Origin](const FVector3d& Pos) { return RotMatrix * (Pos - Origin) + Origin; },
-		[&RotMatrix](const FVector3f& Normal) { return (FVector3f)(RotMatrix * (FVector3d)Normal); } );
-	OnMeshUpdated();
+	if (bDeferTransforms)
+	{
+		AccumulateTransform(RotMatrix, Origin - RotMatrix * Origin);
+	}
+	else
+	{
+		MeshTransforms::ApplyTransform(*Mesh,
+			[&RotMatrix, &Origin](const FVector3d& Pos) { return RotMatrix * (Pos - Origin) + Origin; },
+			[&RotMatrix](const FVector3f& Normal) { return (FVector3f)(RotMatrix * (FVector3d)Normal); } );
+	}
+	OnMeshUpdated(true);
 	return this;
 }
 UGeneratedMesh* UGeneratedMesh::Rotate(FRotator RotationIn, FVector OriginIn)
 {
-	return RotateQuat(RotationIn.Quaternion());
+	return RotateQuat(RotationIn.Quaternion(), OriginIn);
 }
 
 
 UGeneratedMesh* UGeneratedMesh::Scale(FVector Scale, FVector Origin)
 {
-	MeshTransforms::Scale(*Mesh, FVector3d(Scale), FVector3d(Origin));
-	OnMeshUpdated();
+	FVector3d Scaled(Scale), Origind(Origin);
+	FMatrix3d ScaleMatrix(Scaled.X, 0, 0, 0, Scaled.Y, 0, 0, 0, Scaled.Z);
+	if (bDeferTransforms)
+	{
+		AccumulateTransform(ScaleMatrix, Origind - Scaled * Origind);
+	}
+	else
+	{
+		// MeshTransforms::Scale() does not update normals, which are wrong after a non-uniform scale
+		GeneratedMeshLocals::ApplyLinearTransform(*Mesh, ScaleMatrix, Origind - Scaled * Origind);
+	}
+	OnMeshUpdated(true);
 	return this;
 }
 UGeneratedMesh* UGeneratedMesh::ScaleUniform(float Scale, FVector Origin)
@@ -603,12 +1356,65 @@ UGeneratedMesh* UGeneratedMesh::ScaleUniform(float Scale, FVector Origin)
 
 UGeneratedMesh* UGeneratedMesh::Transform(FTransform Transform)
 {
-	MeshTransforms::ApplyTransform(*Mesh, FTransform3d(Transform));
-	OnMeshUpdated();
+	FTransform3d Transformd(Transform);
+	if (bDeferTransforms)
+	{
+		AccumulateTransform(GeneratedMeshLocals::GetLinearPart(Transformd), Transformd.GetTranslation());
+	}
+	else
+	{
+		MeshTransforms::ApplyTransform(*Mesh, Transformd);
+	}
+	OnMeshUpdated(true);
+	return this;
+}
+
+
+UGeneratedMesh* UGeneratedMesh::SetDeferTransforms(bool bDefer)
+{
+	bDeferTransforms = bDefer;
+	if (!bDeferTransforms)
+	{
+		ApplyPendingTransform();
+	}
 	return this;
 }
 
 
+void UGeneratedMesh::AccumulateTransform(const FMatrix3d& Linear, const FVector3d& Translation)
+{
+	// new transform is applied after the pending one
+	PendingLinear = Linear * PendingLinear;
+	PendingTranslation = Linear * PendingTranslation + Translation;
+	bHavePendingTransform = true;
+}
+
+
+void UGeneratedMesh::ClearPendingTransform()
+{
+	PendingLinear = FMatrix3d::Identity();
+	PendingTranslation = FVector3d::Zero();
+	bHavePendingTransform = false;
+}
+
+
+void UGeneratedMesh::ApplyPendingTransform() const
+{
+	if (!bHavePendingTransform)
+	{
+		return;
+	}
+
+	const FMatrix3d Linear = PendingLinear;
+	const FVector3d Translation = PendingTranslation;
+	PendingLinear = FMatrix3d::Identity();
+	PendingTranslation = FVector3d::Zero();
+	bHavePendingTransform = false;
+
+	GeneratedMeshLocals::ApplyLinearTransform(*Mesh, Linear, Translation);
+}
+
+
 
 
 UGeneratedMesh* UGeneratedMeshPool::RequestMesh()
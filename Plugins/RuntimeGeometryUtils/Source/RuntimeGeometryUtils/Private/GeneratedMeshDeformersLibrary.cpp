@@ -27,7 +27,7 @@ UGeneratedMesh* UGeneratedMeshDeformersLibrary::DeformMeshAxisSinWave1D(UGenerat
 					Mesh.SetVertex(vid, NewPos);
 				}
 			});
-		});
+		}, true);
 	}
 
 	return MeshObj;
@@ -59,7 +59,7 @@ UGeneratedMesh* UGeneratedMeshDeformersLibrary::DeformMeshAxisSinWaveRadial(UGen
 					Mesh.SetVertex(vid, NewPos);
 				}
 			});
-		});
+		}, true);
 	}
 
 	return MeshObj;
@@ -92,7 +92,7 @@ UGeneratedMesh* UGeneratedMeshDeformersLibrary::DeformMeshPerlinNoiseNormal(UGen
 					Mesh.SetVertex(vid, NewPos);
 				}
 			});
-		});
+		}, true);
 	}
 
 	return MeshObj;
@@ -133,7 +133,7 @@ UGeneratedMesh* UGeneratedMeshDeformersLibrary::SmoothMeshUniform(UGeneratedMesh
 					}
 				}
 			}
-		});
+		}, true);
 	}
 
 	return MeshObj;
@@ -0,0 +1,172 @@
+#include "MeshBooleanBroadPhase.h"
+#include "DynamicMeshEditor.h"
+#include "MeshTransforms.h"
+
+
+namespace MeshBooleanBroadPhaseLocals
+{
+	static FAxisAlignedBox3d TransformBox(const FAxisAlignedBox3d& Box, const FTransform3d& Transform)
+	{
+		FAxisAlignedBox3d Result = FAxisAlignedBox3d::Empty();
+		for (int32 k = 0; k < 8; ++k)
+		{
+			Result.Contain(Transform.TransformPosition(FVector3d((k & 1) ? Box.Max.X : Box.Min.X, (k & 2) ? Box.Max.Y : Box.Min.Y, (k & 4) ? Box.Max.Z : Box.Min.Z)));
+		}
+		return Result;
+	}
+
+	/** @return any vertex of a triangle of Mesh. Unreferenced vertices are not on the surface, so they cannot be used for inside tests. */
+	static FVector3d GetAnyVertex(const FDynamicMesh3& Mesh)
+	{
+		for (int32 tid : Mesh.TriangleIndicesItr())
+		{
+			return Mesh.GetVertex(Mesh.GetTriangle(tid).A);
+		}
+		return FVector3d::Zero();
+	}
+
+	/** Append MeshB, mapped to the local space of MeshA, to MeshA */
+	static void AppendTransformed(FDynamicMesh3& MeshA, const FTransform3d& TransformA, const FDynamicMesh3& MeshB, const FTransform3d& TransformB)
+	{
+		FDynamicMeshEditor Editor(&MeshA);
+		FMeshIndexMappings Mappings;
+		Editor.AppendMesh(&MeshB, Mappings,
+			[&](int, const FVector3d& Position) { return TransformA.InverseTransformPosition(TransformB.TransformPosition(Position)); },
+			[&](int, const FVector3d& Normal) { return TransformA.InverseTransformNormal(TransformB.TransformNormal(Normal)); });
+	}
+
+	/** Replace MeshA with MeshB, mapped to the local space of MeshA */
+	static void SetTransformed(FDynamicMesh3& MeshA, const FTransform3d& TransformA, const FDynamicMesh3& MeshB, const FTransform3d& TransformB)
+	{
+		MeshA = MeshB;
+		MeshTransforms::ApplyTransform(MeshA, TransformB);
+		MeshTransforms::ApplyTransformInverse(MeshA, TransformA);
+	}
+}
+
+
+bool RTGUtils::IsPointInsideMesh(FUpdatableMeshAABBTree3& Tree, const FVector3d& Point)
+{
+	// direction that is unlikely to be aligned with mesh edges
+	FRay3d Ray(Point, FVector3d(0.5773, 0.5774, 0.5775).Normalized());
+	int32 HitTriangle = Tree.FindNearestHitTriangle(Ray);
+	if (HitTriangle < 0)
+	{
+		return false;
+	}
+	return Tree.GetMesh()->GetTriNormal(HitTriangle).Dot(Ray.Direction) > 0;
+}
+
+
+bool RTGUtils::TestBooleanBoundsOverlap(
+	const FDynamicMesh3& MeshA, const FTransform3d& TransformA,
+	const FDynamicMesh3& MeshB, const FTransform3d& TransformB)
+{
+	using namespace MeshBooleanBroadPhaseLocals;
+	if (MeshA.TriangleCount() == 0 || MeshB.TriangleCount() == 0)
+	{
+		return false;
+	}
+	FAxisAlignedBox3d BoundsA = TransformBox(MeshA.GetBounds(), TransformA);
+	FAxisAlignedBox3d BoundsB = TransformBox(MeshB.GetBounds(), TransformB);
+	return BoundsA.Intersects(BoundsB);
+}
+
+
+EMeshBooleanBroadPhaseResult RTGUtils::ClassifyBooleanOperands(
+	FUpdatableMeshAABBTree3& TreeA, const FTransform3d& TransformA,
+	FUpdatableMeshAABBTree3& TreeB, const FTransform3d& TransformB)
+{
+	using namespace MeshBooleanBroadPhaseLocals;
+	const FDynamicMesh3& MeshA = *TreeA.GetMesh();
+	const FDynamicMesh3& MeshB = *TreeB.GetMesh();
+	if (MeshA.TriangleCount() == 0 || MeshB.TriangleCount() == 0)
+	{
+		return EMeshBooleanBroadPhaseResult::Disjoint;
+	}
+
+	auto BToA = [&](const FVector3d& Point) { return TransformA.InverseTransformPosition(TransformB.TransformPosition(Point)); };
+	if (TreeA.TestMeshIntersection(TreeB, BToA))
+	{
+		return EMeshBooleanBroadPhaseResult::Intersecting;
+	}
+
+	// surfaces do not intersect, so each mesh is either entirely inside or entirely outside the other
+	if (IsPointInsideMesh(TreeA, BToA(GetAnyVertex(MeshB))))
+	{
+		return EMeshBooleanBroadPhaseResult::BInsideA;
+	}
+	FVector3d VertexA = TransformB.InverseTransformPosition(TransformA.TransformPosition(GetAnyVertex(MeshA)));
+	if (IsPointInsideMesh(TreeB, VertexA))
+	{
+		return EMeshBooleanBroadPhaseResult::AInsideB;
+	}
+	return EMeshBooleanBroadPhaseResult::Disjoint;
+}
+
+
+bool RTGUtils::IsBooleanNoOp(FMeshBoolean::EBooleanOp Operation, EMeshBooleanBroadPhaseResult Relationship)
+{
+	return (Operation == FMeshBoolean::EBooleanOp::Union && Relationship == EMeshBooleanBroadPhaseResult::BInsideA)
+		|| (Operation == FMeshBoolean::EBooleanOp::Difference && Relationship == EMeshBooleanBroadPhaseResult::Disjoint)
+		|| (Operation == FMeshBoolean::EBooleanOp::Intersect && Relationship == EMeshBooleanBroadPhaseResult::AInsideB);
+}
+
+
+bool RTGUtils::ApplyTrivialBoolean(
+	FDynamicMesh3& MeshA, const FTransform3d& TransformA,
+	const FDynamicMesh3& MeshB, const FTransform3d& TransformB,
+	FMeshBoolean::EBooleanOp Operation, EMeshBooleanBroadPhaseResult Relationship)
+{
+	using namespace MeshBooleanBroadPhaseLocals;
+	check(Relationship != EMeshBooleanBroadPhaseResult::Intersecting);
+
+	switch (Operation)
+	{
+	case FMeshBoolean::EBooleanOp::Union:
+		if (Relationship == EMeshBooleanBroadPhaseResult::Disjoint)
+		{
+			AppendTransformed(MeshA, TransformA, MeshB, TransformB);
+			return true;
+		}
+		else if (Relationship == EMeshBooleanBroadPhaseResult::AInsideB)
+		{
+			SetTransformed(MeshA, TransformA, MeshB, TransformB);
+			return true;
+		}
+		return false;
+
+	case FMeshBoolean::EBooleanOp::Difference:
+		if (Relationship == EMeshBooleanBroadPhaseResult::BInsideA)
+		{
+			// MeshB becomes an inward-facing cavity
+			FDynamicMesh3 Cavity(MeshB);
+			Cavity.ReverseOrientation();
+			AppendTransformed(MeshA, TransformA, Cavity, TransformB);
+			return true;
+		}
+		else if (Relationship == EMeshBooleanBroadPhaseResult::AInsideB)
+		{
+			MeshA.Clear();
+			return true;
+		}
+		return false;
+
+	case FMeshBoolean::EBooleanOp::Intersect:
+		if (Relationship == EMeshBooleanBroadPhaseResult::Disjoint)
+		{
+			MeshA.Clear();
+			return true;
+		}
+		else if (Relationship == EMeshBooleanBroadPhaseResult::BInsideA)
+		{
+			SetTransformed(MeshA, TransformA, MeshB, TransformB);
+			return true;
+		}
+		return false;
+
+	default:
+		ensureMsgf(false, TEXT("ApplyTrivialBoolean: unsupported boolean operation"));
+		return false;
+	}
+}
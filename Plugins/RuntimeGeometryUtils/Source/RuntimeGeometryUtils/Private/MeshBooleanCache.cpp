@@ -0,0 +1,303 @@
+#include "MeshBooleanCache.h"
+#include "DynamicMeshAttributeSet.h"
+
+#include "Async/ParallelFor.h"
+#include "Hash/CityHash.h"
+#include "Misc/ScopeLock.h"
+
+
+namespace MeshBooleanCacheLocals
+{
+	static const int32 HashBlockSize = 16384;
+
+	template<typename ValueType>
+	static void AppendBytes(TArray<uint8>& Data, const ValueType& Value)
+	{
+		Data.Append(reinterpret_cast<const uint8*>(&Value), sizeof(ValueType));
+	}
+
+	/**
+	 * Hash the IDs [0, MaxID) in fixed-size blocks in parallel, and then hash the block hashes. AppendID appends the data of
+	 * an ID to the block buffer. Unused IDs should append something too, so that the hash depends on the ID layout.
+	 */
+	static uint64 HashIDRange(int32 MaxID, TFunctionRef<void(int32, TArray<uint8>&)> AppendID)
+	{
+		int32 NumBlocks = (MaxID + HashBlockSize - 1) / HashBlockSize;
+		TArray<uint64> BlockHashes;
+		BlockHashes.SetNum(NumBlocks + 1);
+		BlockHashes[NumBlocks] = (uint64)MaxID;
+
+		ParallelFor(NumBlocks, [&](int32 BlockIndex)
+		{
+			TArray<uint8> Data;
+			int32 StartID = BlockIndex * HashBlockSize;
+			int32 EndID = FMath::Min(StartID + HashBlockSize, MaxID);
+			for (int32 ID = StartID; ID < EndID; ++ID)
+			{
+				AppendID(ID, Data);
+			}
+			BlockHashes[BlockIndex] = CityHash64((const char*)Data.GetData(), (uint32)Data.Num());
+		});
+
+		return CityHash64((const char*)BlockHashes.GetData(), (uint32)(BlockHashes.Num() * sizeof(uint64)));
+	}
+
+	/** Hash the elements and triangles of an attribute overlay */
+	template<typename OverlayType>
+	static void HashOverlay(const FDynamicMesh3& Mesh, const OverlayType& Overlay, TArray<uint64>& HashesOut)
+	{
+		HashesOut.Add(HashIDRange(Overlay.MaxElementID(), [&](int32 ElementID, TArray<uint8>& Data)
+		{
+			bool bIsElement = Overlay.IsElement(ElementID);
+			AppendBytes(Data, bIsElement);
+			if (bIsElement)
+			{
+				AppendBytes(Data, Overlay.GetElement(ElementID));
+			}
+		}));
+		HashesOut.Add(HashIDRange(Mesh.MaxTriangleID(), [&](int32 TriangleID, TArray<uint8>& Data)
+		{
+			bool bIsSet = Mesh.IsTriangle(TriangleID) && Overlay.IsSetTriangle(TriangleID);
+			AppendBytes(Data, bIsSet);
+			if (bIsSet)
+			{
+				AppendBytes(Data, Overlay.GetTriangle(TriangleID));
+			}
+		}));
+	}
+
+
+	/** Identifies a boolean result by the operand hashes, the transform of the second operand, and the operation */
+	struct FMeshBooleanCacheKey
+	{
+		uint64 MeshHashA = 0;
+		uint64 MeshHashB = 0;
+		// translation, rotation quaternion, scale
+		double Transform[10];
+		int32 Operation = 0;
+
+		FMeshBooleanCacheKey(uint64 MeshHashAIn, uint64 MeshHashBIn, const FTransform3d& TransformB, FMeshBoolean::EBooleanOp OperationIn)
+			: MeshHashA(MeshHashAIn), MeshHashB(MeshHashBIn), Operation((int32)OperationIn)
+		{
+			FVector3d Translation = TransformB.GetTranslation();
+			FQuaterniond Rotation = TransformB.GetRotation();
+			FVector3d Scale = TransformB.GetScale();
+			double Values[10] = { Translation.X, Translation.Y, Translation.Z, Rotation.X, Rotation.Y, Rotation.Z, Rotation.W, Scale.X, Scale.Y, Scale.Z };
+			FMemory::Memcpy(Transform, Values, sizeof(Transform));
+		}
+
+		bool operator==(const FMeshBooleanCacheKey& Other) const
+		{
+			return MeshHashA == Other.MeshHashA && MeshHashB == Other.MeshHashB && Operation == Other.Operation
+				&& FMemory::Memcmp(Transform, Other.Transform, sizeof(Transform)) == 0;
+		}
+
+		friend uint32 GetTypeHash(const FMeshBooleanCacheKey& Key)
+		{
+			uint32 Hash = HashCombine(GetTypeHash(Key.MeshHashA), GetTypeHash(Key.MeshHashB));
+			return FCrc::MemCrc32(Key.Transform, sizeof(Key.Transform), HashCombine(Hash, (uint32)Key.Operation));
+		}
+	};
+
+	struct FMeshBooleanCacheEntry
+	{
+		TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe> Result;
+		uint64 ResultHash = 0;
+		int64 TriangleCount = 0;
+		// value of UseCounter when the entry was last added or found, the entry with the smallest value is discarded first
+		uint64 LastUsed = 0;
+	};
+
+	static TMap<FMeshBooleanCacheKey, FMeshBooleanCacheEntry> CachedBooleans;
+	static FCriticalSection CachedBooleansLock;
+	static int32 MaxCachedResults = 64;
+	static int64 MaxCachedTriangles = 4 * 1024 * 1024;
+	static int64 CachedTriangles = 0;
+	static uint64 UseCounter = 0;
+
+	/** Discard least-recently-used entries until the cache is within its capacity. CachedBooleansLock must be held. */
+	static void EvictToCapacity()
+	{
+		while (CachedBooleans.Num() > 0 && (CachedBooleans.Num() > MaxCachedResults || CachedTriangles > MaxCachedTriangles))
+		{
+			const FMeshBooleanCacheKey* OldestKey = nullptr;
+			uint64 OldestUse = TNumericLimits<uint64>::Max();
+			for (const TPair<FMeshBooleanCacheKey, FMeshBooleanCacheEntry>& Pair : CachedBooleans)
+			{
+				if (Pair.Value.LastUsed < OldestUse)
+				{
+					OldestUse = Pair.Value.LastUsed;
+					OldestKey = &Pair.Key;
+				}
+			}
+			FMeshBooleanCacheKey RemoveKey = *OldestKey;
+			CachedTriangles -= CachedBooleans[RemoveKey].TriangleCount;
+			CachedBooleans.Remove(RemoveKey);
+		}
+	}
+}
+
+
+uint64 RTGUtils::ComputeMeshContentHash(const FDynamicMesh3& Mesh)
+{
+	using namespace MeshBooleanCacheLocals;
+
+	TArray<uint64> Hashes;
+
+	bool bVertexNormals = Mesh.HasVertexNormals();
+	bool bVertexColors = Mesh.HasVertexColors();
+	bool bVertexUVs = Mesh.HasVertexUVs();
+	Hashes.Add(((uint64)bVertexNormals) | ((uint64)bVertexColors << 1) | ((uint64)bVertexUVs << 2));
+	Hashes.Add(HashIDRange(Mesh.MaxVertexID(), [&](int32 VertexID, TArray<uint8>& Data)
+	{
+		bool bIsVertex = Mesh.IsVertex(VertexID);
+		AppendBytes(Data, bIsVertex);
+		if (bIsVertex)
+		{
+			AppendBytes(Data, Mesh.GetVertex(VertexID));
+			if (bVertexNormals)
+			{
+				AppendBytes(Data, Mesh.GetVertexNormal(VertexID));
+			}
+			if (bVertexColors)
+			{
+				AppendBytes(Data, Mesh.GetVertexColor(VertexID));
+			}
+			if (bVertexUVs)
+			{
+				AppendBytes(Data, Mesh.GetVertexUV(VertexID));
+			}
+		}
+	}));
+
+	bool bTriangleGroups = Mesh.HasTriangleGroups();
+	Hashes.Add((uint64)bTriangleGroups);
+	Hashes.Add(HashIDRange(Mesh.MaxTriangleID(), [&](int32 TriangleID, TArray<uint8>& Data)
+	{
+		bool bIsTriangle = Mesh.IsTriangle(TriangleID);
+		AppendBytes(Data, bIsTriangle);
+		if (bIsTriangle)
+		{
+			AppendBytes(Data, Mesh.GetTriangle(TriangleID));
+			if (bTriangleGroups)
+			{
+				AppendBytes(Data, Mesh.GetTriangleGroup(TriangleID));
+			}
+		}
+	}));
+
+	if (Mesh.HasAttributes())
+	{
+		const FDynamicMeshAttributeSet* Attributes = Mesh.Attributes();
+		Hashes.Add((uint64)Attributes->NumUVLayers());
+		for (int32 UVLayer = 0; UVLayer < Attributes->NumUVLayers(); ++UVLayer)
+		{
+			HashOverlay(Mesh, *Attributes->GetUVLayer(UVLayer), Hashes);
+		}
+		HashOverlay(Mesh, *Attributes->PrimaryNormals(), Hashes);
+
+		if (Attributes->HasMaterialID())
+		{
+			const FDynamicMeshMaterialAttribute* MaterialIDs = Attributes->GetMaterialID();
+			Hashes.Add(HashIDRange(Mesh.MaxTriangleID(), [&](int32 TriangleID, TArray<uint8>& Data)
+			{
+				AppendBytes(Data, (Mesh.IsTriangle(TriangleID)) ? MaterialIDs->GetValue(TriangleID) : -1);
+			}));
+		}
+	}
+
+	return CityHash64((const char*)Hashes.GetData(), (uint32)(Hashes.Num() * sizeof(uint64)));
+}
+
+
+bool RTGUtils::IsMeshBooleanCacheEnabled()
+{
+	using namespace MeshBooleanCacheLocals;
+	FScopeLock Lock(&CachedBooleansLock);
+	return MaxCachedResults > 0 && MaxCachedTriangles > 0;
+}
+
+
+bool RTGUtils::FindCachedMeshBoolean(
+	uint64 MeshHashA,
+	uint64 MeshHashB,
+	const FTransform3d& TransformB,
+	FMeshBoolean::EBooleanOp Operation,
+	FDynamicMesh3& ResultOut,
+	uint64& ResultHashOut)
+{
+	using namespace MeshBooleanCacheLocals;
+
+	TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe> Result;
+	{
+		FScopeLock Lock(&CachedBooleansLock);
+		FMeshBooleanCacheEntry* Found = CachedBooleans.Find(FMeshBooleanCacheKey(MeshHashA, MeshHashB, TransformB, Operation));
+		if (Found == nullptr)
+		{
+			return false;
+		}
+		Found->LastUsed = ++UseCounter;
+		Result = Found->Result;
+		ResultHashOut = Found->ResultHash;
+	}
+
+	// results are never modified after they are added, so they can be copied outside the lock
+	ResultOut = *Result;
+	return true;
+}
+
+
+void RTGUtils::AddCachedMeshBoolean(
+	uint64 MeshHashA,
+	uint64 MeshHashB,
+	const FTransform3d& TransformB,
+	FMeshBoolean::EBooleanOp Operation,
+	const FDynamicMesh3& Result,
+	uint64 ResultHash)
+{
+	using namespace MeshBooleanCacheLocals;
+
+	if (IsMeshBooleanCacheEnabled() == false)
+	{
+		return;
+	}
+
+	FMeshBooleanCacheEntry Entry;
+	Entry.TriangleCount = Result.TriangleCount();
+	Entry.ResultHash = ResultHash;
+	Entry.Result = MakeShared<const FDynamicMesh3, ESPMode::ThreadSafe>(Result);
+
+	FScopeLock Lock(&CachedBooleansLock);
+	if (Entry.TriangleCount > MaxCachedTriangles)
+	{
+		return;
+	}
+	FMeshBooleanCacheKey Key(MeshHashA, MeshHashB, TransformB, Operation);
+	if (const FMeshBooleanCacheEntry* Existing = CachedBooleans.Find(Key))
+	{
+		CachedTriangles -= Existing->TriangleCount;
+	}
+	Entry.LastUsed = ++UseCounter;
+	CachedTriangles += Entry.TriangleCount;
+	CachedBooleans.Add(Key, MoveTemp(Entry));
+	EvictToCapacity();
+}
+
+
+void RTGUtils::SetMeshBooleanCacheCapacity(int32 MaxResults, int64 MaxTriangles)
+{
+	using namespace MeshBooleanCacheLocals;
+	FScopeLock Lock(&CachedBooleansLock);
+	MaxCachedResults = FMath::Max(0, MaxResults);
+	MaxCachedTriangles = FMath::Max((int64)0, MaxTriangles);
+	EvictToCapacity();
+}
+
+
+void RTGUtils::ClearMeshBooleanCache()
+{
+	using namespace MeshBooleanCacheLocals;
+	FScopeLock Lock(&CachedBooleansLock);
+	CachedBooleans.Reset();
+	CachedTriangles = 0;
+}
@@ -0,0 +1,381 @@
+#include "MeshBooleanOps.h"
+#include "MeshBooleanBroadPhase.h"
+#include "UpdatableMeshAABBTree3.h"
+#include "MeshTransforms.h"
+#include "DynamicSubmesh3.h"
+#include "DynamicMeshEditor.h"
+#include "Spatial/PointHashGrid3.h"
+#include "Async/ParallelFor.h"
+
+
+namespace MeshBooleanOpsLocals
+{
+	/** @return the 30-bit Morton code of the cell containing Point in a 1024^3 grid over Bounds */
+	static uint32 GetMortonCode(const FVector3d& Point, const FAxisAlignedBox3d& Bounds)
+	{
+		auto SpreadBits = [](uint32 Value)
+		{
+			Value = (Value | (Value << 16)) & 0x030000FF;
+			Value = (Value | (Value << 8)) & 0x0300F00F;
+			Value = (Value | (Value << 4)) & 0x030C30C3;
+			Value = (Value | (Value << 2)) & 0x09249249;
+			return Value;
+		};
+		uint32 Code = 0;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			double Size = Bounds.Max[Axis] - Bounds.Min[Axis];
+			double T = (Size > FMathd::ZeroTolerance) ? ((Point[Axis] - Bounds.Min[Axis]) / Size) : 0.0;
+			uint32 Cell = (uint32)FMath::Clamp((int32)(T * 1024.0), 0, 1023);
+			Code |= SpreadBits(Cell) << Axis;
+		}
+		return Code;
+	}
+
+	/** Combine Meshes pairwise in a balanced tree, with the pairs of each level computed in parallel. The result is left in Meshes[0]. */
+	static bool ReduceMeshes(TArray<FDynamicMesh3>& Meshes, FMeshBoolean::EBooleanOp Operation)
+	{
+		TAtomic<bool> bAllOK(true);
+		int32 NumMeshes = Meshes.Num();
+		while (NumMeshes > 1)
+		{
+			int32 NumPairs = NumMeshes / 2;
+			ParallelFor(NumPairs, [&](int32 k)
+			{
+				if (RTGUtils::ComputeMeshBoolean(Meshes[2 * k], Meshes[2 * k + 1], Operation) == false)
+				{
+					bAllOK = false;
+				}
+				Meshes[2 * k + 1] = FDynamicMesh3();
+			});
+			// compact the results (and the unpaired last mesh) into the first half of the array
+			for (int32 k = 1; k < NumPairs; ++k)
+			{
+				Meshes[k] = MoveTemp(Meshes[2 * k]);
+			}
+			if (NumMeshes % 2 == 1)
+			{
+				Meshes[NumPairs] = MoveTemp(Meshes[NumMeshes - 1]);
+			}
+			NumMeshes = (NumMeshes + 1) / 2;
+		}
+		Meshes.SetNum(NumMeshes);
+		return bAllOK;
+	}
+
+	/** @return max squared distance between the endpoints of EdgeA and EdgeB, for the closer of the two ways of pairing them */
+	static double GetEdgeDistanceSqr(const FDynamicMesh3& Mesh, int32 EdgeA, int32 EdgeB)
+	{
+		FIndex2i VertsA = Mesh.GetEdgeV(EdgeA), VertsB = Mesh.GetEdgeV(EdgeB);
+		FVector3d A0 = Mesh.GetVertex(VertsA.A), A1 = Mesh.GetVertex(VertsA.B);
+		FVector3d B0 = Mesh.GetVertex(VertsB.A), B1 = Mesh.GetVertex(VertsB.B);
+		double SameDistSqr = FMathd::Max(A0.DistanceSquared(B0), A1.DistanceSquared(B1));
+		double SwappedDistSqr = FMathd::Max(A0.DistanceSquared(B1), A1.DistanceSquared(B0));
+		return FMathd::Min(SameDistSqr, SwappedDistSqr);
+	}
+
+	/**
+	 * Merge each of the boundary edges in Edges with a coincident boundary edge in Edges, like FMergeCoincidentMeshEdges,
+	 * but without visiting the rest of the mesh.
+	 * @param VertexTolerance edges are merged if their endpoints are within this distance
+	 */
+	static void WeldBoundaryEdges(FDynamicMesh3& Mesh, const TSet<int32>& Edges, double VertexTolerance)
+	{
+		// the midpoints of coincident edges are within VertexTolerance
+		double SearchRadius = 2.0 * VertexTolerance;
+		TPointHashGrid3d<int32> EdgeGrid(SearchRadius, IndexConstants::InvalidID);
+		TArray<int32> BoundaryEdges;
+		for (int32 eid : Edges)
+		{
+			if (Mesh.IsEdge(eid) && Mesh.IsBoundaryEdge(eid))
+			{
+				BoundaryEdges.Add(eid);
+				FIndex2i EdgeV = Mesh.GetEdgeV(eid);
+				EdgeGrid.InsertPointUnsafe(eid, 0.5 * (Mesh.GetVertex(EdgeV.A) + Mesh.GetVertex(EdgeV.B)));
+			}
+		}
+
+		double ToleranceSqr = VertexTolerance * VertexTolerance;
+		for (int32 eid : BoundaryEdges)
+		{
+			// edges are no longer boundary edges once they have been merged
+			if (Mesh.IsEdge(eid) == false || Mesh.IsBoundaryEdge(eid) == false)
+			{
+				continue;
+			}
+			FIndex2i EdgeV = Mesh.GetEdgeV(eid);
+			TPair<int32, double> Nearest = EdgeGrid.FindNearestInRadius(
+				0.5 * (Mesh.GetVertex(EdgeV.A) + Mesh.GetVertex(EdgeV.B)), SearchRadius,
+				[&](const int32& OtherEID) { return GetEdgeDistanceSqr(Mesh, eid, OtherEID); },
+				[&](const int32& OtherEID) { return OtherEID == eid || Mesh.IsEdge(OtherEID) == false || Mesh.IsBoundaryEdge(OtherEID) == false; });
+			if (Nearest.Key != IndexConstants::InvalidID && Nearest.Value <= ToleranceSqr)
+			{
+				FDynamicMesh3::FMergeEdgesInfo MergeInfo;
+				Mesh.MergeEdges(eid, Nearest.Key, MergeInfo);
+			}
+		}
+	}
+}
+
+
+bool RTGUtils::ComputeMeshBoolean(FDynamicMesh3& MeshA, const FDynamicMesh3& MeshB, FMeshBoolean::EBooleanOp Operation)
+{
+	const FTransform3d Identity = FTransform3d::Identity();
+	EMeshBooleanBroadPhaseResult Relationship = EMeshBooleanBroadPhaseResult::Disjoint;
+	if (TestBooleanBoundsOverlap(MeshA, Identity, MeshB, Identity))
+	{
+		FUpdatableMeshAABBTree3 TreeA(&MeshA, true);
+		FUpdatableMeshAABBTree3 TreeB(&MeshB, true);
+		Relationship = ClassifyBooleanOperands(TreeA, Identity, TreeB, Identity);
+	}
+	if (Relationship != EMeshBooleanBroadPhaseResult::Intersecting)
+	{
+		ApplyTrivialBoolean(MeshA, Identity, MeshB, Identity, Operation, Relationship);
+		return true;
+	}
+
+	FDynamicMesh3 ResultMesh;
+	FMeshBoolean Boolean(&MeshA, Identity, &MeshB, Identity, &ResultMesh, Operation);
+	Boolean.bPutResultInInputSpace = true;
+	bool bOK = Boolean.Compute();
+	MeshA = MoveTemp(ResultMesh);
+	return bOK;
+}
+
+
+bool RTGUtils::ComputeLocalMeshBoolean(
+	FDynamicMesh3& MeshA,
+	FUpdatableMeshAABBTree3& MeshATree,
+	const FDynamicMesh3& MeshB,
+	FMeshBoolean::EBooleanOp Operation,
+	TArray<int32>& RemovedTrianglesOut,
+	TArray<int32>& AddedTrianglesOut)
+{
+	RemovedTrianglesOut.Reset();
+	AddedTrianglesOut.Reset();
+	using namespace MeshBooleanOpsLocals;
+	bool bDifference = (Operation == FMeshBoolean::EBooleanOp::Difference);
+	if (bDifference == false && Operation != FMeshBoolean::EBooleanOp::Union)
+	{
+		return false;
+	}
+
+	// The region is the triangles that overlap the (padded) bounds of MeshB. The boundary edges of the region belong to 
+	// triangles outside the region, so they do not touch MeshB, and the rest of MeshA is entirely outside MeshB.
+	FAxisAlignedBox3d BoundsB = MeshB.GetBounds();
+	double Padding = FMathd::Max(BoundsB.MaxDim() * 0.01, FMathd::ZeroTolerance);
+	BoundsB.Min -= Padding * FVector3d::One();
+	BoundsB.Max += Padding * FVector3d::One();
+	TArray<int32> RegionTriangles;
+	MeshATree.FindTrianglesInBox(BoundsB, RegionTriangles);
+	if (RegionTriangles.Num() == MeshA.TriangleCount())
+	{
+		return false;
+	}
+	if (RegionTriangles.Num() == 0)
+	{
+		// MeshB does not touch MeshA, so it is either entirely inside (Union: no change, Difference: cavity) or outside (Union: append, Difference: no change)
+		bool bInside = false;
+		for (int32 tid : MeshB.TriangleIndicesItr())
+		{
+			// use a vertex on the surface of MeshB, unreferenced vertices can be anywhere
+			bInside = IsPointInsideMesh(MeshATree, MeshB.GetVertex(MeshB.GetTriangle(tid).A));
+			break;
+		}
+		if (bInside == bDifference)
+		{
+			FDynamicMesh3 AppendMesh(MeshB);
+			if (bDifference)
+			{
+				AppendMesh.ReverseOrientation();
+			}
+			FDynamicMeshEditor Editor(&MeshA);
+			FMeshIndexMappings Mappings;
+			Editor.AppendMesh(&AppendMesh, Mappings);
+			for (int32 tid : AppendMesh.TriangleIndicesItr())
+			{
+				AddedTrianglesOut.Add(Mappings.GetNewTriangle(tid));
+			}
+		}
+		return true;
+	}
+
+	FDynamicSubmesh3 Region(&MeshA, RegionTriangles);
+	const FDynamicMesh3& RegionMesh = Region.GetSubmesh();
+	const FTransform3d Identity = FTransform3d::Identity();
+
+	// the part of the region outside MeshB. MeshB is closed, so this is correct even though the region is open.
+	FDynamicMesh3 RegionPart;
+	{
+		FMeshBoolean Trim(&RegionMesh, Identity, &MeshB, Identity, &RegionPart, FMeshBoolean::EBooleanOp::TrimInside);
+		Trim.bPutResultInInputSpace = true;
+		if (Trim.Compute() == false)
+		{
+			return false;
+		}
+	}
+
+	// MeshB cut along its intersection with the region. The trim discards pieces of MeshB that are inside the (open) region. 
+	// For Difference the region is reversed, so that the pieces inside MeshA are never discarded. The remaining pieces
+	// are classified against all of MeshA below.
+	FDynamicMesh3 PartB;
+	{
+		FDynamicMesh3 TrimRegion(RegionMesh);
+		if (bDifference)
+		{
+			TrimRegion.ReverseOrientation();
+		}
+		FMeshBoolean Trim(&MeshB, Identity, &TrimRegion, Identity, &PartB, FMeshBoolean::EBooleanOp::TrimInside);
+		Trim.bPutResultInInputSpace = true;
+		if (Trim.Compute() == false)
+		{
+			return false;
+		}
+	}
+	TArray<int32> PartBTriangles;
+	for (int32 tid : PartB.TriangleIndicesItr())
+	{
+		PartBTriangles.Add(tid);
+	}
+	TArray<bool> KeepTriangle;
+	KeepTriangle.SetNum(PartBTriangles.Num());
+	ParallelFor(PartBTriangles.Num(), [&](int32 k)
+	{
+		bool bInside = IsPointInsideMesh(MeshATree, PartB.GetTriCentroid(PartBTriangles[k]));
+		KeepTriangle[k] = (bInside == bDifference);
+	});
+	for (int32 k = 0; k < PartBTriangles.Num(); ++k)
+	{
+		if (KeepTriangle[k] == false)
+		{
+			PartB.RemoveTriangle(PartBTriangles[k], true, false);
+		}
+	}
+	if (bDifference)
+	{
+		PartB.ReverseOrientation();
+	}
+
+	// replace the region with the two parts, and weld them to the rest of MeshA and each other.
+	// Only the edges of the hole left by the region and the boundary edges of the parts can be welded.
+	TSet<int32> HoleVertices;
+	for (int32 tid : RegionTriangles)
+	{
+		FIndex3i TriV = MeshA.GetTriangle(tid);
+		HoleVertices.Add(TriV.A);
+		HoleVertices.Add(TriV.B);
+		HoleVertices.Add(TriV.C);
+	}
+	for (int32 tid : RegionTriangles)
+	{
+		MeshA.RemoveTriangle(tid, true, false);
+	}
+	RemovedTrianglesOut = MoveTemp(RegionTriangles);
+	TSet<int32> WeldEdges;
+	for (int32 vid : HoleVertices)
+	{
+		if (MeshA.IsVertex(vid))
+		{
+			for (int32 eid : MeshA.VtxEdgesItr(vid))
+			{
+				WeldEdges.Add(eid);
+			}
+		}
+	}
+	FDynamicMeshEditor Editor(&MeshA);
+	for (const FDynamicMesh3* Part : { &RegionPart, &PartB })
+	{
+		FMeshIndexMappings Mappings;
+		Editor.AppendMesh(Part, Mappings);
+		for (int32 tid : Part->TriangleIndicesItr())
+		{
+			int32 NewTID = Mappings.GetNewTriangle(tid);
+			AddedTrianglesOut.Add(NewTID);
+			FIndex3i TriEdges = MeshA.GetTriEdges(NewTID);
+			for (int32 j = 0; j < 3; ++j)
+			{
+				if (MeshA.IsBoundaryEdge(TriEdges[j]))
+				{
+					WeldEdges.Add(TriEdges[j]);
+				}
+			}
+		}
+	}
+	WeldBoundaryEdges(MeshA, WeldEdges, FMathd::Max(BoundsB.MaxDim() * 1e-6, FMathd::ZeroTolerance));
+
+	return true;
+}
+
+
+bool RTGUtils::ComputeMeshBooleanWithMany(
+	FDynamicMesh3& TargetMesh,
+	const FTransform3d& TargetTransform,
+	const TArray<const FDynamicMesh3*>& Operands,
+	const TArray<FTransform3d>& OperandTransforms,
+	FMeshBoolean::EBooleanOp Operation)
+{
+	using namespace MeshBooleanOpsLocals;
+	if (!ensure(Operands.Num() == OperandTransforms.Num()))
+	{
+		return false;
+	}
+
+	// copy the operands into the local space of TargetMesh
+	TArray<int32> OperandIndices;
+	for (int32 k = 0; k < Operands.Num(); ++k)
+	{
+		if (Operands[k] != nullptr && Operands[k]->TriangleCount() > 0)
+		{
+			OperandIndices.Add(k);
+		}
+	}
+	TArray<FDynamicMesh3> Meshes;
+	Meshes.SetNum(OperandIndices.Num());
+	TArray<FVector3d> Centers;
+	Centers.SetNum(OperandIndices.Num());
+	ParallelFor(OperandIndices.Num(), [&](int32 k)
+	{
+		int32 OperandIndex = OperandIndices[k];
+		Meshes[k] = *Operands[OperandIndex];
+		MeshTransforms::ApplyTransform(Meshes[k], OperandTransforms[OperandIndex]);
+		MeshTransforms::ApplyTransformInverse(Meshes[k], TargetTransform);
+		Centers[k] = Meshes[k].GetBounds().Center();
+	});
+	if (Meshes.Num() == 0)
+	{
+		if (Operation == FMeshBoolean::EBooleanOp::Intersect)
+		{
+			TargetMesh.Clear();
+		}
+		return true;
+	}
+
+	// sort the operands along a Morton curve, so that neighbours in the reduction tree are spatially close
+	FAxisAlignedBox3d CentersBounds = FAxisAlignedBox3d::Empty();
+	for (const FVector3d& Center : Centers)
+	{
+		CentersBounds.Contain(Center);
+	}
+	TArray<TPair<uint32, int32>> SortKeys;
+	for (int32 k = 0; k < Meshes.Num(); ++k)
+	{
+		SortKeys.Add(TPair<uint32, int32>(GetMortonCode(Centers[k], CentersBounds), k));
+	}
+	SortKeys.Sort([](const TPair<uint32, int32>& A, const TPair<uint32, int32>& B) { return A.Key < B.Key; });
+	TArray<FDynamicMesh3> SortedMeshes;
+	SortedMeshes.SetNum(Meshes.Num());
+	for (int32 k = 0; k < SortKeys.Num(); ++k)
+	{
+		SortedMeshes[k] = MoveTemp(Meshes[SortKeys[k].Value]);
+	}
+
+	// For Difference, the union of the operands is subtracted from TargetMesh. For Union and Intersect the 
+	// operands are reduced first as well, TargetMesh is usually the largest mesh so it is combined last.
+	FMeshBoolean::EBooleanOp ReduceOp = (Operation == FMeshBoolean::EBooleanOp::Difference) ? FMeshBoolean::EBooleanOp::Union : Operation;
+	bool bOK = ReduceMeshes(SortedMeshes, ReduceOp);
+	if (ComputeMeshBoolean(TargetMesh, SortedMeshes[0], Operation) == false)
+	{
+		bOK = false;
+	}
+	return bOK;
+}
@@ -47,19 +47,45 @@ void RTGUtils::UpdatePMCFromDynamicMesh_SplitTriangles(
 {
 	Component->ClearAllMeshSections();
 
-	int32 NumTriangles = Mesh->TriangleCount();
+	TArray<int32> TriangleIDs;
+	TriangleIDs.Reserve(Mesh->TriangleCount());
+	for (int32 tid : Mesh->TriangleIndicesItr())
+	{
+		TriangleIDs.Add(tid);
+	}
+	UpdatePMCSectionFromDynamicMesh_SplitTriangles(Component, 0, Mesh, TriangleIDs, bUseFaceNormals, bInitializeUV0, bInitializePerVertexColors, bCreateCollision);
+}
+
+
+
+void RTGUtils::UpdatePMCSectionFromDynamicMesh_SplitTriangles(
+	UProceduralMeshComponent* Component,
+	int32 SectionIndex,
+	const FDynamicMesh3* Mesh,
+	const TArray<int32>& TriangleIDs,
+	bool bUseFaceNormals,
+	bool bInitializeUV0,
+	bool bInitializePerVertexColors,
+	bool bCreateCollision)
+{
+	int32 NumTriangles = TriangleIDs.Num();
 	int32 NumVertices = NumTriangles * 3;
 
 	TArray<FVector> Vertices, Normals;
 	Vertices.SetNumUninitialized(NumVertices);
 	Normals.SetNumUninitialized(NumVertices);
 
-	FMeshNormals PerVertexNormals(Mesh);
+	// per-vertex normals are only computed for the vertices of TriangleIDs
+	TMap<int32, FVector3d> PerVertexNormals;
+	auto GetPerVertexNormal = [&PerVertexNormals, Mesh](int32 vid)
+	{
+		const FVector3d* Found = PerVertexNormals.Find(vid);
+		return (Found != nullptr) ? *Found : PerVertexNormals.Add(vid, FMeshNormals::ComputeVertexNormal(*Mesh, vid));
+	};
 	bool bUsePerVertexNormals = false;
 	const FDynamicMeshNormalOverlay* NormalOverlay = nullptr;
 	if (Mesh->HasAttributes() == false && bUseFaceNormals == false)
 	{
-		PerVertexNormals.ComputeVertexNormals();
 		bUsePerVertexNormals = true;
 	}
 	else if (Mesh->HasAttributes())
@@ -91,7 +117,7 @@ void RTGUtils::UpdatePMCFromDynamicMesh_SplitTriangles(
 	FVector3f Normal[3];
 	FVector2f UV[3];
 	int32 BufferIndex = 0;
-	for (int32 tid : Mesh->TriangleIndicesItr())
+	for (int32 tid : TriangleIDs)
 	{
 		int32 k = 3 * (BufferIndex++);
 
@@ -105,9 +131,9 @@ void RTGUtils::UpdatePMCFromDynamicMesh_SplitTriangles(
 
 		if (bUsePerVertexNormals)
 		{
-			Normals[k] = (FVector)PerVertexNormals[TriVerts.A];
-			Normals[k+1] = (FVector)PerVertexNormals[TriVerts.B];
-			Normals[k+2] = (FVector)PerVertexNormals[TriVerts.C];
+			Normals[k] = (FVector)GetPerVertexNormal(TriVerts.A);
+			Normals[k+1] = (FVector)GetPerVertexNormal(TriVerts.B);
+			Normals[k+2] = (FVector)GetPerVertexNormal(TriVerts.C);
 		}
 		else if (NormalOverlay != nullptr && bUseFaceNormals == false)
 		{
@@ -144,5 +170,5 @@ void RTGUtils::UpdatePMCFromDynamicMesh_SplitTriangles(
 		Triangles[k+2] = k+2;
 	}
 
-	Component->CreateMeshSection_LinearColor(0, Vertices, Triangles, Normals, UV0, VtxColors, Tangents, bCreateCollision);
+	Component->CreateMeshSection_LinearColor(SectionIndex, Vertices, Triangles, Normals, UV0, VtxColors, Tangents, bCreateCollision);
 }
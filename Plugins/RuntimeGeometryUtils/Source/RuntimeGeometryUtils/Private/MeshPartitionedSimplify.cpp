@@ -0,0 +1,403 @@
+#include "MeshPartitionedSimplify.h"
+#include "MeshSimplification.h"
+#include "MeshConstraintsUtil.h"
+#include "DynamicMeshEditor.h"
+#include "DynamicMeshAttributeSet.h"
+#include "Async/ParallelFor.h"
+
+
+namespace MeshPartitionedSimplifyLocals
+{
+	/** Partitions are only worthwhile above this many triangles each */
+	static const int32 MinPartitionTriangles = 50000;
+	static const int32 MaxPartitions = 64;
+
+	/** Fraction of the removed triangles that is left to the final pass */
+	static const double FinalPassFraction = 0.1;
+
+	/** Number of histogram bins used to find the median centroid when splitting a partition */
+	static const int32 NumSplitBins = 1024;
+
+	/**
+	 * Split the triangles into NumPartitions sets, by splitting the largest set in two at the (approximate) median of its
+	 * centroids along the longest axis of the centroid bounds, until there are enough sets.
+	 */
+	static void SplitTriangles(const TArray<FVector3d>& Centroids, TArray<int32>&& AllTriangles, int32 NumPartitions, TArray<TArray<int32>>& PartitionsOut)
+	{
+		PartitionsOut.Reset();
+		PartitionsOut.Add(MoveTemp(AllTriangles));
+		while (PartitionsOut.Num() < NumPartitions)
+		{
+			int32 LargestIndex = 0;
+			for (int32 k = 1; k < PartitionsOut.Num(); ++k)
+			{
+				LargestIndex = (PartitionsOut[k].Num() > PartitionsOut[LargestIndex].Num()) ? k : LargestIndex;
+			}
+			TArray<int32> Triangles = MoveTemp(PartitionsOut[LargestIndex]);
+
+			FAxisAlignedBox3d Bounds = FAxisAlignedBox3d::Empty();
+			for (int32 tid : Triangles)
+			{
+				Bounds.Contain(Centroids[tid]);
+			}
+			int32 Axis = (Bounds.Width() >= Bounds.Height()) ? ((Bounds.Width() >= Bounds.Depth()) ? 0 : 2) : ((Bounds.Height() >= Bounds.Depth()) ? 1 : 2);
+			double AxisMin = Bounds.Min[Axis];
+			double BinScale = (double)NumSplitBins / FMathd::Max(Bounds.Max[Axis] - AxisMin, FMathd::ZeroTolerance);
+			auto GetBin = [&](int32 tid) { return FMath::Clamp((int32)((Centroids[tid][Axis] - AxisMin) * BinScale), 0, NumSplitBins - 1); };
+
+			TArray<int32> BinCounts;
+			BinCounts.Init(0, NumSplitBins);
+			for (int32 tid : Triangles)
+			{
+				BinCounts[GetBin(tid)]++;
+			}
+			int32 SplitBin = 0, CountBelow = 0;
+			while (SplitBin < NumSplitBins - 1 && CountBelow + BinCounts[SplitBin] <= Triangles.Num() / 2)
+			{
+				CountBelow += BinCounts[SplitBin++];
+			}
+
+			TArray<int32> Below, Above;
+			Below.Reserve(Triangles.Num() / 2);
+			Above.Reserve(Triangles.Num() / 2);
+			for (int32 tid : Triangles)
+			{
+				((GetBin(tid) < SplitBin) ? Below : Above).Add(tid);
+			}
+			if (Below.Num() == 0 || Above.Num() == 0)
+			{
+				// all centroids are in one bin, the partition cannot be split further
+				PartitionsOut[LargestIndex] = MoveTemp(Triangles);
+				break;
+			}
+			PartitionsOut[LargestIndex] = MoveTemp(Below);
+			PartitionsOut.Add(MoveTemp(Above));
+		}
+	}
+
+
+	/**
+	 * Simplify Mesh to TargetTriangleCount, as in UGeneratedMesh::SimplifyMeshToTriCount(). The LockedVertices cannot be moved
+	 * or removed, and the boundary edges between them cannot be modified.
+	 */
+	static void SimplifyWithLockedVertices(FDynamicMesh3& Mesh, int32 TargetTriangleCount, bool bPreserveAttributes, const TArray<int32>& LockedVertices)
+	{
+		if (!Mesh.HasTriangleGroups())
+		{
+			Mesh.EnableTriangleGroups();		// workaround for failing check()
+		}
+
+		FMeshConstraints Constraints;
+		if (bPreserveAttributes)
+		{
+			// eliminate any bowties that might have formed on UV seams.
+			if (FDynamicMeshAttributeSet* Attributes = Mesh.Attributes())
+			{
+				for (int i = 0; i < Attributes->NumUVLayers(); ++i)
+				{
+					Attributes->GetUVLayer(i)->SplitBowties();
+				}
+				Attributes->PrimaryNormals()->SplitBowties();
+			}
+
+			bool bAllowSeamSplits = true, bAllowSeamSmoothing = true, bAllowSeamCollapse = true;
+			FMeshConstraintsUtil::ConstrainAllBoundariesAndSeams(Constraints, Mesh,
+				EEdgeRefineFlags::NoConstraint, EEdgeRefineFlags::NoConstraint, EEdgeRefineFlags::NoConstraint,
+				bAllowSeamSplits, bAllowSeamSmoothing, bAllowSeamCollapse);
+		}
+		TSet<int32> LockedSet(LockedVertices);
+		for (int32 vid : LockedVertices)
+		{
+			Constraints.SetOrUpdateVertexConstraint(vid, FVertexConstraint::FullyConstrained());
+		}
+		for (int32 vid : LockedVertices)
+		{
+			for (int32 eid : Mesh.VtxEdgesItr(vid))
+			{
+				FIndex2i EdgeV = Mesh.GetEdgeV(eid);
+				int32 OtherV = (EdgeV.A == vid) ? EdgeV.B : EdgeV.A;
+				if (Mesh.IsBoundaryEdge(eid) && LockedSet.Contains(OtherV))
+				{
+					Constraints.SetOrUpdateEdgeConstraint(eid, FEdgeConstraint::FullyConstrained());
+				}
+			}
+		}
+
+		if (bPreserveAttributes && Mesh.HasAttributes())
+		{
+			FAttrMeshSimplification Reducer(&Mesh);
+			Reducer.SetEdgeFlipTolerance(1.e-5);
+			Reducer.SetExternalConstraints(MoveTemp(Constraints));
+			Reducer.SimplifyToTriangleCount(TargetTriangleCount);
+		}
+		else
+		{
+			FQEMSimplification Reducer(&Mesh);
+			Reducer.SetExternalConstraints(MoveTemp(Constraints));
+			Reducer.SimplifyToTriangleCount(TargetTriangleCount);
+		}
+	}
+
+
+	/**
+	 * Merge the overlay elements at each vertex that have identical values. Appending the partitions duplicates the elements
+	 * along the partition boundaries, and this removes the resulting (invisible) seams so they do not constrain the final pass.
+	 */
+	template<typename RealType, int ElementSize>
+	static void MergeIdenticalElements(const FDynamicMesh3& Mesh, TDynamicMeshOverlay<RealType, ElementSize>* Overlay)
+	{
+		TArray<int> VertexElements;
+		for (int32 vid : Mesh.VertexIndicesItr())
+		{
+			Overlay->GetVertexElements(vid, VertexElements);
+			if (VertexElements.Num() < 2)
+			{
+				continue;
+			}
+
+			TMap<int32, int32> ElementRemap;
+			for (int32 k = 1; k < VertexElements.Num(); ++k)
+			{
+				RealType Value[ElementSize];
+				Overlay->GetElement(VertexElements[k], Value);
+				for (int32 j = 0; j < k; ++j)
+				{
+					RealType OtherValue[ElementSize];
+					Overlay->GetElement(VertexElements[j], OtherValue);
+					if (ElementRemap.Contains(VertexElements[j]) == false && FMemory::Memcmp(Value, OtherValue, sizeof(Value)) == 0)
+					{
+						ElementRemap.Add(VertexElements[k], VertexElements[j]);
+						break;
+					}
+				}
+			}
+			if (ElementRemap.Num() == 0)
+			{
+				continue;
+			}
+
+			for (int32 tid : Mesh.VtxTrianglesItr(vid))
+			{
+				if (Overlay->IsSetTriangle(tid) == false)
+				{
+					continue;
+				}
+				FIndex3i TriElements = Overlay->GetTriangle(tid);
+				bool bModified = false;
+				for (int32 j = 0; j < 3; ++j)
+				{
+					if (const int32* NewElement = ElementRemap.Find(TriElements[j]))
+					{
+						TriElements[j] = *NewElement;
+						bModified = true;
+					}
+				}
+				if (bModified)
+				{
+					Overlay->SetTriangle(tid, TriElements);
+				}
+			}
+		}
+	}
+}
+
+
+void RTGUtils::SimplifyMeshPartitioned(
+	FDynamicMesh3& Mesh,
+	int32 TargetTriangleCount,
+	bool bPreserveAttributes,
+	int32 NumPartitions)
+{
+	using namespace MeshPartitionedSimplifyLocals;
+	TargetTriangleCount = FMath::Max(1, TargetTriangleCount);
+	int32 NumTriangles = Mesh.TriangleCount();
+	if (TargetTriangleCount >= NumTriangles)
+	{
+		return;
+	}
+	bPreserveAttributes = bPreserveAttributes && Mesh.HasAttributes();
+
+	if (NumPartitions <= 0)
+	{
+		NumPartitions = NumTriangles / MinPartitionTriangles;
+	}
+	NumPartitions = FMath::Clamp(NumPartitions, 1, MaxPartitions);
+	if (NumPartitions == 1)
+	{
+		SimplifyWithLockedVertices(Mesh, TargetTriangleCount, bPreserveAttributes, TArray<int32>());
+		Mesh.CompactInPlace();
+		return;
+	}
+
+	TArray<FVector3d> Centroids;
+	Centroids.SetNum(Mesh.MaxTriangleID());
+	ParallelFor(Mesh.MaxTriangleID(), [&](int32 tid)
+	{
+		Centroids[tid] = (Mesh.IsTriangle(tid)) ? Mesh.GetTriCentroid(tid) : FVector3d::Zero();
+	});
+	TArray<int32> AllTriangles;
+	AllTriangles.Reserve(NumTriangles);
+	for (int32 tid : Mesh.TriangleIndicesItr())
+	{
+		AllTriangles.Add(tid);
+	}
+	TArray<TArray<int32>> Partitions;
+	SplitTriangles(Centroids, MoveTemp(AllTriangles), NumPartitions, Partitions);
+	NumPartitions = Partitions.Num();
+
+	TArray<int32> TrianglePartition;
+	TrianglePartition.Init(-1, Mesh.MaxTriangleID());
+	for (int32 PartIndex = 0; PartIndex < NumPartitions; ++PartIndex)
+	{
+		for (int32 tid : Partitions[PartIndex])
+		{
+			TrianglePartition[tid] = PartIndex;
+		}
+	}
+
+	// the partitions keep their share of the budget plus their share of the triangles left to the final pass
+	double RemovedTriangles = (double)(NumTriangles - TargetTriangleCount);
+	double PartitionKeepFraction = ((double)TargetTriangleCount + FinalPassFraction * RemovedTriangles) / (double)NumTriangles;
+
+	TArray<FDynamicMesh3> PartitionMeshes;
+	PartitionMeshes.SetNum(NumPartitions);
+	TArray<TArray<TPair<int32, int32>>> PartitionLockedVertices;		// (partition vertex, source vertex)
+	PartitionLockedVertices.SetNum(NumPartitions);
+	ParallelFor(NumPartitions, [&](int32 PartIndex)
+	{
+		FDynamicMesh3& PartMesh = PartitionMeshes[PartIndex];
+		PartMesh.EnableMatchingAttributes(Mesh);
+		if (Mesh.HasTriangleGroups())
+		{
+			PartMesh.EnableTriangleGroups();
+		}
+		FDynamicMeshEditor Editor(&PartMesh);
+		FMeshIndexMappings Mappings;
+		FDynamicEditResult EditResult;
+		Editor.AppendTriangles(&Mesh, Partitions[PartIndex], Mappings, EditResult, false);
+
+		// AppendTriangles() allocates new group IDs, restore the source groups so the result has the same polygroups as the serial path
+		if (Mesh.HasTriangleGroups())
+		{
+			for (int32 tid : Partitions[PartIndex])
+			{
+				PartMesh.SetTriangleGroup(Mappings.GetNewTriangle(tid), Mesh.GetTriangleGroup(tid));
+			}
+		}
+
+		// lock the vertices shared with other partitions
+		TSet<int32> SharedVertices;
+		for (int32 tid : Partitions[PartIndex])
+		{
+			FIndex3i TriV = Mesh.GetTriangle(tid);
+			for (int32 j = 0; j < 3; ++j)
+			{
+				if (SharedVertices.Contains(TriV[j]))
+				{
+					continue;
+				}
+				for (int32 NbrTID : Mesh.VtxTrianglesItr(TriV[j]))
+				{
+					if (TrianglePartition[NbrTID] != PartIndex)
+					{
+						SharedVertices.Add(TriV[j]);
+						break;
+					}
+				}
+			}
+		}
+		TArray<int32> LockedVertices;
+		for (int32 SourceVID : SharedVertices)
+		{
+			int32 PartVID = Mappings.GetNewVertex(SourceVID);
+			LockedVertices.Add(PartVID);
+			PartitionLockedVertices[PartIndex].Add(TPair<int32, int32>(PartVID, SourceVID));
+		}
+
+		int32 PartTarget = FMath::Max((int32)(PartitionKeepFraction * (double)PartMesh.TriangleCount()), 1);
+		SimplifyWithLockedVertices(PartMesh, PartTarget, bPreserveAttributes, LockedVertices);
+	});
+
+	// combine the partitions, and record the source vertex of each locked vertex
+	FDynamicMesh3 Combined;
+	Combined.EnableMatchingAttributes(Mesh);
+	Combined.EnableTriangleGroups();
+	FDynamicMeshEditor Editor(&Combined);
+	TArray<TPair<int32, int32>> SeamVertices;		// (combined vertex, source vertex)
+	for (int32 PartIndex = 0; PartIndex < NumPartitions; ++PartIndex)
+	{
+		FMeshIndexMappings Mappings;
+		const FDynamicMesh3& PartMesh = PartitionMeshes[PartIndex];
+		Editor.AppendMesh(&PartMesh, Mappings);
+		if (PartMesh.HasTriangleGroups())
+		{
+			// AppendMesh() remaps the group IDs as well, the partition groups are the source groups
+			for (int32 tid : PartMesh.TriangleIndicesItr())
+			{
+				Combined.SetTriangleGroup(Mappings.GetNewTriangle(tid), PartMesh.GetTriangleGroup(tid));
+			}
+		}
+		for (const TPair<int32, int32>& Locked : PartitionLockedVertices[PartIndex])
+		{
+			SeamVertices.Add(TPair<int32, int32>(Mappings.GetNewVertex(Locked.Key), Locked.Value));
+		}
+	}
+	PartitionMeshes.Empty();
+	TArray<int32> SourceVertex;
+	SourceVertex.Init(-1, Combined.MaxVertexID());
+	for (const TPair<int32, int32>& Seam : SeamVertices)
+	{
+		SourceVertex[Seam.Key] = Seam.Value;
+	}
+
+	// weld the partitions along the locked boundaries, which are unchanged, so each seam edge is a boundary edge
+	// in the two partitions on either side of it, between the same source vertices
+	TMap<FIndex2i, int32> SeamEdges;
+	TArray<FIndex2i> SeamEdgePairs;
+	for (const TPair<int32, int32>& Seam : SeamVertices)
+	{
+		for (int32 eid : Combined.VtxEdgesItr(Seam.Key))
+		{
+			FIndex2i EdgeV = Combined.GetEdgeV(eid);
+			int32 OtherV = (EdgeV.A == Seam.Key) ? EdgeV.B : EdgeV.A;
+			// each edge is visited from its lower vertex
+			if (OtherV < Seam.Key || SourceVertex[OtherV] < 0 || Combined.IsBoundaryEdge(eid) == false)
+			{
+				continue;
+			}
+			FIndex2i SourceEdge(FMath::Min(Seam.Value, SourceVertex[OtherV]), FMath::Max(Seam.Value, SourceVertex[OtherV]));
+			if (const int32* FirstEdge = SeamEdges.Find(SourceEdge))
+			{
+				SeamEdgePairs.Add(FIndex2i(*FirstEdge, eid));
+			}
+			else
+			{
+				SeamEdges.Add(SourceEdge, eid);
+			}
+		}
+	}
+	for (const FIndex2i& EdgePair : SeamEdgePairs)
+	{
+		// merging an edge can also merge neighbouring edges that now connect the same vertices
+		if (Combined.IsEdge(EdgePair.A) && Combined.IsEdge(EdgePair.B) && Combined.IsBoundaryEdge(EdgePair.A) && Combined.IsBoundaryEdge(EdgePair.B))
+		{
+			FDynamicMesh3::FMergeEdgesInfo MergeInfo;
+			Combined.MergeEdges(EdgePair.A, EdgePair.B, MergeInfo);
+		}
+	}
+
+	if (bPreserveAttributes)
+	{
+		FDynamicMeshAttributeSet* Attributes = Combined.Attributes();
+		for (int i = 0; i < Attributes->NumUVLayers(); ++i)
+		{
+			MergeIdenticalElements(Combined, Attributes->GetUVLayer(i));
+		}
+		MergeIdenticalElements(Combined, Attributes->PrimaryNormals());
+	}
+
+	// final pass with the partition boundaries unlocked
+	SimplifyWithLockedVertices(Combined, TargetTriangleCount, bPreserveAttributes, TArray<int32>());
+	Combined.CompactInPlace();
+	Mesh = MoveTemp(Combined);
+}
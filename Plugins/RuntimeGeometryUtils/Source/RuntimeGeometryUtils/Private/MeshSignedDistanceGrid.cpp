@@ -0,0 +1,486 @@
+#include "MeshSignedDistanceGrid.h"
+#include "MarchingCubes.h"
+#include "Distance/DistPoint3Triangle3.h"
+
+#include "Async/ParallelFor.h"
+
+
+namespace MeshSignedDistanceGridLocals
+{
+	static const int32 BlockSize = FMeshSignedDistanceGrid::BlockSize;
+	static const int32 NodesPerBlock = BlockSize * BlockSize * BlockSize;
+
+	/** Number of times the eight sweep directions are repeated */
+	static const int32 NumSweepPasses = 2;
+
+	static FORCEINLINE int32 NodeIndexInBlock(int32 i, int32 j, int32 k)
+	{
+		return i + BlockSize * (j + BlockSize * k);
+	}
+
+	static FORCEINLINE FVector3i GetGridCoords(int32 Index, const FVector3i& Dims)
+	{
+		return FVector3i(Index % Dims.X, (Index / Dims.X) % Dims.Y, Index / (Dims.X * Dims.Y));
+	}
+
+	static FDistPoint3Triangle3d TriangleDistance(const FDynamicMesh3& Mesh, int32 TriangleID, const FVector3d& Point)
+	{
+		FVector3d V0, V1, V2;
+		Mesh.GetTriVertices(TriangleID, V0, V1, V2);
+		return FDistPoint3Triangle3d(Point, FTriangle3d(V0, V1, V2));
+	}
+
+	static double TriangleDistanceSqr(const FDynamicMesh3& Mesh, int32 TriangleID, const FVector3d& Point)
+	{
+		return TriangleDistance(Mesh, TriangleID, Point).GetSquared();
+	}
+
+	/** Trilinear interpolation of the values at the corners of a cell, in x-fastest order, at the position P in [0,1]^3 */
+	static FORCEINLINE double Interpolate(const double V[8], const FVector3d& P)
+	{
+		double X00 = V[0] + P.X * (V[1] - V[0]);
+		double X10 = V[2] + P.X * (V[3] - V[2]);
+		double X01 = V[4] + P.X * (V[5] - V[4]);
+		double X11 = V[6] + P.X * (V[7] - V[6]);
+		double Y0 = X00 + P.Y * (X10 - X00);
+		double Y1 = X01 + P.Y * (X11 - X01);
+		return Y0 + P.Z * (Y1 - Y0);
+	}
+
+	/** Gradient of Interpolate() with respect to P */
+	static FORCEINLINE FVector3d InterpolateGradient(const double V[8], const FVector3d& P)
+	{
+		double DX = (1 - P.Y) * (1 - P.Z) * (V[1] - V[0]) + P.Y * (1 - P.Z) * (V[3] - V[2]) + (1 - P.Y) * P.Z * (V[5] - V[4]) + P.Y * P.Z * (V[7] - V[6]);
+		double DY = (1 - P.X) * (1 - P.Z) * (V[2] - V[0]) + P.X * (1 - P.Z) * (V[3] - V[1]) + (1 - P.X) * P.Z * (V[6] - V[4]) + P.X * P.Z * (V[7] - V[5]);
+		double DZ = (1 - P.X) * (1 - P.Y) * (V[4] - V[0]) + P.X * (1 - P.Y) * (V[5] - V[1]) + (1 - P.X) * P.Y * (V[6] - V[2]) + P.X * P.Y * (V[7] - V[3]);
+		return FVector3d(DX, DY, DZ);
+	}
+}
+
+
+void FMeshSignedDistanceGrid::Reset()
+{
+	NodeDims = FVector3i::Zero();
+	BlockDims = FVector3i::Zero();
+	BandWidth = 0;
+	BlockOffsets.Empty();
+	BlockSigns.Empty();
+	Distances.Empty();
+	NearestTriangles.Empty();
+	SourceMesh = nullptr;
+	SourceTimestamp = 0;
+}
+
+
+bool FMeshSignedDistanceGrid::IsValidFor(const FDynamicMesh3& Mesh) const
+{
+	return SourceMesh == &Mesh && SourceTimestamp == Mesh.GetTimestamp();
+}
+
+
+FAxisAlignedBox3d FMeshSignedDistanceGrid::GetBounds() const
+{
+	FVector3d Extent = CellSize * FVector3d(NodeDims.X - 1, NodeDims.Y - 1, NodeDims.Z - 1);
+	return FAxisAlignedBox3d(GridOrigin, GridOrigin + Extent);
+}
+
+
+void FMeshSignedDistanceGrid::Build(const FDynamicMesh3& Mesh, const FUpdatableMeshAABBTree3& AABBTree, TFastWindingTree<FDynamicMesh3>& FastWinding,
+	int32 Resolution, int32 NarrowBandCells, double ExtendBounds)
+{
+	using namespace MeshSignedDistanceGridLocals;
+	Reset();
+	SourceMesh = &Mesh;
+	SourceTimestamp = Mesh.GetTimestamp();
+	if (Mesh.TriangleCount() == 0)
+	{
+		return;
+	}
+
+	FAxisAlignedBox3d Bounds = Mesh.GetBounds();
+	Resolution = FMath::Clamp(Resolution, 4, 1024);
+	CellSize = FMathd::Max(Bounds.MaxDim() / (double)Resolution, FMathd::ZeroTolerance);
+	BandWidth = FMath::Max(NarrowBandCells, 1) * CellSize;
+	double Padding = FMathd::Max(ExtendBounds, 0.0) + BandWidth + CellSize;
+	GridOrigin = Bounds.Min - FVector3d(Padding, Padding, Padding);
+	for (int32 j = 0; j < 3; ++j)
+	{
+		NodeDims[j] = (int32)FMathd::Ceil((Bounds.Max[j] - Bounds.Min[j] + 2 * Padding) / CellSize) + 1;
+		BlockDims[j] = (NodeDims[j] + BlockSize - 1) / BlockSize;
+	}
+	int32 NumBlocks = BlockDims.X * BlockDims.Y * BlockDims.Z;
+
+	// Find the triangles within the band of each block. Blocks without any are outside the band and only store their sign,
+	// which is constant over the block because no triangle is closer than the band width.
+	TArray<TArray<int32>> BlockTriangles;
+	BlockTriangles.SetNum(NumBlocks);
+	BlockSigns.Init(1, NumBlocks);
+	ParallelFor(NumBlocks, [&](int32 BlockIndex)
+	{
+		FVector3i Block = GetGridCoords(BlockIndex, BlockDims);
+		FVector3d BlockMin = GridOrigin + (CellSize * BlockSize) * FVector3d(Block.X, Block.Y, Block.Z);
+		FVector3d BlockMax = BlockMin + FVector3d(CellSize * (BlockSize - 1), CellSize * (BlockSize - 1), CellSize * (BlockSize - 1));
+		FAxisAlignedBox3d BandBox(BlockMin - FVector3d(BandWidth, BandWidth, BandWidth), BlockMax + FVector3d(BandWidth, BandWidth, BandWidth));
+		AABBTree.FindTrianglesInBox(BandBox, BlockTriangles[BlockIndex]);
+		if (BlockTriangles[BlockIndex].Num() == 0)
+		{
+			BlockSigns[BlockIndex] = (FastWinding.IsInside((BlockMin + BlockMax) * 0.5, 0.5)) ? -1 : 1;
+		}
+	});
+
+	TArray<int32> BandBlocks;
+	BlockOffsets.Init(-1, NumBlocks);
+	for (int32 BlockIndex = 0; BlockIndex < NumBlocks; ++BlockIndex)
+	{
+		if (BlockTriangles[BlockIndex].Num() > 0)
+		{
+			BlockOffsets[BlockIndex] = BandBlocks.Num() * NodesPerBlock;
+			BandBlocks.Add(BlockIndex);
+		}
+	}
+	Distances.Init(TNumericLimits<float>::Max(), BandBlocks.Num() * NodesPerBlock);
+	NearestTriangles.Init(-1, BandBlocks.Num() * NodesPerBlock);
+
+	// exact distances for the nodes within a cell of the bounds of each triangle
+	TArray<bool> IsExactNode;
+	IsExactNode.Init(false, Distances.Num());
+	ParallelFor(BandBlocks.Num(), [&](int32 k)
+	{
+		int32 BlockIndex = BandBlocks[k];
+		FVector3i BlockNodeMin = GetGridCoords(BlockIndex, BlockDims) * BlockSize;
+		int32 Offset = BlockOffsets[BlockIndex];
+		for (int32 tid : BlockTriangles[BlockIndex])
+		{
+			FAxisAlignedBox3d TriBounds = Mesh.GetTriBounds(tid);
+			FVector3i NodeMin, NodeMax;
+			for (int32 j = 0; j < 3; ++j)
+			{
+				NodeMin[j] = (int32)FMathd::Floor((TriBounds.Min[j] - GridOrigin[j]) / CellSize) - 1 - BlockNodeMin[j];
+				NodeMax[j] = (int32)FMathd::Ceil((TriBounds.Max[j] - GridOrigin[j]) / CellSize) + 1 - BlockNodeMin[j];
+			}
+			if (NodeMax.X < 0 || NodeMax.Y < 0 || NodeMax.Z < 0 || NodeMin.X >= BlockSize || NodeMin.Y >= BlockSize || NodeMin.Z >= BlockSize)
+			{
+				continue;
+			}
+			for (int32 j = 0; j < 3; ++j)
+			{
+				NodeMin[j] = FMath::Max(NodeMin[j], 0);
+				NodeMax[j] = FMath::Min(NodeMax[j], BlockSize - 1);
+			}
+
+			for (int32 nk = NodeMin.Z; nk <= NodeMax.Z; ++nk)
+			{
+				for (int32 nj = NodeMin.Y; nj <= NodeMax.Y; ++nj)
+				{
+					for (int32 ni = NodeMin.X; ni <= NodeMax.X; ++ni)
+					{
+						int32 Index = Offset + NodeIndexInBlock(ni, nj, nk);
+						FVector3d NodePos = GridOrigin + CellSize * FVector3d(BlockNodeMin.X + ni, BlockNodeMin.Y + nj, BlockNodeMin.Z + nk);
+						double Distance = FMathd::Sqrt(TriangleDistanceSqr(Mesh, tid, NodePos));
+						if (Distance < Distances[Index])
+						{
+							Distances[Index] = (float)Distance;
+							NearestTriangles[Index] = tid;
+						}
+						IsExactNode[Index] = true;
+					}
+				}
+			}
+		}
+	});
+
+	// Fast sweeping. Each node takes the nearest of the triangles nearest to its upwind neighbours in the sweep direction.
+	// A sweep only writes to the nodes of its own block, so blocks with the same parity in each axis can be swept in parallel.
+	TArray<int32> ParityBlocks[8];
+	for (int32 BlockIndex : BandBlocks)
+	{
+		FVector3i Block = GetGridCoords(BlockIndex, BlockDims);
+		ParityBlocks[(Block.X & 1) | ((Block.Y & 1) << 1) | ((Block.Z & 1) << 2)].Add(BlockIndex);
+	}
+	for (int32 Pass = 0; Pass < NumSweepPasses; ++Pass)
+	{
+		for (int32 Direction = 0; Direction < 8; ++Direction)
+		{
+			FVector3i Step((Direction & 1) ? -1 : 1, (Direction & 2) ? -1 : 1, (Direction & 4) ? -1 : 1);
+			for (int32 Parity = 0; Parity < 8; ++Parity)
+			{
+				const TArray<int32>& SweepBlocks = ParityBlocks[Parity];
+				ParallelFor(SweepBlocks.Num(), [&](int32 k)
+				{
+					int32 BlockIndex = SweepBlocks[k];
+					FVector3i BlockNodeMin = GetGridCoords(BlockIndex, BlockDims) * BlockSize;
+					int32 Offset = BlockOffsets[BlockIndex];
+					for (int32 sk = 0; sk < BlockSize; ++sk)
+					{
+						int32 nk = (Step.Z > 0) ? sk : (BlockSize - 1 - sk);
+						for (int32 sj = 0; sj < BlockSize; ++sj)
+						{
+							int32 nj = (Step.Y > 0) ? sj : (BlockSize - 1 - sj);
+							for (int32 si = 0; si < BlockSize; ++si)
+							{
+								int32 ni = (Step.X > 0) ? si : (BlockSize - 1 - si);
+								int32 Index = Offset + NodeIndexInBlock(ni, nj, nk);
+								FVector3i Node(BlockNodeMin.X + ni, BlockNodeMin.Y + nj, BlockNodeMin.Z + nk);
+								FVector3d NodePos = GridOrigin + CellSize * FVector3d(Node.X, Node.Y, Node.Z);
+								for (int32 Upwind = 1; Upwind < 8; ++Upwind)
+								{
+									int32 NbrIndex = GetNodeIndex(
+										Node.X - ((Upwind & 1) ? Step.X : 0), Node.Y - ((Upwind & 2) ? Step.Y : 0), Node.Z - ((Upwind & 4) ? Step.Z : 0));
+									int32 NbrTriangle = (NbrIndex >= 0) ? NearestTriangles[NbrIndex] : -1;
+									if (NbrTriangle >= 0 && NbrTriangle != NearestTriangles[Index])
+									{
+										double Distance = FMathd::Sqrt(TriangleDistanceSqr(Mesh, NbrTriangle, NodePos));
+										if (Distance < Distances[Index])
+										{
+											Distances[Index] = (float)Distance;
+											NearestTriangles[Index] = NbrTriangle;
+										}
+									}
+								}
+							}
+						}
+					}
+				});
+			}
+		}
+	}
+
+	// Signs. Nodes near the surface are tested individually. The other nodes of a block are grouped into connected regions,
+	// which cannot cross the surface, and the winding number is evaluated once per region.
+	ParallelFor(BandBlocks.Num(), [&](int32 k)
+	{
+		int32 BlockIndex = BandBlocks[k];
+		FVector3i BlockNodeMin = GetGridCoords(BlockIndex, BlockDims) * BlockSize;
+		int32 Offset = BlockOffsets[BlockIndex];
+		auto NodePosition = [&](int32 LocalIndex)
+		{
+			FVector3i Local = GetGridCoords(LocalIndex, FVector3i(BlockSize, BlockSize, BlockSize));
+			return GridOrigin + CellSize * FVector3d(BlockNodeMin.X + Local.X, BlockNodeMin.Y + Local.Y, BlockNodeMin.Z + Local.Z);
+		};
+		auto SetSign = [&](int32 LocalIndex, bool bInside)
+		{
+			float& Distance = Distances[Offset + LocalIndex];
+			Distance = FMath::Min(Distance, (float)BandWidth) * ((bInside) ? -1.0f : 1.0f);
+		};
+
+		TArray<bool> Visited;
+		Visited.Init(false, NodesPerBlock);
+		TArray<int32, TInlineAllocator<NodesPerBlock>> Stack;
+		for (int32 SeedIndex = 0; SeedIndex < NodesPerBlock; ++SeedIndex)
+		{
+			if (Visited[SeedIndex])
+			{
+				continue;
+			}
+			Visited[SeedIndex] = true;
+			bool bInside = FastWinding.IsInside(NodePosition(SeedIndex), 0.5);
+			SetSign(SeedIndex, bInside);
+			if (IsExactNode[Offset + SeedIndex])
+			{
+				continue;
+			}
+
+			Stack.Add(SeedIndex);
+			while (Stack.Num() > 0)
+			{
+				FVector3i Local = GetGridCoords(Stack.Pop(false), FVector3i(BlockSize, BlockSize, BlockSize));
+				const FVector3i Neighbours[6] = { {Local.X - 1, Local.Y, Local.Z}, {Local.X + 1, Local.Y, Local.Z},
+					{Local.X, Local.Y - 1, Local.Z}, {Local.X, Local.Y + 1, Local.Z}, {Local.X, Local.Y, Local.Z - 1}, {Local.X, Local.Y, Local.Z + 1} };
+				for (const FVector3i& Nbr : Neighbours)
+				{
+					if (Nbr.X >= 0 && Nbr.X < BlockSize && Nbr.Y >= 0 && Nbr.Y < BlockSize && Nbr.Z >= 0 && Nbr.Z < BlockSize)
+					{
+						int32 NbrIndex = NodeIndexInBlock(Nbr.X, Nbr.Y, Nbr.Z);
+						if (Visited[NbrIndex] == false && IsExactNode[Offset + NbrIndex] == false)
+						{
+							Visited[NbrIndex] = true;
+							SetSign(NbrIndex, bInside);
+							Stack.Add(NbrIndex);
+						}
+					}
+				}
+			}
+		}
+	});
+}
+
+
+int32 FMeshSignedDistanceGrid::GetNodeIndex(int32 i, int32 j, int32 k) const
+{
+	if (i < 0 || j < 0 || k < 0 || i >= BlockDims.X * BlockSize || j >= BlockDims.Y * BlockSize || k >= BlockDims.Z * BlockSize)
+	{
+		return -1;
+	}
+	int32 Offset = BlockOffsets[(i / BlockSize) + BlockDims.X * ((j / BlockSize) + BlockDims.Y * (k / BlockSize))];
+	return (Offset < 0) ? -1 : Offset + MeshSignedDistanceGridLocals::NodeIndexInBlock(i % BlockSize, j % BlockSize, k % BlockSize);
+}
+
+
+float FMeshSignedDistanceGrid::GetNodeDistance(int32 i, int32 j, int32 k) const
+{
+	int32 BlockIndex = (i / BlockSize) + BlockDims.X * ((j / BlockSize) + BlockDims.Y * (k / BlockSize));
+	int32 Offset = BlockOffsets[BlockIndex];
+	if (Offset < 0)
+	{
+		return (float)(BlockSigns[BlockIndex] * BandWidth);
+	}
+	return Distances[Offset + MeshSignedDistanceGridLocals::NodeIndexInBlock(i % BlockSize, j % BlockSize, k % BlockSize)];
+}
+
+
+bool FMeshSignedDistanceGrid::FindCell(const FVector3d& Point, FVector3i& CellOut, FVector3d& CellPositionOut) const
+{
+	FVector3d GridPoint = (Point - GridOrigin) / CellSize;
+	for (int32 j = 0; j < 3; ++j)
+	{
+		if (!(GridPoint[j] >= 0 && GridPoint[j] < NodeDims[j] - 1))
+		{
+			return false;
+		}
+		CellOut[j] = (int32)GridPoint[j];
+		CellPositionOut[j] = GridPoint[j] - CellOut[j];
+	}
+	return true;
+}
+
+
+bool FMeshSignedDistanceGrid::GetDistance(const FVector3d& Point, double& DistanceOut) const
+{
+	FVector3d Unused;
+	return GetDistanceAndGradient(Point, DistanceOut, Unused);
+}
+
+
+bool FMeshSignedDistanceGrid::GetDistanceAndGradient(const FVector3d& Point, double& DistanceOut, FVector3d& GradientOut) const
+{
+	FVector3i Cell;
+	FVector3d CellPosition;
+	if (FindCell(Point, Cell, CellPosition) == false)
+	{
+		return false;
+	}
+
+	double Values[8];
+	for (int32 Corner = 0; Corner < 8; ++Corner)
+	{
+		Values[Corner] = GetNodeDistance(Cell.X + (Corner & 1), Cell.Y + ((Corner >> 1) & 1), Cell.Z + ((Corner >> 2) & 1));
+		if (FMathd::Abs(Values[Corner]) >= (float)BandWidth)
+		{
+			return false;
+		}
+	}
+	DistanceOut = MeshSignedDistanceGridLocals::Interpolate(Values, CellPosition);
+	GradientOut = MeshSignedDistanceGridLocals::InterpolateGradient(Values, CellPosition) / CellSize;
+	return true;
+}
+
+
+double FMeshSignedDistanceGrid::GetClampedDistance(const FVector3d& Point) const
+{
+	FVector3i Cell;
+	FVector3d CellPosition;
+	if (FindCell(Point, Cell, CellPosition) == false)
+	{
+		return BandWidth;
+	}
+
+	double Values[8];
+	for (int32 Corner = 0; Corner < 8; ++Corner)
+	{
+		Values[Corner] = GetNodeDistance(Cell.X + (Corner & 1), Cell.Y + ((Corner >> 1) & 1), Cell.Z + ((Corner >> 2) & 1));
+	}
+	return MeshSignedDistanceGridLocals::Interpolate(Values, CellPosition);
+}
+
+
+int32 FMeshSignedDistanceGrid::FindNearestTriangle(const FVector3d& Point, double& NearestDistSqrOut, FVector3d& NearestPointOut, FVector3d& BaryCoordsOut) const
+{
+	FVector3i Cell;
+	FVector3d CellPosition;
+	if (FindCell(Point, Cell, CellPosition) == false)
+	{
+		return -1;
+	}
+
+	int32 NearestTriangle = -1;
+	NearestDistSqrOut = TNumericLimits<double>::Max();
+	TArray<int32, TInlineAllocator<8>> Candidates;
+	for (int32 Corner = 0; Corner < 8; ++Corner)
+	{
+		int32 NodeIndex = GetNodeIndex(Cell.X + (Corner & 1), Cell.Y + ((Corner >> 1) & 1), Cell.Z + ((Corner >> 2) & 1));
+		if (NodeIndex < 0 || FMath::Abs(Distances[NodeIndex]) >= (float)BandWidth)
+		{
+			return -1;
+		}
+		int32 Candidate = NearestTriangles[NodeIndex];
+		if (Candidate >= 0 && Candidates.Contains(Candidate) == false)
+		{
+			Candidates.Add(Candidate);
+			FDistPoint3Triangle3d Query = MeshSignedDistanceGridLocals::TriangleDistance(*SourceMesh, Candidate, Point);
+			double DistSqr = Query.GetSquared();
+			if (DistSqr < NearestDistSqrOut)
+			{
+				NearestDistSqrOut = DistSqr;
+				NearestPointOut = Query.ClosestTrianglePoint;
+				BaryCoordsOut = Query.TriangleBaryCoords;
+				NearestTriangle = Candidate;
+			}
+		}
+	}
+	return NearestTriangle;
+}
+
+
+
+bool RTGUtils::GenerateOffsetSurface(
+	const FMeshSignedDistanceGrid& Grid,
+	double Offset,
+	FDynamicMesh3& ResultOut)
+{
+	// the interpolated distance is only accurate up to a cell from the edge of the band
+	if (FMathd::Abs(Offset) > Grid.GetBandWidth() - Grid.GetCellSize())
+	{
+		return false;
+	}
+
+	FMarchingCubes MarchingCubes;
+	MarchingCubes.Implicit = [&Grid](const FVector3d& Pos) { return Grid.GetClampedDistance(Pos); };
+	MarchingCubes.IsoValue = Offset;
+	MarchingCubes.Bounds = Grid.GetBounds();
+	MarchingCubes.CubeSize = Grid.GetCellSize();
+	MarchingCubes.bParallelCompute = true;
+	ResultOut = FDynamicMesh3(&MarchingCubes.Generate());
+
+	// make sure the surface is oriented outwards, ie encloses positive volume
+	double SignedVolume = 0;
+	for (int32 tid : ResultOut.TriangleIndicesItr())
+	{
+		FVector3d V0, V1, V2;
+		ResultOut.GetTriVertices(tid, V0, V1, V2);
+		SignedVolume += V0.Dot(V1.Cross(V2));
+	}
+	if (SignedVolume < 0)
+	{
+		ResultOut.ReverseOrientation();
+	}
+	return true;
+}
+
+
+void RTGUtils::ComputeOffsetSurface(
+	const FDynamicMesh3& Mesh,
+	const FUpdatableMeshAABBTree3& AABBTree,
+	TFastWindingTree<FDynamicMesh3>& FastWinding,
+	int32 Resolution,
+	double Offset,
+	FDynamicMesh3& ResultOut)
+{
+	// same cell size as FMeshSignedDistanceGrid::Build()
+	Resolution = FMath::Clamp(Resolution, 4, 1024);
+	double CellSize = FMathd::Max(Mesh.GetBounds().MaxDim() / (double)Resolution, FMathd::ZeroTolerance);
+	int32 NarrowBandCells = (int32)FMathd::Ceil(FMathd::Abs(Offset) / CellSize) + 2;
+
+	FMeshSignedDistanceGrid Grid;
+	Grid.Build(Mesh, AABBTree, FastWinding, Resolution, NarrowBandCells, FMathd::Max(Offset, 0.0));
+	GenerateOffsetSurface(Grid, Offset, ResultOut);
+}
@@ -0,0 +1,374 @@
+#include "MeshSpatialQueries.h"
+#include "MeshQueries.h"
+#include "Async/ParallelFor.h"
+
+
+namespace MeshSpatialQueriesLocals
+{
+	/** Queries are processed in blocks, so that the per-task overhead of ParallelFor is not paid per query */
+	static const int32 QueryBlockSize = 256;
+
+	static void ParallelForQueries(int32 NumQueries, TFunctionRef<void(int32)> QueryFunc)
+	{
+		int32 NumBlocks = (NumQueries + QueryBlockSize - 1) / QueryBlockSize;
+		ParallelFor(NumBlocks, [&](int32 BlockIndex)
+		{
+			int32 BlockEnd = FMath::Min(NumQueries, (BlockIndex + 1) * QueryBlockSize);
+			for (int32 k = BlockIndex * QueryBlockSize; k < BlockEnd; ++k)
+			{
+				QueryFunc(k);
+			}
+		});
+	}
+
+	/**
+	 * Transform the rays (RayOrigins[k], RayDirections[k]) to the local space of the mesh and pass them to PacketFunc in
+	 * packets of consecutive rays. PacketFunc(FirstRay, LocalRays, NumRays) is called on worker threads.
+	 */
+	static void ParallelForRayPackets(
+		const FTransform3d& MeshToWorld, 
+		const TArray<FVector>& RayOrigins, 
+		const TArray<FVector>& RayDirections,
+		TFunctionRef<void(int32, const FRay3d*, int32)> PacketFunc)
+	{
+		const int32 PacketSize = FUpdatableMeshAABBTree3::MaxPacketSize;
+		int32 NumRays = RayOrigins.Num();
+		int32 NumPackets = (NumRays + PacketSize - 1) / PacketSize;
+		ParallelForQueries(NumPackets, [&](int32 PacketIndex)
+		{
+			int32 FirstRay = PacketIndex * PacketSize;
+			int32 NumPacketRays = FMath::Min(PacketSize, NumRays - FirstRay);
+			FRay3d LocalRays[PacketSize];
+			for (int32 j = 0; j < NumPacketRays; ++j)
+			{
+				FVector3d WorldDirection(RayDirections[FirstRay + j]); WorldDirection.Normalize();
+				LocalRays[j] = FRay3d(MeshToWorld.InverseTransformPosition((FVector3d)RayOrigins[FirstRay + j]),
+					MeshToWorld.InverseTransformNormal(WorldDirection));
+			}
+			PacketFunc(FirstRay, LocalRays, NumPacketRays);
+		});
+	}
+}
+
+
+void RTGUtils::FindDistancesToPoints(
+	const FDynamicMesh3& Mesh,
+	FDynamicMeshAABBTree3& AABBTree,
+	const FTransform3d& MeshToWorld,
+	const TArray<FVector>& Points,
+	FMeshDistanceQueryResults& ResultsOut)
+{
+	int32 NumPoints = Points.Num();
+	ResultsOut.Distances.SetNumUninitialized(NumPoints);
+	ResultsOut.NearestPoints.SetNumUninitialized(NumPoints);
+	ResultsOut.NearestTriangles.SetNumUninitialized(NumPoints);
+	ResultsOut.TriBaryCoords.SetNumUninitialized(NumPoints);
+
+	MeshSpatialQueriesLocals::ParallelForQueries(NumPoints, [&](int32 k)
+	{
+		FVector3d LocalPoint = MeshToWorld.InverseTransformPosition((FVector3d)Points[k]);
+
+		double NearDistSqr;
+		int32 NearestTriangle = AABBTree.FindNearestTriangle(LocalPoint, NearDistSqr);
+		ResultsOut.NearestTriangles[k] = NearestTriangle;
+		if (NearestTriangle < 0)
+		{
+			ResultsOut.Distances[k] = TNumericLimits<float>::Max();
+			ResultsOut.NearestPoints[k] = Points[k];
+			ResultsOut.TriBaryCoords[k] = FVector::ZeroVector;
+			return;
+		}
+
+		FDistPoint3Triangle3d DistQuery = TMeshQueries<FDynamicMesh3>::TriangleDistance(Mesh, NearestTriangle, LocalPoint);
+		ResultsOut.Distances[k] = (float)FMathd::Sqrt(NearDistSqr);
+		ResultsOut.NearestPoints[k] = (FVector)MeshToWorld.TransformPosition(DistQuery.ClosestTrianglePoint);
+		ResultsOut.TriBaryCoords[k] = (FVector)DistQuery.TriangleBaryCoords;
+	});
+}
+
+
+void RTGUtils::FindDistancesToPoints(
+	const FMeshSignedDistanceGrid& Grid,
+	const FDynamicMesh3& Mesh,
+	FDynamicMeshAABBTree3& AABBTree,
+	const FTransform3d& MeshToWorld,
+	const TArray<FVector>& Points,
+	FMeshDistanceQueryResults& ResultsOut)
+{
+	int32 NumPoints = Points.Num();
+	ResultsOut.Distances.SetNumUninitialized(NumPoints);
+	ResultsOut.NearestPoints.SetNumUninitialized(NumPoints);
+	ResultsOut.NearestTriangles.SetNumUninitialized(NumPoints);
+	ResultsOut.TriBaryCoords.SetNumUninitialized(NumPoints);
+
+	MeshSpatialQueriesLocals::ParallelForQueries(NumPoints, [&](int32 k)
+	{
+		FVector3d LocalPoint = MeshToWorld.InverseTransformPosition((FVector3d)Points[k]);
+
+		double NearDistSqr;
+		FVector3d NearestPoint, BaryCoords;
+		int32 NearestTriangle = Grid.FindNearestTriangle(LocalPoint, NearDistSqr, NearestPoint, BaryCoords);
+		if (NearestTriangle < 0)
+		{
+			NearestTriangle = AABBTree.FindNearestTriangle(LocalPoint, NearDistSqr);
+			if (NearestTriangle >= 0)
+			{
+				FDistPoint3Triangle3d DistQuery = TMeshQueries<FDynamicMesh3>::TriangleDistance(Mesh, NearestTriangle, LocalPoint);
+				NearestPoint = DistQuery.ClosestTrianglePoint;
+				BaryCoords = DistQuery.TriangleBaryCoords;
+			}
+		}
+
+		ResultsOut.NearestTriangles[k] = NearestTriangle;
+		if (NearestTriangle < 0)
+		{
+			ResultsOut.Distances[k] = TNumericLimits<float>::Max();
+			ResultsOut.NearestPoints[k] = Points[k];
+			ResultsOut.TriBaryCoords[k] = FVector::ZeroVector;
+			return;
+		}
+		ResultsOut.Distances[k] = (float)FMathd::Sqrt(NearDistSqr);
+		ResultsOut.NearestPoints[k] = (FVector)MeshToWorld.TransformPosition(NearestPoint);
+		ResultsOut.TriBaryCoords[k] = (FVector)BaryCoords;
+	});
+}
+
+
+void RTGUtils::FindNearestPoints(
+	FDynamicMeshAABBTree3& AABBTree,
+	const FTransform3d& MeshToWorld,
+	const TArray<FVector>& Points,
+	TArray<FVector>& NearestPointsOut)
+{
+	NearestPointsOut.SetNumUninitialized(Points.Num());
+	MeshSpatialQueriesLocals::ParallelForQueries(Points.Num(), [&](int32 k)
+	{
+		FVector3d LocalPoint = MeshToWorld.InverseTransformPosition((FVector3d)Points[k]);
+		NearestPointsOut[k] = (FVector)MeshToWorld.TransformPosition(AABBTree.FindNearestPoint(LocalPoint));
+	});
+}
+
+
+void RTGUtils::FindContainedPoints(
+	TFastWindingTree<FDynamicMesh3>& FastWinding,
+	const FTransform3d& MeshToWorld,
+	const TArray<FVector>& Points,
+	float WindingThreshold,
+	TArray<bool>& ContainedOut)
+{
+	ContainedOut.SetNumUninitialized(Points.Num());
+	MeshSpatialQueriesLocals::ParallelForQueries(Points.Num(), [&](int32 k)
+	{
+		FVector3d LocalPoint = MeshToWorld.InverseTransformPosition((FVector3d)Points[k]);
+		ContainedOut[k] = FastWinding.IsInside(LocalPoint, WindingThreshold);
+	});
+}
+
+
+void RTGUtils::FindContainedPoints(
+	const FWindingOccupancyGrid& Grid,
+	TFastWindingTree<FDynamicMesh3>& FastWinding,
+	const FTransform3d& MeshToWorld,
+	const TArray<FVector>& Points,
+	TArray<bool>& ContainedOut)
+{
+	ContainedOut.SetNumUninitialized(Points.Num());
+	MeshSpatialQueriesLocals::ParallelForQueries(Points.Num(), [&](int32 k)
+	{
+		FVector3d LocalPoint = MeshToWorld.InverseTransformPosition((FVector3d)Points[k]);
+		ContainedOut[k] = Grid.IsInside(FastWinding, LocalPoint);
+	});
+}
+
+
+bool RTGUtils::FindRayIntersections(
+	const FUpdatableMeshAABBTree3& AABBTree,
+	const FTransform3d& MeshToWorld,
+	const TArray<FVector>& RayOrigins,
+	const TArray<FVector>& RayDirections,
+	float MaxDistance,
+	FMeshRayQueryResults& ResultsOut)
+{
+	using namespace MeshSpatialQueriesLocals;
+	if (RayOrigins.Num() != RayDirections.Num())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FindRayIntersections: %d ray origins but %d ray directions"), RayOrigins.Num(), RayDirections.Num());
+		return false;
+	}
+
+	int32 NumRays = RayOrigins.Num();
+	ResultsOut.bHit.SetNumUninitialized(NumRays);
+	ResultsOut.HitDistances.SetNumUninitialized(NumRays);
+	ResultsOut.HitPoints.SetNumUninitialized(NumRays);
+	ResultsOut.HitTriangles.SetNumUninitialized(NumRays);
+	ResultsOut.TriBaryCoords.SetNumUninitialized(NumRays);
+
+	ParallelForRayPackets(MeshToWorld, RayOrigins, RayDirections, [&](int32 FirstRay, const FRay3d* LocalRays, int32 NumPacketRays)
+	{
+		TArray<FMeshRayPacketHit> Hits[FUpdatableMeshAABBTree3::MaxPacketSize];
+		AABBTree.FindRayPacketHits(LocalRays, NumPacketRays, MaxDistance, false, Hits);
+		for (int32 j = 0; j < NumPacketRays; ++j)
+		{
+			int32 k = FirstRay + j;
+			bool bHit = Hits[j].Num() > 0;
+			ResultsOut.bHit[k] = bHit;
+			ResultsOut.HitDistances[k] = (bHit) ? Hits[j][0].RayParameter : 0;
+			ResultsOut.HitPoints[k] = (bHit) ? (FVector)MeshToWorld.TransformPosition(LocalRays[j].PointAt(Hits[j][0].RayParameter)) : FVector::ZeroVector;
+			ResultsOut.HitTriangles[k] = (bHit) ? Hits[j][0].TriangleID : -1;
+			ResultsOut.TriBaryCoords[k] = (bHit) ? (FVector)Hits[j][0].TriBaryCoords : FVector::ZeroVector;
+		}
+	});
+
+	return true;
+}
+
+
+bool RTGUtils::FindAllRayIntersections(
+	const FUpdatableMeshAABBTree3& AABBTree,
+	const FTransform3d& MeshToWorld,
+	const TArray<FVector>& RayOrigins,
+	const TArray<FVector>& RayDirections,
+	float MaxDistance,
+	FMeshRayMultiHitResults& ResultsOut)
+{
+	using namespace MeshSpatialQueriesLocals;
+	if (RayOrigins.Num() != RayDirections.Num())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FindAllRayIntersections: %d ray origins but %d ray directions"), RayOrigins.Num(), RayDirections.Num());
+		return false;
+	}
+
+	// the number of hits is not known up front, so they are collected per ray and then packed into the output arrays
+	int32 NumRays = RayOrigins.Num();
+	TArray<TArray<FMeshRayPacketHit>> RayHits;
+	RayHits.SetNum(NumRays);
+	TArray<FRay3d> LocalRays;
+	LocalRays.SetNumUninitialized(NumRays);
+	ParallelForRayPackets(MeshToWorld, RayOrigins, RayDirections, [&](int32 FirstRay, const FRay3d* PacketRays, int32 NumPacketRays)
+	{
+		AABBTree.FindRayPacketHits(PacketRays, NumPacketRays, MaxDistance, true, &RayHits[FirstRay]);
+		for (int32 j = 0; j < NumPacketRays; ++j)
+		{
+			LocalRays[FirstRay + j] = PacketRays[j];
+		}
+	});
+
+	ResultsOut.FirstHits.SetNumUninitialized(NumRays);
+	ResultsOut.HitCounts.SetNumUninitialized(NumRays);
+	int32 NumHits = 0;
+	for (int32 k = 0; k < NumRays; ++k)
+	{
+		ResultsOut.FirstHits[k] = NumHits;
+		ResultsOut.HitCounts[k] = RayHits[k].Num();
+		NumHits += RayHits[k].Num();
+	}
+
+	ResultsOut.HitDistances.SetNumUninitialized(NumHits);
+	ResultsOut.HitPoints.SetNumUninitialized(NumHits);
+	ResultsOut.HitTriangles.SetNumUninitialized(NumHits);
+	ResultsOut.TriBaryCoords.SetNumUninitialized(NumHits);
+	ParallelForQueries(NumRays, [&](int32 k)
+	{
+		for (int32 j = 0; j < RayHits[k].Num(); ++j)
+		{
+			const FMeshRayPacketHit& Hit = RayHits[k][j];
+			int32 HitIndex = ResultsOut.FirstHits[k] + j;
+			ResultsOut.HitDistances[HitIndex] = Hit.RayParameter;
+			ResultsOut.HitPoints[HitIndex] = (FVector)MeshToWorld.TransformPosition(LocalRays[k].PointAt(Hit.RayParameter));
+			ResultsOut.HitTriangles[HitIndex] = Hit.TriangleID;
+			ResultsOut.TriBaryCoords[HitIndex] = (FVector)Hit.TriBaryCoords;
+		}
+	});
+
+	return true;
+}
+
+
+
+void RTGUtils::FindDistancesToPoints(
+	const FFlatMeshBVH& BVH,
+	const FTransform3d& MeshToWorld,
+	const TArray<FVector>& Points,
+	FMeshDistanceQueryResults& ResultsOut)
+{
+	int32 NumPoints = Points.Num();
+	ResultsOut.Distances.SetNumUninitialized(NumPoints);
+	ResultsOut.NearestPoints.SetNumUninitialized(NumPoints);
+	ResultsOut.NearestTriangles.SetNumUninitialized(NumPoints);
+	ResultsOut.TriBaryCoords.SetNumUninitialized(NumPoints);
+
+	MeshSpatialQueriesLocals::ParallelForQueries(NumPoints, [&](int32 k)
+	{
+		FVector3d LocalPoint = MeshToWorld.InverseTransformPosition((FVector3d)Points[k]);
+
+		double NearDistSqr;
+		FVector3d NearestPoint, BaryCoords;
+		int32 NearestTriangle = BVH.FindNearestTriangle(LocalPoint, NearDistSqr, NearestPoint, BaryCoords);
+		ResultsOut.NearestTriangles[k] = NearestTriangle;
+		bool bFound = NearestTriangle >= 0;
+		ResultsOut.Distances[k] = (bFound) ? (float)FMathd::Sqrt(NearDistSqr) : TNumericLimits<float>::Max();
+		ResultsOut.NearestPoints[k] = (bFound) ? (FVector)MeshToWorld.TransformPosition(NearestPoint) : Points[k];
+		ResultsOut.TriBaryCoords[k] = (bFound) ? (FVector)BaryCoords : FVector::ZeroVector;
+	});
+}
+
+
+void RTGUtils::FindNearestPoints(
+	const FFlatMeshBVH& BVH,
+	const FTransform3d& MeshToWorld,
+	const TArray<FVector>& Points,
+	TArray<FVector>& NearestPointsOut)
+{
+	NearestPointsOut.SetNumUninitialized(Points.Num());
+	MeshSpatialQueriesLocals::ParallelForQueries(Points.Num(), [&](int32 k)
+	{
+		FVector3d LocalPoint = MeshToWorld.InverseTransformPosition((FVector3d)Points[k]);
+		double NearDistSqr;
+		FVector3d NearestPoint, BaryCoords;
+		bool bFound = BVH.FindNearestTriangle(LocalPoint, NearDistSqr, NearestPoint, BaryCoords) >= 0;
+		NearestPointsOut[k] = (bFound) ? (FVector)MeshToWorld.TransformPosition(NearestPoint) : Points[k];
+	});
+}
+
+
+bool RTGUtils::FindRayIntersections(
+	const FFlatMeshBVH& BVH,
+	const FTransform3d& MeshToWorld,
+	const TArray<FVector>& RayOrigins,
+	const TArray<FVector>& RayDirections,
+	float MaxDistance,
+	FMeshRayQueryResults& ResultsOut)
+{
+	using namespace MeshSpatialQueriesLocals;
+	if (RayOrigins.Num() != RayDirections.Num())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FindRayIntersections: %d ray origins but %d ray directions"), RayOrigins.Num(), RayDirections.Num());
+		return false;
+	}
+
+	int32 NumRays = RayOrigins.Num();
+	ResultsOut.bHit.SetNumUninitialized(NumRays);
+	ResultsOut.HitDistances.SetNumUninitialized(NumRays);
+	ResultsOut.HitPoints.SetNumUninitialized(NumRays);
+	ResultsOut.HitTriangles.SetNumUninitialized(NumRays);
+	ResultsOut.TriBaryCoords.SetNumUninitialized(NumRays);
+
+	ParallelForRayPackets(MeshToWorld, RayOrigins, RayDirections, [&](int32 FirstRay, const FRay3d* LocalRays, int32 NumPacketRays)
+	{
+		for (int32 j = 0; j < NumPacketRays; ++j)
+		{
+			int32 k = FirstRay + j;
+			double RayParameter = 0;
+			FVector3d BaryCoords;
+			int32 HitTriangle = BVH.FindNearestHitTriangle(LocalRays[j], MaxDistance, RayParameter, BaryCoords);
+			bool bHit = HitTriangle >= 0;
+			ResultsOut.bHit[k] = bHit;
+			ResultsOut.HitDistances[k] = (bHit) ? (float)RayParameter : 0;
+			ResultsOut.HitPoints[k] = (bHit) ? (FVector)MeshToWorld.TransformPosition(LocalRays[j].PointAt(RayParameter)) : FVector::ZeroVector;
+			ResultsOut.HitTriangles[k] = HitTriangle;
+			ResultsOut.TriBaryCoords[k] = (bHit) ? (FVector)BaryCoords : FVector::ZeroVector;
+		}
+	});
+
+	return true;
+}
@@ -0,0 +1,251 @@
+#include "ProgressiveMesh.h"
+#include "MeshSimplification.h"
+
+
+namespace ProgressiveMeshLocals
+{
+	struct FCollapseRecord
+	{
+		int32 KeptVertex;
+		int32 RemovedVertex;
+		FIndex2i RemovedTriangles;
+		FVector3d NewPosition;
+	};
+
+	/** FQEMSimplification that records each collapse it applies */
+	class FRecordingQEMSimplification : public FQEMSimplification
+	{
+	public:
+		TArray<FCollapseRecord> Collapses;
+
+		FRecordingQEMSimplification(FDynamicMesh3* MeshIn) : FQEMSimplification(MeshIn)
+		{
+		}
+
+	protected:
+		virtual void OnEdgeCollapse(int edgeID, int va, int vb, const FDynamicMesh3::FEdgeCollapseInfo& collapseInfo) override
+		{
+			FQEMSimplification::OnEdgeCollapse(edgeID, va, vb, collapseInfo);
+			Collapses.Add({ collapseInfo.KeptVertex, collapseInfo.RemovedVertex, collapseInfo.RemovedTris, Mesh->GetVertex(collapseInfo.KeptVertex) });
+		}
+	};
+}
+
+
+void FProgressiveMesh::Reset()
+{
+	bBuilt = false;
+	Positions.Empty();
+	Triangles.Empty();
+	VertexRemovedAt.Empty();
+	TriangleRemovedAt.Empty();
+	VertexCollapsedTo.Empty();
+	CollapsePositions.Empty();
+	TriangleCountAfter.Empty();
+	VertexOrder.Empty();
+	VertexRank.Empty();
+	TriangleOrder.Empty();
+	PositionUpdateOffsets.Empty();
+	PositionUpdates.Empty();
+}
+
+
+void FProgressiveMesh::Build(const FDynamicMesh3& MeshIn)
+{
+	using namespace ProgressiveMeshLocals;
+	Reset();
+
+	FDynamicMesh3 SimplifyMesh;
+	SimplifyMesh.CompactCopy(MeshIn, false, false, false, false);
+	SimplifyMesh.EnableTriangleGroups();			// workaround for failing check()
+	int32 NumVertices = SimplifyMesh.MaxVertexID();
+	int32 NumTriangles = SimplifyMesh.MaxTriangleID();
+	Positions.SetNum(NumVertices);
+	for (int32 vid = 0; vid < NumVertices; ++vid)
+	{
+		Positions[vid] = SimplifyMesh.GetVertex(vid);
+	}
+	Triangles.SetNum(NumTriangles);
+	for (int32 tid = 0; tid < NumTriangles; ++tid)
+	{
+		Triangles[tid] = SimplifyMesh.GetTriangle(tid);
+	}
+
+	VertexRemovedAt.Init(MAX_int32, NumVertices);
+	for (int32 vid = 0; vid < NumVertices; ++vid)
+	{
+		if (SimplifyMesh.GetVtxEdgeCount(vid) == 0)
+		{
+			VertexRemovedAt[vid] = -1;
+		}
+	}
+
+	FRecordingQEMSimplification Simplifier(&SimplifyMesh);
+	Simplifier.SimplifyToTriangleCount(1);
+	const TArray<FCollapseRecord>& Collapses = Simplifier.Collapses;
+	int32 NumCollapses = Collapses.Num();
+
+	VertexCollapsedTo.Init(-1, NumVertices);
+	TriangleRemovedAt.Init(MAX_int32, NumTriangles);
+	CollapsePositions.SetNum(NumCollapses);
+	TriangleCountAfter.SetNum(NumCollapses + 1);
+	TriangleCountAfter[0] = NumTriangles;
+	TArray<int32> NumPositionUpdates;
+	NumPositionUpdates.Init(0, NumVertices);
+	for (int32 k = 0; k < NumCollapses; ++k)
+	{
+		const FCollapseRecord& Collapse = Collapses[k];
+		VertexRemovedAt[Collapse.RemovedVertex] = k;
+		VertexCollapsedTo[Collapse.RemovedVertex] = Collapse.KeptVertex;
+		CollapsePositions[k] = Collapse.NewPosition;
+		NumPositionUpdates[Collapse.KeptVertex]++;
+		int32 NumRemoved = 0;
+		for (int32 j = 0; j < 2; ++j)
+		{
+			if (Collapse.RemovedTriangles[j] >= 0)
+			{
+				TriangleRemovedAt[Collapse.RemovedTriangles[j]] = k;
+				NumRemoved++;
+			}
+		}
+		TriangleCountAfter[k + 1] = TriangleCountAfter[k] - NumRemoved;
+	}
+
+	PositionUpdateOffsets.SetNum(NumVertices + 1);
+	PositionUpdateOffsets[0] = 0;
+	for (int32 vid = 0; vid < NumVertices; ++vid)
+	{
+		PositionUpdateOffsets[vid + 1] = PositionUpdateOffsets[vid] + NumPositionUpdates[vid];
+		NumPositionUpdates[vid] = 0;
+	}
+	PositionUpdates.SetNum(NumCollapses);
+	for (int32 k = 0; k < NumCollapses; ++k)
+	{
+		int32 vid = Collapses[k].KeptVertex;
+		PositionUpdates[PositionUpdateOffsets[vid] + NumPositionUpdates[vid]++] = k;
+	}
+
+	// the elements of each level are a prefix of these orders
+	VertexOrder.SetNum(NumVertices);
+	for (int32 vid = 0; vid < NumVertices; ++vid)
+	{
+		VertexOrder[vid] = vid;
+	}
+	VertexOrder.StableSort([this](int32 A, int32 B) { return VertexRemovedAt[A] > VertexRemovedAt[B]; });
+	VertexRank.SetNum(NumVertices);
+	for (int32 k = 0; k < NumVertices; ++k)
+	{
+		VertexRank[VertexOrder[k]] = k;
+	}
+	TriangleOrder.SetNum(NumTriangles);
+	for (int32 tid = 0; tid < NumTriangles; ++tid)
+	{
+		TriangleOrder[tid] = tid;
+	}
+	TriangleOrder.StableSort([this](int32 A, int32 B) { return TriangleRemovedAt[A] > TriangleRemovedAt[B]; });
+
+	bBuilt = true;
+}
+
+
+int32 FProgressiveMesh::GetMaxTriangleCount() const
+{
+	return (bBuilt) ? TriangleCountAfter[0] : 0;
+}
+
+
+int32 FProgressiveMesh::GetMinTriangleCount() const
+{
+	return (bBuilt) ? TriangleCountAfter.Last() : 0;
+}
+
+
+int32 FProgressiveMesh::FindNumCollapses(int32 TriangleCount) const
+{
+	// find the fewest collapses that reach TriangleCount. TriangleCountAfter is decreasing.
+	int32 Lo = 0, Hi = TriangleCountAfter.Num() - 1;
+	while (Lo < Hi)
+	{
+		int32 Mid = (Lo + Hi) / 2;
+		if (TriangleCountAfter[Mid] <= TriangleCount)
+		{
+			Hi = Mid;
+		}
+		else
+		{
+			Lo = Mid + 1;
+		}
+	}
+	return Lo;
+}
+
+
+int32 FProgressiveMesh::GetLODTriangleCount(int32 TriangleCount) const
+{
+	return (bBuilt) ? TriangleCountAfter[FindNumCollapses(TriangleCount)] : 0;
+}
+
+
+FVector3d FProgressiveMesh::GetPosition(int32 VertexID, int32 NumCollapses) const
+{
+	// binary search for the last update before NumCollapses
+	int32 Lo = PositionUpdateOffsets[VertexID], Hi = PositionUpdateOffsets[VertexID + 1];
+	while (Lo < Hi)
+	{
+		int32 Mid = (Lo + Hi) / 2;
+		if (PositionUpdates[Mid] < NumCollapses)
+		{
+			Lo = Mid + 1;
+		}
+		else
+		{
+			Hi = Mid;
+		}
+	}
+	return (Lo > PositionUpdateOffsets[VertexID]) ? CollapsePositions[PositionUpdates[Lo - 1]] : Positions[VertexID];
+}
+
+
+int32 FProgressiveMesh::GetCollapsedVertex(int32 VertexID, int32 NumCollapses) const
+{
+	while (VertexRemovedAt[VertexID] < NumCollapses)
+	{
+		VertexID = VertexCollapsedTo[VertexID];
+	}
+	return VertexID;
+}
+
+
+int32 FProgressiveMesh::ExtractLOD(int32 TriangleCount, FDynamicMesh3& ResultOut) const
+{
+	ResultOut = FDynamicMesh3();
+	if (!bBuilt)
+	{
+		return 0;
+	}
+
+	int32 NumCollapses = FindNumCollapses(TriangleCount);
+
+	// every collapse removes one vertex, and the unreferenced vertices are at the end of VertexOrder
+	int32 NumVertices = 0;
+	while (NumVertices < VertexOrder.Num() && VertexRemovedAt[VertexOrder[NumVertices]] >= NumCollapses)
+	{
+		NumVertices++;
+	}
+	for (int32 k = 0; k < NumVertices; ++k)
+	{
+		ResultOut.AppendVertex(GetPosition(VertexOrder[k], NumCollapses));
+	}
+
+	int32 NumTriangles = TriangleCountAfter[NumCollapses];
+	for (int32 k = 0; k < NumTriangles; ++k)
+	{
+		FIndex3i Tri = Triangles[TriangleOrder[k]];
+		for (int32 j = 0; j < 3; ++j)
+		{
+			Tri[j] = VertexRank[GetCollapsedVertex(Tri[j], NumCollapses)];
+		}
+		ResultOut.AppendTriangle(Tri);
+	}
+	return ResultOut.TriangleCount();
+}
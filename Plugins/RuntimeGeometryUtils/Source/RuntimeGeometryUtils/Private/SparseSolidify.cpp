@@ -0,0 +1,245 @@
+#include "SparseSolidify.h"
+#include "MarchingCubes.h"
+
+#include "Async/ParallelFor.h"
+
+
+namespace SparseSolidifyLocals
+{
+	static const int32 BlockSize = RTGUtils::SparseSolidifyBlockSize;
+
+	/** Tolerance, in cells, for a vertex to be on a grid plane */
+	static const double GridTolerance = 1e-4;
+
+	/** Key of a vertex that is not on a block face */
+	static const uint64 InvalidSeamKey = MAX_uint64;
+
+	struct FBlockSurface
+	{
+		int32 BlockIndex = -1;
+		TArray<FVector3d> Vertices;
+		TArray<FIndex3i> Triangles;
+		/** Grid edge (or grid node) of each vertex on a face of the block, or InvalidSeamKey */
+		TArray<uint64> SeamKeys;
+		/** Bit for each face of the block (-X, +X, -Y, +Y, -Z, +Z) that the surface touches */
+		uint8 CrossedFaces = 0;
+	};
+
+	/**
+	 * @return key of the grid edge that the marching cubes vertex at GridPoint (in cell units) lies on. Both blocks that share
+	 * a face generate a vertex for a crossed edge of that face, and these get the same key. Vertices at a grid node get a node key.
+	 */
+	static uint64 GetSeamKey(const FVector3d& GridPoint)
+	{
+		int32 Axis = 3;
+		double MaxDeviation = GridTolerance;
+		FVector3i Rounded;
+		for (int32 j = 0; j < 3; ++j)
+		{
+			Rounded[j] = (int32)FMathd::Round(GridPoint[j]);
+			double Deviation = FMathd::Abs(GridPoint[j] - (double)Rounded[j]);
+			if (Deviation > MaxDeviation)
+			{
+				MaxDeviation = Deviation;
+				Axis = j;
+			}
+		}
+		if (Axis < 3)
+		{
+			Rounded[Axis] = (int32)FMathd::Floor(GridPoint[Axis]);
+		}
+		return (uint64)Axis | ((uint64)Rounded.X << 2) | ((uint64)Rounded.Y << 23) | ((uint64)Rounded.Z << 44);
+	}
+}
+
+
+void RTGUtils::ComputeSparseSolidify(
+	const FDynamicMesh3& Mesh,
+	TFastWindingTree<FDynamicMesh3>& FastWinding,
+	int32 VoxelResolution,
+	double WindingThreshold,
+	double ExtendBounds,
+	int32 SurfaceSearchSteps,
+	FDynamicMesh3& ResultOut)
+{
+	using namespace SparseSolidifyLocals;
+	ResultOut = FDynamicMesh3();
+	if (Mesh.TriangleCount() == 0)
+	{
+		return;
+	}
+	if (FastWinding.IsBuilt() == false)
+	{
+		FastWinding.Build();
+	}
+
+	// pad the grid by a cell beyond ExtendBounds, so that the surface closes inside the grid
+	FAxisAlignedBox3d Bounds = Mesh.GetBounds();
+	VoxelResolution = FMath::Clamp(VoxelResolution, 4, 2048);
+	double CellSize = FMathd::Max(Bounds.MaxDim() / (double)VoxelResolution, FMathd::ZeroTolerance);
+	double Padding = FMathd::Max(ExtendBounds, 0.0) + CellSize;
+	FVector3d GridOrigin = Bounds.Min - FVector3d(Padding, Padding, Padding);
+	FVector3i BlockDims, NumCells;
+	for (int32 j = 0; j < 3; ++j)
+	{
+		int32 AxisCells = (int32)FMathd::Ceil((Bounds.Max[j] - Bounds.Min[j] + 2.0 * Padding) / CellSize);
+		BlockDims[j] = FMath::Max((AxisCells + BlockSize - 1) / BlockSize, 1);
+		NumCells[j] = BlockDims[j] * BlockSize;
+	}
+	int32 NumBlocks = BlockDims.X * BlockDims.Y * BlockDims.Z;
+	double BlockWidth = BlockSize * CellSize;
+	auto GetBlockIndex = [&BlockDims](int32 bi, int32 bj, int32 bk) { return bi + BlockDims.X * (bj + BlockDims.Y * bk); };
+
+	// the winding field is zero on the outer layer of grid nodes, which closes the surface at the grid boundaries
+	TFunction<double(const FVector3d&)> WindingField = [&](const FVector3d& Pos)
+	{
+		FVector3d GridPoint = (Pos - GridOrigin) / CellSize;
+		if (GridPoint.X < 0.5 || GridPoint.Y < 0.5 || GridPoint.Z < 0.5
+			|| GridPoint.X > NumCells.X - 0.5 || GridPoint.Y > NumCells.Y - 0.5 || GridPoint.Z > NumCells.Z - 0.5)
+		{
+			return 0.0;
+		}
+		return FastWinding.FastWindingNumber(Pos);
+	};
+
+	// the first wave is the blocks that contain triangles. Blocks are marked for every triangle whose
+	// (slightly expanded) bounds touch them, so triangles on a block face seed both blocks.
+	TArray<uint8> BlockQueued;
+	BlockQueued.Init(0, NumBlocks);
+	TArray<int32> Wave;
+	for (int32 tid : Mesh.TriangleIndicesItr())
+	{
+		FAxisAlignedBox3d TriBounds = Mesh.GetTriBounds(tid);
+		FVector3i MinBlock, MaxBlock;
+		for (int32 j = 0; j < 3; ++j)
+		{
+			MinBlock[j] = FMath::Clamp((int32)FMathd::Floor((TriBounds.Min[j] - GridOrigin[j]) / BlockWidth - GridTolerance), 0, BlockDims[j] - 1);
+			MaxBlock[j] = FMath::Clamp((int32)FMathd::Floor((TriBounds.Max[j] - GridOrigin[j]) / BlockWidth + GridTolerance), 0, BlockDims[j] - 1);
+		}
+		for (int32 bk = MinBlock.Z; bk <= MaxBlock.Z; ++bk)
+		{
+			for (int32 bj = MinBlock.Y; bj <= MaxBlock.Y; ++bj)
+			{
+				for (int32 bi = MinBlock.X; bi <= MaxBlock.X; ++bi)
+				{
+					int32 BlockIndex = GetBlockIndex(bi, bj, bk);
+					if (BlockQueued[BlockIndex] == 0)
+					{
+						BlockQueued[BlockIndex] = 1;
+						Wave.Add(BlockIndex);
+					}
+				}
+			}
+		}
+	}
+
+	// March each wave of blocks in parallel. The next wave is the unvisited neighbours across the faces that the surface touched.
+	TArray<FBlockSurface> Surfaces;
+	while (Wave.Num() > 0)
+	{
+		Wave.Sort();
+		TArray<FBlockSurface> WaveSurfaces;
+		WaveSurfaces.SetNum(Wave.Num());
+		ParallelFor(Wave.Num(), [&](int32 WaveIndex)
+		{
+			FBlockSurface& Surface = WaveSurfaces[WaveIndex];
+			Surface.BlockIndex = Wave[WaveIndex];
+			FVector3i BlockCoords(Surface.BlockIndex % BlockDims.X, (Surface.BlockIndex / BlockDims.X) % BlockDims.Y, Surface.BlockIndex / (BlockDims.X * BlockDims.Y));
+			FVector3i FirstCell = BlockCoords * BlockSize;
+			FVector3d BlockMin = GridOrigin + CellSize * FVector3d(FirstCell.X, FirstCell.Y, FirstCell.Z);
+
+			// FMarchingCubes adds a cell beyond Bounds.Max, so stop half a cell short of the far faces to march exactly BlockSize^3 cells
+			FMarchingCubes MarchingCubes;
+			MarchingCubes.Implicit = WindingField;
+			MarchingCubes.IsoValue = WindingThreshold;
+			MarchingCubes.Bounds = FAxisAlignedBox3d(BlockMin, BlockMin + ((double)BlockSize - 0.5) * CellSize * FVector3d::One());
+			MarchingCubes.CubeSize = CellSize;
+			MarchingCubes.bParallelCompute = false;
+			MarchingCubes.RootMode = ERootfindingModes::Bisection;
+			MarchingCubes.RootModeSteps = SurfaceSearchSteps;
+			MarchingCubes.Generate();
+			if (MarchingCubes.Triangles.Num() == 0)
+			{
+				return;
+			}
+
+			Surface.Vertices = MoveTemp(MarchingCubes.Vertices);
+			Surface.Triangles = MoveTemp(MarchingCubes.Triangles);
+			Surface.SeamKeys.Init(InvalidSeamKey, Surface.Vertices.Num());
+			for (int32 vi = 0; vi < Surface.Vertices.Num(); ++vi)
+			{
+				FVector3d GridPoint = (Surface.Vertices[vi] - GridOrigin) / CellSize;
+				uint8 VertexFaces = 0;
+				for (int32 j = 0; j < 3; ++j)
+				{
+					double LocalCoord = GridPoint[j] - (double)FirstCell[j];
+					VertexFaces |= (LocalCoord < GridTolerance) ? (1 << (2 * j)) : 0;
+					VertexFaces |= (LocalCoord > (double)BlockSize - GridTolerance) ? (1 << (2 * j + 1)) : 0;
+				}
+				if (VertexFaces != 0)
+				{
+					Surface.SeamKeys[vi] = GetSeamKey(GridPoint);
+					Surface.CrossedFaces |= VertexFaces;
+				}
+			}
+		});
+
+		TArray<int32> NextWave;
+		for (FBlockSurface& Surface : WaveSurfaces)
+		{
+			if (Surface.Triangles.Num() == 0)
+			{
+				continue;
+			}
+			FVector3i BlockCoords(Surface.BlockIndex % BlockDims.X, (Surface.BlockIndex / BlockDims.X) % BlockDims.Y, Surface.BlockIndex / (BlockDims.X * BlockDims.Y));
+			for (int32 Face = 0; Face < 6; ++Face)
+			{
+				if ((Surface.CrossedFaces & (1 << Face)) == 0)
+				{
+					continue;
+				}
+				FVector3i Neighbour = BlockCoords;
+				Neighbour[Face / 2] += (Face % 2 == 0) ? -1 : 1;
+				if (Neighbour[Face / 2] < 0 || Neighbour[Face / 2] >= BlockDims[Face / 2])
+				{
+					continue;
+				}
+				int32 NeighbourIndex = GetBlockIndex(Neighbour.X, Neighbour.Y, Neighbour.Z);
+				if (BlockQueued[NeighbourIndex] == 0)
+				{
+					BlockQueued[NeighbourIndex] = 1;
+					NextWave.Add(NeighbourIndex);
+				}
+			}
+			Surfaces.Add(MoveTemp(Surface));
+		}
+		Wave = MoveTemp(NextWave);
+	}
+
+	// combine the block surfaces, welding the vertices on shared block faces
+	Surfaces.Sort([](const FBlockSurface& A, const FBlockSurface& B) { return A.BlockIndex < B.BlockIndex; });
+	TMap<uint64, int32> SeamVertices;
+	TArray<int32> VertexMap;
+	for (const FBlockSurface& Surface : Surfaces)
+	{
+		VertexMap.SetNum(Surface.Vertices.Num(), false);
+		for (int32 vi = 0; vi < Surface.Vertices.Num(); ++vi)
+		{
+			if (Surface.SeamKeys[vi] == InvalidSeamKey)
+			{
+				VertexMap[vi] = ResultOut.AppendVertex(Surface.Vertices[vi]);
+				continue;
+			}
+			int32* Found = SeamVertices.Find(Surface.SeamKeys[vi]);
+			VertexMap[vi] = (Found != nullptr) ? *Found : SeamVertices.Add(Surface.SeamKeys[vi], ResultOut.AppendVertex(Surface.Vertices[vi]));
+		}
+		for (const FIndex3i& Triangle : Surface.Triangles)
+		{
+			FIndex3i MappedTriangle(VertexMap[Triangle.A], VertexMap[Triangle.B], VertexMap[Triangle.C]);
+			if (MappedTriangle.A != MappedTriangle.B && MappedTriangle.B != MappedTriangle.C && MappedTriangle.C != MappedTriangle.A)
+			{
+				ResultOut.AppendTriangle(MappedTriangle);
+			}
+		}
+	}
+}
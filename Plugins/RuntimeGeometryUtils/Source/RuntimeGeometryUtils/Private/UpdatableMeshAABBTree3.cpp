@@ -0,0 +1,1286 @@
+#include "UpdatableMeshAABBTree3.h"
+#include "Async/ParallelFor.h"
+#include "Intersection/IntrTriangle3Triangle3.h"
+
+
+namespace UpdatableMeshAABBTreeLocals
+{
+	/** Number of rays processed by one SIMD register */
+	static const int32 RayGroupSize = 4;
+
+	/** A group of 4 rays in SIMD registers, one register per coordinate */
+	struct FRayGroup
+	{
+		VectorRegister Origin[3];
+		VectorRegister Direction[3];
+		VectorRegister InvDirection[3];
+		/** per-ray maximum hit distance, reduced to the nearest hit so far if only the nearest hits are found */
+		VectorRegister TMax;
+		/** all bits set for the lanes that hold a ray */
+		VectorRegister Active;
+	};
+
+	/** @return mask of the rays in Group that intersect the box (BoxMin, BoxMax) within their TMax */
+	static FORCEINLINE VectorRegister IntersectBox(const FRayGroup& Group, const VectorRegister BoxMin[3], const VectorRegister BoxMax[3])
+	{
+		VectorRegister TNear = VectorZero();
+		VectorRegister TFar = Group.TMax;
+		for (int32 j = 0; j < 3; ++j)
+		{
+			VectorRegister T1 = VectorMultiply(VectorSubtract(BoxMin[j], Group.Origin[j]), Group.InvDirection[j]);
+			VectorRegister T2 = VectorMultiply(VectorSubtract(BoxMax[j], Group.Origin[j]), Group.InvDirection[j]);
+			TNear = VectorMax(TNear, VectorMin(T1, T2));
+			TFar = VectorMin(TFar, VectorMax(T1, T2));
+		}
+		return VectorBitwiseAnd(VectorCompareLE(TNear, TFar), Group.Active);
+	}
+
+	/** 
+	 * Moller-Trumbore intersection of the rays in Group with the triangle (V0,V1,V2), both sides of the triangle are hit.
+	 * @return mask of the rays that hit the triangle within their TMax. TOut, UOut and VOut are the distances and barycentric coordinates of V1 and V2.
+	 */
+	static FORCEINLINE VectorRegister IntersectTriangle(const FRayGroup& Group, const FVector3f& V0, const FVector3f& V1, const FVector3f& V2, 
+		VectorRegister& TOut, VectorRegister& UOut, VectorRegister& VOut)
+	{
+		const VectorRegister Epsilon = VectorSetFloat1(FMathf::ZeroTolerance);
+		FVector3f Edge1 = V1 - V0, Edge2 = V2 - V0;
+		// determinant is scaled by the triangle size, so the parallel-ray threshold is as well
+		const VectorRegister DetTolerance = VectorSetFloat1(FMathf::ZeroTolerance * Edge1.Length() * Edge2.Length());
+		const VectorRegister E1[3] = { VectorSetFloat1(Edge1.X), VectorSetFloat1(Edge1.Y), VectorSetFloat1(Edge1.Z) };
+		const VectorRegister E2[3] = { VectorSetFloat1(Edge2.X), VectorSetFloat1(Edge2.Y), VectorSetFloat1(Edge2.Z) };
+		const VectorRegister* D = Group.Direction;
+
+		// P = D x E2, Det = E1.P
+		VectorRegister P[3];
+		P[0] = VectorSubtract(VectorMultiply(D[1], E2[2]), VectorMultiply(D[2], E2[1]));
+		P[1] = VectorSubtract(VectorMultiply(D[2], E2[0]), VectorMultiply(D[0], E2[2]));
+		P[2] = VectorSubtract(VectorMultiply(D[0], E2[1]), VectorMultiply(D[1], E2[0]));
+		VectorRegister Det = VectorMultiplyAdd(E1[0], P[0], VectorMultiplyAdd(E1[1], P[1], VectorMultiply(E1[2], P[2])));
+		VectorRegister InvDet = VectorDivide(VectorOne(), Det);
+
+		// S = O - V0, U = S.P / Det
+		VectorRegister S[3];
+		S[0] = VectorSubtract(Group.Origin[0], VectorSetFloat1(V0.X));
+		S[1] = VectorSubtract(Group.Origin[1], VectorSetFloat1(V0.Y));
+		S[2] = VectorSubtract(Group.Origin[2], VectorSetFloat1(V0.Z));
+		UOut = VectorMultiply(VectorMultiplyAdd(S[0], P[0], VectorMultiplyAdd(S[1], P[1], VectorMultiply(S[2], P[2]))), InvDet);
+
+		// Q = S x E1, V = D.Q / Det, T = E2.Q / Det
+		VectorRegister Q[3];
+		Q[0] = VectorSubtract(VectorMultiply(S[1], E1[2]), VectorMultiply(S[2], E1[1]));
+		Q[1] = VectorSubtract(VectorMultiply(S[2], E1[0]), VectorMultiply(S[0], E1[2]));
+		Q[2] = VectorSubtract(VectorMultiply(S[0], E1[1]), VectorMultiply(S[1], E1[0]));
+		VOut = VectorMultiply(VectorMultiplyAdd(D[0], Q[0], VectorMultiplyAdd(D[1], Q[1], VectorMultiply(D[2], Q[2]))), InvDet);
+		TOut = VectorMultiply(VectorMultiplyAdd(E2[0], Q[0], VectorMultiplyAdd(E2[1], Q[1], VectorMultiply(E2[2], Q[2]))), InvDet);
+
+		VectorRegister Mask = VectorBitwiseAnd(Group.Active, VectorCompareGT(VectorAbs(Det), DetTolerance));
+		Mask = VectorBitwiseAnd(Mask, VectorCompareGE(UOut, VectorNegate(Epsilon)));
+		Mask = VectorBitwiseAnd(Mask, VectorCompareGE(VOut, VectorNegate(Epsilon)));
+		Mask = VectorBitwiseAnd(Mask, VectorCompareLE(VectorAdd(UOut, VOut), VectorAdd(VectorOne(), Epsilon)));
+		Mask = VectorBitwiseAnd(Mask, VectorCompareGE(TOut, VectorZero()));
+		Mask = VectorBitwiseAnd(Mask, VectorCompareLE(TOut, Group.TMax));
+		return Mask;
+	}
+
+	/** Binned SAH split of the triangle ranges of FUpdatableMeshAABBTree3::BuildParallelSAH() */
+	struct FSAHBuilder
+	{
+		static constexpr int32 NumBins = 16;
+		static constexpr int32 LeafMaxTriCount = 4;
+		/** ranges with more triangles than this are binned in parallel chunks */
+		static constexpr int32 ParallelChunkSize = 16384;
+
+		/** a range [Start, End) of Order, and the bounds of its triangles */
+		struct FRange
+		{
+			int32 Start = 0;
+			int32 End = 0;
+			FAxisAlignedBox3d Box;
+		};
+
+		struct FBin
+		{
+			FAxisAlignedBox3d Box = FAxisAlignedBox3d::Empty();
+			int32 Count = 0;
+		};
+
+		struct FBinSet
+		{
+			FBin Bins[3][NumBins];
+
+			void Merge(const FBinSet& Other)
+			{
+				for (int32 Axis = 0; Axis < 3; ++Axis)
+				{
+					for (int32 b = 0; b < NumBins; ++b)
+					{
+						Bins[Axis][b].Box.Contain(Other.Bins[Axis][b].Box);
+						Bins[Axis][b].Count += Other.Bins[Axis][b].Count;
+					}
+				}
+			}
+		};
+
+		/** bounds and bounds-centers of the triangles, indexed by compact triangle index */
+		TArray<FAxisAlignedBox3d> Bounds;
+		TArray<FVector3d> Centers;
+		/** compact triangle indices, reordered by the splits so that each node is a contiguous range */
+		TArray<int32> Order;
+
+		static double HalfArea(const FAxisAlignedBox3d& Box)
+		{
+			FVector3d Size = Box.Max - Box.Min;
+			return Size.X * Size.Y + Size.Y * Size.Z + Size.Z * Size.X;
+		}
+
+		/** call ChunkFunc(ChunkIndex, ChunkStart, ChunkEnd) for chunks of [Start, End), in parallel if bParallel is true */
+		template<typename ChunkFuncType>
+		static int32 ForEachChunk(int32 Start, int32 End, bool bParallel, ChunkFuncType ChunkFunc)
+		{
+			int32 NumChunks = (bParallel) ? FMath::Max(1, (End - Start + ParallelChunkSize - 1) / ParallelChunkSize) : 1;
+			int32 ChunkSize = (End - Start + NumChunks - 1) / NumChunks;
+			ParallelFor(NumChunks, [&](int32 Chunk)
+			{
+				int32 ChunkStart = Start + Chunk * ChunkSize;
+				ChunkFunc(Chunk, ChunkStart, FMath::Min(ChunkStart + ChunkSize, End));
+			}, NumChunks == 1);
+			return NumChunks;
+		}
+
+		/** @return box of the triangle bounds-centers in Range */
+		FAxisAlignedBox3d GetCentersBox(const FRange& Range, bool bParallel) const
+		{
+			TArray<FAxisAlignedBox3d, TInlineAllocator<64>> ChunkBoxes;
+			ChunkBoxes.Init(FAxisAlignedBox3d::Empty(), (Range.End - Range.Start) / ParallelChunkSize + 2);
+			int32 NumChunks = ForEachChunk(Range.Start, Range.End, bParallel, [&](int32 Chunk, int32 ChunkStart, int32 ChunkEnd)
+			{
+				for (int32 k = ChunkStart; k < ChunkEnd; ++k)
+				{
+					ChunkBoxes[Chunk].Contain(Centers[Order[k]]);
+				}
+			});
+			for (int32 Chunk = 1; Chunk < NumChunks; ++Chunk)
+			{
+				ChunkBoxes[0].Contain(ChunkBoxes[Chunk]);
+			}
+			return ChunkBoxes[0];
+		}
+
+		/** 
+		 * Split Range into two child ranges, reordering its triangles. Range must contain more than LeafMaxTriCount triangles.
+		 * @param bParallel if true, large ranges are binned on multiple threads
+		 */
+		void Split(const FRange& Range, bool bParallel, FRange& LeftOut, FRange& RightOut)
+		{
+			FAxisAlignedBox3d CentersBox = GetCentersBox(Range, bParallel);
+			FVector3d CentersSize = CentersBox.Max - CentersBox.Min;
+			FVector3d BinScale;
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				BinScale[Axis] = (CentersSize[Axis] > FMathd::ZeroTolerance) ? ((double)NumBins / CentersSize[Axis]) : 0.0;
+			}
+			auto GetBin = [&CentersBox, &BinScale](const FVector3d& Center, int32 Axis)
+			{
+				return FMath::Clamp((int32)((Center[Axis] - CentersBox.Min[Axis]) * BinScale[Axis]), 0, NumBins - 1);
+			};
+
+			// bin the triangles along each axis
+			TArray<FBinSet, TInlineAllocator<4>> ChunkBins;
+			ChunkBins.SetNum((Range.End - Range.Start) / ParallelChunkSize + 2);
+			int32 NumChunks = ForEachChunk(Range.Start, Range.End, bParallel, [&](int32 Chunk, int32 ChunkStart, int32 ChunkEnd)
+			{
+				FBinSet& Bins = ChunkBins[Chunk];
+				for (int32 k = ChunkStart; k < ChunkEnd; ++k)
+				{
+					int32 Tri = Order[k];
+					for (int32 Axis = 0; Axis < 3; ++Axis)
+					{
+						FBin& Bin = Bins.Bins[Axis][GetBin(Centers[Tri], Axis)];
+						Bin.Box.Contain(Bounds[Tri]);
+						Bin.Count++;
+					}
+				}
+			});
+			for (int32 Chunk = 1; Chunk < NumChunks; ++Chunk)
+			{
+				ChunkBins[0].Merge(ChunkBins[Chunk]);
+			}
+			const FBinSet& Bins = ChunkBins[0];
+
+			// find the split plane between two bins with the lowest cost, ie sum of child (area * triangle count)
+			int32 BestAxis = -1, BestSplit = 0;
+			double BestCost = TNumericLimits<double>::Max();
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				if (BinScale[Axis] == 0)
+				{
+					continue;
+				}
+				double RightCosts[NumBins];
+				FAxisAlignedBox3d RightBox = FAxisAlignedBox3d::Empty();
+				int32 RightCount = 0;
+				for (int32 b = NumBins - 1; b > 0; --b)
+				{
+					RightBox.Contain(Bins.Bins[Axis][b].Box);
+					RightCount += Bins.Bins[Axis][b].Count;
+					RightCosts[b] = (RightCount > 0) ? HalfArea(RightBox) * RightCount : -1.0;
+				}
+				FAxisAlignedBox3d LeftBox = FAxisAlignedBox3d::Empty();
+				int32 LeftCount = 0;
+				for (int32 b = 1; b < NumBins; ++b)
+				{
+					LeftBox.Contain(Bins.Bins[Axis][b - 1].Box);
+					LeftCount += Bins.Bins[Axis][b - 1].Count;
+					if (LeftCount > 0 && RightCosts[b] >= 0)
+					{
+						double Cost = HalfArea(LeftBox) * LeftCount + RightCosts[b];
+						if (Cost < BestCost)
+						{
+							BestCost = Cost;
+							BestAxis = Axis;
+							BestSplit = b;
+						}
+					}
+				}
+			}
+
+			int32 Mid;
+			if (BestAxis >= 0)
+			{
+				int32 Left = Range.Start, Right = Range.End - 1;
+				while (Left <= Right)
+				{
+					if (GetBin(Centers[Order[Left]], BestAxis) < BestSplit)
+					{
+						Left++;
+					}
+					else
+					{
+						Swap(Order[Left], Order[Right]);
+						Right--;
+					}
+				}
+				Mid = Left;
+			}
+			else
+			{
+				// all triangles have the same bounds-center, so any split is as good as another
+				Mid = (Range.Start + Range.End) / 2;
+			}
+
+			LeftOut.Start = Range.Start;
+			LeftOut.End = Mid;
+			RightOut.Start = Mid;
+			RightOut.End = Range.End;
+			if (BestAxis >= 0)
+			{
+				LeftOut.Box = FAxisAlignedBox3d::Empty();
+				RightOut.Box = FAxisAlignedBox3d::Empty();
+				for (int32 b = 0; b < NumBins; ++b)
+				{
+					((b < BestSplit) ? LeftOut.Box : RightOut.Box).Contain(Bins.Bins[BestAxis][b].Box);
+				}
+			}
+			else
+			{
+				LeftOut.Box = GetBounds(LeftOut);
+				RightOut.Box = GetBounds(RightOut);
+			}
+		}
+
+		FAxisAlignedBox3d GetBounds(const FRange& Range) const
+		{
+			FAxisAlignedBox3d Box = FAxisAlignedBox3d::Empty();
+			for (int32 k = Range.Start; k < Range.End; ++k)
+			{
+				Box.Contain(Bounds[Order[k]]);
+			}
+			return Box;
+		}
+	};
+
+	/** A node of a subtree built by FUpdatableMeshAABBTree3::BuildParallelSAH(). Children are indices into the subtree nodes, or -1 for a leaf. */
+	struct FSAHBuildNode
+	{
+		FAxisAlignedBox3d Box;
+		int32 Children[2] = { -1, -1 };
+		int32 Start = 0;
+		int32 Count = 0;
+	};
+
+	struct FSAHSubtree
+	{
+		FSAHBuilder::FRange Range;
+		TArray<FSAHBuildNode> Nodes;
+		int32 NumLeaves = 0;
+
+		/** Split Range down to leaves on this thread. Only the Range part of Builder.Order is reordered. */
+		void Build(FSAHBuilder& Builder)
+		{
+			TArray<TPair<int32, FSAHBuilder::FRange>, TInlineAllocator<64>> Stack;
+			Nodes.Reserve(2 * (Range.End - Range.Start) / FSAHBuilder::LeafMaxTriCount + 1);
+			Nodes.AddDefaulted();
+			Stack.Add(TPair<int32, FSAHBuilder::FRange>(0, Range));
+			while (Stack.Num() > 0)
+			{
+				TPair<int32, FSAHBuilder::FRange> Item = Stack.Pop(false);
+				const FSAHBuilder::FRange& ItemRange = Item.Value;
+				Nodes[Item.Key].Box = ItemRange.Box;
+				if (ItemRange.End - ItemRange.Start <= FSAHBuilder::LeafMaxTriCount)
+				{
+					Nodes[Item.Key].Start = ItemRange.Start;
+					Nodes[Item.Key].Count = ItemRange.End - ItemRange.Start;
+					NumLeaves++;
+					continue;
+				}
+				FSAHBuilder::FRange Ranges[2];
+				Builder.Split(ItemRange, false, Ranges[0], Ranges[1]);
+				for (int32 j = 0; j < 2; ++j)
+				{
+					int32 Child = Nodes.AddDefaulted();
+					Nodes[Item.Key].Children[j] = Child;
+					Stack.Add(TPair<int32, FSAHBuilder::FRange>(Child, Ranges[j]));
+				}
+			}
+		}
+	};
+
+	/** A node of the top levels of the tree. If Subtree >= 0 the node is the root of that subtree, otherwise Children are top-level node indices. */
+	struct FSAHTopNode
+	{
+		int32 Children[2] = { -1, -1 };
+		int32 Subtree = -1;
+		FAxisAlignedBox3d Box;
+	};
+}
+
+
+FUpdatableMeshAABBTree3::FUpdatableMeshAABBTree3(const FDynamicMesh3* SourceMesh, bool bAutoBuild)
+{
+	SetMesh(SourceMesh, bAutoBuild);
+}
+
+
+void FUpdatableMeshAABBTree3::SetMesh(const FDynamicMesh3* SourceMesh, bool bAutoBuild)
+{
+	FDynamicMeshAABBTree3::SetMesh(SourceMesh, false);
+	bBuiltForMesh = false;
+	if (bAutoBuild)
+	{
+		Build();
+	}
+}
+
+
+void FUpdatableMeshAABBTree3::Build()
+{
+	if (bParallelSAHBuild)
+	{
+		BuildParallelSAH(&LastBuildTimings);
+		UE_LOG(LogTemp, Verbose, TEXT("FUpdatableMeshAABBTree3: built %d boxes for %d triangles in %.2fms (setup %.2fms, top levels %.2fms, %d subtrees %.2fms, flatten %.2fms)"),
+			LastBuildTimings.NumBoxes, LastBuildTimings.NumTriangles, LastBuildTimings.TotalTime * 1000.0, LastBuildTimings.SetupTime * 1000.0,
+			LastBuildTimings.TopLevelTime * 1000.0, LastBuildTimings.NumSubtrees, LastBuildTimings.SubtreesTime * 1000.0, LastBuildTimings.FlattenTime * 1000.0);
+	}
+	else
+	{
+		FDynamicMeshAABBTree3::Build();
+	}
+	BuiltTopologyTimestamp = Mesh->GetTopologyTimestamp();
+	bBuiltForMesh = true;
+	bHaveRegionMaps = false;
+	NumRegionUpdateTriangles = 0;
+}
+
+
+void FUpdatableMeshAABBTree3::BuildParallelSAH(FMeshAABBTreeBuildTimings* TimingsOut)
+{
+	using namespace UpdatableMeshAABBTreeLocals;
+
+	FMeshAABBTreeBuildTimings Timings;
+	double StartTime = FPlatformTime::Seconds();
+	double PhaseStartTime = StartTime;
+	auto EndPhase = [&PhaseStartTime]()
+	{
+		double Now = FPlatformTime::Seconds();
+		double Elapsed = Now - PhaseStartTime;
+		PhaseStartTime = Now;
+		return Elapsed;
+	};
+
+	const int32 NumTriangles = Mesh->TriangleCount();
+	if (NumTriangles == 0)
+	{
+		FDynamicMeshAABBTree3::Build();
+		if (TimingsOut)
+		{
+			*TimingsOut = Timings;
+		}
+		return;
+	}
+
+	// compute triangle bounds
+	TArray<int32> TriangleIDs;
+	TriangleIDs.Reserve(NumTriangles);
+	for (int32 tid : Mesh->TriangleIndicesItr())
+	{
+		TriangleIDs.Add(tid);
+	}
+	FSAHBuilder Builder;
+	Builder.Bounds.SetNum(NumTriangles);
+	Builder.Centers.SetNum(NumTriangles);
+	Builder.Order.SetNum(NumTriangles);
+	ParallelFor(NumTriangles, [&](int32 k)
+	{
+		Builder.Bounds[k] = Mesh->GetTriBounds(TriangleIDs[k]);
+		Builder.Centers[k] = Builder.Bounds[k].Center();
+		Builder.Order[k] = k;
+	});
+	FSAHBuilder::FRange RootRange;
+	RootRange.Start = 0;
+	RootRange.End = NumTriangles;
+	{
+		TArray<FAxisAlignedBox3d> ChunkBoxes;
+		ChunkBoxes.Init(FAxisAlignedBox3d::Empty(), NumTriangles / FSAHBuilder::ParallelChunkSize + 2);
+		int32 NumChunks = FSAHBuilder::ForEachChunk(0, NumTriangles, true, [&](int32 Chunk, int32 ChunkStart, int32 ChunkEnd)
+		{
+			for (int32 k = ChunkStart; k < ChunkEnd; ++k)
+			{
+				ChunkBoxes[Chunk].Contain(Builder.Bounds[k]);
+			}
+		});
+		RootRange.Box = ChunkBoxes[0];
+		for (int32 Chunk = 1; Chunk < NumChunks; ++Chunk)
+		{
+			RootRange.Box.Contain(ChunkBoxes[Chunk]);
+		}
+	}
+	Timings.SetupTime = EndPhase();
+
+	// split the top levels on this thread, until the ranges are small enough that there are several per worker thread
+	const int32 NumWorkers = FMath::Max(1, FTaskGraphInterface::Get().GetNumWorkerThreads());
+	const int32 SubtreeMaxTriCount = FMath::Max(2048, NumTriangles / (NumWorkers * 8));
+	TArray<FSAHTopNode> TopNodes;
+	TArray<FSAHSubtree> Subtrees;
+	TArray<TPair<int32, FSAHBuilder::FRange>> TopStack;
+	TopNodes.AddDefaulted();
+	TopStack.Add(TPair<int32, FSAHBuilder::FRange>(0, RootRange));
+	while (TopStack.Num() > 0)
+	{
+		TPair<int32, FSAHBuilder::FRange> Item = TopStack.Pop(false);
+		const FSAHBuilder::FRange& Range = Item.Value;
+		TopNodes[Item.Key].Box = Range.Box;
+		if (Range.End - Range.Start <= SubtreeMaxTriCount)
+		{
+			TopNodes[Item.Key].Subtree = Subtrees.Num();
+			Subtrees.AddDefaulted_GetRef().Range = Range;
+			continue;
+		}
+		FSAHBuilder::FRange Ranges[2];
+		Builder.Split(Range, true, Ranges[0], Ranges[1]);
+		for (int32 j = 0; j < 2; ++j)
+		{
+			int32 Child = TopNodes.AddDefaulted();
+			TopNodes[Item.Key].Children[j] = Child;
+			TopStack.Add(TPair<int32, FSAHBuilder::FRange>(Child, Ranges[j]));
+		}
+	}
+	Timings.TopLevelTime = EndPhase();
+
+	// build the subtrees in parallel. Each subtree reorders only its own range of Builder.Order.
+	ParallelFor(Subtrees.Num(), [&](int32 SubtreeIndex)
+	{
+		Subtrees[SubtreeIndex].Build(Builder);
+	});
+	Timings.SubtreesTime = EndPhase();
+
+	// Convert to the base-class representation. Leaf boxes are [N, tri1, ..., triN] at the start of IndexList (before TrianglesEnd),
+	// followed by the internal boxes [child1+1, child2+1]. The top-level internal nodes come first in both the box and internal index ranges.
+	TArray<int32> TopBoxIndex;
+	TopBoxIndex.Init(-1, TopNodes.Num());
+	int32 NumTopBoxes = 0;
+	for (int32 k = 0; k < TopNodes.Num(); ++k)
+	{
+		if (TopNodes[k].Subtree < 0)
+		{
+			TopBoxIndex[k] = NumTopBoxes++;
+		}
+	}
+	TArray<int32> SubtreeBoxStart, SubtreeLeafIndexStart, SubtreeInternalIndexStart;
+	SubtreeBoxStart.SetNum(Subtrees.Num());
+	SubtreeLeafIndexStart.SetNum(Subtrees.Num());
+	SubtreeInternalIndexStart.SetNum(Subtrees.Num());
+	int32 NumBoxes = NumTopBoxes, NumLeafIndices = 0, NumInternalIndices = 2 * NumTopBoxes;
+	for (int32 k = 0; k < Subtrees.Num(); ++k)
+	{
+		const FSAHSubtree& Subtree = Subtrees[k];
+		SubtreeBoxStart[k] = NumBoxes;
+		SubtreeLeafIndexStart[k] = NumLeafIndices;
+		SubtreeInternalIndexStart[k] = NumInternalIndices;
+		NumBoxes += Subtree.Nodes.Num();
+		NumLeafIndices += Subtree.NumLeaves + (Subtree.Range.End - Subtree.Range.Start);
+		NumInternalIndices += 2 * (Subtree.Nodes.Num() - Subtree.NumLeaves);
+	}
+	auto GetTopBoxIndex = [&](int32 TopNode)
+	{
+		return (TopNodes[TopNode].Subtree >= 0) ? SubtreeBoxStart[TopNodes[TopNode].Subtree] : TopBoxIndex[TopNode];
+	};
+
+	BoxToIndex.Clear();
+	BoxToIndex.Resize(NumBoxes);
+	BoxCenters.Clear();
+	BoxCenters.Resize(NumBoxes);
+	BoxExtents.Clear();
+	BoxExtents.Resize(NumBoxes);
+	IndexList.Clear();
+	IndexList.Resize(NumLeafIndices + NumInternalIndices);
+	TrianglesEnd = NumLeafIndices;
+
+	for (int32 k = 0; k < TopNodes.Num(); ++k)
+	{
+		const FSAHTopNode& Node = TopNodes[k];
+		if (Node.Subtree < 0)
+		{
+			int32 iBox = TopBoxIndex[k];
+			int32 iStart = TrianglesEnd + 2 * iBox;
+			BoxToIndex[iBox] = iStart;
+			BoxCenters[iBox] = Node.Box.Center();
+			BoxExtents[iBox] = Node.Box.Extents();
+			IndexList[iStart] = GetTopBoxIndex(Node.Children[0]) + 1;
+			IndexList[iStart + 1] = GetTopBoxIndex(Node.Children[1]) + 1;
+		}
+	}
+	ParallelFor(Subtrees.Num(), [&](int32 SubtreeIndex)
+	{
+		const FSAHSubtree& Subtree = Subtrees[SubtreeIndex];
+		int32 BoxStart = SubtreeBoxStart[SubtreeIndex];
+		int32 LeafIndex = SubtreeLeafIndexStart[SubtreeIndex];
+		int32 InternalIndex = TrianglesEnd + SubtreeInternalIndexStart[SubtreeIndex];
+		for (int32 k = 0; k < Subtree.Nodes.Num(); ++k)
+		{
+			const FSAHBuildNode& Node = Subtree.Nodes[k];
+			int32 iBox = BoxStart + k;
+			BoxCenters[iBox] = Node.Box.Center();
+			BoxExtents[iBox] = Node.Box.Extents();
+			if (Node.Children[0] < 0)
+			{
+				BoxToIndex[iBox] = LeafIndex;
+				IndexList[LeafIndex++] = Node.Count;
+				for (int32 j = 0; j < Node.Count; ++j)
+				{
+					IndexList[LeafIndex++] = TriangleIDs[Builder.Order[Node.Start + j]];
+				}
+			}
+			else
+			{
+				BoxToIndex[iBox] = InternalIndex;
+				IndexList[InternalIndex++] = BoxStart + Node.Children[0] + 1;
+				IndexList[InternalIndex++] = BoxStart + Node.Children[1] + 1;
+			}
+		}
+	});
+	RootIndex = GetTopBoxIndex(0);
+	MeshTimestamp = Mesh->GetShapeTimestamp();
+	Timings.FlattenTime = EndPhase();
+
+	Timings.NumTriangles = NumTriangles;
+	Timings.NumBoxes = NumBoxes;
+	Timings.NumSubtrees = Subtrees.Num();
+	Timings.TotalTime = FPlatformTime::Seconds() - StartTime;
+	if (TimingsOut)
+	{
+		*TimingsOut = Timings;
+	}
+}
+
+
+bool FUpdatableMeshAABBTree3::CanRefit() const
+{
+	return bBuiltForMesh && RootIndex >= 0 && BuiltTopologyTimestamp == Mesh->GetTopologyTimestamp();
+}
+
+
+void FUpdatableMeshAABBTree3::Refit()
+{
+	check(CanRefit());
+
+	// collect the boxes level-by-level from the root, so that processing the levels in reverse
+	// order visits all children before their parents. Boxes within a level are independent.
+	TArray<int32> Boxes;
+	TArray<int32> LevelStarts;
+	Boxes.Add(RootIndex);
+	int32 LevelStart = 0;
+	while (LevelStart < Boxes.Num())
+	{
+		LevelStarts.Add(LevelStart);
+		int32 LevelEnd = Boxes.Num();
+		for (int32 k = LevelStart; k < LevelEnd; ++k)
+		{
+			int32 iStart = BoxToIndex[Boxes[k]];
+			if (iStart >= TrianglesEnd)
+			{
+				// internal box, either [-(child+1)] for a single child or [child1+1, child2+1]
+				int32 iChild1 = IndexList[iStart];
+				if (iChild1 < 0)
+				{
+					Boxes.Add((-iChild1) - 1);
+				}
+				else
+				{
+					Boxes.Add(iChild1 - 1);
+					Boxes.Add(IndexList[iStart + 1] - 1);
+				}
+			}
+		}
+		LevelStart = LevelEnd;
+	}
+	LevelStarts.Add(Boxes.Num());
+
+	for (int32 Level = LevelStarts.Num() - 2; Level >= 0; --Level)
+	{
+		int32 Start = LevelStarts[Level];
+		ParallelFor(LevelStarts[Level + 1] - Start, [&](int32 k)
+		{
+			int32 iBox = Boxes[Start + k];
+			FAxisAlignedBox3d Box = ComputeNodeBox(iBox);
+			BoxCenters[iBox] = Box.Center();
+			BoxExtents[iBox] = Box.Extents();
+		});
+	}
+
+	MeshTimestamp = Mesh->GetShapeTimestamp();
+}
+
+
+FAxisAlignedBox3d FUpdatableMeshAABBTree3::GetNodeBox(int32 iBox) const
+{
+	return FAxisAlignedBox3d(BoxCenters[iBox] - BoxExtents[iBox], BoxCenters[iBox] + BoxExtents[iBox]);
+}
+
+
+FAxisAlignedBox3d FUpdatableMeshAABBTree3::ComputeNodeBox(int32 iBox) const
+{
+	int32 iStart = BoxToIndex[iBox];
+	FAxisAlignedBox3d Box = FAxisAlignedBox3d::Empty();
+	if (iStart < TrianglesEnd)
+	{
+		// leaf box, [N, tri1, ..., triN]
+		int32 NumTris = IndexList[iStart];
+		if (NumTris == 0)
+		{
+			// a leaf emptied by UpdateRegion() shrinks to its center, an empty box would not be rejected by all queries
+			return FAxisAlignedBox3d(BoxCenters[iBox], BoxCenters[iBox]);
+		}
+		for (int32 j = 1; j <= NumTris; ++j)
+		{
+			Box.Contain(Mesh->GetTriBounds(IndexList[iStart + j]));
+		}
+	}
+	else
+	{
+		int32 iChild1 = IndexList[iStart];
+		if (iChild1 < 0)
+		{
+			Box = GetNodeBox((-iChild1) - 1);
+		}
+		else
+		{
+			Box = GetNodeBox(iChild1 - 1);
+			Box.Contain(GetNodeBox(IndexList[iStart + 1] - 1));
+		}
+	}
+	return Box;
+}
+
+
+bool FUpdatableMeshAABBTree3::Update()
+{
+	if (bBuiltForMesh && IsValid(false))
+	{
+		return false;
+	}
+	if (CanRefit())
+	{
+		Refit();
+	}
+	else
+	{
+		Build();
+	}
+	return true;
+}
+
+
+bool FUpdatableMeshAABBTree3::IsUpToDate() const
+{
+	return bBuiltForMesh && IsValid(false);
+}
+
+
+void FUpdatableMeshAABBTree3::BuildRegionMaps()
+{
+	TriangleLeafBoxes.Init(-1, Mesh->MaxTriangleID());
+	BoxParents.Init(-1, (int32)BoxToIndex.Num());
+
+	TArray<int32> Stack;
+	Stack.Add(RootIndex);
+	while (Stack.Num() > 0)
+	{
+		int32 iBox = Stack.Pop(false);
+		int32 iStart = BoxToIndex[iBox];
+		if (iStart < TrianglesEnd)
+		{
+			int32 NumTris = IndexList[iStart];
+			for (int32 j = 1; j <= NumTris; ++j)
+			{
+				TriangleLeafBoxes[IndexList[iStart + j]] = iBox;
+			}
+			continue;
+		}
+		int32 iChild1 = IndexList[iStart];
+		int32 Children[2] = { (iChild1 < 0) ? (-iChild1) - 1 : iChild1 - 1, (iChild1 < 0) ? -1 : IndexList[iStart + 1] - 1 };
+		for (int32 Child : Children)
+		{
+			if (Child >= 0)
+			{
+				BoxParents[Child] = iBox;
+				Stack.Add(Child);
+			}
+		}
+	}
+	bHaveRegionMaps = true;
+}
+
+
+void FUpdatableMeshAABBTree3::RefitToRoot(int32 iBox)
+{
+	while (iBox >= 0)
+	{
+		FAxisAlignedBox3d Box = ComputeNodeBox(iBox);
+		FVector3d Center = Box.Center(), Extents = Box.Extents();
+		if (Center == BoxCenters[iBox] && Extents == BoxExtents[iBox])
+		{
+			// the boxes above are unchanged, or are refit from another changed box
+			return;
+		}
+		BoxCenters[iBox] = Center;
+		BoxExtents[iBox] = Extents;
+		iBox = BoxParents[iBox];
+	}
+}
+
+
+void FUpdatableMeshAABBTree3::UpdateRegion(const TArray<int32>& RemovedTriangles, const TArray<int32>& AddedTriangles)
+{
+	using namespace UpdatableMeshAABBTreeLocals;
+
+	// each update makes the tree less efficient to query, so it is rebuilt once the updates are a significant part of the mesh
+	NumRegionUpdateTriangles += AddedTriangles.Num();
+	if (bBuiltForMesh == false || RootIndex < 0 || (double)NumRegionUpdateTriangles > MaxRegionUpdateFraction * (double)Mesh->TriangleCount())
+	{
+		Build();
+		return;
+	}
+	if (bHaveRegionMaps == false)
+	{
+		BuildRegionMaps();
+	}
+
+	// take the removed triangles out of their leaves. The removed IDs may have been reused for added triangles.
+	TSet<int32> ChangedLeaves;
+	for (int32 tid : RemovedTriangles)
+	{
+		int32 iBox = (TriangleLeafBoxes.IsValidIndex(tid)) ? TriangleLeafBoxes[tid] : -1;
+		if (iBox < 0)
+		{
+			continue;
+		}
+		TriangleLeafBoxes[tid] = -1;
+		int32 iStart = BoxToIndex[iBox];
+		int32 NumTris = IndexList[iStart];
+		for (int32 j = 1; j <= NumTris; ++j)
+		{
+			if (IndexList[iStart + j] == tid)
+			{
+				IndexList[iStart + j] = IndexList[iStart + NumTris];
+				IndexList[iStart] = NumTris - 1;
+				break;
+			}
+		}
+		ChangedLeaves.Add(iBox);
+	}
+
+	// the vertices shared by the added triangles and the rest of the mesh may have been moved slightly (eg by welding)
+	int32 OldMaxTriangleID = TriangleLeafBoxes.Num();
+	if (Mesh->MaxTriangleID() > OldMaxTriangleID)
+	{
+		TriangleLeafBoxes.SetNumUninitialized(Mesh->MaxTriangleID());
+		for (int32 tid = OldMaxTriangleID; tid < TriangleLeafBoxes.Num(); ++tid)
+		{
+			TriangleLeafBoxes[tid] = -1;
+		}
+	}
+	TArray<int32> NewTriangleIDs;
+	for (int32 tid : AddedTriangles)
+	{
+		if (Mesh->IsTriangle(tid) && TriangleLeafBoxes[tid] < 0)
+		{
+			NewTriangleIDs.Add(tid);
+		}
+	}
+	for (int32 tid : NewTriangleIDs)
+	{
+		FIndex3i TriV = Mesh->GetTriangle(tid);
+		for (int32 j = 0; j < 3; ++j)
+		{
+			for (int32 NbrTID : Mesh->VtxTrianglesItr(TriV[j]))
+			{
+				if (TriangleLeafBoxes[NbrTID] >= 0)
+				{
+					ChangedLeaves.Add(TriangleLeafBoxes[NbrTID]);
+				}
+			}
+		}
+	}
+	for (int32 iBox : ChangedLeaves)
+	{
+		RefitToRoot(iBox);
+	}
+
+	if (NewTriangleIDs.Num() > 0)
+	{
+		// build a subtree for the added triangles
+		const int32 NumNewTriangles = NewTriangleIDs.Num();
+		FSAHBuilder Builder;
+		Builder.Bounds.SetNum(NumNewTriangles);
+		Builder.Centers.SetNum(NumNewTriangles);
+		Builder.Order.SetNum(NumNewTriangles);
+		FSAHSubtree Subtree;
+		Subtree.Range.End = NumNewTriangles;
+		Subtree.Range.Box = FAxisAlignedBox3d::Empty();
+		for (int32 k = 0; k < NumNewTriangles; ++k)
+		{
+			Builder.Bounds[k] = Mesh->GetTriBounds(NewTriangleIDs[k]);
+			Builder.Centers[k] = Builder.Bounds[k].Center();
+			Builder.Order[k] = k;
+			Subtree.Range.Box.Contain(Builder.Bounds[k]);
+		}
+		Subtree.Build(Builder);
+
+		// insert it below the smallest box that contains it, so the boxes above that are unchanged
+		int32 Target = RootIndex;
+		auto ContainsSubtree = [this, &Subtree](int32 iBox)
+		{
+			FAxisAlignedBox3d Box = GetNodeBox(iBox);
+			return Box.Contains(Subtree.Range.Box.Min) && Box.Contains(Subtree.Range.Box.Max);
+		};
+		if (ContainsSubtree(Target))
+		{
+			bool bDescended = true;
+			while (bDescended && BoxToIndex[Target] >= TrianglesEnd)
+			{
+				bDescended = false;
+				int32 iStart = BoxToIndex[Target];
+				int32 iChild1 = IndexList[iStart];
+				int32 Children[2] = { (iChild1 < 0) ? (-iChild1) - 1 : iChild1 - 1, (iChild1 < 0) ? -1 : IndexList[iStart + 1] - 1 };
+				for (int32 Child : Children)
+				{
+					if (Child >= 0 && ContainsSubtree(Child))
+					{
+						Target = Child;
+						bDescended = true;
+						break;
+					}
+				}
+			}
+		}
+
+		// Make room for the new leaves at the end of the leaf range, by moving the internal boxes up. The new internal boxes,
+		// and the box that joins the subtree to Target, go at the end of IndexList.
+		const int32 OldNumBoxes = (int32)BoxToIndex.Num();
+		const int32 OldNumIndices = (int32)IndexList.Num();
+		const int32 NumNewBoxes = Subtree.Nodes.Num() + 1;
+		const int32 NumNewLeafIndices = Subtree.NumLeaves + NumNewTriangles;
+		const int32 NumNewInternalIndices = 2 * (Subtree.Nodes.Num() - Subtree.NumLeaves) + 2;
+		IndexList.Resize(OldNumIndices + NumNewLeafIndices + NumNewInternalIndices);
+		for (int32 k = OldNumIndices - 1; k >= TrianglesEnd; --k)
+		{
+			IndexList[k + NumNewLeafIndices] = IndexList[k];
+		}
+		for (int32 iBox = 0; iBox < OldNumBoxes; ++iBox)
+		{
+			if (BoxToIndex[iBox] >= TrianglesEnd)
+			{
+				BoxToIndex[iBox] += NumNewLeafIndices;
+			}
+		}
+		BoxToIndex.Resize(OldNumBoxes + NumNewBoxes);
+		BoxCenters.Resize(OldNumBoxes + NumNewBoxes);
+		BoxExtents.Resize(OldNumBoxes + NumNewBoxes);
+		BoxParents.SetNum(OldNumBoxes + NumNewBoxes);
+
+		int32 LeafIndex = TrianglesEnd;
+		int32 InternalIndex = OldNumIndices + NumNewLeafIndices;
+		TrianglesEnd += NumNewLeafIndices;
+		for (int32 k = 0; k < Subtree.Nodes.Num(); ++k)
+		{
+			const FSAHBuildNode& Node = Subtree.Nodes[k];
+			int32 iBox = OldNumBoxes + k;
+			BoxCenters[iBox] = Node.Box.Center();
+			BoxExtents[iBox] = Node.Box.Extents();
+			if (Node.Children[0] < 0)
+			{
+				BoxToIndex[iBox] = LeafIndex;
+				IndexList[LeafIndex++] = Node.Count;
+				for (int32 j = 0; j < Node.Count; ++j)
+				{
+					int32 tid = NewTriangleIDs[Builder.Order[Node.Start + j]];
+					IndexList[LeafIndex++] = tid;
+					TriangleLeafBoxes[tid] = iBox;
+				}
+			}
+			else
+			{
+				BoxToIndex[iBox] = InternalIndex;
+				for (int32 j = 0; j < 2; ++j)
+				{
+					IndexList[InternalIndex++] = OldNumBoxes + Node.Children[j] + 1;
+					BoxParents[OldNumBoxes + Node.Children[j]] = iBox;
+				}
+			}
+		}
+
+		int32 SubtreeRoot = OldNumBoxes;
+		int32 JoinBox = OldNumBoxes + Subtree.Nodes.Num();
+		FAxisAlignedBox3d JoinBounds = GetNodeBox(Target);
+		JoinBounds.Contain(Subtree.Range.Box);
+		BoxCenters[JoinBox] = JoinBounds.Center();
+		BoxExtents[JoinBox] = JoinBounds.Extents();
+		BoxToIndex[JoinBox] = InternalIndex;
+		IndexList[InternalIndex++] = Target + 1;
+		IndexList[InternalIndex++] = SubtreeRoot + 1;
+
+		int32 Parent = BoxParents[Target];
+		if (Parent < 0)
+		{
+			RootIndex = JoinBox;
+		}
+		else
+		{
+			int32 iStart = BoxToIndex[Parent];
+			if (IndexList[iStart] == -(Target + 1))
+			{
+				IndexList[iStart] = -(JoinBox + 1);
+			}
+			else
+			{
+				int32 j = (IndexList[iStart] == Target + 1) ? 0 : 1;
+				IndexList[iStart + j] = JoinBox + 1;
+			}
+		}
+		BoxParents[JoinBox] = Parent;
+		BoxParents[Target] = JoinBox;
+		BoxParents[SubtreeRoot] = JoinBox;
+	}
+
+	MeshTimestamp = Mesh->GetShapeTimestamp();
+	BuiltTopologyTimestamp = Mesh->GetTopologyTimestamp();
+}
+
+
+void FUpdatableMeshAABBTree3::FindRayPacketHits(const FRay3d* Rays, int32 NumRays, double MaxDistance, bool bAllHits, TArray<FMeshRayPacketHit>* HitsOut) const
+{
+	using namespace UpdatableMeshAABBTreeLocals;
+	check(NumRays <= MaxPacketSize);
+
+	for (int32 k = 0; k < NumRays; ++k)
+	{
+		HitsOut[k].Reset();
+	}
+	if (NumRays <= 0 || RootIndex < 0)
+	{
+		return;
+	}
+
+	// set up the ray groups. Unused lanes of the last group get a valid dummy ray and are masked out.
+	const float RayTMax = (MaxDistance > 0) ? (float)MaxDistance : TNumericLimits<float>::Max();
+	const int32 NumGroups = (NumRays + RayGroupSize - 1) / RayGroupSize;
+	FRayGroup Groups[MaxPacketSize / RayGroupSize];
+	for (int32 g = 0; g < NumGroups; ++g)
+	{
+		float Values[10][RayGroupSize];
+		for (int32 Lane = 0; Lane < RayGroupSize; ++Lane)
+		{
+			int32 k = g * RayGroupSize + Lane;
+			bool bValid = k < NumRays;
+			FVector3d Origin = (bValid) ? Rays[k].Origin : FVector3d::Zero();
+			FVector3d Direction = (bValid) ? Rays[k].Direction : FVector3d::UnitZ();
+			for (int32 j = 0; j < 3; ++j)
+			{
+				Values[j][Lane] = (float)Origin[j];
+				Values[3 + j][Lane] = (float)Direction[j];
+				// avoid infinities, which would produce NaNs in the slab test for rays lying in a box plane
+				double InvDirection = (FMathd::Abs(Direction[j]) > FMathd::ZeroTolerance) ? (1.0 / Direction[j]) : FMathd::SignNonZero(Direction[j]) * 1e30;
+				Values[6 + j][Lane] = (float)InvDirection;
+			}
+			Values[9][Lane] = (bValid) ? 1.0f : 0.0f;
+		}
+		for (int32 j = 0; j < 3; ++j)
+		{
+			Groups[g].Origin[j] = VectorLoad(Values[j]);
+			Groups[g].Direction[j] = VectorLoad(Values[3 + j]);
+			Groups[g].InvDirection[j] = VectorLoad(Values[6 + j]);
+		}
+		Groups[g].TMax = VectorSetFloat1(RayTMax);
+		Groups[g].Active = VectorCompareGT(VectorLoad(Values[9]), VectorZero());
+	}
+
+	FMeshRayPacketHit NearestHits[MaxPacketSize];
+
+	TArray<int32, TInlineAllocator<64>> Stack;
+	Stack.Add(RootIndex);
+	while (Stack.Num() > 0)
+	{
+		int32 iBox = Stack.Pop(false);
+
+		// pad the box slightly, to account for converting to single precision
+		const FVector3d& Center = BoxCenters[iBox];
+		FVector3d Extents = BoxExtents[iBox];
+		double MaxCoord = FMathd::Max3(FMathd::Abs(Center.X), FMathd::Abs(Center.Y), FMathd::Abs(Center.Z));
+		MaxCoord += FMathd::Max3(Extents.X, Extents.Y, Extents.Z);
+		Extents += FVector3d::One() * (FMathf::ZeroTolerance * (MaxCoord + 1.0));
+		VectorRegister BoxMin[3], BoxMax[3];
+		for (int32 j = 0; j < 3; ++j)
+		{
+			BoxMin[j] = VectorSetFloat1((float)(Center[j] - Extents[j]));
+			BoxMax[j] = VectorSetFloat1((float)(Center[j] + Extents[j]));
+		}
+		bool bAnyRayHitsBox = false;
+		for (int32 g = 0; g < NumGroups && !bAnyRayHitsBox; ++g)
+		{
+			bAnyRayHitsBox = VectorMaskBits(IntersectBox(Groups[g], BoxMin, BoxMax)) != 0;
+		}
+		if (!bAnyRayHitsBox)
+		{
+			continue;
+		}
+
+		int32 iStart = BoxToIndex[iBox];
+		if (iStart >= TrianglesEnd)
+		{
+			int32 iChild1 = IndexList[iStart];
+			if (iChild1 < 0)
+			{
+				Stack.Add((-iChild1) - 1);
+			}
+			else
+			{
+				Stack.Add(iChild1 - 1);
+				Stack.Add(IndexList[iStart + 1] - 1);
+			}
+			continue;
+		}
+
+		int32 NumTris = IndexList[iStart];
+		for (int32 i = 1; i <= NumTris; ++i)
+		{
+			int32 TriangleID = IndexList[iStart + i];
+			FVector3d A, B, C;
+			Mesh->GetTriVertices(TriangleID, A, B, C);
+			FVector3f V0(A), V1(B), V2(C);
+
+			for (int32 g = 0; g < NumGroups; ++g)
+			{
+				VectorRegister T, U, V;
+				VectorRegister HitMask = IntersectTriangle(Groups[g], V0, V1, V2, T, U, V);
+				int32 HitBits = VectorMaskBits(HitMask);
+				if (HitBits == 0)
+				{
+					continue;
+				}
+
+				float TValues[RayGroupSize], UValues[RayGroupSize], VValues[RayGroupSize];
+				VectorStore(T, TValues);
+				VectorStore(U, UValues);
+				VectorStore(V, VValues);
+				for (int32 Lane = 0; Lane < RayGroupSize; ++Lane)
+				{
+					if (HitBits & (1 << Lane))
+					{
+						FMeshRayPacketHit Hit;
+						Hit.TriangleID = TriangleID;
+						Hit.RayParameter = TValues[Lane];
+						Hit.TriBaryCoords = FVector3f(1.0f - UValues[Lane] - VValues[Lane], UValues[Lane], VValues[Lane]);
+						int32 k = g * RayGroupSize + Lane;
+						if (bAllHits)
+						{
+							HitsOut[k].Add(Hit);
+						}
+						else
+						{
+							NearestHits[k] = Hit;
+						}
+					}
+				}
+				if (!bAllHits)
+				{
+					// hits are within TMax, so they are nearer than any previous hit. Further boxes and triangles are culled against them.
+					Groups[g].TMax = VectorSelect(HitMask, T, Groups[g].TMax);
+				}
+			}
+		}
+	}
+
+	for (int32 k = 0; k < NumRays; ++k)
+	{
+		if (bAllHits)
+		{
+			HitsOut[k].Sort([](const FMeshRayPacketHit& Hit1, const FMeshRayPacketHit& Hit2) { return Hit1.RayParameter < Hit2.RayParameter; });
+		}
+		else if (NearestHits[k].TriangleID >= 0)
+		{
+			HitsOut[k].Add(NearestHits[k]);
+		}
+	}
+}
+
+
+void FUpdatableMeshAABBTree3::FindTrianglesInBox(const FAxisAlignedBox3d& Box, TArray<int32>& TrianglesOut) const
+{
+	TrianglesOut.Reset();
+	if (RootIndex < 0)
+	{
+		return;
+	}
+
+	TArray<int32, TInlineAllocator<64>> Stack;
+	Stack.Add(RootIndex);
+	while (Stack.Num() > 0)
+	{
+		int32 iBox = Stack.Pop(false);
+		FAxisAlignedBox3d NodeBox(BoxCenters[iBox] - BoxExtents[iBox], BoxCenters[iBox] + BoxExtents[iBox]);
+		if (NodeBox.Intersects(Box) == false)
+		{
+			continue;
+		}
+
+		int32 iStart = BoxToIndex[iBox];
+		if (iStart >= TrianglesEnd)
+		{
+			int32 iChild1 = IndexList[iStart];
+			if (iChild1 < 0)
+			{
+				Stack.Add((-iChild1) - 1);
+			}
+			else
+			{
+				Stack.Add(iChild1 - 1);
+				Stack.Add(IndexList[iStart + 1] - 1);
+			}
+			continue;
+		}
+
+		int32 NumTris = IndexList[iStart];
+		for (int32 i = 1; i <= NumTris; ++i)
+		{
+			int32 TriangleID = IndexList[iStart + i];
+			if (Mesh->GetTriBounds(TriangleID).Intersects(Box))
+			{
+				TrianglesOut.Add(TriangleID);
+			}
+		}
+	}
+}
+
+
+bool FUpdatableMeshAABBTree3::TestMeshIntersection(const FUpdatableMeshAABBTree3& OtherTree, TFunctionRef<FVector3d(const FVector3d&)> OtherToThis) const
+{
+	if (RootIndex < 0 || OtherTree.RootIndex < 0)
+	{
+		return false;
+	}
+
+	auto GetBox = [](const FUpdatableMeshAABBTree3& Tree, int32 iBox)
+	{
+		return FAxisAlignedBox3d(Tree.BoxCenters[iBox] - Tree.BoxExtents[iBox], Tree.BoxCenters[iBox] + Tree.BoxExtents[iBox]);
+	};
+	auto GetOtherBox = [&](int32 iBox)
+	{
+		FAxisAlignedBox3d LocalBox = GetBox(OtherTree, iBox);
+		FAxisAlignedBox3d Box = FAxisAlignedBox3d::Empty();
+		for (int32 k = 0; k < 8; ++k)
+		{
+			Box.Contain(OtherToThis(FVector3d((k & 1) ? LocalBox.Max.X : LocalBox.Min.X, (k & 2) ? LocalBox.Max.Y : LocalBox.Min.Y, (k & 4) ? LocalBox.Max.Z : LocalBox.Min.Z)));
+		}
+		return Box;
+	};
+	// children of an internal box, or an empty list for a leaf box
+	auto GetChildren = [](const FUpdatableMeshAABBTree3& Tree, int32 iBox, TArray<int32, TInlineAllocator<2>>& ChildrenOut)
+	{
+		ChildrenOut.Reset();
+		int32 iStart = Tree.BoxToIndex[iBox];
+		if (iStart >= Tree.TrianglesEnd)
+		{
+			int32 iChild1 = Tree.IndexList[iStart];
+			if (iChild1 < 0)
+			{
+				ChildrenOut.Add((-iChild1) - 1);
+			}
+			else
+			{
+				ChildrenOut.Add(iChild1 - 1);
+				ChildrenOut.Add(Tree.IndexList[iStart + 1] - 1);
+			}
+		}
+	};
+
+	TArray<TPair<int32, int32>, TInlineAllocator<64>> Stack;
+	Stack.Add(TPair<int32, int32>(RootIndex, OtherTree.RootIndex));
+	TArray<int32, TInlineAllocator<2>> Children, OtherChildren;
+	while (Stack.Num() > 0)
+	{
+		TPair<int32, int32> Pair = Stack.Pop(false);
+		FAxisAlignedBox3d Box = GetBox(*this, Pair.Key);
+		FAxisAlignedBox3d OtherBox = GetOtherBox(Pair.Value);
+		if (Box.Intersects(OtherBox) == false)
+		{
+			continue;
+		}
+
+		GetChildren(*this, Pair.Key, Children);
+		GetChildren(OtherTree, Pair.Value, OtherChildren);
+		if (Children.Num() > 0 || OtherChildren.Num() > 0)
+		{
+			// descend into the larger box, or the one that is not a leaf
+			bool bDescendThis = OtherChildren.Num() == 0 || (Children.Num() > 0 && Box.MaxDim() >= OtherBox.MaxDim());
+			for (int32 Child : (bDescendThis ? Children : OtherChildren))
+			{
+				Stack.Add(bDescendThis ? TPair<int32, int32>(Child, Pair.Value) : TPair<int32, int32>(Pair.Key, Child));
+			}
+			continue;
+		}
+
+		// both leaves, test triangle pairs
+		int32 iStart = BoxToIndex[Pair.Key];
+		int32 iOtherStart = OtherTree.BoxToIndex[Pair.Value];
+		for (int32 j = 1; j <= OtherTree.IndexList[iOtherStart]; ++j)
+		{
+			FTriangle3d OtherTri;
+			OtherTree.Mesh->GetTriVertices(OtherTree.IndexList[iOtherStart + j], OtherTri.V[0], OtherTri.V[1], OtherTri.V[2]);
+			for (int32 v = 0; v < 3; ++v)
+			{
+				OtherTri.V[v] = OtherToThis(OtherTri.V[v]);
+			}
+			for (int32 i = 1; i <= IndexList[iStart]; ++i)
+			{
+				FTriangle3d Tri;
+				Mesh->GetTriVertices(IndexList[iStart + i], Tri.V[0], Tri.V[1], Tri.V[2]);
+				FIntrTriangle3Triangle3d Intersection(Tri, OtherTri);
+				if (Intersection.Test())
+				{
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
@@ -0,0 +1,226 @@
+#include "WindingOccupancyGrid.h"
+
+#include "Async/ParallelFor.h"
+
+
+namespace WindingOccupancyGridLocals
+{
+	static const int32 CellsPerBlock = FWindingOccupancyGrid::BlockSize * FWindingOccupancyGrid::BlockSize * FWindingOccupancyGrid::BlockSize;
+
+	static FORCEINLINE int32 CellIndexInBlock(int32 i, int32 j, int32 k)
+	{
+		return i + FWindingOccupancyGrid::BlockSize * (j + FWindingOccupancyGrid::BlockSize * k);
+	}
+
+	/**
+	 * Classify the cells of a block that contains triangles. Cells that overlap the bounds of a triangle are Boundary. The other cells are
+	 * grouped into connected regions that do not cross a Boundary cell, and the winding number is evaluated once per region, at the center of its first cell.
+	 */
+	static void ClassifyBlockCells(
+		const FDynamicMesh3& Mesh,
+		TFastWindingTree<FDynamicMesh3>& FastWinding,
+		float WindingThreshold,
+		const FVector3d& BlockMin,
+		double CellSize,
+		const TArray<int32>& BlockTriangles,
+		TArray<FWindingOccupancyGrid::ECellState>& CellsOut)
+	{
+		using ECellState = FWindingOccupancyGrid::ECellState;
+		const int32 N = FWindingOccupancyGrid::BlockSize;
+
+		TArray<bool> Classified;
+		Classified.Init(false, CellsPerBlock);
+		CellsOut.Init(ECellState::Outside, CellsPerBlock);
+
+		for (int32 tid : BlockTriangles)
+		{
+			FAxisAlignedBox3d TriBounds = Mesh.GetTriBounds(tid);
+			FVector3i MinCell, MaxCell;
+			for (int32 j = 0; j < 3; ++j)
+			{
+				MinCell[j] = FMath::Clamp((int32)FMathd::Floor((TriBounds.Min[j] - BlockMin[j]) / CellSize), 0, N - 1);
+				MaxCell[j] = FMath::Clamp((int32)FMathd::Floor((TriBounds.Max[j] - BlockMin[j]) / CellSize), 0, N - 1);
+			}
+			for (int32 k = MinCell.Z; k <= MaxCell.Z; ++k)
+			{
+				for (int32 j = MinCell.Y; j <= MaxCell.Y; ++j)
+				{
+					for (int32 i = MinCell.X; i <= MaxCell.X; ++i)
+					{
+						int32 CellIndex = CellIndexInBlock(i, j, k);
+						CellsOut[CellIndex] = ECellState::Boundary;
+						Classified[CellIndex] = true;
+					}
+				}
+			}
+		}
+
+		TArray<int32, TInlineAllocator<CellsPerBlock>> Stack;
+		for (int32 SeedIndex = 0; SeedIndex < CellsPerBlock; ++SeedIndex)
+		{
+			if (Classified[SeedIndex])
+			{
+				continue;
+			}
+
+			int32 si = SeedIndex % N, sj = (SeedIndex / N) % N, sk = SeedIndex / (N * N);
+			FVector3d SeedCenter = BlockMin + CellSize * FVector3d(si + 0.5, sj + 0.5, sk + 0.5);
+			ECellState RegionState = (FastWinding.IsInside(SeedCenter, WindingThreshold)) ? ECellState::Inside : ECellState::Outside;
+
+			Classified[SeedIndex] = true;
+			Stack.Add(SeedIndex);
+			while (Stack.Num() > 0)
+			{
+				int32 CellIndex = Stack.Pop(false);
+				CellsOut[CellIndex] = RegionState;
+				int32 ci = CellIndex % N, cj = (CellIndex / N) % N, ck = CellIndex / (N * N);
+				const FVector3i Neighbours[6] = { {ci - 1, cj, ck}, {ci + 1, cj, ck}, {ci, cj - 1, ck}, {ci, cj + 1, ck}, {ci, cj, ck - 1}, {ci, cj, ck + 1} };
+				for (const FVector3i& Nbr : Neighbours)
+				{
+					if (Nbr.X >= 0 && Nbr.X < N && Nbr.Y >= 0 && Nbr.Y < N && Nbr.Z >= 0 && Nbr.Z < N)
+					{
+						int32 NbrIndex = CellIndexInBlock(Nbr.X, Nbr.Y, Nbr.Z);
+						if (Classified[NbrIndex] == false)
+						{
+							Classified[NbrIndex] = true;
+							Stack.Add(NbrIndex);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+
+void FWindingOccupancyGrid::Reset()
+{
+	BlockDims = FVector3i::Zero();
+	BlockStates.Empty();
+	BlockCellsOffsets.Empty();
+	Cells.Empty();
+	SourceMesh = nullptr;
+	SourceTimestamp = 0;
+}
+
+
+bool FWindingOccupancyGrid::IsValidFor(const FDynamicMesh3& Mesh, float WindingThresholdIn) const
+{
+	return SourceMesh == &Mesh && SourceTimestamp == Mesh.GetTimestamp() && WindingThreshold == WindingThresholdIn;
+}
+
+
+void FWindingOccupancyGrid::Build(const FDynamicMesh3& Mesh, const FUpdatableMeshAABBTree3& AABBTree, TFastWindingTree<FDynamicMesh3>& FastWinding, float WindingThresholdIn, int32 Resolution)
+{
+	using namespace WindingOccupancyGridLocals;
+	Reset();
+	SourceMesh = &Mesh;
+	SourceTimestamp = Mesh.GetTimestamp();
+	WindingThreshold = WindingThresholdIn;
+	if (Mesh.TriangleCount() == 0)
+	{
+		return;
+	}
+
+	// pad the grid by a cell, so that the outer boundary does not touch the surface
+	FAxisAlignedBox3d Bounds = Mesh.GetBounds();
+	Resolution = FMath::Clamp(Resolution, 4, 1024);
+	CellSize = FMathd::Max(Bounds.MaxDim() / (double)Resolution, FMathd::ZeroTolerance);
+	GridOrigin = Bounds.Min - FVector3d(CellSize, CellSize, CellSize);
+	for (int32 j = 0; j < 3; ++j)
+	{
+		int32 NumCells = (int32)FMathd::Ceil((Bounds.Max[j] - Bounds.Min[j]) / CellSize) + 2;
+		BlockDims[j] = (NumCells + BlockSize - 1) / BlockSize;
+	}
+	int32 NumBlocks = BlockDims.X * BlockDims.Y * BlockDims.Z;
+	double BlockWidth = BlockSize * CellSize;
+
+	// inside state at the block corners, shared by the (up to) eight blocks around each corner
+	FVector3i CornerDims(BlockDims.X + 1, BlockDims.Y + 1, BlockDims.Z + 1);
+	TArray<bool> CornerInside;
+	CornerInside.SetNum(CornerDims.X * CornerDims.Y * CornerDims.Z);
+	ParallelFor(CornerInside.Num(), [&](int32 CornerIndex)
+	{
+		int32 i = CornerIndex % CornerDims.X, j = (CornerIndex / CornerDims.X) % CornerDims.Y, k = CornerIndex / (CornerDims.X * CornerDims.Y);
+		FVector3d Corner = GridOrigin + BlockWidth * FVector3d(i, j, k);
+		CornerInside[CornerIndex] = FastWinding.IsInside(Corner, WindingThreshold);
+	});
+
+	BlockStates.SetNum(NumBlocks);
+	TArray<TArray<ECellState>> BlockCells;
+	BlockCells.SetNum(NumBlocks);
+	ParallelFor(NumBlocks, [&](int32 BlockIndex)
+	{
+		int32 bi = BlockIndex % BlockDims.X, bj = (BlockIndex / BlockDims.X) % BlockDims.Y, bk = BlockIndex / (BlockDims.X * BlockDims.Y);
+		FVector3d BlockMin = GridOrigin + BlockWidth * FVector3d(bi, bj, bk);
+		FAxisAlignedBox3d BlockBox(BlockMin, BlockMin + FVector3d(BlockWidth, BlockWidth, BlockWidth));
+
+		TArray<int32> BlockTriangles;
+		AABBTree.FindTrianglesInBox(BlockBox, BlockTriangles);
+		if (BlockTriangles.Num() > 0)
+		{
+			BlockStates[BlockIndex] = ECellState::Boundary;
+			ClassifyBlockCells(Mesh, FastWinding, WindingThreshold, BlockMin, CellSize, BlockTriangles, BlockCells[BlockIndex]);
+			return;
+		}
+
+		// No surface in the block, so the winding number is constant (for closed meshes) and the corners agree. If they
+		// do not, the mesh is open and the state varies smoothly inside the block, and queries in the block are evaluated exactly.
+		int32 NumInside = 0;
+		for (int32 Corner = 0; Corner < 8; ++Corner)
+		{
+			int32 ci = bi + (Corner & 1), cj = bj + ((Corner >> 1) & 1), ck = bk + ((Corner >> 2) & 1);
+			NumInside += (CornerInside[ci + CornerDims.X * (cj + CornerDims.Y * ck)]) ? 1 : 0;
+		}
+		BlockStates[BlockIndex] = (NumInside == 0) ? ECellState::Outside :
+			((NumInside == 8) ? ECellState::Inside : ECellState::Boundary);
+	});
+
+	// pack the per-cell states of the narrow-band blocks
+	BlockCellsOffsets.Init(-1, NumBlocks);
+	int32 NumCellBlocks = 0;
+	for (int32 BlockIndex = 0; BlockIndex < NumBlocks; ++BlockIndex)
+	{
+		NumCellBlocks += (BlockCells[BlockIndex].Num() > 0) ? 1 : 0;
+	}
+	Cells.Reserve(NumCellBlocks * CellsPerBlock);
+	for (int32 BlockIndex = 0; BlockIndex < NumBlocks; ++BlockIndex)
+	{
+		if (BlockCells[BlockIndex].Num() > 0)
+		{
+			BlockCellsOffsets[BlockIndex] = Cells.Num();
+			Cells.Append(BlockCells[BlockIndex]);
+		}
+	}
+}
+
+
+FWindingOccupancyGrid::ECellState FWindingOccupancyGrid::GetCellState(const FVector3d& Point) const
+{
+	FVector3d GridPoint = (Point - GridOrigin) / CellSize;
+	if (GridPoint.X < 0 || GridPoint.Y < 0 || GridPoint.Z < 0
+		|| GridPoint.X >= BlockDims.X * BlockSize || GridPoint.Y >= BlockDims.Y * BlockSize || GridPoint.Z >= BlockDims.Z * BlockSize)
+	{
+		return ECellState::Outside;
+	}
+
+	int32 ci = (int32)GridPoint.X, cj = (int32)GridPoint.Y, ck = (int32)GridPoint.Z;
+	int32 BlockIndex = (ci / BlockSize) + BlockDims.X * ((cj / BlockSize) + BlockDims.Y * (ck / BlockSize));
+	int32 Offset = BlockCellsOffsets[BlockIndex];
+	if (Offset < 0)
+	{
+		return BlockStates[BlockIndex];
+	}
+	return Cells[Offset + WindingOccupancyGridLocals::CellIndexInBlock(ci % BlockSize, cj % BlockSize, ck % BlockSize)];
+}
+
+
+bool FWindingOccupancyGrid::IsInside(TFastWindingTree<FDynamicMesh3>& FastWinding, const FVector3d& Point) const
+{
+	ECellState State = GetCellState(Point);
+	if (State == ECellState::Boundary)
+	{
+		return FastWinding.IsInside(Point, WindingThreshold);
+	}
+	return State == ECellState::Inside;
+}
@@ -4,7 +4,11 @@
 #include "GameFramework/Actor.h"
 #include "DynamicMesh3.h"
 #include "DynamicMeshAABBTree3.h"
+#include "UpdatableMeshAABBTree3.h"
+#include "FlatMeshBVH.h"
+#include "WindingOccupancyGrid.h"
 #include "Spatial/FastWinding.h"
+#include "Async/Future.h"
 #include "GeneratedMesh.h"
 #include "DynamicMeshBaseActor.generated.h"
 
@@ -59,6 +63,31 @@ enum class EDynamicMeshActorBooleanOperation : uint8
 };
 
 
+/**
+ * When the spatial data structures (AABBTree, FastWindingTree) of an ADynamicMeshBaseActor are rebuilt after the mesh is modified
+ */
+UENUM(BlueprintType)
+enum class EDynamicMeshActorSpatialUpdateMode : uint8
+{
+	/** Rebuild in EditMesh() */
+	Immediate,
+	/** Rebuild on the first spatial query after the mesh is modified */
+	Lazy,
+	/** Rebuild on a background task after the mesh is modified. Until it completes, queries use the structures for the previous version of the mesh. */
+	Background
+};
+
+
+/** Spatial data structures built for a copy of the SourceMesh of an ADynamicMeshBaseActor, see EDynamicMeshActorSpatialUpdateMode::Background */
+struct FDynamicMeshActorSpatialData
+{
+	TUniquePtr<FDynamicMesh3> Mesh;
+	TUniquePtr<FUpdatableMeshAABBTree3> AABBTree;
+	TUniquePtr<TFastWindingTree<FDynamicMesh3>> FastWinding;
+	FFlatMeshBVH FlatBVH;
+};
+
+
 /**
  * Auto-Generated Collision mode for an ADynamicMeshBaseActor (only works with DynamicPMCActor)
  */
@@ -87,15 +116,18 @@ enum class EDynamicMeshActorCollisionMode : uint8
  * be modified via lambdas passed to the EditMesh() function, which will
  * then cause necessary updates to happen to the implementing Components.
  * An AABBTree and FastWindingTree can optionally be enabled with the
- * bEnableSpatialQueries and bEnableInsideQueries flags.
+ * bEnableSpatialQueries and bEnableInsideQueries flags. SpatialUpdateMode controls
+ * whether they are rebuilt immediately after each edit, lazily on the next query,
+ * or on a background task.
  *
  * When Spatial queries are enabled, a set of UFunctions DistanceToPoint(), 
  * NearestPoint(), ContainsPoint(), and IntersectRay() are available via Blueprints
  * on the relevant Actor. These functions *do not* depend on the UE4 Physics
- * system to work.
+ * system to work. The batched variants DistanceToPoints(), NearestPoints(),
+ * ContainsPoints() and IntersectRays() evaluate many queries in parallel.
  *
  * A small set of mesh modification UFunctions are also available via Blueprints,
- * including BooleanWithMesh(), SolidifyMesh(), SimplifyMeshToTriCount(), and 
+ * including BooleanWithMesh(), SolidifyMesh(), SolidifyMeshSDF(), SimplifyMeshToTriCount(), and 
  * CopyFromMesh().
  *
  * Meshes can be read from OBJ files either using the ImportedMesh type for
@@ -154,6 +186,10 @@ public:
 	UPROPERTY(EditAnywhere, Category = "DynamicMeshActor|ImportOptions", meta = (EditCondition = "SourceType == EDynamicMeshActorSourceType::ImportedMesh", EditConditionHides))
 	float ImportScale = 1.0;
 
+	/** If true, the imported mesh is stored in a binary cache file (.rtgmesh) next to the OBJ, and re-importing an unmodified OBJ reads the cache instead */
+	UPROPERTY(EditAnywhere, Category = "DynamicMeshActor|ImportOptions", meta = (EditCondition = "SourceType == EDynamicMeshActorSourceType::ImportedMesh", EditConditionHides))
+	bool bCacheImportedMesh = true;
+
 
 	//
 	// Parameters for SourceType = Primitive
@@ -198,6 +234,17 @@ public:
 	 */
 	virtual void EditMesh(TFunctionRef<void(FDynamicMesh3&)> EditFunc);
 
+	/**
+	 * Call EditMeshRegion() to modify only a region of the SourceMesh. Your EditFunc is called with the current SourceMesh,
+	 * and must return the IDs of the triangles it removed and of the triangles it added. Other triangles must not be modified,
+	 * other than moving the vertices they share with the added triangles by a small amount (eg by welding).
+	 * Normals are only recomputed for the added triangles, and the AABBTree and the mesh Components are only updated for the region
+	 * where possible (see FUpdatableMeshAABBTree3::UpdateRegion() and OnMeshRegionEditedInternal()).
+	 * If EditFunc returns false it must not have modified the mesh, and nothing is updated.
+	 * @return the value returned by EditFunc
+	 */
+	virtual bool EditMeshRegion(TFunctionRef<bool(FDynamicMesh3&, TArray<int32>&, TArray<int32>&)> EditFunc);
+
 	/**
 	 * Get a copy of the current SourceMesh stored in MeshOut
 	 */
@@ -215,6 +262,13 @@ public:
 	DECLARE_MULTICAST_DELEGATE_OneParam(FOnMeshModified, ADynamicMeshBaseActor*);
 	FOnMeshModified OnMeshModified;
 
+	/**
+	 * This delegate is broadcast (after OnMeshModified) when EditMeshRegion(), eg a local boolean (see bLocalBooleans), modified only a region of the SourceMesh.
+	 * The arguments are the IDs of the removed triangles and of the added triangles, all other triangles are unchanged.
+	 */
+	DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnMeshRegionModified, ADynamicMeshBaseActor*, const TArray<int32>&, const TArray<int32>&);
+	FOnMeshRegionModified OnMeshRegionModified;
+
 protected:
 
 	/** The SourceMesh used to initialize the mesh Components in the various subclasses */
@@ -232,6 +286,12 @@ protected:
 	/** Call this on a Mesh to compute normals according to the NormalsMode setting */
 	virtual void RecomputeNormals(FDynamicMesh3& MeshOut);
 
+	/**
+	 * Call this on a Mesh to compute normals according to the NormalsMode setting for the given (added) Triangles only.
+	 * With PerVertexNormals, the normals of the vertices of Triangles are also updated in the neighbouring triangles.
+	 */
+	virtual void RecomputeRegionNormals(FDynamicMesh3& MeshOut, const TArray<int32>& Triangles);
+
 
 
 
@@ -245,12 +305,80 @@ public:
 	UPROPERTY(EditAnywhere, Category = "DynamicMeshActor|SpatialQueries")
 	bool bEnableInsideQueries = false;
 
+	/** 
+	 * If true, distance and ray queries use a compact single-precision BVH (see FFlatMeshBVH), which is built on the first query after SourceMesh is modified.
+	 * This is faster to query than the AABBTree, but is rebuilt from scratch after every edit, so it is best for meshes that are rarely modified.
+	 */
+	UPROPERTY(EditAnywhere, Category = "DynamicMeshActor|SpatialQueries", meta = (EditCondition = "bEnableSpatialQueries"))
+	bool bUseFlatQueryBVH = false;
+
+	/**
+	 * If true, ContainsPoint() and ContainsPoints() use an occupancy grid (see FWindingOccupancyGrid), which is built on the first inside query after SourceMesh is modified.
+	 * Most queries are then a grid lookup instead of a fast-winding evaluation, so this is best for meshes that receive many inside queries between edits.
+	 */
+	UPROPERTY(EditAnywhere, Category = "DynamicMeshActor|SpatialQueries", meta = (EditCondition = "bEnableInsideQueries"))
+	bool bUseInsideQueryGrid = false;
+
+	/** Number of occupancy grid cells along the longest axis of the mesh bounds */
+	UPROPERTY(EditAnywhere, Category = "DynamicMeshActor|SpatialQueries", meta = (EditCondition = "bEnableInsideQueries && bUseInsideQueryGrid", ClampMin = 4, ClampMax = 1024))
+	int32 InsideQueryGridResolution = 128;
+
+	/** When the AABBTree and FastWindingTree are rebuilt after SourceMesh is modified */
+	UPROPERTY(EditAnywhere, Category = "DynamicMeshActor|SpatialQueries")
+	EDynamicMeshActorSpatialUpdateMode SpatialUpdateMode = EDynamicMeshActorSpatialUpdateMode::Immediate;
+
+	/** 
+	 * If true, in Background mode queries wait for a pending rebuild to complete, so they always see the current SourceMesh.
+	 * Queries also wait if there are no structures for a previous version of the mesh.
+	 */
+	UPROPERTY(EditAnywhere, Category = "DynamicMeshActor|SpatialQueries", meta = (EditCondition = "SpatialUpdateMode == EDynamicMeshActorSpatialUpdateMode::Background", EditConditionHides))
+	bool bWaitForSpatialRebuild = false;
+
 protected:
-	// This AABBTree is updated each time SourceMesh is modified if bEnableSpatialQueries=true or bEnableInsideQueries=true
-	FDynamicMeshAABBTree3 MeshAABBTree;
-	// This FastWindingTree is updated each time SourceMesh is modified if bEnableInsideQueries=true
+	// This AABBTree is rebuilt after SourceMesh is modified (see SpatialUpdateMode) if bEnableSpatialQueries=true or bEnableInsideQueries=true
+	TUniquePtr<FUpdatableMeshAABBTree3> MeshAABBTree;
+	// This FastWindingTree is rebuilt after SourceMesh is modified (see SpatialUpdateMode) if bEnableInsideQueries=true
 	TUniquePtr<TFastWindingTree<FDynamicMesh3>> FastWinding;
 
+	// Built on demand if bUseFlatQueryBVH=true (or with the other structures in Background mode), and reset each time SourceMesh is modified
+	FFlatMeshBVH FlatBVH;
+	// Built on demand by inside queries if bUseInsideQueryGrid=true, and reset each time SourceMesh is modified
+	FWindingOccupancyGrid InsideQueryGrid;
+
+	// In Background mode, the copy of SourceMesh that the structures above were built for. Otherwise null, and they are built for SourceMesh.
+	TUniquePtr<FDynamicMesh3> SpatialMeshCopy;
+	// true if SourceMesh has been modified since the last rebuild was done or started
+	bool bSpatialDataDirty = true;
+	// true if the structures above are valid for SpatialMeshCopy, or for SourceMesh if SpatialMeshCopy is null
+	bool bHasSpatialData = false;
+	// rebuild running on a background task in Background mode
+	TFuture<void> PendingSpatialRebuild;
+	TSharedPtr<FDynamicMeshActorSpatialData, ESPMode::ThreadSafe> PendingSpatialData;
+
+	/** @return the mesh that the spatial data structures were built for */
+	const FDynamicMesh3& GetSpatialMesh() const;
+
+	/** Rebuild the spatial data structures for SourceMesh on this thread, discarding any background rebuild */
+	void RebuildSpatialData();
+
+	/** Invalidate the spatial data structures after SourceMesh has been modified, and rebuild them according to SpatialUpdateMode */
+	void UpdateSpatialDataAfterEdit();
+
+	/** In Background mode, swap in the results of a completed background rebuild, and start a new one if SourceMesh has been modified since */
+	void UpdateBackgroundSpatialRebuild();
+
+	/** Make the spatial data structures ready for a query, according to SpatialUpdateMode */
+	void UpdateSpatialDataForQuery();
+
+	/** @return MeshAABBTree, updated for the current SourceMesh, unless it is built for a Background mode copy of SourceMesh. In that case a new tree for SourceMesh is stored in TempTree. */
+	FUpdatableMeshAABBTree3& GetSourceMeshAABBTree(TUniquePtr<FUpdatableMeshAABBTree3>& TempTree);
+
+	/** @return the flat BVH for the current spatial mesh (building it if necessary) if it should be used for queries, otherwise nullptr */
+	const FFlatMeshBVH* GetFlatQueryBVH();
+
+	/** @return the occupancy grid for the current spatial mesh and WindingThreshold (building it if necessary) if it should be used for inside queries, otherwise nullptr */
+	const FWindingOccupancyGrid* GetInsideQueryGrid(float WindingThreshold);
+
 
 	//
 	// Support for Runtime-Generated Collision
@@ -279,6 +407,13 @@ protected:
 	 */
 	virtual void OnMeshEditedInternal();
 
+	/**
+	 * Called when EditMeshRegion() has modified a region of the SourceMesh. Subclasses that can update only the part of
+	 * their Component that contains the region override this function, by default OnMeshEditedInternal() is called.
+	 * Overrides must call ADynamicMeshBaseActor::OnMeshEditedInternal() or OnMeshEditedInternal().
+	 */
+	virtual void OnMeshRegionEditedInternal(const TArray<int32>& RemovedTriangles, const TArray<int32>& AddedTriangles);
+
 
 
 
@@ -363,17 +498,80 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|SpatialQueries")
 	bool IntersectRay(FVector RayOrigin, FVector RayDirection, FVector& WorldHitPoint, float& HitDistance, int& NearestTriangle, FVector& TriBaryCoords, float MaxDistance = 0);
 
+	/**
+	 * Batched version of DistanceToPoint(). The queries are computed in parallel, and the Actor transform is only fetched once per batch.
+	 * @return per-point distances, nearest world-space points, nearest triangles and barycentric coordinates
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|SpatialQueries")
+	FMeshDistanceQueryResults DistanceToPoints(const TArray<FVector>& WorldPoints);
+
+	/**
+	 * Batched version of NearestPoint(). The queries are computed in parallel.
+	 * @return nearest world-space point on SourceMesh for each of WorldPoints
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|SpatialQueries")
+	TArray<FVector> NearestPoints(const TArray<FVector>& WorldPoints);
+
+	/**
+	 * Batched version of ContainsPoint(). The queries are computed in parallel.
+	 * @return true for each of WorldPoints that is contained in the mesh
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|SpatialQueries")
+	TArray<bool> ContainsPoints(const TArray<FVector>& WorldPoints, float WindingThreshold = 0.5);
+
+	/**
+	 * Batched version of IntersectRay(), for the World-Space rays (RayOrigins[k], RayDirections[k]). The queries are computed in parallel,
+	 * and consecutive rays are traced together in SIMD packets, so neighbouring rays should be coherent. RayOrigins and RayDirections must have the same length, otherwise no queries are done.
+	 * @return per-ray hit flags, hit distances, world-space hit points, hit triangles and barycentric coordinates
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|SpatialQueries")
+	FMeshRayQueryResults IntersectRays(const TArray<FVector>& RayOrigins, const TArray<FVector>& RayDirections, float MaxDistance = 0);
+
+	/**
+	 * Find all hits along each of the World-Space rays (RayOrigins[k], RayDirections[k]). Consecutive rays are traced together in SIMD packets,
+	 * so neighbouring rays should be coherent. RayOrigins and RayDirections must have the same length, otherwise no queries are done.
+	 * @return hits of each ray, sorted by increasing distance
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|SpatialQueries")
+	FMeshRayMultiHitResults IntersectRaysAllHits(const TArray<FVector>& RayOrigins, const TArray<FVector>& RayDirections, float MaxDistance = 0);
+
 
 
 	//
 	// Mesh Modification API
 	//
 public:
+	/**
+	 * If true, BooleanWithMesh() (and SubtractMesh() and UnionWithMesh()) only recompute the region of SourceMesh that overlaps the other mesh,
+	 * which is much faster for small operands, eg when repeatedly carving a large mesh. The other mesh must be closed. Intersections always recompute the whole mesh.
+	 * The result is applied with EditMeshRegion(), so normals, the AABBTree and (depending on the subclass) the mesh Component are only updated for that region.
+	 */
+	UPROPERTY(EditAnywhere, Category = "DynamicMeshActor|Composition")
+	bool bLocalBooleans = false;
+
+	/**
+	 * If true, the results of BooleanWithMesh() are stored in the shared boolean result cache (see MeshBooleanCache.h), keyed by the contents
+	 * of both meshes and their relative transform, and a cached result is used instead of recomputing the boolean when the same inputs are seen again.
+	 * Hashing the meshes costs a pass over both of them, so this only pays off when the same booleans are repeated (eg undo/redo).
+	 * Ignored for the booleans that bLocalBooleans applies locally, as a cached result would replace the whole mesh.
+	 */
+	UPROPERTY(EditAnywhere, Category = "DynamicMeshActor|Composition")
+	bool bCacheBooleanResults = false;
+
+	/** @return hash of the contents of SourceMesh (see RTGUtils::ComputeMeshContentHash()), which is only recomputed after SourceMesh is modified */
+	uint64 GetMeshContentHash();
 
 	/** Compute the specified a Boolean operation with OtherMesh (transformed to world space) and store in our SourceMesh */
 	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|Composition")
 	void BooleanWithMesh(ADynamicMeshBaseActor* OtherMesh, EDynamicMeshActorBooleanOperation Operation);
 
+	/** 
+	 * Compute the specified Boolean operation with all of OtherMeshes (transformed to world space) and store in our SourceMesh. 
+	 * For Subtraction, the union of OtherMeshes is subtracted. The meshes are combined pairwise in a balanced tree on multiple threads.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|Composition")
+	void BooleanWithMany(TArray<ADynamicMeshBaseActor*> OtherMeshes, EDynamicMeshActorBooleanOperation Operation);
+
 	/** Subtract OtherMesh from our SourceMesh */
 	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|CompositionOps")
 	void SubtractMesh(ADynamicMeshBaseActor* OtherMesh);
@@ -386,14 +584,35 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|CompositionOps")
 	void IntersectWithMesh(ADynamicMeshBaseActor* OtherMesh);
 
+protected:
+	// content hash of SourceMesh, computed on demand by GetMeshContentHash() and discarded by EditMesh()
+	bool bHaveMeshContentHash = false;
+	uint64 MeshContentHash = 0;
+
+	/** Replace SourceMesh with the boolean of SourceMesh and OtherMeshActor, without using the boolean result cache */
+	void ApplyBooleanWithMesh(ADynamicMeshBaseActor* OtherMeshActor, EDynamicMeshActorBooleanOperation Operation);
+
+public:
+
 	/** Create a "solid" verison of SourceMesh by voxelizing with the fast winding number at the given grid resolution */
 	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|RemeshingOps")
 	void SolidifyMesh(int VoxelResolution = 64, float WindingThreshold = 0.5);
 
+	/**
+	 * Replace SourceMesh with the surface at signed distance Offset from it, extracted from a narrow-band signed distance grid at the given grid resolution.
+	 * With Offset = 0 this creates a "solid" version of SourceMesh like SolidifyMesh(), positive Offsets dilate it and negative Offsets erode it.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|RemeshingOps")
+	void SolidifyMeshSDF(int VoxelResolution = 64, float Offset = 0);
+
 	/** Simplify current SourceMesh to the target triangle count */
 	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|RemeshingOps")
 	void SimplifyMeshToTriCount(int32 TargetTriangleCount);
 
+	/** Simplify current SourceMesh to the target triangle count by simplifying spatial partitions of it in parallel. This is much faster for very large meshes. */
+	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|RemeshingOps")
+	void SimplifyMeshToTriCountParallel(int32 TargetTriangleCount, int NumPartitions = 0);
+
 public:
 	/** @return number of triangles in current SourceMesh */
 	UFUNCTION(BlueprintCallable, Category = "DynamicMeshActor|MeshQueries")
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh3.h"
+#include "DynamicMeshOBJReader.h"
+
+namespace RTGUtils
+{
+	/**
+	 * Import options that change the mesh produced by ReadOBJMesh(). These are stored in the
+	 * mesh cache so that a cache written with different options is not reused.
+	 */
+	enum class EMeshCacheImportFlags : uint32
+	{
+		None = 0,
+		Normals = 1,
+		TexCoords = 2,
+		VertexColors = 4,
+		ReverseOrientation = 8
+	};
+	ENUM_CLASS_FLAGS(EMeshCacheImportFlags);
+
+	/**
+	 * @return path of the binary mesh cache (.rtgmesh) for the given source mesh file. The cache is stored next to the source file.
+	 */
+	RUNTIMEGEOMETRYUTILS_API FString GetMeshCachePath(const FString& SourcePath);
+
+	/**
+	 * Write Mesh to the binary mesh cache for SourcePath. The cache is keyed by the source path, size,
+	 * modification time and content hash, as well as the ImportFlags. Positions, triangles, groups,
+	 * vertex colors and the primary normal and UV overlays are stored as contiguous arrays.
+	 * @param return false if the cache could not be written
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool WriteMeshCache(
+		const FString& SourcePath,
+		const FDynamicMesh3& Mesh,
+		EMeshCacheImportFlags ImportFlags);
+
+	/**
+	 * Read the binary mesh cache for SourcePath into MeshOut, if the cache exists and its key matches the
+	 * current source file and ImportFlags. If only the modification time differs, the source content hash
+	 * is recomputed and the cache is still used if the content is unchanged.
+	 * @param return false if there is no valid cache, in which case MeshOut is not modified
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool ReadMeshCache(
+		const FString& SourcePath,
+		FDynamicMesh3& MeshOut,
+		EMeshCacheImportFlags ImportFlags);
+
+	/**
+	 * Read mesh in OBJ format, using the binary mesh cache if it is valid. Otherwise the OBJ is
+	 * parsed with ReadOBJMesh() and the cache is (re)written. See ReadOBJMesh() for parameters.
+	 * @param ProgressFunc passed to ReadOBJMesh(), it is not called if the cache is used
+	 * @param return false if read failed or was cancelled
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool ReadOBJMeshCached(
+		const FString& Path,
+		FDynamicMesh3& MeshOut,
+		bool bNormals,
+		bool bTexCoords,
+		bool bVertexColors,
+		bool bReverseOrientation,
+		const FOBJReadProgressFunc& ProgressFunc = FOBJReadProgressFunc());
+}
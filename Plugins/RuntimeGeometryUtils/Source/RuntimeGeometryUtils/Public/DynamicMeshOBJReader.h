@@ -5,15 +5,75 @@
 
 namespace RTGUtils
 {
+	/**
+	 * Progress callback of the chunked OBJ readers, called with the fraction of the read that is complete each time a chunk of the file
+	 * has been processed. It is called from worker threads, so it must be thread-safe. Return false to cancel the read.
+	 */
+	typedef TFunction<bool(float)> FOBJReadProgressFunc;
+
 	/**
 	 * Read mesh in OBJ format from the given path into a FDynamicMesh3.
+	 * The memory-mapped reader (ReadOBJMesh_MemoryMapped) is used if the file can be mapped, otherwise the multithreaded
+	 * parser (ReadOBJMesh_Parallel). If that fails (and was not cancelled), the tinyobj parser (ReadOBJMesh_TinyOBJ) is
+	 * tried as a last resort. Any existing contents of MeshOut are replaced.
 	 * @param bNormals should normals be imported into primary normal attribute overlay
 	 * @param bTexCoords should texture coordinates be imported into primary UV attribute overlay
 	 * @param bVertexColors should normals be imported into per-vertex colors
 	 * @param bReverseOrientation if true, mesh orientation/normals are flipped. You probably want this for importing to UE4 from other apps.
-	 * @param return false if read failed
+	 * @param ProgressFunc if set, reports progress and can cancel the read, see FOBJReadProgressFunc. MeshOut may be incomplete after a cancelled read.
+	 * @param return false if read failed or was cancelled
 	 */
 	RUNTIMEGEOMETRYUTILS_API bool ReadOBJMesh(
+		const FString& Path,
+		FDynamicMesh3& MeshOut,
+		bool bNormals,
+		bool bTexCoords,
+		bool bVertexColors,
+		bool bReverseOrientation,
+		const FOBJReadProgressFunc& ProgressFunc = FOBJReadProgressFunc());
+
+	/**
+	 * Read mesh in OBJ format using the multithreaded chunked parser. The file is split into chunks at
+	 * line boundaries, v/vn/vt/f records are parsed on worker threads, and the per-chunk results are
+	 * merged in file order. The resulting mesh is identical to the one produced by ReadOBJMesh_TinyOBJ().
+	 * Any existing contents of MeshOut are replaced. MeshOut is not modified if parsing fails.
+	 * @param ProgressFunc see ReadOBJMesh()
+	 * @param return false if read failed or was cancelled
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool ReadOBJMesh_Parallel(
+		const FString& Path,
+		FDynamicMesh3& MeshOut,
+		bool bNormals,
+		bool bTexCoords,
+		bool bVertexColors,
+		bool bReverseOrientation,
+		const FOBJReadProgressFunc& ProgressFunc = FOBJReadProgressFunc());
+
+	/**
+	 * Read mesh in OBJ format by memory-mapping the file and tokenizing directly from the mapped pages.
+	 * No line strings or intermediate attribute arrays are created: normals and UVs are parsed on worker threads
+	 * straight into the pre-allocated FDynamicMesh3 attribute storage, vertices into flat position (and color) arrays
+	 * that are appended to the mesh afterwards, and faces are parsed in bounded windows of chunks.
+	 * Peak memory is close to the size of the final mesh.
+	 * The resulting mesh is identical to the one produced by ReadOBJMesh_TinyOBJ().
+	 * Any existing contents of MeshOut are replaced. MeshOut is not modified if parsing fails.
+	 * @param ProgressFunc see ReadOBJMesh()
+	 * @param return false if read failed or was cancelled, or if the platform does not support memory-mapped files
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool ReadOBJMesh_MemoryMapped(
+		const FString& Path,
+		FDynamicMesh3& MeshOut,
+		bool bNormals,
+		bool bTexCoords,
+		bool bVertexColors,
+		bool bReverseOrientation,
+		const FOBJReadProgressFunc& ProgressFunc = FOBJReadProgressFunc());
+
+	/**
+	 * Read mesh in OBJ format using the single-threaded tinyobj parser. See ReadOBJMesh() for parameters.
+	 * @param return false if read failed
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool ReadOBJMesh_TinyOBJ(
 		const FString& Path,
 		FDynamicMesh3& MeshOut,
 		bool bNormals,
@@ -21,4 +81,3 @@ namespace RTGUtils
 		bool bVertexColors,
 		bool bReverseOrientation);
 }
-
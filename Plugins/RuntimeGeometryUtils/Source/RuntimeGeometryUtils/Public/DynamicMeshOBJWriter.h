@@ -16,7 +16,9 @@ namespace RTGUtils
 		bool bReverseOrientation);
 
 	/**
-	 * Write set of meshes to the given output path in OBJ format.
+	 * Write set of meshes to the given output path in OBJ format. The meshes are streamed into the file one
+	 * after the other with running index offsets, ie they are not combined into a single mesh first.
+	 * Each mesh is written as at least one OBJ group, triangle groups of different meshes are kept distinct.
 	 * @param bReverseOrientation if true, mesh orientation/normals are flipped. You probably want this for exporting from UE4 to other apps.
 	 * @param return false if write failed
 	 */
@@ -24,6 +26,15 @@ namespace RTGUtils
 		const FString& OutputPath,
 		const TArray<FDynamicMesh3>& Meshes,
 		bool bReverseOrientation);
+
+	/**
+	 * Write set of meshes to the given output path in OBJ format, without copying them. See WriteOBJMeshes() above.
+	 * @param return false if write failed
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool WriteOBJMeshes(
+		const FString& OutputPath,
+		const TArray<const FDynamicMesh3*>& Meshes,
+		bool bReverseOrientation);
 }
 
 
@@ -21,6 +21,12 @@ public:
 	UPROPERTY(VisibleAnywhere)
 	UProceduralMeshComponent* MeshComponent = nullptr;
 
+	/**
+	 * Number of mesh sections along each axis of the mesh bounds. If greater than 1, the triangles are split into sections by position,
+	 * and a region edit (eg a local boolean, see bLocalBooleans) only rebuilds the sections that contain the modified triangles.
+	 */
+	UPROPERTY(EditAnywhere, Category = "DynamicMeshActor|Sections", meta = (ClampMin = 1, ClampMax = 8))
+	int32 SectionGridResolution = 1;
 
 
 protected:
@@ -37,8 +43,24 @@ protected:
 	 * ADynamicBaseActor API
 	 */
 	virtual void OnMeshEditedInternal() override;
+	virtual void OnMeshRegionEditedInternal(const TArray<int32>& RemovedTriangles, const TArray<int32>& AddedTriangles) override;
 
 protected:
 	virtual void UpdatePMCMesh();
 
+	/** Rebuild the sections that contain RemovedTriangles, AddedTriangles or their neighbours. @return false if the mesh is not split into sections */
+	virtual bool UpdatePMCMeshRegion(const TArray<int32>& RemovedTriangles, const TArray<int32>& AddedTriangles);
+
+	// if SectionGridResolution > 1, the bounds of the section grid, the section of each triangle ID (or -1), and the triangles of each section
+	FAxisAlignedBox3d SectionGridBounds;
+	TArray<int32> TriangleSections;
+	TArray<TArray<int32>> SectionTriangles;
+
+	int32 GetTriangleSection(int32 TriangleID) const;
+	void UpdatePMCSection(int32 SectionIndex, bool bGenerateSectionCollision);
+
+	// @return true if the sections should have collision
+	bool UpdatePMCCollisionSettings();
+	void UpdatePMCConvexHullCollision();
+
 };
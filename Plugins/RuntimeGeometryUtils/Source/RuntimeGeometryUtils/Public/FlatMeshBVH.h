@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh3.h"
+#include "VectorTypes.h"
+#include "RayTypes.h"
+
+
+/**
+ * FFlatMeshBVH is a compact, read-only bounding volume hierarchy for ray and distance queries against a FDynamicMesh3
+ * that is not modified after it has been built. Unlike FDynamicMeshAABBTree3, the nodes store both child boxes in single
+ * precision in one cache line, and the triangle vertices are copied into the BVH in leaf order, so queries do not
+ * access the source mesh at all.
+ *
+ * The BVH records the mesh timestamp when it is built, IsValidFor() can be used to check if it needs to be rebuilt.
+ */
+class RUNTIMEGEOMETRYUTILS_API FFlatMeshBVH
+{
+public:
+	/** Maximum number of triangles in a leaf */
+	static constexpr int32 MaxLeafTriangles = 4;
+
+	/** Build the BVH for the current triangles of Mesh */
+	void Build(const FDynamicMesh3& Mesh);
+
+	/** Discard the BVH */
+	void Reset();
+
+	/** @return true if the BVH was built for Mesh and Mesh has not been modified since */
+	bool IsValidFor(const FDynamicMesh3& Mesh) const;
+
+	/**
+	 * Find the triangle nearest to Point
+	 * @param NearestDistSqrOut squared distance to the nearest triangle
+	 * @param NearestPointOut nearest point on the nearest triangle
+	 * @param BaryCoordsOut barycentric coordinates of NearestPointOut in the nearest triangle
+	 * @return ID of the nearest triangle, or -1 if the BVH is empty
+	 */
+	int32 FindNearestTriangle(const FVector3d& Point, double& NearestDistSqrOut, FVector3d& NearestPointOut, FVector3d& BaryCoordsOut) const;
+
+	/**
+	 * Find the nearest triangle hit by Ray. Both sides of triangles are hit.
+	 * @param MaxDistance if > 0, hits further along the ray than this are ignored
+	 * @param RayParameterOut distance along the ray to the hit point
+	 * @param BaryCoordsOut barycentric coordinates of the hit point in the hit triangle
+	 * @return ID of the hit triangle, or -1 if there was no hit
+	 */
+	int32 FindNearestHitTriangle(const FRay3d& Ray, double MaxDistance, double& RayParameterOut, FVector3d& BaryCoordsOut) const;
+
+protected:
+	/**
+	 * A node stores the boxes of both of its children. If ChildTriCount[k] > 0 child k is a leaf with the triangles
+	 * [ChildIndex[k], ChildIndex[k]+ChildTriCount[k]), otherwise it is the inner node ChildIndex[k], or empty if ChildIndex[k] < 0.
+	 */
+	struct alignas(64) FNode
+	{
+		float ChildMin[2][3];
+		float ChildMax[2][3];
+		int32 ChildIndex[2];
+		int32 ChildTriCount[2];
+	};
+	static_assert(sizeof(FNode) == 64, "FFlatMeshBVH::FNode should be one cache line");
+
+	struct FTriangle
+	{
+		FVector3f V0, V1, V2;
+		int32 TriangleID;
+	};
+
+	TArray<FNode, TAlignedHeapAllocator<64>> Nodes;
+	TArray<FTriangle> Triangles;
+
+	const FDynamicMesh3* SourceMesh = nullptr;
+	uint64 SourceTimestamp = 0;
+};
@@ -3,10 +3,15 @@
 #include "CoreMinimal.h"
 #include "DynamicMesh3.h"
 #include "DynamicMeshAABBTree3.h"
+#include "UpdatableMeshAABBTree3.h"
 #include "Spatial/FastWinding.h"
+#include "MatrixTypes.h"
+#include "MeshSpatialQueries.h"
+#include "ProgressiveMesh.h"
 #include "GeneratedMesh.generated.h"
 
 class ADynamicMeshBaseActor;
+class FMeshShapeGenerator;
 
 
 UENUM(BlueprintType)
@@ -48,10 +53,11 @@ public:
 	/**
 	 * Update SourceMesh by reading external mesh file at Path. Optionally flip orientation.
 	 * Note: Path may be relative to Content folder, otherwise it must be an absolute path.
+	 * @param bUseMeshCache if true, the binary mesh cache (.rtgmesh) next to the file is used if valid, and written otherwise
 	 * @return false if mesh read failed
 	 */
 	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|Initialization")
-	bool ReadMeshFromFile(FString Path, bool bFlipOrientation);
+	bool ReadMeshFromFile(FString Path, bool bFlipOrientation, bool bUseMeshCache = true);
 
 	/**
 	 * Set the Append Transform. This transform will be applied to any shapes created using the AppendX() functions (AppendBox, AppendSphere, etc)
@@ -173,6 +179,20 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|CompositionOps") UPARAM(DisplayName = "Input Mesh")
 	UGeneratedMesh* BooleanWithTransformed(UGeneratedMesh* OtherMesh, FTransform Transform, EGeneratedMeshBooleanOperation Operation);
 
+	/** 
+	 * Compute the specified Boolean operation with all of OtherMeshes. For Subtraction, the union of OtherMeshes is subtracted.
+	 * The meshes are combined pairwise in a balanced tree on multiple threads, which is much faster than calling BooleanWith() for each mesh.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|CompositionOps") UPARAM(DisplayName = "Input Mesh")
+	UGeneratedMesh* BooleanWithMany(TArray<UGeneratedMesh*> OtherMeshes, EGeneratedMeshBooleanOperation Operation);
+
+	/**
+	 * Enable or disable the boolean result cache (see MeshBooleanCache.h) for BooleanWith() and BooleanWithTransformed() on this mesh.
+	 * Both operands are hashed for each boolean, which only pays off if the same booleans are computed repeatedly. Disabled by default.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|CompositionOps") UPARAM(DisplayName = "Input Mesh")
+	UGeneratedMesh* SetCacheBooleanResults(bool bEnable = true);
+
 
 	/** 
 	 * Cut the mesh with a 3D plane defined by the Origin and Normal. Positive side is kept.
@@ -196,11 +216,53 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|RemeshingOps") UPARAM(DisplayName = "Input Mesh")
 	UGeneratedMesh* SolidifyMesh(int VoxelResolution = 64, float WindingThreshold = 0.5);
 
+	/**
+	 * Replace the mesh with the surface at signed distance Offset from it, extracted from a narrow-band signed distance grid (see FMeshSignedDistanceGrid)
+	 * at the given grid resolution. With Offset = 0 this creates a "solid" version of the mesh like SolidifyMesh(), positive Offsets dilate it and negative Offsets erode it.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|RemeshingOps") UPARAM(DisplayName = "Input Mesh")
+	UGeneratedMesh* SolidifyMeshSDF(int VoxelResolution = 64, float Offset = 0);
+
 
 	/** Simplify current Mesh to the target triangle count */
 	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|RemeshingOps") UPARAM(DisplayName = "Input Mesh")
 	UGeneratedMesh* SimplifyMeshToTriCount(int32 TargetTriangleCount, bool bDiscardAttributes = false);
 
+	/**
+	 * Simplify current Mesh to the target triangle count by simplifying spatial partitions of it in parallel, with a final pass over the whole mesh (see RTGUtils::SimplifyMeshPartitioned()).
+	 * This is much faster than SimplifyMeshToTriCount() for very large meshes, with similar quality.
+	 * @param NumPartitions number of partitions, or 0 to pick a number from the triangle count
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|RemeshingOps") UPARAM(DisplayName = "Input Mesh")
+	UGeneratedMesh* SimplifyMeshToTriCountParallel(int32 TargetTriangleCount, bool bDiscardAttributes = false, int NumPartitions = 0);
+
+	/**
+	 * Record the sequence of simplification collapses of the current Mesh (see FProgressiveMesh), so that SetToProgressiveLOD() can extract any
+	 * triangle count without re-running the simplifier. The progressive mesh is a copy, so it is not affected by later changes to Mesh.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|RemeshingOps") UPARAM(DisplayName = "Input Mesh")
+	UGeneratedMesh* BuildProgressiveMesh();
+
+	/**
+	 * Replace Mesh with the level of detail of the progressive mesh that has at most TargetTriangleCount triangles. This takes time proportional to
+	 * the output size, and does nothing if the current Mesh is already that level, so it can be called every frame, eg from a slider.
+	 * Attributes are not preserved, the result has per-vertex normals.
+	 * @return false if BuildProgressiveMesh() has not been called
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|RemeshingOps")
+	bool SetToProgressiveLOD(int32 TargetTriangleCount);
+
+	/**
+	 * Get the range of triangle counts available from the progressive mesh
+	 * @return false if BuildProgressiveMesh() has not been called
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|RemeshingOps")
+	bool GetProgressiveMeshTriangleCounts(int& MinTriangleCount, int& MaxTriangleCount);
+
+	/** Discard the progressive mesh */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|RemeshingOps") UPARAM(DisplayName = "Input Mesh")
+	UGeneratedMesh* ClearProgressiveMesh();
+
 
 
 
@@ -232,6 +294,69 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|SpatialQueries")
 	bool IntersectRay(FVector RayOrigin, FVector RayDirection, FVector& WorldHitPoint, float& HitDistance, int& NearestTriangle, FVector& TriBaryCoords, float MaxDistance = 0);
 
+	/**
+	 * Batched version of DistanceToPoint(). The queries are computed in parallel.
+	 * @return per-point distances, nearest points, nearest triangles and barycentric coordinates
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|SpatialQueries")
+	FMeshDistanceQueryResults DistanceToPoints(const TArray<FVector>& WorldPoints);
+
+	/**
+	 * Batched version of NearestPoint(). The queries are computed in parallel.
+	 * @return nearest point on SourceMesh for each of WorldPoints
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|SpatialQueries")
+	TArray<FVector> NearestPoints(const TArray<FVector>& WorldPoints);
+
+	/**
+	 * Batched version of ContainsPoint(). The queries are computed in parallel.
+	 * @return true for each of WorldPoints that is contained in the mesh
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|SpatialQueries")
+	TArray<bool> ContainsPoints(const TArray<FVector>& WorldPoints, float WindingThreshold = 0.5);
+
+	/**
+	 * Enable or disable the occupancy grid for ContainsPoint() and ContainsPoints() (see FWindingOccupancyGrid). The grid is built on the first
+	 * query after the mesh is modified, and later queries with the same WindingThreshold are mostly a grid lookup instead of a fast-winding evaluation.
+	 * This is best for meshes that receive many inside queries between edits.
+	 * @param GridResolution number of grid cells along the longest axis of the mesh bounds
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|SpatialQueries") UPARAM(DisplayName = "Input Mesh")
+	UGeneratedMesh* SetUseInsideQueryGrid(bool bEnable = true, int GridResolution = 128);
+
+	/**
+	 * Enable or disable the signed distance grid for DistanceToPoint(), NearestPoint() and DistanceToPoints() (see FMeshSignedDistanceGrid). The grid is built on the
+	 * first query after the mesh is modified. Queries within the narrow band around the surface are then answered from the grid in constant time, other queries use the AABBTree.
+	 * @param GridResolution number of grid cells along the longest axis of the mesh bounds
+	 * @param NarrowBandCells width of the narrow band around the surface, in cells
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|SpatialQueries") UPARAM(DisplayName = "Input Mesh")
+	UGeneratedMesh* SetUseDistanceQueryGrid(bool bEnable = true, int GridResolution = 128, int NarrowBandCells = 4);
+
+	/**
+	 * @return signed distance from WorldPoint to the mesh (negative inside), interpolated from the signed distance grid, which is built if necessary with the
+	 * settings of SetUseDistanceQueryGrid(). Outside the narrow band, the distance is found with the AABBTree and the sign with the fast winding number.
+	 * @param Gradient set to the gradient of the distance, ie the direction away from the surface
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|SpatialQueries")
+	float SignedDistanceToPoint(FVector WorldPoint, FVector& Gradient);
+
+	/**
+	 * Batched version of IntersectRay(), for the rays (RayOrigins[k], RayDirections[k]). The queries are computed in parallel,
+	 * and consecutive rays are traced together in SIMD packets, so neighbouring rays should be coherent. RayOrigins and RayDirections must have the same length, otherwise no queries are done.
+	 * @return per-ray hit flags, hit distances, hit points, hit triangles and barycentric coordinates
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|SpatialQueries")
+	FMeshRayQueryResults IntersectRays(const TArray<FVector>& RayOrigins, const TArray<FVector>& RayDirections, float MaxDistance = 0);
+
+	/**
+	 * Find all hits along each of the rays (RayOrigins[k], RayDirections[k]). Consecutive rays are traced together in SIMD packets,
+	 * so neighbouring rays should be coherent. RayOrigins and RayDirections must have the same length, otherwise no queries are done.
+	 * @return hits of each ray, sorted by increasing distance
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|SpatialQueries")
+	FMeshRayMultiHitResults IntersectRaysAllHits(const TArray<FVector>& RayOrigins, const TArray<FVector>& RayDirections, float MaxDistance = 0);
+
 
 
 	/** Translate the vertices of the Mesh by the given 3D Translation */
@@ -258,6 +383,14 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|Transforms") UPARAM(DisplayName = "Input Mesh")
 	UGeneratedMesh* Transform(FTransform Transform);
 
+	/**
+	 * Enable or disable deferred transforms. In deferred mode, Translate/Rotate/Scale/Transform only accumulate into a single pending
+	 * affine transform, which is applied to the vertices and normals in one parallel pass the next time the mesh is used
+	 * (queries, appends, booleans, GetMesh(), etc). Disabling deferred mode applies any pending transform.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GeneratedMesh|Transforms") UPARAM(DisplayName = "Input Mesh")
+	UGeneratedMesh* SetDeferTransforms(bool bDefer = true);
+
 
 
 	/** Set the normals of the mesh to Per-Triangle/Face Normals */
@@ -281,24 +414,98 @@ protected:
 	FTransform3d AppendTransform;
 	TUniquePtr<FDynamicMesh3> Mesh;
 
-	TUniquePtr<FDynamicMeshAABBTree3> MeshAABBTree;
+	TUniquePtr<FUpdatableMeshAABBTree3> MeshAABBTree;
 	TUniquePtr<TFastWindingTree<FDynamicMesh3>> FastWinding;
 
+	// occupancy grid for inside queries, built on demand by GetInsideQueryGrid() if bUseInsideQueryGrid is true
+	bool bUseInsideQueryGrid = false;
+	int32 InsideQueryGridResolution = 128;
+	FWindingOccupancyGrid InsideQueryGrid;
+
+	// @return the occupancy grid for WindingThreshold (building it if necessary) if it should be used for inside queries, otherwise nullptr
+	const FWindingOccupancyGrid* GetInsideQueryGrid(float WindingThreshold);
+
+	// signed distance grid for distance queries, built on demand by GetDistanceGrid(), and used by distance queries if bUseDistanceQueryGrid is true
+	bool bUseDistanceQueryGrid = false;
+	int32 DistanceGridResolution = 128;
+	int32 DistanceGridBandCells = 4;
+	FMeshSignedDistanceGrid DistanceGrid;
+
+	// @return the signed distance grid for the current mesh, building it if necessary
+	const FMeshSignedDistanceGrid& GetDistanceGrid();
+
+	// collapse sequence recorded by BuildProgressiveMesh(), and the level of detail that SetToProgressiveLOD() last extracted into Mesh
+	FProgressiveMesh ProgressiveMesh;
+	int32 ProgressiveLODTriangleCount = -1;
+	uint64 ProgressiveLODTimestamp = 0;
+
+	// If the boolean of Mesh with OtherTransform(OtherMesh) does not need the FMeshBoolean kernel, ie the
+	// operands do not intersect (see MeshBooleanBroadPhase.h), update Mesh and return true. Otherwise return false.
+	bool ApplyTrivialBoolean(UGeneratedMesh* OtherMesh, const FTransform3d& OtherTransform, EGeneratedMeshBooleanOperation Operation);
+
+	// if true, ApplyBoolean() uses the boolean result cache (see MeshBooleanCache.h), set by SetCacheBooleanResults()
+	bool bCacheBooleanResults = false;
+
+	// Replace Mesh with the boolean of Mesh and OtherTransform(OtherMesh), using the boolean result cache if bCacheBooleanResults is true
+	void ApplyBoolean(UGeneratedMesh* OtherMesh, const FTransform3d& OtherTransform, EGeneratedMeshBooleanOperation Operation);
+
+	// content hash of Mesh, computed on demand by GetContentHash() and discarded by OnMeshUpdated()
+	bool bHaveContentHash = false;
+	uint64 ContentHash = 0;
+	uint64 ContentHashTimestamp = 0;
+
+	// pending transform in deferred mode, ie Position' = PendingLinear * Position + PendingTranslation.
+	// Mutable because the pending transform is applied lazily from const accessors like GetMesh()
+	bool bDeferTransforms = false;
+	mutable bool bHavePendingTransform = false;
+	mutable FMatrix3d PendingLinear = FMatrix3d::Identity();
+	mutable FVector3d PendingTranslation = FVector3d::Zero();
+
+	void AccumulateTransform(const FMatrix3d& Linear, const FVector3d& Translation);
+	void ClearPendingTransform();
+
 public:
-	const TUniquePtr<FDynamicMesh3>& GetMesh() const { return Mesh; }
-	TUniquePtr<FDynamicMeshAABBTree3>& GetAABBTree();		// note: cannot return const because query functions are non-const
+	/** Apply the pending deferred transform (if any) to Mesh. Mesh accessors and operations call this automatically. */
+	void ApplyPendingTransform() const;
+
+	const TUniquePtr<FDynamicMesh3>& GetMesh() const { ApplyPendingTransform(); return Mesh; }
+	TUniquePtr<FUpdatableMeshAABBTree3>& GetAABBTree();		// note: cannot return const because query functions are non-const
+
+	/** @return hash of the contents of the mesh (see RTGUtils::ComputeMeshContentHash()), which is only recomputed after the mesh is modified */
+	uint64 GetContentHash();
 	const TUniquePtr<TFastWindingTree<FDynamicMesh3>>& GetFastWindingTree();
 
-	void SetMesh(const FDynamicMesh3& MeshIn) { *Mesh = MeshIn; OnMeshUpdated(); }
+	void SetMesh(const FDynamicMesh3& MeshIn) { ClearPendingTransform(); *Mesh = MeshIn; OnMeshUpdated(); }
 	void AppendMeshWithAppendTransform(FDynamicMesh3&& ToAppend, bool bPostMeshUpdate = true);
 
-	void OnMeshUpdated();
+	/**
+	 * Append the output of a shape generator (ie after Generate() has been called) directly to the mesh, with the
+	 * Append Transform applied to positions and normals on the way in. No intermediate FDynamicMesh3 is created.
+	 */
+	void AppendGeneratorWithAppendTransform(const FMeshShapeGenerator& Generator, bool bPostMeshUpdate = true);
+
+	/**
+	 * The AppendX() primitive functions cache the generated shapes, keyed by generator type and parameters, and
+	 * append a transformed copy of the cached shape on later calls with the same parameters. The cache is shared by all
+	 * UGeneratedMesh instances. This releases all cached shapes.
+	 */
+	static void ClearPrimitiveTemplateCache();
 
-	// warning: not safe to use AABBTree or FastWindingTree during this function
-	virtual void EditMeshInPlace(TFunctionRef<void(FDynamicMesh3&)> EditFunc)
+	/**
+	 * Notify that the mesh has been modified.
+	 * @param bPositionsOnly if true, only vertex positions (and normals) changed, so the AABBTree and FastWindingTree are kept and refit on next use instead of being rebuilt
+	 */
+	void OnMeshUpdated(bool bPositionsOnly = false);
+
+	/**
+	 * warning: not safe to use AABBTree or FastWindingTree during this function
+	 * @param bPositionsOnly pass true if EditFunc only modifies vertex positions/normals, see OnMeshUpdated()
+	 */
+	virtual void EditMeshInPlace(TFunctionRef<void(FDynamicMesh3&)> EditFunc, bool bPositionsOnly = false)
 	{
+		ApplyPendingTransform();
 		EditFunc(*Mesh);
-		OnMeshUpdated();
+		OnMeshUpdated(bPositionsOnly);
 	}
 };
 
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh3.h"
+#include "UpdatableMeshAABBTree3.h"
+#include "Operations/MeshBoolean.h"
+
+
+/**
+ * Relationship between the two operands of a mesh boolean, as found by the broad-phase tests below
+ */
+enum class EMeshBooleanBroadPhaseResult
+{
+	/** The mesh surfaces may intersect, the boolean must be computed */
+	Intersecting,
+	/** The meshes are disjoint, ie the surfaces do not intersect and neither mesh contains the other */
+	Disjoint,
+	/** The surfaces do not intersect, and MeshB is inside MeshA */
+	BInsideA,
+	/** The surfaces do not intersect, and MeshA is inside MeshB */
+	AInsideB
+};
+
+
+/**
+ * Broad-phase tests that detect mesh booleans whose result can be found without the FMeshBoolean kernel.
+ * Like FMeshBoolean, the operands are given with transforms TransformA and TransformB into a shared space,
+ * and the results are returned in the local space of MeshA.
+ *
+ * Typical usage is to call TestBooleanBoundsOverlap(), and if the bounds overlap, build (or reuse) AABBTrees for both
+ * meshes and call ClassifyBooleanOperands(). If the result is not Intersecting, ApplyTrivialBoolean() updates MeshA.
+ */
+namespace RTGUtils
+{
+	/**
+	 * @return true if Point (in the space of the mesh of Tree) is inside the mesh. Casts a ray from Point and checks if the
+	 * nearest hit triangle faces away from Point, so the mesh must be closed and consistently oriented.
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool IsPointInsideMesh(FUpdatableMeshAABBTree3& Tree, const FVector3d& Point);
+
+	/**
+	 * @return true if the bounding boxes of MeshA and MeshB overlap in the shared space
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool TestBooleanBoundsOverlap(
+		const FDynamicMesh3& MeshA, const FTransform3d& TransformA,
+		const FDynamicMesh3& MeshB, const FTransform3d& TransformB);
+
+	/**
+	 * Test if the surfaces of the meshes of TreeA and TreeB intersect, and if not, whether one mesh contains the other.
+	 * Containment is tested with a single vertex of each mesh, so the meshes should be closed.
+	 */
+	RUNTIMEGEOMETRYUTILS_API EMeshBooleanBroadPhaseResult ClassifyBooleanOperands(
+		FUpdatableMeshAABBTree3& TreeA, const FTransform3d& TransformA,
+		FUpdatableMeshAABBTree3& TreeB, const FTransform3d& TransformB);
+
+	/**
+	 * @return true if the boolean Operation leaves MeshA unchanged for operands with the given Relationship, eg subtracting a disjoint mesh
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool IsBooleanNoOp(FMeshBoolean::EBooleanOp Operation, EMeshBooleanBroadPhaseResult Relationship);
+
+	/**
+	 * Update MeshA with the result of the boolean Operation with MeshB, for operands that do not intersect.
+	 * @param Relationship result of the broad-phase tests, must not be Intersecting
+	 * @return true if MeshA was modified
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool ApplyTrivialBoolean(
+		FDynamicMesh3& MeshA, const FTransform3d& TransformA,
+		const FDynamicMesh3& MeshB, const FTransform3d& TransformB,
+		FMeshBoolean::EBooleanOp Operation, EMeshBooleanBroadPhaseResult Relationship);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh3.h"
+#include "Operations/MeshBoolean.h"
+
+
+/**
+ * Cache of boolean results, keyed by the content hashes of both operands, the transform applied to the
+ * second operand, and the operation. This allows repeated evaluation of the same boolean chains (eg in
+ * construction scripts, which re-run on every property change) to skip the boolean kernel entirely.
+ *
+ * The cache is shared by all users and is safe to use from multiple threads. It holds at most a fixed number
+ * of results and of total result triangles, and the least-recently-used results are discarded first.
+ */
+namespace RTGUtils
+{
+	/**
+	 * @return 64-bit hash of the full contents of Mesh, ie vertex positions and attributes, triangles, groups and
+	 * attribute overlays, including element IDs. The mesh is hashed in blocks on multiple threads.
+	 */
+	RUNTIMEGEOMETRYUTILS_API uint64 ComputeMeshContentHash(const FDynamicMesh3& Mesh);
+
+	/** @return true if the boolean result cache has nonzero capacity. Callers can skip hashing if it does not. */
+	RUNTIMEGEOMETRYUTILS_API bool IsMeshBooleanCacheEnabled();
+
+	/**
+	 * Find the cached result of the boolean Operation of the mesh with hash MeshHashA and TransformB(mesh with hash MeshHashB).
+	 * @param ResultOut set to a copy of the cached result, if found
+	 * @param ResultHashOut set to the content hash of the cached result, if found
+	 * @return true if a cached result was found
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool FindCachedMeshBoolean(
+		uint64 MeshHashA,
+		uint64 MeshHashB,
+		const FTransform3d& TransformB,
+		FMeshBoolean::EBooleanOp Operation,
+		FDynamicMesh3& ResultOut,
+		uint64& ResultHashOut);
+
+	/**
+	 * Add the Result of the boolean Operation of the mesh with hash MeshHashA and TransformB(mesh with hash MeshHashB) to the cache.
+	 * Results with more triangles than the cache capacity are not stored.
+	 * @param ResultHash content hash of Result, see ComputeMeshContentHash()
+	 */
+	RUNTIMEGEOMETRYUTILS_API void AddCachedMeshBoolean(
+		uint64 MeshHashA,
+		uint64 MeshHashB,
+		const FTransform3d& TransformB,
+		FMeshBoolean::EBooleanOp Operation,
+		const FDynamicMesh3& Result,
+		uint64 ResultHash);
+
+	/**
+	 * Set the capacity of the boolean result cache, discarding least-recently-used results as needed.
+	 * @param MaxResults maximum number of stored results. Pass 0 to disable the cache.
+	 * @param MaxTriangles maximum total triangle count of stored results
+	 */
+	RUNTIMEGEOMETRYUTILS_API void SetMeshBooleanCacheCapacity(int32 MaxResults, int64 MaxTriangles);
+
+	/** Discard all cached boolean results */
+	RUNTIMEGEOMETRYUTILS_API void ClearMeshBooleanCache();
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh3.h"
+#include "Operations/MeshBoolean.h"
+#include "UpdatableMeshAABBTree3.h"
+
+
+/**
+ * Mesh boolean operations built on FMeshBoolean, which skip the boolean kernel for operands
+ * that do not intersect (see MeshBooleanBroadPhase.h).
+ */
+namespace RTGUtils
+{
+	/**
+	 * Replace MeshA with the boolean Operation of MeshA and MeshB. Both meshes are in the same space.
+	 * @return false if the boolean kernel reported a failure, in which case MeshA is still replaced with its (possibly invalid) result
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool ComputeMeshBoolean(
+		FDynamicMesh3& MeshA,
+		const FDynamicMesh3& MeshB,
+		FMeshBoolean::EBooleanOp Operation);
+
+	/**
+	 * Compute the Union or Difference of MeshA and the closed mesh MeshB, by recomputing only the region of MeshA near MeshB.
+	 * The triangles of MeshA that overlap the bounds of MeshB are extracted into a submesh, which is trimmed by MeshB. The part of
+	 * MeshB that is inside (for Difference) or outside (for Union) of MeshA is found by cutting MeshB with the submesh and
+	 * classifying the pieces against all of MeshA with MeshATree. Both parts then replace the region in MeshA, and are welded to it along the region boundary.
+	 * This is much faster than FMeshBoolean when MeshB is small compared to MeshA, eg when repeatedly carving a large terrain.
+	 *
+	 * @param MeshATree valid AABBTree for MeshA. It is not updated.
+	 * @param RemovedTrianglesOut IDs of the triangles that were removed from MeshA
+	 * @param AddedTrianglesOut IDs of the triangles that were added to MeshA. Other triangles of MeshA are unchanged.
+	 * @return false if the local boolean cannot be used, ie Operation is not Union or Difference, the region is all of MeshA, or trimming the region failed.
+	 *         In that case MeshA is not modified, and the full FMeshBoolean should be used instead.
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool ComputeLocalMeshBoolean(
+		FDynamicMesh3& MeshA,
+		FUpdatableMeshAABBTree3& MeshATree,
+		const FDynamicMesh3& MeshB,
+		FMeshBoolean::EBooleanOp Operation,
+		TArray<int32>& RemovedTrianglesOut,
+		TArray<int32>& AddedTrianglesOut);
+
+	/**
+	 * Replace TargetMesh with the boolean Operation of TargetMesh and all the Operands. For Union and Intersect the
+	 * result is the union/intersection of all the meshes, for Difference the union of the Operands is subtracted from TargetMesh.
+	 *
+	 * The operands are sorted along a space-filling curve so that nearby meshes are combined first, and then combined
+	 * pairwise in a balanced tree, with the pairs of each level of the tree computed in parallel. This keeps the
+	 * intermediate meshes small, compared to applying the operands one at a time to a growing result.
+	 *
+	 * @param TargetTransform maps TargetMesh to the shared space
+	 * @param OperandTransforms maps each of the Operands to the shared space, must have the same length as Operands
+	 * @return false if any boolean kernel reported a failure
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool ComputeMeshBooleanWithMany(
+		FDynamicMesh3& TargetMesh,
+		const FTransform3d& TargetTransform,
+		const TArray<const FDynamicMesh3*>& Operands,
+		const TArray<FTransform3d>& OperandTransforms,
+		FMeshBoolean::EBooleanOp Operation);
+}
@@ -34,4 +34,18 @@ namespace RTGUtils
 		bool bInitializePerVertexColors,
 		bool bCreateCollision);
 
+	/**
+	 * Create (or replace) section SectionIndex of a ProceduralMeshComponent from the given triangles of the FDynamicMesh3.
+	 * Other sections are not modified. See UpdatePMCFromDynamicMesh_SplitTriangles() for the other parameters.
+	 */
+	RUNTIMEGEOMETRYUTILS_API void UpdatePMCSectionFromDynamicMesh_SplitTriangles(
+		UProceduralMeshComponent* Component,
+		int32 SectionIndex,
+		const FDynamicMesh3* Mesh,
+		const TArray<int32>& TriangleIDs,
+		bool bUseFaceNormals,
+		bool bInitializeUV0,
+		bool bInitializePerVertexColors,
+		bool bCreateCollision);
+
 }
\ No newline at end of file
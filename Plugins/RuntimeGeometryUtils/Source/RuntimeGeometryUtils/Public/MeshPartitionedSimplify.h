@@ -0,0 +1,26 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh3.h"
+
+
+namespace RTGUtils
+{
+	/**
+	 * Simplify Mesh to TargetTriangleCount by simplifying spatial partitions of it in parallel. The triangles are split into
+	 * NumPartitions sets of similar size by recursively splitting the largest set at the median of its triangle centroids.
+	 * Each partition is extracted into a submesh and simplified to its share of the triangle budget, with the vertices and edges
+	 * on the partition boundaries locked, so that the simplified partitions still match. They are then welded back together along the seams, and a
+	 * final serial pass with unlocked partition boundaries removes the remaining triangles, mostly around the partition boundaries.
+	 * The partitions keep a little more than their share of the budget for the final pass, so the result is close to simplifying the whole mesh at once.
+	 * Mesh is compacted.
+	 *
+	 * @param bPreserveAttributes if true, use FAttrMeshSimplification and constrain the attribute seams, otherwise use FQEMSimplification
+	 * @param NumPartitions number of partitions, or 0 to pick a number from the triangle count
+	 */
+	RUNTIMEGEOMETRYUTILS_API void SimplifyMeshPartitioned(
+		FDynamicMesh3& Mesh,
+		int32 TargetTriangleCount,
+		bool bPreserveAttributes,
+		int32 NumPartitions = 0);
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh3.h"
+#include "IntVectorTypes.h"
+#include "Spatial/FastWinding.h"
+#include "UpdatableMeshAABBTree3.h"
+
+
+/**
+ * FMeshSignedDistanceGrid is a sparse, narrow-band signed distance field for a mesh, sampled at the nodes of a regular grid. Distances
+ * are negative inside the mesh. Queries interpolate the eight nodes around the query point, so they take constant time.
+ *
+ * The grid is stored as blocks of BlockSize^3 nodes, and only the blocks within the narrow band around the surface store per-node
+ * distances. The other blocks only store whether they are inside or outside the mesh. Nodes near the triangles are initialized with
+ * exact distances, and these are then propagated to the rest of the band by fast sweeping, where each node takes the nearest of the
+ * triangles nearest to its upwind neighbours. The sweeps are done in parallel over blocks, with the blocks split into eight sets so
+ * that neighbouring blocks are never swept at the same time. The sign of each node is found with the fast winding number.
+ *
+ * Distances are clamped to the band width, so queries further than that from the surface fail, and the caller should fall back to an exact query.
+ * The grid records the mesh timestamp when it is built, IsValidFor() can be used to check if it needs to be rebuilt.
+ */
+class RUNTIMEGEOMETRYUTILS_API FMeshSignedDistanceGrid
+{
+public:
+	/** Number of nodes along each axis of a block */
+	static constexpr int32 BlockSize = 8;
+
+	/**
+	 * Build the distance field for the current triangles of Mesh.
+	 * @param AABBTree valid tree for Mesh, used to find the triangles near each block
+	 * @param FastWinding valid fast-winding tree for Mesh, used to find the sign of the distances
+	 * @param Resolution number of grid cells along the longest axis of the mesh bounds
+	 * @param NarrowBandCells width of the narrow band around the surface, in cells
+	 * @param ExtendBounds the grid extends this far (plus the band width) beyond the mesh bounds, eg to cover an offset surface
+	 */
+	void Build(const FDynamicMesh3& Mesh, const FUpdatableMeshAABBTree3& AABBTree, TFastWindingTree<FDynamicMesh3>& FastWinding,
+		int32 Resolution = 128, int32 NarrowBandCells = 4, double ExtendBounds = 0);
+
+	/** Discard the distance field */
+	void Reset();
+
+	/** @return true if the grid was built for Mesh and Mesh has not been modified since */
+	bool IsValidFor(const FDynamicMesh3& Mesh) const;
+
+	/** @return size of a grid cell */
+	double GetCellSize() const { return CellSize; }
+
+	/** @return width of the narrow band, ie the largest distance stored in the grid */
+	double GetBandWidth() const { return BandWidth; }
+
+	/** @return bounding box of the grid nodes */
+	FAxisAlignedBox3d GetBounds() const;
+
+	/**
+	 * Interpolate the signed distance at Point.
+	 * @return false if Point is outside the grid or not within the narrow band, in which case DistanceOut is not set
+	 */
+	bool GetDistance(const FVector3d& Point, double& DistanceOut) const;
+
+	/**
+	 * Interpolate the signed distance at Point, and find the gradient of the interpolated distance, which points away from the surface outside the mesh.
+	 * @return false if Point is outside the grid or not within the narrow band, in which case the outputs are not set
+	 */
+	bool GetDistanceAndGradient(const FVector3d& Point, double& DistanceOut, FVector3d& GradientOut) const;
+
+	/**
+	 * @return interpolated signed distance at Point, clamped to the band width. Points outside the grid are outside the mesh.
+	 * This is defined everywhere, so it can be used as an implicit function, eg for marching cubes.
+	 */
+	double GetClampedDistance(const FVector3d& Point) const;
+
+	/**
+	 * Find the triangle nearest to Point among the triangles nearest to the eight grid nodes around it. The distance to that triangle is exact,
+	 * but it may not be the nearest triangle of the mesh if Point is not within the narrow band.
+	 * @param NearestDistSqrOut squared distance to the nearest triangle
+	 * @param NearestPointOut nearest point on the nearest triangle
+	 * @param BaryCoordsOut barycentric coordinates of NearestPointOut in the nearest triangle
+	 * @return ID of the nearest triangle, or -1 if Point is outside the grid or not within the narrow band
+	 */
+	int32 FindNearestTriangle(const FVector3d& Point, double& NearestDistSqrOut, FVector3d& NearestPointOut, FVector3d& BaryCoordsOut) const;
+
+protected:
+	FVector3d GridOrigin = FVector3d::Zero();
+	double CellSize = 1.0;
+	double BandWidth = 0;
+	FVector3i NodeDims = FVector3i::Zero();
+	FVector3i BlockDims = FVector3i::Zero();
+
+	/** Offset of the nodes of each block in Distances and NearestTriangles, or -1 if the block is outside the narrow band */
+	TArray<int32> BlockOffsets;
+	/** For blocks outside the narrow band, -1 if the block is inside the mesh and 1 if it is outside */
+	TArray<int8> BlockSigns;
+	/** Signed distances of the nodes of the narrow-band blocks, BlockSize^3 nodes per block in x-fastest order */
+	TArray<float> Distances;
+	/** Nearest triangle of each node, or -1 if the sweeps did not reach the node */
+	TArray<int32> NearestTriangles;
+
+	const FDynamicMesh3* SourceMesh = nullptr;
+	uint64 SourceTimestamp = 0;
+
+	/** @return index of node (i,j,k) in Distances, or -1 if the node is in a block outside the narrow band */
+	int32 GetNodeIndex(int32 i, int32 j, int32 k) const;
+
+	/** @return signed distance at node (i,j,k), which must be inside the grid */
+	float GetNodeDistance(int32 i, int32 j, int32 k) const;
+
+	/** Find the cell containing Point, and the position of Point in the cell. @return false if Point is outside the grid */
+	bool FindCell(const FVector3d& Point, FVector3i& CellOut, FVector3d& CellPositionOut) const;
+};
+
+
+namespace RTGUtils
+{
+	/**
+	 * Extract the surface at signed distance Offset from the distance field with marching cubes, at the resolution of the grid.
+	 * With Offset = 0 this is a "solid" version of the source mesh, as with TImplicitSolidify. The Grid band width must be larger than |Offset|.
+	 * @return false if |Offset| is too large for the band width of the Grid, in which case ResultOut is not modified
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool GenerateOffsetSurface(
+		const FMeshSignedDistanceGrid& Grid,
+		double Offset,
+		FDynamicMesh3& ResultOut);
+
+	/**
+	 * Build a distance field for Mesh with a band wide enough for Offset, and extract the surface at signed distance Offset. See GenerateOffsetSurface().
+	 * @param Resolution number of grid cells along the longest axis of the mesh bounds
+	 */
+	RUNTIMEGEOMETRYUTILS_API void ComputeOffsetSurface(
+		const FDynamicMesh3& Mesh,
+		const FUpdatableMeshAABBTree3& AABBTree,
+		TFastWindingTree<FDynamicMesh3>& FastWinding,
+		int32 Resolution,
+		double Offset,
+		FDynamicMesh3& ResultOut);
+}
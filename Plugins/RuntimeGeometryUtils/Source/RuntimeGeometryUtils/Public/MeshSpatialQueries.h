@@ -0,0 +1,218 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh3.h"
+#include "DynamicMeshAABBTree3.h"
+#include "Spatial/FastWinding.h"
+#include "UpdatableMeshAABBTree3.h"
+#include "FlatMeshBVH.h"
+#include "WindingOccupancyGrid.h"
+#include "MeshSignedDistanceGrid.h"
+#include "MeshSpatialQueries.generated.h"
+
+
+/**
+ * Results of a batched distance query, stored as one array per result value. Element k of each array is the result for query point k.
+ */
+USTRUCT(BlueprintType)
+struct RUNTIMEGEOMETRYUTILS_API FMeshDistanceQueryResults
+{
+	GENERATED_BODY()
+
+	/** Distance to the mesh, or TNumericLimits<float>::Max() if no nearest triangle was found */
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<float> Distances;
+
+	/** Nearest point on the mesh, or the query point if no nearest triangle was found */
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<FVector> NearestPoints;
+
+	/** Nearest triangle ID, or -1 if none was found */
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<int32> NearestTriangles;
+
+	/** Barycentric coordinates of the nearest point in the nearest triangle */
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<FVector> TriBaryCoords;
+};
+
+
+/**
+ * Results of a batched ray intersection query, stored as one array per result value. Element k of each array is the result for ray k.
+ * The other values are only meaningful if bHit[k] is true.
+ */
+USTRUCT(BlueprintType)
+struct RUNTIMEGEOMETRYUTILS_API FMeshRayQueryResults
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<bool> bHit;
+
+	/** Distance along the ray to the hit point */
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<float> HitDistances;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<FVector> HitPoints;
+
+	/** Hit triangle ID, or -1 if there was no hit */
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<int32> HitTriangles;
+
+	/** Barycentric coordinates of the hit point in the hit triangle */
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<FVector> TriBaryCoords;
+};
+
+
+/**
+ * Results of a batched ray intersection query that finds all hits along each ray. The hits of ray k are elements
+ * [FirstHits[k], FirstHits[k] + HitCounts[k]) of the hit arrays, sorted by increasing distance.
+ */
+USTRUCT(BlueprintType)
+struct RUNTIMEGEOMETRYUTILS_API FMeshRayMultiHitResults
+{
+	GENERATED_BODY()
+
+	/** Index of the first hit of each ray in the hit arrays */
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<int32> FirstHits;
+
+	/** Number of hits of each ray */
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<int32> HitCounts;
+
+	/** Distance along the ray to each hit point */
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<float> HitDistances;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<FVector> HitPoints;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<int32> HitTriangles;
+
+	/** Barycentric coordinates of each hit point in the hit triangle */
+	UPROPERTY(BlueprintReadOnly, Category = "SpatialQueries")
+	TArray<FVector> TriBaryCoords;
+};
+
+
+/**
+ * Batched spatial queries against a mesh and its spatial data structures. The queries are distributed across worker threads.
+ * Query points and rays are given in world space, and MeshToWorld maps from the local space of the mesh to world space.
+ * The trees must be valid (ie up-to-date with the mesh) and are not modified, so they can be shared with other queries.
+ */
+namespace RTGUtils
+{
+	/**
+	 * Find the nearest point on Mesh to each of the Points.
+	 */
+	RUNTIMEGEOMETRYUTILS_API void FindDistancesToPoints(
+		const FDynamicMesh3& Mesh,
+		FDynamicMeshAABBTree3& AABBTree,
+		const FTransform3d& MeshToWorld,
+		const TArray<FVector>& Points,
+		FMeshDistanceQueryResults& ResultsOut);
+
+	/**
+	 * Find the nearest point on the mesh to each of the Points. This skips the per-triangle distance and barycentric calculation of FindDistancesToPoints().
+	 */
+	RUNTIMEGEOMETRYUTILS_API void FindNearestPoints(
+		FDynamicMeshAABBTree3& AABBTree,
+		const FTransform3d& MeshToWorld,
+		const TArray<FVector>& Points,
+		TArray<FVector>& NearestPointsOut);
+
+	/**
+	 * Test if the mesh contains each of the Points, ie the mesh winding number is >= WindingThreshold.
+	 */
+	RUNTIMEGEOMETRYUTILS_API void FindContainedPoints(
+		TFastWindingTree<FDynamicMesh3>& FastWinding,
+		const FTransform3d& MeshToWorld,
+		const TArray<FVector>& Points,
+		float WindingThreshold,
+		TArray<bool>& ContainedOut);
+
+	/**
+	 * Test if the mesh contains each of the Points, using the occupancy Grid (see FWindingOccupancyGrid), with the WindingThreshold it was built for.
+	 * FastWinding is only evaluated for points in Boundary cells of the Grid.
+	 */
+	RUNTIMEGEOMETRYUTILS_API void FindContainedPoints(
+		const FWindingOccupancyGrid& Grid,
+		TFastWindingTree<FDynamicMesh3>& FastWinding,
+		const FTransform3d& MeshToWorld,
+		const TArray<FVector>& Points,
+		TArray<bool>& ContainedOut);
+
+	/**
+	 * Intersect each ray (RayOrigins[k], RayDirections[k]) with the mesh of AABBTree, and find the nearest hit.
+	 * Consecutive rays are traced together in packets (see FUpdatableMeshAABBTree3::FindRayPacketHits()), so rays
+	 * should be ordered such that neighbouring rays are coherent, eg in scanline order.
+	 * @param MaxDistance if > 0, hits further along the ray than this are ignored
+	 * @return false if RayOrigins and RayDirections have different lengths, in which case no queries are done
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool FindRayIntersections(
+		const FUpdatableMeshAABBTree3& AABBTree,
+		const FTransform3d& MeshToWorld,
+		const TArray<FVector>& RayOrigins,
+		const TArray<FVector>& RayDirections,
+		float MaxDistance,
+		FMeshRayQueryResults& ResultsOut);
+
+	/**
+	 * Intersect each ray (RayOrigins[k], RayDirections[k]) with the mesh of AABBTree, and find all hits along each ray.
+	 * Rays are traced in packets, see FindRayIntersections().
+	 * @param MaxDistance if > 0, hits further along the ray than this are ignored
+	 * @return false if RayOrigins and RayDirections have different lengths, in which case no queries are done
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool FindAllRayIntersections(
+		const FUpdatableMeshAABBTree3& AABBTree,
+		const FTransform3d& MeshToWorld,
+		const TArray<FVector>& RayOrigins,
+		const TArray<FVector>& RayDirections,
+		float MaxDistance,
+		FMeshRayMultiHitResults& ResultsOut);
+
+	/**
+	 * Find the nearest point on Mesh to each of the Points, using the signed distance Grid (see FMeshSignedDistanceGrid::FindNearestTriangle())
+	 * for points within its narrow band, and AABBTree for the other points. Distances are unsigned, as in FindDistancesToPoints() above.
+	 */
+	RUNTIMEGEOMETRYUTILS_API void FindDistancesToPoints(
+		const FMeshSignedDistanceGrid& Grid,
+		const FDynamicMesh3& Mesh,
+		FDynamicMeshAABBTree3& AABBTree,
+		const FTransform3d& MeshToWorld,
+		const TArray<FVector>& Points,
+		FMeshDistanceQueryResults& ResultsOut);
+
+	/**
+	 * Find the nearest point on the mesh of the flattened BVH to each of the Points. See FindDistancesToPoints() above.
+	 */
+	RUNTIMEGEOMETRYUTILS_API void FindDistancesToPoints(
+		const FFlatMeshBVH& BVH,
+		const FTransform3d& MeshToWorld,
+		const TArray<FVector>& Points,
+		FMeshDistanceQueryResults& ResultsOut);
+
+	/**
+	 * Find the nearest point on the mesh of the flattened BVH to each of the Points. See FindNearestPoints() above.
+	 */
+	RUNTIMEGEOMETRYUTILS_API void FindNearestPoints(
+		const FFlatMeshBVH& BVH,
+		const FTransform3d& MeshToWorld,
+		const TArray<FVector>& Points,
+		TArray<FVector>& NearestPointsOut);
+
+	/**
+	 * Intersect each ray (RayOrigins[k], RayDirections[k]) with the mesh of the flattened BVH, and find the nearest hit. See FindRayIntersections() above.
+	 */
+	RUNTIMEGEOMETRYUTILS_API bool FindRayIntersections(
+		const FFlatMeshBVH& BVH,
+		const FTransform3d& MeshToWorld,
+		const TArray<FVector>& RayOrigins,
+		const TArray<FVector>& RayDirections,
+		float MaxDistance,
+		FMeshRayQueryResults& ResultsOut);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh3.h"
+
+
+/**
+ * FProgressiveMesh records the sequence of edge collapses that FQEMSimplification applies to a mesh when it is simplified as far as
+ * possible. Replaying the first K collapses gives the same mesh as running FQEMSimplification to the corresponding triangle count,
+ * so any level of detail can be extracted without re-running the simplifier.
+ *
+ * The vertices and triangles are sorted by the collapse that removes them, so the vertices and triangles of each level are a prefix
+ * of those arrays, and extraction only visits the output. Each triangle corner follows the chain of collapses of its vertex to the
+ * vertex that is still alive, and each vertex takes the last position that a collapse before the level assigned to it.
+ *
+ * The progressive mesh is a copy of the source mesh, so it stays valid when the source is modified or replaced by one of its levels.
+ * Attributes are not recorded, the extracted meshes only have vertex positions and triangles.
+ */
+class RUNTIMEGEOMETRYUTILS_API FProgressiveMesh
+{
+public:
+	/** Simplify a copy of Mesh as far as possible, and record the collapse sequence */
+	void Build(const FDynamicMesh3& Mesh);
+
+	/** Discard the recorded mesh */
+	void Reset();
+
+	/** @return true if Build() has been called since the last Reset() */
+	bool IsBuilt() const { return bBuilt; }
+
+	/** @return triangle count of the full-resolution mesh */
+	int32 GetMaxTriangleCount() const;
+
+	/** @return triangle count after all the recorded collapses */
+	int32 GetMinTriangleCount() const;
+
+	/** @return triangle count of the level of detail that ExtractLOD() returns for TriangleCount */
+	int32 GetLODTriangleCount(int32 TriangleCount) const;
+
+	/**
+	 * Replace ResultOut with the level of detail that has at most TriangleCount triangles, ie the result of replaying the fewest
+	 * collapses that reach TriangleCount (or all of them, if TriangleCount is less than GetMinTriangleCount()).
+	 * @return triangle count of ResultOut
+	 */
+	int32 ExtractLOD(int32 TriangleCount, FDynamicMesh3& ResultOut) const;
+
+protected:
+	bool bBuilt = false;
+
+	/** Vertex positions and triangles of the (compacted) full-resolution mesh */
+	TArray<FVector3d> Positions;
+	TArray<FIndex3i> Triangles;
+
+	/** Index of the collapse that removed each vertex/triangle, MAX_int32 if it is never removed, or -1 for unreferenced vertices */
+	TArray<int32> VertexRemovedAt;
+	TArray<int32> TriangleRemovedAt;
+	/** Vertex that each removed vertex was collapsed into */
+	TArray<int32> VertexCollapsedTo;
+
+	/** New position of the kept vertex of each collapse */
+	TArray<FVector3d> CollapsePositions;
+	/** TriangleCountAfter[K] is the triangle count after K collapses */
+	TArray<int32> TriangleCountAfter;
+
+	/** Vertices and triangles sorted by decreasing removal index, and the position of each vertex in VertexOrder */
+	TArray<int32> VertexOrder;
+	TArray<int32> VertexRank;
+	TArray<int32> TriangleOrder;
+
+	/** The collapses that moved vertex v are PositionUpdates[PositionUpdateOffsets[v] .. PositionUpdateOffsets[v+1]), in increasing order */
+	TArray<int32> PositionUpdateOffsets;
+	TArray<int32> PositionUpdates;
+
+	/** @return number of collapses of the level of detail for TriangleCount */
+	int32 FindNumCollapses(int32 TriangleCount) const;
+
+	/** @return position of vertex VertexID after NumCollapses collapses */
+	FVector3d GetPosition(int32 VertexID, int32 NumCollapses) const;
+
+	/** @return the vertex that VertexID has been collapsed into after NumCollapses collapses */
+	int32 GetCollapsedVertex(int32 VertexID, int32 NumCollapses) const;
+};
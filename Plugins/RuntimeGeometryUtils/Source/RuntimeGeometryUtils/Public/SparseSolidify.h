@@ -0,0 +1,37 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh3.h"
+#include "Spatial/FastWinding.h"
+
+
+namespace RTGUtils
+{
+	/** Number of cells along each axis of a block in ComputeSparseSolidify() */
+	static constexpr int32 SparseSolidifyBlockSize = 16;
+
+	/**
+	 * Create a "solid" version of Mesh by extracting the WindingThreshold iso-surface of its fast winding number with marching cubes,
+	 * like TImplicitSolidify, but without evaluating the winding number over the full grid. The grid is split into blocks of
+	 * SparseSolidifyBlockSize^3 cells. Marching starts from the blocks that contain triangles, and continues into the neighbouring
+	 * blocks that the surface crosses into (eg to close holes), so blocks away from the output surface are never evaluated.
+	 * Each wave of blocks is marched in parallel, and the vertices on the shared block faces are welded when the blocks are combined.
+	 *
+	 * The winding field outside the grid is zero, ie the result is closed at the grid boundaries.
+	 *
+	 * @param FastWinding fast-winding tree for Mesh. It is built if necessary, so an existing tree can be reused for repeated calls.
+	 * @param VoxelResolution number of grid cells along the longest axis of the mesh bounds
+	 * @param WindingThreshold iso-value of the extracted surface
+	 * @param ExtendBounds the grid extends this far beyond the mesh bounds
+	 * @param SurfaceSearchSteps number of bisection steps used to find the surface along each cell edge
+	 * @param ResultOut the solid mesh, without attributes
+	 */
+	RUNTIMEGEOMETRYUTILS_API void ComputeSparseSolidify(
+		const FDynamicMesh3& Mesh,
+		TFastWindingTree<FDynamicMesh3>& FastWinding,
+		int32 VoxelResolution,
+		double WindingThreshold,
+		double ExtendBounds,
+		int32 SurfaceSearchSteps,
+		FDynamicMesh3& ResultOut);
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh3.h"
+#include "DynamicMeshAABBTree3.h"
+#include "VectorTypes.h"
+#include "RayTypes.h"
+
+
+/** A ray-triangle hit found by FUpdatableMeshAABBTree3::FindRayPacketHits() */
+struct FMeshRayPacketHit
+{
+	int32 TriangleID = -1;
+	/** distance along the ray */
+	float RayParameter = 0;
+	/** barycentric coordinates of the hit point in the triangle */
+	FVector3f TriBaryCoords = FVector3f::Zero();
+};
+
+
+/** Timings and statistics of a FUpdatableMeshAABBTree3::BuildParallelSAH() build */
+struct FMeshAABBTreeBuildTimings
+{
+	int32 NumTriangles = 0;
+	int32 NumBoxes = 0;
+	/** number of subtrees that were built in parallel */
+	int32 NumSubtrees = 0;
+
+	/** time to compute the triangle bounds, in seconds */
+	double SetupTime = 0;
+	/** time to split the top levels of the tree into subtrees */
+	double TopLevelTime = 0;
+	/** time to build the subtrees */
+	double SubtreesTime = 0;
+	/** time to convert the tree to the FDynamicMeshAABBTree3 representation */
+	double FlattenTime = 0;
+	double TotalTime = 0;
+};
+
+
+/**
+ * FUpdatableMeshAABBTree3 is a FDynamicMeshAABBTree3 that can be updated after the mesh has been modified.
+ * If only vertex positions changed since the last build (ie the mesh topology timestamp is unchanged), the
+ * existing tree is refit bottom-up, ie the node boxes are recomputed but the tree structure is kept.
+ * Otherwise the tree is rebuilt. Query functions are inherited unchanged.
+ *
+ * By default the tree is built with BuildParallelSAH(), which splits the triangles using a binned surface area heuristic
+ * and builds independent subtrees on multiple threads. The resulting tree has the same representation as a tree built
+ * by FDynamicMeshAABBTree3::Build(), so all the query functions work unchanged.
+ *
+ * After an edit that replaced a region of the mesh, UpdateRegion() patches the tree for that region instead of rebuilding it.
+ *
+ * In addition FindRayPacketHits() traces packets of coherent rays through the tree together, using SIMD box and triangle tests.
+ *
+ * Note that a refit tree may be less efficient to query than a rebuilt tree if the positions change a lot.
+ */
+class RUNTIMEGEOMETRYUTILS_API FUpdatableMeshAABBTree3 : public FDynamicMeshAABBTree3
+{
+public:
+	FUpdatableMeshAABBTree3() = default;
+	FUpdatableMeshAABBTree3(const FDynamicMesh3* SourceMesh, bool bAutoBuild = true);
+
+	/** Set the source mesh, and optionally build the tree. Hides the base-class version so that the built topology is tracked. */
+	void SetMesh(const FDynamicMesh3* SourceMesh, bool bAutoBuild = true);
+
+	/** 
+	 * Build the tree from scratch, with BuildParallelSAH() if bParallelSAHBuild is true, otherwise with the base-class build. 
+	 * Hides the base-class version so that the built topology is tracked. 
+	 */
+	void Build();
+
+	/** If true, Build() uses BuildParallelSAH() */
+	bool bParallelSAHBuild = true;
+
+	/**
+	 * Build the tree from scratch. The top levels of the tree are split on the calling thread (binning large triangle ranges in parallel),
+	 * until the remaining triangle ranges are small enough to be built as independent subtrees on the worker threads.
+	 * Splits are chosen with a binned surface area heuristic, and leaves contain at most 4 triangles, as in the base-class build.
+	 * @param TimingsOut if non-null, the build timings are returned here
+	 */
+	void BuildParallelSAH(FMeshAABBTreeBuildTimings* TimingsOut = nullptr);
+
+	/** @return timings of the last BuildParallelSAH() */
+	const FMeshAABBTreeBuildTimings& GetLastBuildTimings() const { return LastBuildTimings; }
+
+	/** @return true if the tree has been built and the mesh topology has not changed since, ie Refit() can be used */
+	bool CanRefit() const;
+
+	/** Recompute the node boxes bottom-up for the current vertex positions. The mesh topology must not have changed (see CanRefit()). */
+	void Refit();
+
+	/**
+	 * Refit or rebuild the tree if the mesh has been modified since the last update.
+	 * @return true if the tree was updated, false if it was already valid
+	 */
+	bool Update();
+
+	/** @return true if the tree has been built and the mesh has not been modified since, ie the tree can be queried */
+	bool IsUpToDate() const;
+
+	/**
+	 * Update the tree after an edit that removed RemovedTriangles from the mesh and added AddedTriangles, and otherwise only moved the
+	 * vertices of the added triangles by a small amount (eg by welding them to the rest of the mesh). The tree must have been up to date before the edit.
+	 * The removed triangles are taken out of their leaves, the boxes above those leaves are refit, and a subtree built for the added triangles
+	 * is inserted below the smallest box that contains it. No bounds outside the region are recomputed, but the internal part of the index list
+	 * is moved to make room for the new leaves. The tree is rebuilt instead once the triangles added since the last build exceed MaxRegionUpdateFraction of the mesh.
+	 */
+	void UpdateRegion(const TArray<int32>& RemovedTriangles, const TArray<int32>& AddedTriangles);
+
+	/** UpdateRegion() rebuilds the tree once the triangles it has added since the last build exceed this fraction of the mesh triangles */
+	double MaxRegionUpdateFraction = 0.25;
+
+	/** Maximum number of rays in a packet passed to FindRayPacketHits() */
+	static constexpr int32 MaxPacketSize = 8;
+
+	/**
+	 * Trace a packet of up to MaxPacketSize rays through the tree in a single traversal. Each box and triangle is tested against
+	 * 4 rays at a time with SIMD instructions, in single precision. Rays should be coherent (ie similar origins and directions),
+	 * otherwise the traversal visits the union of the boxes of all rays. The tree must be valid for the current mesh.
+	 * @param Rays array of NumRays rays
+	 * @param MaxDistance if > 0, hits further along the rays than this are ignored
+	 * @param bAllHits if true, all hits along each ray are returned, otherwise only the nearest hit
+	 * @param HitsOut array of NumRays hit lists, HitsOut[k] is set to the hits of Rays[k] sorted by increasing distance
+	 */
+	void FindRayPacketHits(const FRay3d* Rays, int32 NumRays, double MaxDistance, bool bAllHits, TArray<FMeshRayPacketHit>* HitsOut) const;
+
+	/** Find the triangles whose bounding boxes overlap Box. The tree must be valid for the current mesh. */
+	void FindTrianglesInBox(const FAxisAlignedBox3d& Box, TArray<int32>& TrianglesOut) const;
+
+	/**
+	 * Test if any triangle of the mesh intersects any triangle of the mesh of OtherTree, by descending both trees together.
+	 * Both trees must be valid for their meshes.
+	 * @param OtherToThis maps positions in the space of the other mesh to the space of this mesh
+	 */
+	bool TestMeshIntersection(const FUpdatableMeshAABBTree3& OtherTree, TFunctionRef<FVector3d(const FVector3d&)> OtherToThis) const;
+
+protected:
+	// true if the tree was built for the current Mesh, ie SetMesh() has not been called since
+	bool bBuiltForMesh = false;
+	uint64 BuiltTopologyTimestamp = 0;
+	FMeshAABBTreeBuildTimings LastBuildTimings;
+
+	// leaf box of each triangle ID (or -1) and parent of each box (or -1 for the root), built by the first UpdateRegion() after each build and kept up to date by it
+	bool bHaveRegionMaps = false;
+	TArray<int32> TriangleLeafBoxes;
+	TArray<int32> BoxParents;
+	// number of triangles added by UpdateRegion() since the last build
+	int32 NumRegionUpdateTriangles = 0;
+
+	void BuildRegionMaps();
+
+	// recompute box iBox and its ancestors, stopping at the first box that is unchanged
+	void RefitToRoot(int32 iBox);
+
+	// @return box iBox
+	FAxisAlignedBox3d GetNodeBox(int32 iBox) const;
+	// @return bounds of the triangles of leaf box iBox, or of the child boxes of internal box iBox
+	FAxisAlignedBox3d ComputeNodeBox(int32 iBox) const;
+};
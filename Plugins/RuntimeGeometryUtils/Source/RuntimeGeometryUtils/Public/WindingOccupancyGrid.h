@@ -0,0 +1,73 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh3.h"
+#include "IntVectorTypes.h"
+#include "Spatial/FastWinding.h"
+#include "UpdatableMeshAABBTree3.h"
+
+
+/**
+ * FWindingOccupancyGrid caches the result of inside tests (mesh winding number >= WindingThreshold) against a mesh on a regular grid
+ * over the mesh bounds, so that most IsInside() queries are a grid lookup instead of a fast-winding evaluation. Cells that overlap the
+ * bounding box of a triangle are marked as Boundary, and queries in those cells fall back to the exact fast-winding evaluation.
+ *
+ * The grid is stored sparsely as blocks of BlockSize^3 cells. Blocks away from the surface store a single state, and only the blocks
+ * in the narrow band around the surface store per-cell states. Blocks are classified in parallel. The winding number only changes
+ * across the surface for closed meshes, so the grid is exact for those. For open meshes the state of cells away from the surface is an approximation.
+ *
+ * The grid records the mesh timestamp and threshold when it is built, IsValidFor() can be used to check if it needs to be rebuilt.
+ */
+class RUNTIMEGEOMETRYUTILS_API FWindingOccupancyGrid
+{
+public:
+	/** Number of cells along each axis of a block */
+	static constexpr int32 BlockSize = 8;
+
+	enum class ECellState : uint8
+	{
+		Outside = 0,
+		Inside = 1,
+		Boundary = 2
+	};
+
+	/**
+	 * Build the grid for the current triangles of Mesh.
+	 * @param AABBTree valid tree for Mesh, used to find the triangles in each block
+	 * @param FastWinding valid fast-winding tree for Mesh, used to classify the cells away from the surface
+	 * @param WindingThreshold queries with this threshold can use the grid
+	 * @param Resolution number of cells along the longest axis of the mesh bounds
+	 */
+	void Build(const FDynamicMesh3& Mesh, const FUpdatableMeshAABBTree3& AABBTree, TFastWindingTree<FDynamicMesh3>& FastWinding, float WindingThreshold, int32 Resolution = 128);
+
+	/** Discard the grid */
+	void Reset();
+
+	/** @return true if the grid was built for Mesh and WindingThreshold, and Mesh has not been modified since */
+	bool IsValidFor(const FDynamicMesh3& Mesh, float WindingThreshold) const;
+
+	/** @return state of the cell containing Point. Points outside the grid are Outside. */
+	ECellState GetCellState(const FVector3d& Point) const;
+
+	/**
+	 * @return true if Point is inside the mesh, ie the winding number is >= the threshold the grid was built for.
+	 * FastWinding must be the fast-winding tree for the mesh, it is only evaluated for points in Boundary cells.
+	 */
+	bool IsInside(TFastWindingTree<FDynamicMesh3>& FastWinding, const FVector3d& Point) const;
+
+protected:
+	FVector3d GridOrigin = FVector3d::Zero();
+	double CellSize = 1.0;
+	FVector3i BlockDims = FVector3i::Zero();
+
+	/** Uniform state of each block, or Boundary if the block stores per-cell states */
+	TArray<ECellState> BlockStates;
+	/** Offset of the cells of each Boundary block in Cells, or -1 */
+	TArray<int32> BlockCellsOffsets;
+	/** Per-cell states of the Boundary blocks, BlockSize^3 cells per block in x-fastest order */
+	TArray<ECellState> Cells;
+
+	float WindingThreshold = 0.5f;
+	const FDynamicMesh3* SourceMesh = nullptr;
+	uint64 SourceTimestamp = 0;
+};
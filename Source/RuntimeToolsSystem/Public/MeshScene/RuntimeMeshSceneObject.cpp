@@ -17,7 +17,7 @@ URuntimeMeshSceneObject::URuntimeMeshSceneObject()
 	}
 	if (!MeshAABBTree)
 	{
-		MeshAABBTree = MakeUnique<FDynamicMeshAABBTree3>();
+		MeshAABBTree = MakeUnique<FUpdatableMeshAABBTree3>();
 	}
 
 	UMaterialInterface* DefaultMaterial = UMaterial::GetDefaultMaterial(MD_Surface);
@@ -72,12 +72,38 @@ void URuntimeMeshSceneObject::Initialize(UWorld* TargetWorld, const FDynamicMesh
 	UpdateComponentMaterials(false);
 }
 
+void URuntimeMeshSceneObject::Initialize(UWorld* TargetWorld, TUniquePtr<FDynamicMesh3> InitialMesh, TUniquePtr<FUpdatableMeshAABBTree3> InitialMeshAABBTree, TUniquePtr<FDynamicMesh3> InitialActorMesh)
+{
+	FActorSpawnParameters SpawnInfo;
+	SimpleDynamicMeshActor = TargetWorld->SpawnActor<ADynamicSDMCActor>(FVector::ZeroVector, FRotator(0, 0, 0), SpawnInfo);
+
+	GetActor()->SourceType = EDynamicMeshActorSourceType::ExternallyGenerated;
+	GetActor()->CollisionMode = EDynamicMeshActorCollisionMode::ComplexAsSimpleAsync;
+
+	// the AABBTree references the mesh object, which is not moved here, only the pointer
+	SourceMesh = MoveTemp(InitialMesh);
+	MeshAABBTree = MoveTemp(InitialMeshAABBTree);
+
+	GetActor()->EditMesh([&](FDynamicMesh3& MeshToEdit)
+	{
+		MeshToEdit = MoveTemp(*InitialActorMesh);
+	});
+
+	// listen for changes. This is done after the initial mesh update so that the AABBTree is not rebuilt on the game thread.
+	SimpleDynamicMeshActor->MeshComponent->OnMeshChanged.AddLambda([this]() {
+		OnExternalDynamicMeshComponentUpdate();
+	});
+
+	UpdateComponentMaterials(false);
+}
+
 
 void URuntimeMeshSceneObject::OnExternalDynamicMeshComponentUpdate()
 {
 	const FDynamicMesh3* Mesh = SimpleDynamicMeshActor->MeshComponent->GetMesh();
 	*SourceMesh = *Mesh;
 	MeshAABBTree->SetMesh(SourceMesh.Get(), true);
+	FlatBVH.Reset();
 }
 
 
@@ -179,6 +205,7 @@ void URuntimeMeshSceneObject::UpdateSourceMesh(const FMeshDescription* MeshDescr
 	*SourceMesh = MoveTemp(TmpMesh);
 
 	MeshAABBTree->SetMesh(SourceMesh.Get(), true);
+	FlatBVH.Reset();
 }
 
 
@@ -191,6 +218,22 @@ bool URuntimeMeshSceneObject::IntersectRay(FVector RayOrigin, FVector RayDirecti
 	FVector3d WorldDirection(RayDirection); WorldDirection.Normalize();
 	FRay3d LocalRay(ActorToWorld.InverseTransformPosition((FVector3d)RayOrigin),
 		ActorToWorld.InverseTransformNormal(WorldDirection));
+
+	if (const FFlatMeshBVH* BVH = GetFlatQueryBVH())
+	{
+		double RayParameter;
+		FVector3d BaryCoords;
+		NearestTriangle = BVH->FindNearestHitTriangle(LocalRay, MaxDistance, RayParameter, BaryCoords);
+		if (NearestTriangle >= 0)
+		{
+			HitDistance = (float)RayParameter;
+			WorldHitPoint = (FVector)ActorToWorld.TransformPosition(LocalRay.PointAt(RayParameter));
+			TriBaryCoords = (FVector)BaryCoords;
+			return true;
+		}
+		return false;
+	}
+
 	IMeshSpatial::FQueryOptions QueryOptions;
 	if (MaxDistance > 0)
 	{
@@ -210,3 +253,54 @@ bool URuntimeMeshSceneObject::IntersectRay(FVector RayOrigin, FVector RayDirecti
 	}
 	return false;
 }
+
+
+FMeshRayQueryResults URuntimeMeshSceneObject::IntersectRays(const TArray<FVector>& RayOrigins, const TArray<FVector>& RayDirections, float MaxDistance)
+{
+	FMeshRayQueryResults Results;
+	if (!ensure(SourceMesh)) return Results;
+
+	if (const FFlatMeshBVH* BVH = GetFlatQueryBVH())
+	{
+		RTGUtils::FindRayIntersections(*BVH, FTransform3d(GetActor()->GetActorTransform()), RayOrigins, RayDirections, MaxDistance, Results);
+	}
+	else
+	{
+		RTGUtils::FindRayIntersections(*MeshAABBTree, FTransform3d(GetActor()->GetActorTransform()), RayOrigins, RayDirections, MaxDistance, Results);
+	}
+	return Results;
+}
+
+
+FMeshRayMultiHitResults URuntimeMeshSceneObject::IntersectRaysAllHits(const TArray<FVector>& RayOrigins, const TArray<FVector>& RayDirections, float MaxDistance)
+{
+	FMeshRayMultiHitResults Results;
+	if (!ensure(SourceMesh)) return Results;
+
+	RTGUtils::FindAllRayIntersections(*MeshAABBTree, FTransform3d(GetActor()->GetActorTransform()), RayOrigins, RayDirections, MaxDistance, Results);
+	return Results;
+}
+
+
+void URuntimeMeshSceneObject::SetUseFlatQueryBVH(bool bEnable)
+{
+	bUseFlatQueryBVH = bEnable;
+	if (!bUseFlatQueryBVH)
+	{
+		FlatBVH.Reset();
+	}
+}
+
+
+const FFlatMeshBVH* URuntimeMeshSceneObject::GetFlatQueryBVH()
+{
+	if (!bUseFlatQueryBVH)
+	{
+		return nullptr;
+	}
+	if (FlatBVH.IsValidFor(*SourceMesh) == false)
+	{
+		FlatBVH.Build(*SourceMesh);
+	}
+	return &FlatBVH;
+}
@@ -8,6 +8,9 @@
 #include "Templates/PimplPtr.h"
 #include "DynamicMesh3.h"
 #include "DynamicMeshAABBTree3.h"
+#include "UpdatableMeshAABBTree3.h"
+#include "MeshSpatialQueries.h"
+#include "FlatMeshBVH.h"
 #include "DynamicPMCActor.h"
 #include "DynamicSDMCActor.h"
 #include "RuntimeMeshSceneObject.generated.h"
@@ -36,6 +39,10 @@ public:
 	void Initialize(UWorld* TargetWorld, const FMeshDescription* InitialMeshDescription);
 	void Initialize(UWorld* TargetWorld, const FDynamicMesh3* InitialMesh);
 
+	// initialize from a mesh and AABBTree built elsewhere (eg on a background thread). The SceneObject takes ownership of both.
+	// InitialActorMesh is a copy of InitialMesh that is moved into the Actor, so that no mesh is copied here.
+	void Initialize(UWorld* TargetWorld, TUniquePtr<FDynamicMesh3> InitialMesh, TUniquePtr<FUpdatableMeshAABBTree3> InitialMeshAABBTree, TUniquePtr<FDynamicMesh3> InitialActorMesh);
+
 	// set the 3D transform of this SceneObject
 	void SetTransform(FTransform Transform);
 
@@ -70,6 +77,20 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "RuntimeMeshSceneObject")
 	bool IntersectRay(FVector RayOrigin, FVector RayDirection, FVector& WorldHitPoint, float& HitDistance, int& NearestTriangle, FVector& TriBaryCoords, float MaxDistance = 0);
 
+	// intersect the World-Space rays (RayOrigins[k], RayDirections[k]) with the mesh and return the nearest hit of each ray.
+	// Consecutive rays are traced together in SIMD packets, so neighbouring rays should be coherent (eg a picking or scan grid)
+	UFUNCTION(BlueprintCallable, Category = "RuntimeMeshSceneObject")
+	FMeshRayQueryResults IntersectRays(const TArray<FVector>& RayOrigins, const TArray<FVector>& RayDirections, float MaxDistance = 0);
+
+	// intersect the World-Space rays (RayOrigins[k], RayDirections[k]) with the mesh and return all hits along each ray, see IntersectRays()
+	UFUNCTION(BlueprintCallable, Category = "RuntimeMeshSceneObject")
+	FMeshRayMultiHitResults IntersectRaysAllHits(const TArray<FVector>& RayOrigins, const TArray<FVector>& RayDirections, float MaxDistance = 0);
+
+	// if enabled, IntersectRay() and IntersectRays() use a compact single-precision BVH (see FFlatMeshBVH) that is built on the first
+	// query after the mesh changes. This is faster to query than the AABBTree, so it is a good choice for SceneObjects that are not edited.
+	UFUNCTION(BlueprintCallable, Category = "RuntimeMeshSceneObject")
+	void SetUseFlatQueryBVH(bool bEnable);
+
 
 protected:
 	// URuntimeMeshSceneObject's representation in UE Level is a ADynamicSDMCActor
@@ -79,7 +100,12 @@ protected:
 protected:
 
 	TUniquePtr<FDynamicMesh3> SourceMesh;
-	TUniquePtr<FDynamicMeshAABBTree3> MeshAABBTree;
+	TUniquePtr<FUpdatableMeshAABBTree3> MeshAABBTree;
+
+	bool bUseFlatQueryBVH = false;
+	FFlatMeshBVH FlatBVH;
+	// returns the flat BVH for the current SourceMesh (building it if necessary) if it is enabled, otherwise nullptr
+	const FFlatMeshBVH* GetFlatQueryBVH();
 
 	void UpdateSourceMesh(const FMeshDescription* MeshDescription);
 
@@ -7,6 +7,9 @@
 #include "ToolsContextActor.h"
 #include "MeshScene/RuntimeMeshSceneSubsystem.h"
 #include "GeneratedMesh.h"
+#include "DynamicMeshCache.h"
+#include "Generators/SphereGenerator.h"
+#include "Async/Async.h"
 
 #include "Framework/Application/SlateApplication.h"
 #include "Slate/SceneViewport.h"
@@ -248,6 +251,8 @@ URuntimeToolsFrameworkSubsystem* URuntimeToolsFrameworkSubsystem::Get()
 
 void URuntimeToolsFrameworkSubsystem::Deinitialize()
 {
+	CancelAllPendingImports();
+
 	ShutdownToolsContext();
 
 	InstanceSingleton = nullptr;
@@ -425,6 +430,8 @@ void URuntimeToolsFrameworkSubsystem::Tick(float DeltaTime)
 {
 	if (ensure(ContextActor) == false) return;
 
+	UpdatePendingImports();
+
 	GizmoRenderingUtil::SetGlobalFocusedEditorSceneView(nullptr);
 
 	FInputDeviceState InputState = CurrentMouseState;
@@ -776,6 +783,170 @@ URuntimeMeshSceneObject* URuntimeToolsFrameworkSubsystem::ImportMeshSceneObject(
 
 
 
+/**
+ * State of one asynchronous mesh import, shared between the game thread and the background task
+ */
+struct FAsyncMeshImport
+{
+	enum class EStage : int32
+	{
+		Queued = 0,
+		Reading = 1,
+		BuildingSpatial = 2,
+		Ready = 3
+	};
+
+	FString Path;
+	bool bFlipOrientation = false;
+
+	TAtomic<int32> Stage { (int32)EStage::Queued };
+	FThreadSafeBool bCancelled = false;
+	// fraction of the file read so far, reported by the OBJ reader
+	TAtomic<float> ReadFraction { 0.0f };
+
+	TUniquePtr<FDynamicMesh3> Mesh;
+	TUniquePtr<FUpdatableMeshAABBTree3> AABBTree;
+	// copy of Mesh for the SceneObject's Actor, made here so that the game thread does not copy the mesh
+	TUniquePtr<FDynamicMesh3> ActorMesh;
+	TFuture<void> Task;
+
+	float GetProgress() const
+	{
+		// reading the file dominates, building the AABBTree is most of the rest
+		static const float StageProgress[] = { 0.0f, 0.05f, 0.75f, 0.95f };
+		int32 CurStage = Stage.Load();
+		if (CurStage == (int32)EStage::Reading)
+		{
+			return FMath::Lerp(StageProgress[CurStage], StageProgress[CurStage + 1], ReadFraction.Load());
+		}
+		return StageProgress[CurStage];
+	}
+
+	/** Runs on the background task. Cancellation is checked between stages, and by the OBJ reader after each chunk of the file. */
+	void Run()
+	{
+		if (bCancelled)
+		{
+			return;
+		}
+		Stage = (int32)EStage::Reading;
+		Mesh = MakeUnique<FDynamicMesh3>();
+		bool bReadOK = RTGUtils::ReadOBJMeshCached(Path, *Mesh, true, true, true, bFlipOrientation, [this](float Fraction)
+		{
+			ReadFraction = Fraction;
+			return bCancelled == false;
+		});
+		if (bCancelled)
+		{
+			return;
+		}
+		if (bReadOK == false)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Error reading mesh file %s"), *Path);
+			FSphereGenerator SphereGen;
+			SphereGen.NumPhi = 8;
+			SphereGen.NumTheta = 8;
+			SphereGen.Radius = 200;
+			*Mesh = FDynamicMesh3(&SphereGen.Generate());
+		}
+		Mesh->EnableAttributes();
+
+		if (bCancelled)
+		{
+			return;
+		}
+		Stage = (int32)EStage::BuildingSpatial;
+		AABBTree = MakeUnique<FUpdatableMeshAABBTree3>();
+		AABBTree->SetMesh(Mesh.Get(), true);
+		ActorMesh = MakeUnique<FDynamicMesh3>(*Mesh);
+
+		Stage = (int32)EStage::Ready;
+	}
+};
+
+
+int32 URuntimeToolsFrameworkSubsystem::ImportMeshSceneObjectAsync(const FString ImportPath, bool bFlipOrientation)
+{
+	TSharedPtr<FAsyncMeshImport, ESPMode::ThreadSafe> Import = MakeShared<FAsyncMeshImport, ESPMode::ThreadSafe>();
+	Import->Path = ImportPath;
+	if (FPaths::FileExists(Import->Path) == false && FPaths::IsRelative(Import->Path))
+	{
+		Import->Path = FPaths::ProjectContentDir() + ImportPath;
+	}
+	Import->bFlipOrientation = bFlipOrientation;
+
+	Import->Task = Async(EAsyncExecution::ThreadPool, [Import]()
+	{
+		Import->Run();
+	});
+
+	int32 ImportID = NextImportID++;
+	PendingImports.Add(ImportID, Import);
+	return ImportID;
+}
+
+
+float URuntimeToolsFrameworkSubsystem::GetAsyncImportProgress(int32 ImportID) const
+{
+	const TSharedPtr<FAsyncMeshImport, ESPMode::ThreadSafe>* Found = PendingImports.Find(ImportID);
+	return (Found) ? (*Found)->GetProgress() : -1.0f;
+}
+
+
+bool URuntimeToolsFrameworkSubsystem::CancelAsyncImport(int32 ImportID)
+{
+	TSharedPtr<FAsyncMeshImport, ESPMode::ThreadSafe>* Found = PendingImports.Find(ImportID);
+	if (Found)
+	{
+		// the import stays pending until the task has stopped, so that completion is still reported
+		(*Found)->bCancelled = true;
+	}
+	return Found != nullptr;
+}
+
+
+void URuntimeToolsFrameworkSubsystem::UpdatePendingImports()
+{
+	TArray<int32> FinishedImports;
+	for (const TPair<int32, TSharedPtr<FAsyncMeshImport, ESPMode::ThreadSafe>>& Pair : PendingImports)
+	{
+		if (Pair.Value->Task.IsReady())
+		{
+			FinishedImports.Add(Pair.Key);
+		}
+	}
+
+	for (int32 ImportID : FinishedImports)
+	{
+		TSharedPtr<FAsyncMeshImport, ESPMode::ThreadSafe> Import;
+		PendingImports.RemoveAndCopyValue(ImportID, Import);
+
+		URuntimeMeshSceneObject* SceneObject = nullptr;
+		if (Import->bCancelled == false && Import->Stage.Load() == (int32)FAsyncMeshImport::EStage::Ready)
+		{
+			SceneObject = URuntimeMeshSceneSubsystem::Get()->CreateNewSceneObject();
+			SceneObject->Initialize(TargetWorld, MoveTemp(Import->Mesh), MoveTemp(Import->AABBTree), MoveTemp(Import->ActorMesh));
+		}
+		OnAsyncMeshImportCompleted.Broadcast(ImportID, SceneObject);
+	}
+}
+
+
+void URuntimeToolsFrameworkSubsystem::CancelAllPendingImports()
+{
+	for (TPair<int32, TSharedPtr<FAsyncMeshImport, ESPMode::ThreadSafe>>& Pair : PendingImports)
+	{
+		Pair.Value->bCancelled = true;
+	}
+	for (TPair<int32, TSharedPtr<FAsyncMeshImport, ESPMode::ThreadSafe>>& Pair : PendingImports)
+	{
+		Pair.Value->Task.Wait();
+	}
+	PendingImports.Empty();
+}
+
+
+
 void URuntimeToolsFrameworkSubsystem::SetCurrentCoordinateSystem(EToolContextCoordinateSystem CoordSystem) 
 { 
 	CurrentCoordinateSystem = CoordSystem; 
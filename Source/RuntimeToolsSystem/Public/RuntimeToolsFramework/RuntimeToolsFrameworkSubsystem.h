@@ -18,6 +18,9 @@ class FRuntimeToolsContextQueriesImpl;
 class FRuntimeToolsContextTransactionImpl;
 class FRuntimeToolsContextAssetImpl;
 class AToolsContextActor;
+struct FAsyncMeshImport;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FAsyncMeshImportCompletedEvent, int32, ImportID, URuntimeMeshSceneObject*, SceneObject);
 
 /**
  * 
@@ -129,6 +132,36 @@ public:
 
 
 
+	//
+	// Asynchronous mesh import. The mesh file is read and the mesh and its AABBTree are built on a
+	// background task, the SceneObject is only created on the game thread (in Tick) once the mesh is ready.
+	//
+
+	/** Start importing the mesh at Path. @return ID of the import, used to query progress or cancel it */
+	UFUNCTION(BlueprintCallable)
+	int32 ImportMeshSceneObjectAsync(const FString Path, bool bFlipOrientation);
+
+	/** @return progress of the import in range [0,1], or -1 if ImportID is not a pending import */
+	UFUNCTION(BlueprintCallable)
+	float GetAsyncImportProgress(int32 ImportID) const;
+
+	/** Cancel a pending import. No SceneObject will be created. @return false if ImportID is not a pending import */
+	UFUNCTION(BlueprintCallable)
+	bool CancelAsyncImport(int32 ImportID);
+
+	/** Broadcast on the game thread when an async import finishes. The SceneObject is null if the import was cancelled. */
+	UPROPERTY(BlueprintAssignable)
+	FAsyncMeshImportCompletedEvent OnAsyncMeshImportCompleted;
+
+protected:
+	TMap<int32, TSharedPtr<FAsyncMeshImport, ESPMode::ThreadSafe>> PendingImports;
+	int32 NextImportID = 1;
+
+	void UpdatePendingImports();
+	void CancelAllPendingImports();
+
+
+
 	//
 	// mouse state queries/functions
 	//